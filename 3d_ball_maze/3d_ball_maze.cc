@@ -5,6 +5,7 @@
 #include "nyla/commons/asset_manager.h"
 #include "nyla/commons/byteliterals.h"
 #include "nyla/commons/cell_renderer.h"
+#include "nyla/commons/cpu_sampler.h"
 #include "nyla/commons/debug_text_renderer.h"
 #include "nyla/commons/dev_assets.h"
 #include "nyla/commons/dev_log.h"
@@ -66,12 +67,12 @@ void UserMain()
 #endif
     Shader::Bootstrap();
     PipelineCache::Bootstrap();
-    DebugTextRenderer::Bootstrap(alloc);
-    Renderer::Bootstrap(alloc);
-#if !defined(NDEBUG)
     CellRenderer::Bootstrap(alloc, cell_renderer_init_desc{
                                        .bdfGuid = ID_bdf_terminus_u32,
                                    });
+    DebugTextRenderer::Bootstrap(alloc);
+    Renderer::Bootstrap(alloc);
+#if !defined(NDEBUG)
     Tunables::Bootstrap("3d_ball_maze.tunables"_s);
 #endif
 
@@ -82,12 +83,13 @@ void UserMain()
     Tunables::RegisterFloat("camera.moveSpeed"_s, &moveSpeed, 0.5f, 0.5f, 100.f);
     Tunables::RegisterFloat("camera.fovDeg"_s, &fovDeg, 1.f, 30.f, 170.f);
     Tunables::RegisterFloat("camera.lookSens"_s, &lookSensitivity, 0.01f, 0.01f, 1.f);
+    Renderer::RegisterTunables();
     Profiler::Bootstrap();
 #endif
 
-    mesh_handle cubeMesh = MeshManager::DeclareMesh(ID_mesh_gltf_cube, ID_mesh_bin_cube);
-    mesh_handle sphereMesh = MeshManager::DeclareMesh(ID_mesh_gltf_sphere, ID_mesh_bin_sphere);
-    mesh_handle rectMesh = MeshManager::DeclareMesh(ID_mesh_rect_gltf, ID_mesh_bin_rect);
+    mesh_handle cubeMesh = MeshManager::DeclareMesh(ID_mesh_gltf_cube);
+    mesh_handle sphereMesh = MeshManager::DeclareMesh(ID_mesh_gltf_sphere);
+    mesh_handle rectMesh = MeshManager::DeclareMesh(ID_mesh_rect_gltf);
 
     render_targets renderTargets{
         .ColorFormat = rhi_texture_format::B8G8R8A8_sRGB,
@@ -103,7 +105,7 @@ void UserMain()
         GpuUpload::Update();
         InputManager::Update();
         TweenManager::Update(frame.dt);
-        MeshManager::Update(alloc, frame.cmd);
+        MeshManager::Update(frame.cmd);
         TextureManager::Update(frame.cmd);
 
         {
@@ -191,7 +193,8 @@ void UserMain()
                             CellRenderer::CmdFlush(frame.cmd);
                         }
                         Profiler::CmdFlush(frame.cmd, 8, 8 + 32 * 9, frame.fps);
-                        Tunables::CmdFlush(frame.cmd, 8, 8 + 32 * 18);
+                        CpuSampler::CmdFlush(frame.cmd, 8 + 16 * 66, 8 + 32 * 9);
+                        Tunables::CmdFlush(frame.cmd, 8, 8 + 32 * 24);
                     }
 #endif
                 }
@@ -15,9 +15,11 @@
 #include "nyla/commons/file_utils.h"
 #include "nyla/commons/fmt.h"
 #include "nyla/commons/gamepad.h"
+#include "nyla/commons/gltf.h"
 #include "nyla/commons/gpu_upload.h"
 #include "nyla/commons/inline_vec.h"
 #include "nyla/commons/input_manager.h"
+#include "nyla/commons/job_system.h"
 #include "nyla/commons/keyboard.h"
 #include "nyla/commons/lerp.h"
 #include "nyla/commons/limits.h"
@@ -29,6 +31,7 @@
 #include "nyla/commons/mesh_manager.h"
 #include "nyla/commons/minmax.h"
 #include "nyla/commons/platform.h"
+#include "nyla/commons/qoa.h"
 #include "nyla/commons/random.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/region_alloc_def.h"
@@ -44,6 +47,7 @@
 #include "nyla/commons/tokenparser.h"
 #include "nyla/commons/tween_manager.h"
 #include "nyla/commons/vec.h"
+#include "nyla/commons/wave.h"
 
 #include "nyla/commons/asset_import.h"
 
@@ -54,12 +58,13 @@ enum class AssetType
 {
     Unknown = 0,
     Texture = 1,
-    Gltf = 2,
     Bin = 3,
     BdfFont = 4,
     Spv = 5,
     Wav = 6,
     Pipeline = 7,
+    Mesh = 8,
+    Qoa = 9,
 };
 
 namespace
@@ -71,8 +76,137 @@ struct pending_entry
     byteview alias;
     AssetType type;
     byteview processed;
+    byteview raw; // left for CookEntries
 };
 
+auto JoinPath(region_alloc &alloc, byteview dir, byteview name, byteview suffix = {}) -> byteview
+{
+    auto &path = RegionAlloc::AllocVec<uint8_t, 0x100>(alloc);
+    InlineVec::Append(path, dir);
+    InlineVec::Append(path, "/"_s);
+    InlineVec::Append(path, name);
+    InlineVec::Append(path, suffix);
+    return path;
+}
+
+auto ReadMeta(region_alloc &alloc, byteview metaPath, uint64_t &guid, byteview &alias, byteview &codec) -> bool
+{
+    file_handle metaFile = FileOpen(metaPath, FileOpenMode::Read);
+    if (!FileValid(metaFile))
+        return false;
+
+    span buf = FileReadFully(alloc, metaFile);
+    FileClose(metaFile);
+
+    byte_parser p;
+    ByteParser::Init(p, buf.data, buf.size);
+    while (ByteParser::HasNext(p))
+    {
+        StringParser::SkipWhitespace(p);
+        if (!ByteParser::HasNext(p))
+            break;
+        if (TokenParser::SkipLineComment(p))
+            continue;
+
+        byteview key = TokenParser::ParseIdentifier(p);
+        TokenParser::SkipLineWhitespace(p);
+
+        if (Span::Eq(key, "guid"_s))
+            guid = TokenParser::ParseHexU64(p);
+        else if (Span::Eq(key, "alias"_s))
+            alias = TokenParser::ParseIdentifier(p);
+        else if (Span::Eq(key, "codec"_s))
+            codec = TokenParser::ParseIdentifier(p);
+        else
+            ByteParser::NextLine(p);
+    }
+
+    return true;
+}
+
+// The .bin is read through the buffer uri, image uris resolve to the texture guids from their .meta files.
+auto CookMesh(region_alloc &alloc, byteview dir, byteview gltfJson) -> byteview
+{
+    gltf_parser gltf{.jsonChunk = gltfJson};
+    ASSERT(GltfParser::Parse(gltf, alloc));
+    ASSERT(gltf.buffers.size == 1 && gltf.buffers[0].uri.size, "only a single external buffer is supported");
+
+    file_handle binFile = FileOpen(JoinPath(alloc, dir, gltf.buffers[0].uri), FileOpenMode::Read);
+    ASSERT(FileValid(binFile));
+    gltf.binChunk = FileReadFully(alloc, binFile);
+    FileClose(binFile);
+
+    span<uint64_t> imageGuids = RegionAlloc::AllocArray<uint64_t>(alloc, gltf.images.size);
+    for (uint64_t i = 0; i < gltf.images.size; ++i)
+    {
+        byteview alias;
+        byteview codec;
+        if (!gltf.images[i].uri.size || !ReadMeta(alloc, JoinPath(alloc, dir, gltf.images[i].uri, ".meta"_s),
+                                                  imageGuids[i], alias, codec))
+        {
+            LOG("mesh image " SV_FMT " has no meta, using the default texture", SV_ARG(gltf.images[i].uri));
+        }
+    }
+
+    return ImportMeshFromGltf(gltf, imageGuids, mesh_import_options{}, alloc);
+}
+
+// A .wav whose meta says "codec qoa" ships as QOA, about a fifth of the size, and streams instead of staying
+// resident as PCM.
+auto CookQoa(region_alloc &alloc, byteview wav) -> byteview
+{
+    const ParseWavFileResult parsed = ParseWavFile(wav);
+    const qoa_desc desc{
+        .numFrames = (uint32_t)(parsed.data.size / (parsed.fmt->numChannels * sizeof(int16_t))),
+        .sampleRate = parsed.fmt->numSamplesPerSec,
+        .channels = parsed.fmt->numChannels,
+    };
+
+    // The data chunk is not necessarily aligned for int16_t.
+    span<int16_t> pcm = RegionAlloc::AllocArrayUninit<int16_t>(alloc, (uint64_t)desc.numFrames * desc.channels);
+    MemCpy(pcm.data, parsed.data.data, pcm.size * sizeof(int16_t));
+
+    span<uint8_t> out = RegionAlloc::AllocArrayUninit<uint8_t>(alloc, Qoa::EncodeBound(desc.numFrames, desc.channels));
+    const uint64_t size = Qoa::Encode(pcm.data, desc, out);
+    LOG("qoa: %" PRIu64 " -> %" PRIu64 " bytes", parsed.data.size, size);
+    return byteview{out.data, size};
+}
+
+struct cook_context
+{
+    span<pending_entry> entries;
+    span<region_alloc> allocs; // one per worker, the results outlive the jobs
+};
+
+// Decoding images and encoding audio is most of the packer's time, and no two files depend on each other.
+void CookEntries(void *user, uint64_t begin, uint64_t end)
+{
+    auto &ctx = *static_cast<cook_context *>(user);
+    region_alloc &alloc = ctx.allocs[JobSystem::GetWorkerIndex()];
+
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        pending_entry &entry = ctx.entries[i];
+        if (!entry.raw.size)
+            continue;
+
+        switch (entry.type)
+        {
+        case AssetType::Texture: {
+            entry.processed = ImportTextureFromPngOrJpg(entry.raw, alloc);
+            ASSERT(entry.processed.size > 0);
+            break;
+        }
+        case AssetType::Qoa: {
+            entry.processed = CookQoa(alloc, entry.raw);
+            break;
+        }
+        default:
+            UNREACHABLE();
+        }
+    }
+}
+
 } // namespace
 
 void UserMain()
@@ -124,13 +258,15 @@ void UserMain()
                     else if (Span::EndsWith(meta.fileName, ".bdf"_s))
                         type = AssetType::BdfFont;
                     else if (Span::EndsWith(meta.fileName, ".gltf"_s))
-                        type = AssetType::Gltf;
+                        type = AssetType::Mesh;
                     else if (Span::EndsWith(meta.fileName, ".bin"_s))
                         type = AssetType::Bin;
                     else if (Span::EndsWith(meta.fileName, ".spv"_s))
                         type = AssetType::Spv;
                     else if (Span::EndsWith(meta.fileName, ".wav"_s))
                         type = AssetType::Wav;
+                    else if (Span::EndsWith(meta.fileName, ".qoa"_s))
+                        type = AssetType::Qoa;
                     else if (Span::EndsWith(meta.fileName, ".pipeline"_s))
                         type = AssetType::Pipeline;
                     else
@@ -151,33 +287,9 @@ void UserMain()
 
                         uint64_t guid = 0;
                         byteview alias{};
-                        file_handle metaFile = FileOpen(metaPath, FileOpenMode::Read);
-                        if (FileValid(metaFile))
+                        byteview codec{};
+                        if (ReadMeta(alloc, metaPath, guid, alias, codec))
                         {
-                            span buf = FileReadFully(alloc, metaFile);
-                            FileClose(metaFile);
-
-                            byte_parser p;
-                            ByteParser::Init(p, buf.data, buf.size);
-                            while (ByteParser::HasNext(p))
-                            {
-                                StringParser::SkipWhitespace(p);
-                                if (!ByteParser::HasNext(p))
-                                    break;
-                                if (TokenParser::SkipLineComment(p))
-                                    continue;
-
-                                byteview key = TokenParser::ParseIdentifier(p);
-                                TokenParser::SkipLineWhitespace(p);
-
-                                if (Span::Eq(key, "guid"_s))
-                                    guid = TokenParser::ParseHexU64(p);
-                                else if (Span::Eq(key, "alias"_s))
-                                    alias = TokenParser::ParseIdentifier(p);
-                                else
-                                    ByteParser::NextLine(p);
-                            }
-
                             LOG("meta exists guid: 0x%016" PRIX64 " alias: " SV_FMT, guid, SV_ARG(alias));
                         }
                         else
@@ -201,16 +313,31 @@ void UserMain()
                         span rawBytes = FileReadFully(alloc, file);
                         FileClose(file);
 
-                        byteview processed;
+                        if (type == AssetType::Wav && Span::Eq(codec, "qoa"_s))
+                            type = AssetType::Qoa;
+
+                        byteview processed{};
+                        byteview raw{};
                         switch (type)
                         {
                         case AssetType::Texture: {
-                            processed = ImportTextureFromPngOrJpg(rawBytes, alloc);
+                            raw = rawBytes;
+                            break;
+                        }
+                        case AssetType::Mesh: {
+                            processed = CookMesh(alloc, currentDir, rawBytes);
                             ASSERT(processed.size > 0);
                             break;
                         }
+                        case AssetType::Qoa: {
+                            qoa_desc desc;
+                            if (Qoa::ParseHeader(rawBytes, desc))
+                                processed = rawBytes;
+                            else
+                                raw = rawBytes;
+                            break;
+                        }
                         case AssetType::Bin:
-                        case AssetType::Gltf:
                         case AssetType::BdfFont:
                         case AssetType::Spv:
                         case AssetType::Wav:
@@ -226,6 +353,7 @@ void UserMain()
                                                        .alias = alias,
                                                        .type = type,
                                                        .processed = processed,
+                                                       .raw = raw,
                                                    });
                     }
                 }
@@ -235,6 +363,22 @@ void UserMain()
         }
     }
 
+    {
+        JobSystem::Bootstrap();
+
+        cook_context ctx{
+            .entries = entries,
+            .allocs = RegionAlloc::AllocArray<region_alloc>(alloc, JobSystem::GetWorkerCount()),
+        };
+        for (region_alloc &cookAlloc : ctx.allocs)
+            cookAlloc = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+
+        const uint64_t start = GetMonotonicTimeNanos();
+        JobSystem::ParallelFor(entries.size, 1, &CookEntries, &ctx);
+        LOG("cooked in %.1f ms on %u workers", (double)(GetMonotonicTimeNanos() - start) / 1e6,
+            JobSystem::GetWorkerCount());
+    }
+
     file_handle assetsHeaderFile = FileOpen("assets.h"_s, FileOpenMode::Write);
     ASSERT(FileValid(assetsHeaderFile));
 
@@ -9,8 +9,6 @@ constexpr inline uint64_t ID_shipgame_grid_pipeline = 0x4e85b1c92a73fd08;
 constexpr inline uint64_t ID_shipgame_world_pipeline = 0x9c4a2f817bd306e5;
 constexpr inline uint64_t ID_cell_renderer_ps = 0x9e3f4d8a1c07b2e6;
 constexpr inline uint64_t ID_cell_renderer_vs = 0x6d1a8f7c2e5b9043;
-constexpr inline uint64_t ID_debug_text_renderer_ps = 0x40c5cf806d5a00d;
-constexpr inline uint64_t ID_fullscreen_vs = 0xf3624967bc396a3c;
 constexpr inline uint64_t ID_shipgame_grid_ps = 0x7d1f04e27e5102cb;
 constexpr inline uint64_t ID_shipgame_grid_vs = 0x5b83e19e4471ffa7;
 constexpr inline uint64_t ID_renderer_ps = 0xfe6e3d0d77673448;
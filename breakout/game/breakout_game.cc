@@ -0,0 +1,290 @@
+#include <cmath>
+#include <cstdint>
+
+#include "assets.h"
+#include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/audio.h"
+#include "nyla/commons/color.h"
+#include "nyla/commons/engine.h"
+#include "nyla/commons/game_module.h"
+#include "nyla/commons/inline_vec.h"
+#include "nyla/commons/input_manager.h"
+#include "nyla/commons/keyboard.h"
+#include "nyla/commons/macros.h" // IWYU pragma: keep
+#include "nyla/commons/mat.h"
+#include "nyla/commons/mesh_manager.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/renderer.h"
+#include "nyla/commons/texture_manager.h"
+#include "nyla/commons/time.h"
+#include "nyla/commons/tunables.h"
+#include "nyla/commons/tween_manager.h"
+#include "nyla/commons/vec.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+const uint64_t kBricks[] = {
+    ID_breakout_brick_1_4, ID_breakout_brick_2_4, ID_breakout_brick_3_4, ID_breakout_brick_4_4, ID_breakout_brick_5_4,
+    ID_breakout_brick_6_4, ID_breakout_brick_7_4, ID_breakout_brick_8_4, ID_breakout_brick_9_4,
+};
+
+struct brick_data
+{
+    static constexpr uint32_t kFlagDead = 1 << 0;
+
+    uint32_t flags;
+    float2 pos;
+    float2 size;
+    texture_handle texture;
+};
+
+// Lives in the host, it survives reloads of this module.
+struct game_state
+{
+    inline_vec<brick_data, 512> bricks;
+
+    audio_clip_handle brickHitClip;
+    audio_clip_handle paddleHitClip;
+
+    mesh_handle rectMesh;
+    texture_handle ballTex;
+    texture_handle playerTex;
+    texture_handle playerFlashTex;
+    array<texture_handle, 9> brickTextures;
+
+    uint64_t dtUsAccumulator;
+
+    float2 worldBoundaryX;
+    float2 worldBoundaryY;
+    float ballRadius;
+    float playerPosX;
+    float playerPosY;
+    float playerHeight;
+    float playerWidth;
+    float playerSpeed;
+    float2 ballPos;
+    float2 ballVel;
+};
+
+auto IsInside(float pos, float size, float2 boundary) -> bool
+{
+    if (pos > boundary[0] - size / 2.f && pos < boundary[1] + size / 2.f)
+    {
+        return true;
+    }
+    return false;
+}
+
+void Init(void *state, bool reloaded)
+{
+    auto &game = *static_cast<game_state *>(state);
+    if (reloaded)
+        return;
+
+#if !defined(NDEBUG)
+    Tunables::RegisterFloat("ball.radius"_s, &game.ballRadius, 0.05f, 0.1f, 5.f);
+    Tunables::RegisterFloat("player.height"_s, &game.playerHeight, 0.1f, 0.5f, 10.f);
+    Tunables::RegisterFloat("player.speed"_s, &game.playerSpeed, 5.f, 5.f, 400.f);
+#endif
+
+    game.brickHitClip = Audio::DeclareClip(ID_breakout_brick_hit_wav);
+    game.paddleHitClip = Audio::DeclareClip(ID_breakout_paddle_hit_wav);
+
+    game.rectMesh = MeshManager::DeclareMesh(ID_mesh_rect_gltf);
+
+    texture_handle backgroundTex = TextureManager::DeclareTexture(ID_breakout_background1);
+    game.ballTex = TextureManager::DeclareTexture(ID_breakout_ball_small_blue);
+    game.playerTex = TextureManager::DeclareTexture(ID_breakout_player);
+    game.playerFlashTex = TextureManager::DeclareTexture(ID_breakout_player_flash);
+
+    for (int i = 0; i < 9; ++i)
+        game.brickTextures[i] = TextureManager::DeclareTexture(kBricks[i]);
+
+    Renderer::CreateInstance(render_instance_desc{
+        .pos = {0, 0, 0},
+        .scale = {100, 70, 0},
+        .mesh = game.rectMesh,
+        .texture = backgroundTex,
+    });
+
+    game.worldBoundaryX = {-35.f, 35.f};
+    game.worldBoundaryY = {-30.f, 30.f};
+    game.ballRadius = .8f;
+    game.playerPosX = 0.f;
+    game.playerPosY = game.worldBoundaryY[0] + 1.6f;
+    game.playerHeight = 2.5f;
+    game.playerWidth = (74.f / 26.f) * game.playerHeight;
+    game.playerSpeed = 100.f;
+    game.ballPos = {10.f, game.playerPosY};
+    game.ballVel = {40.f, 40.f};
+
+    for (uint32_t i = 0; i < 12; ++i)
+    {
+        float h = std::fmod(static_cast<float>(i) + 825.f, 12.f) / 12.f;
+        float s = .97f;
+        float v = .97f;
+
+        float3 color = ConvertHsvToRgb({h, s, v});
+
+        for (uint32_t j = 0; j < 17; ++j)
+        {
+            float y = 20.f - (float)i * 1.5f;
+            float x = -28.f + (float)j * 3.5f;
+
+            float posX;
+            if (j % 2)
+                posX = 50.f;
+            else
+                posX = -50.f;
+            float posY;
+            if (j % 3)
+                posY = -50.f;
+            else
+                posY = 50.f;
+            brick_data &brick = InlineVec::Append(game.bricks, brick_data{
+                                                                   .pos = {posX, posY},
+                                                                   .size = {40.f / 15.f, 1.f},
+                                                               });
+
+            TweenManager::Lerp(brick.pos[0], x, TweenManager::Now(), TweenManager::Now() + 1);
+            TweenManager::Lerp(brick.pos[1], y, TweenManager::Now(), TweenManager::Now() + 1);
+        }
+    }
+
+    InputManager::Map(input_id::MoveRight, input_interface_type::Keyboard, (uint32_t)KeyPhysical::F);
+    InputManager::Map(input_id::MoveLeft, input_interface_type::Keyboard, (uint32_t)KeyPhysical::S);
+}
+
+void Update(void *state, const engine_frame &frame)
+{
+    auto &game = *static_cast<game_state *>(state);
+    game.dtUsAccumulator += frame.dtUs;
+
+    constexpr uint64_t kStepUs = 1'000'000 / 120;
+    constexpr float kStep = 1.f / 120.f;
+    for (; game.dtUsAccumulator >= kStepUs; game.dtUsAccumulator -= kStepUs)
+    {
+        // game input, the paddle moves for as long within the step as the key was held
+        InputManager::Step((frame.frameStartUs - (game.dtUsAccumulator - kStepUs)) * 1000);
+        const float dx =
+            InputManager::GetHeldFraction(input_id::MoveRight) - InputManager::GetHeldFraction(input_id::MoveLeft);
+
+        game.playerPosX += game.playerSpeed * kStep * dx;
+        game.playerPosX = Clamp(game.playerPosX, game.worldBoundaryX[0] + game.playerWidth / 2.f,
+                                game.worldBoundaryX[1] - game.playerWidth / 2.f);
+
+        if (!IsInside(game.ballPos[0], game.ballRadius * 2.f, game.worldBoundaryX))
+        {
+            game.ballVel[0] = -game.ballVel[0];
+        }
+
+        if (!IsInside(game.ballPos[1], game.ballRadius * 2.f, game.worldBoundaryY))
+        {
+            game.ballVel[1] = -game.ballVel[1];
+        }
+
+        game.ballPos += game.ballVel * kStep;
+
+        for (auto &brick : game.bricks)
+        {
+            if (brick.flags & brick_data::kFlagDead)
+                continue;
+
+            bool hit = false;
+
+            if (IsInside(game.ballPos[0], game.ballRadius * 2.f,
+                         float2{brick.pos[0] - brick.size[0] / 2.f, brick.pos[0] + brick.size[0] / 2.f}))
+            {
+                if (IsInside(game.ballPos[1], game.ballRadius * 2.f,
+                             float2{brick.pos[1] - brick.size[1] / 2.f, brick.pos[1] + brick.size[1] / 2.f}))
+                {
+                    game.ballVel[1] = -game.ballVel[1];
+                    game.ballVel[0] = -game.ballVel[0];
+                    hit = true;
+                    brick.flags |= brick_data::kFlagDead;
+                    Audio::Play(game.brickHitClip);
+                }
+            }
+
+            if (hit)
+                break;
+        }
+
+        {
+            if (IsInside(game.ballPos[0], game.ballRadius * 2.f,
+                         float2{game.playerPosX - game.playerWidth / 2.f, game.playerPosX + game.playerWidth / 2.f}))
+            {
+                if (IsInside(game.ballPos[1], game.ballRadius * 2.f,
+                             float2{game.playerPosY - game.playerHeight / 2.f,
+                                    game.playerPosY + game.playerHeight / 2.f}))
+                {
+                    game.ballVel[1] = -game.ballVel[1];
+                    game.ballVel[0] = -game.ballVel[0];
+                    Audio::Play(game.paddleHitClip);
+                }
+            }
+        }
+    }
+}
+
+void Render(void *state, const engine_frame &, uint32_t width, uint32_t height)
+{
+    auto &game = *static_cast<game_state *>(state);
+
+    uint32_t i = 0;
+    for (brick_data &brick : game.bricks)
+    {
+        i++;
+        if (brick.flags & brick_data::kFlagDead)
+            continue;
+
+        const float3 pos = float3{brick.pos[0], brick.pos[1], 0};
+        const float3 size = float3{brick.size[0], brick.size[1], 0};
+
+        Renderer::Mesh(pos, size, game.rectMesh, game.brickTextures[i % Array::Size(game.brickTextures)]);
+    }
+
+    uint64_t second = GetMonotonicTimeMillis() / 1000;
+    if (second % 2)
+    {
+        Renderer::Mesh({game.playerPosX, game.playerPosY, 0}, {game.playerWidth, game.playerHeight, 0},
+                       game.rectMesh, game.playerFlashTex);
+    }
+    else
+    {
+        Renderer::Mesh({game.playerPosX, game.playerPosY, 0}, {game.playerWidth, game.playerHeight, 0},
+                       game.rectMesh, game.playerTex);
+    }
+
+    {
+        const float3 pos = float3{game.ballPos[0], game.ballPos[1], 0};
+        Renderer::Mesh(pos, {game.ballRadius * 2, game.ballRadius * 2, 0}, game.rectMesh, game.ballTex);
+    }
+
+    Renderer::SetOrthoProjection(width, height, 64);
+
+    float4x4 view;
+    Mat::Identity(view);
+    Renderer::SetView(view);
+}
+
+constexpr game_api kGameApi{
+    .version = kGameApiVersion,
+    .stateSize = sizeof(game_state),
+    .init = &Init,
+    .update = &Update,
+    .render = &Render,
+};
+
+} // namespace
+
+NYLA_GAME_EXPORT auto NylaGetGameApi() -> const game_api *
+{
+    return &kGameApi;
+}
+
+} // namespace nyla
@@ -30,4 +30,52 @@ struct texture_blob_header
     uint32_t pixelOffset;
 };
 
+constexpr inline uint32_t kMeshBlobMagic = DWord("MESH");
+
+enum class mesh_blob_vertex_format : uint32_t
+{
+    Float32,   // float3 position, float2 octahedral normal, float2 uv
+    Quantized, // half4 position (w = 1), snorm16x2 octahedral normal, half2 uv
+};
+
+constexpr inline uint32_t kMeshBlobFloat32VertexStride = 28;
+constexpr inline uint32_t kMeshBlobQuantizedVertexStride = 16;
+
+constexpr inline uint32_t kMeshBlobMaxLods = 4;
+
+// mesh_blob_header, then submeshCount mesh_blob_submesh, then the interleaved vertex stream and the index stream.
+// Offsets are from the start of the blob, both streams are ready to be copied to the GPU as is.
+struct mesh_blob_header
+{
+    uint32_t magic; // MESH
+    mesh_blob_vertex_format vertexFormat;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t vertexOffset;
+    uint32_t indexCount;
+    uint32_t indexSize; // 2 or 4
+    uint32_t indexOffset;
+    uint32_t submeshCount;
+    uint32_t lodCount;
+    float lodError[kMeshBlobMaxLods]; // worst object space deviation of each level, 0 for lod 0
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct mesh_blob_lod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+struct mesh_blob_submesh
+{
+    mesh_blob_lod lods[kMeshBlobMaxLods]; // lodCount from the header, a submesh that simplifies less repeats a level
+    uint32_t baseVertex;
+    uint32_t vertexCount;
+    uint64_t textureGuid; // 0 when the material has no base color texture
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
 } // namespace nyla
\ No newline at end of file
@@ -1,14 +1,23 @@
 #include "nyla/commons/asset_import.h"
 
+#include <cinttypes>
 #include <cstdint>
 #include <cstdlib>
 
 #include "nyla/commons/asset_file_format.h"
+#include "nyla/commons/align.h"
+#include "nyla/commons/array.h" // IWYU pragma: keep
 #include "nyla/commons/cast.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/gltf.h"
+#include "nyla/commons/intrin.h"
 #include "nyla/commons/mem.h"
+#include "nyla/commons/mesh_optimize.h"
+#include "nyla/commons/minmax.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/span.h"
 #include "nyla/commons/span_def.h"
+#include "nyla/commons/vec.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_STDIO
@@ -50,4 +59,345 @@ auto ImportTextureFromPngOrJpg(byteview rawBytes, region_alloc &alloc) -> bytevi
     return byteview{dst.data, totalSize};
 }
 
-} // namespace nyla
+namespace
+{
+
+// float3 position, float3 normal, float2 uv as authored, the baseline for the cooked vertex size.
+constexpr uint32_t kAuthoredVertexStride = 32;
+
+auto IsTriangles(const gltf_mesh_primitive &primitive) -> bool
+{
+    return primitive.mode == 4;
+}
+
+auto ReadIndex(gltf_parser &gltf, const gltf_accessor &indices, uint32_t i) -> uint32_t
+{
+    const uint8_t *p = GltfParser::GetAccessorElement(gltf, indices, i);
+    switch (indices.componentType)
+    {
+    case gltf_accessor_component_type::UNSIGNED_BYTE:
+        return *p;
+    case gltf_accessor_component_type::UNSIGNED_SHORT:
+        return LoadU<uint16_t>(p);
+    case gltf_accessor_component_type::UNSIGNED_INT:
+        return LoadU<uint32_t>(p);
+    default:
+        ASSERT(false);
+        return 0;
+    }
+}
+
+auto IsFloatAccessor(const gltf_accessor &accessor, gltf_accessor_type type) -> bool
+{
+    return accessor.type == type && accessor.componentType == gltf_accessor_component_type::FLOAT;
+}
+
+} // namespace
+
+auto ImportMeshFromGltf(gltf_parser &gltf, span<const uint64_t> imageGuids, const mesh_import_options &options,
+                        region_alloc &alloc) -> byteview
+{
+    uint32_t submeshCount = 0;
+    uint64_t vertexCount = 0;
+    uint64_t indexCount = 0;
+    uint32_t indexSize = 2;
+
+    for (gltf_mesh &mesh : gltf.meshes)
+    {
+        for (gltf_mesh_primitive &primitive : mesh.primitives)
+        {
+            if (!IsTriangles(primitive))
+            {
+                LOG("skipping non-triangle primitive (mode %u) in mesh " SV_FMT, primitive.mode, SV_ARG(mesh.name));
+                continue;
+            }
+
+            gltf_accessor pos;
+            if (!GltfParser::FindAttributeAccessor(gltf, primitive.attributes, "POSITION"_s, pos) ||
+                !IsFloatAccessor(pos, gltf_accessor_type::VEC3))
+            {
+                LOG("primitive without float3 POSITION in mesh " SV_FMT, SV_ARG(mesh.name));
+                return byteview{};
+            }
+
+            // Indices are local to the submesh, so only a single primitive can force 32-bit indices.
+            if (pos.count > 0x10000)
+                indexSize = 4;
+
+            ++submeshCount;
+            vertexCount += pos.count;
+            indexCount += primitive.indices == kGltfNone ? pos.count : gltf.accessors[primitive.indices].count;
+        }
+    }
+
+    if (!submeshCount || vertexCount > 0xFFFFFFFF || indexCount > 0xFFFFFFFF)
+        return byteview{};
+
+    const mesh_blob_vertex_format vertexFormat =
+        options.quantize ? mesh_blob_vertex_format::Quantized : mesh_blob_vertex_format::Float32;
+    const uint32_t vertexStride = options.quantize ? kMeshBlobQuantizedVertexStride : kMeshBlobFloat32VertexStride;
+
+    const uint32_t maxLods = Clamp(options.maxLods, 1u, kMeshBlobMaxLods);
+
+    // Sized for the authored vertex count, the fetch remap only ever drops unused vertices. Every level is at most
+    // as long as the full detail index buffer.
+    const uint64_t submeshOffset = sizeof(mesh_blob_header);
+    const uint64_t vertexOffset = AlignedUp(submeshOffset + submeshCount * sizeof(mesh_blob_submesh), 16);
+    const uint64_t indexOffset = AlignedUp(vertexOffset + vertexCount * vertexStride, 16);
+
+    span<uint8_t> dst = RegionAlloc::AllocArray<uint8_t>(alloc, indexOffset + indexCount * maxLods * indexSize);
+    auto allocMark = alloc.at;
+
+    auto &header = *(mesh_blob_header *)dst.data;
+    header = mesh_blob_header{
+        .magic = kMeshBlobMagic,
+        .vertexFormat = vertexFormat,
+        .vertexStride = vertexStride,
+        .vertexOffset = (uint32_t)vertexOffset,
+        .indexSize = indexSize,
+        .indexOffset = (uint32_t)indexOffset,
+        .submeshCount = submeshCount,
+    };
+
+    auto *submeshes = (mesh_blob_submesh *)(dst.data + submeshOffset);
+    uint8_t *indices = dst.data + indexOffset;
+    uint8_t *vertices = dst.data + vertexOffset;
+
+    uint32_t submeshIndex = 0;
+    uint32_t baseVertex = 0;
+    uint32_t firstIndex = 0;
+    float missesBefore = 0.f;
+    float missesAfter = 0.f;
+
+    for (gltf_mesh &mesh : gltf.meshes)
+    {
+        for (gltf_mesh_primitive &primitive : mesh.primitives)
+        {
+            if (!IsTriangles(primitive))
+                continue;
+
+            gltf_accessor pos;
+            GltfParser::FindAttributeAccessor(gltf, primitive.attributes, "POSITION"_s, pos);
+
+            gltf_accessor norm;
+            bool hasNorm = GltfParser::FindAttributeAccessor(gltf, primitive.attributes, "NORMAL"_s, norm) &&
+                           IsFloatAccessor(norm, gltf_accessor_type::VEC3) && norm.count == pos.count;
+
+            gltf_accessor texCoord;
+            bool hasTexCoord =
+                GltfParser::FindAttributeAccessor(gltf, primitive.attributes, "TEXCOORD_0"_s, texCoord) &&
+                IsFloatAccessor(texCoord, gltf_accessor_type::VEC2) && texCoord.count == pos.count;
+
+            mesh_blob_submesh &submesh = submeshes[submeshIndex++];
+            submesh = mesh_blob_submesh{
+                .baseVertex = baseVertex,
+            };
+
+            if (primitive.material != kGltfNone && primitive.material < gltf.materials.size)
+            {
+                const uint32_t texture = gltf.materials[primitive.material].baseColorTexture;
+                if (texture != kGltfNone && texture < gltf.textures.size)
+                {
+                    const uint32_t image = gltf.textures[texture].source;
+                    if (image < imageGuids.size)
+                        submesh.textureGuid = imageGuids[image];
+                }
+            }
+
+            span<float3> positions = RegionAlloc::AllocArray<float3>(alloc, pos.count);
+            for (uint32_t i = 0; i < pos.count; ++i)
+                MemCpy(positions[i].data, GltfParser::GetAccessorElement(gltf, pos, i), sizeof(float3));
+
+            const uint32_t primitiveIndexCount =
+                primitive.indices == kGltfNone ? pos.count : gltf.accessors[primitive.indices].count;
+            span<uint32_t> lodIndices =
+                RegionAlloc::AllocArray<uint32_t>(alloc, uint64_t{primitiveIndexCount} * maxLods);
+            span<uint32_t> primitiveIndices{lodIndices.data, primitiveIndexCount};
+
+            if (primitive.indices != kGltfNone)
+            {
+                const gltf_accessor &accessor = gltf.accessors[primitive.indices];
+                for (uint32_t i = 0; i < accessor.count; ++i)
+                {
+                    primitiveIndices[i] = ReadIndex(gltf, accessor, i);
+                    if (primitiveIndices[i] >= pos.count)
+                    {
+                        LOG("index out of range in mesh " SV_FMT, SV_ARG(mesh.name));
+                        return byteview{};
+                    }
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < pos.count; ++i)
+                    primitiveIndices[i] = i;
+            }
+
+            span<uint32_t> remap = RegionAlloc::AllocArray<uint32_t>(alloc, pos.count);
+            uint32_t primitiveVertexCount = pos.count;
+
+            const float triCount = float(primitiveIndexCount / 3);
+            missesBefore += MeshOptimize::SimulateAcmr(primitiveIndices, pos.count, alloc) * triCount;
+
+            if (options.optimize)
+            {
+                MeshOptimize::OptimizeVertexCache(primitiveIndices, pos.count, alloc);
+                MeshOptimize::OptimizeOverdraw(primitiveIndices, positions, 1.05f, alloc);
+            }
+
+            // Every level is simplified from the full detail one, so its error is measured against the original
+            // surface. Stop once a level saves less than a fifth of the triangles.
+            float3 extent{};
+            for (const float3 &p : positions)
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                    extent[axis] = Max(extent[axis], p[axis] < 0.f ? -p[axis] : p[axis]);
+            const float maxError = Vec::Len(extent) * options.lodMaxError;
+
+            uint32_t lodSize[kMeshBlobMaxLods] = {primitiveIndexCount};
+            float lodError[kMeshBlobMaxLods] = {};
+            uint32_t primitiveLods = 1;
+
+            for (uint32_t lod = 1; lod < maxLods; ++lod)
+            {
+                span<uint32_t> lodDst{lodIndices.data + uint64_t{lod} * primitiveIndexCount, primitiveIndexCount};
+                const uint32_t target = (primitiveIndexCount >> lod) / 3 * 3;
+
+                const uint32_t size = MeshOptimize::Simplify(lodDst, primitiveIndices, positions, target, maxError,
+                                                             lodError[lod], alloc);
+                if (!size || size * 5 > lodSize[lod - 1] * 4)
+                    break;
+
+                if (options.optimize)
+                    MeshOptimize::OptimizeVertexCache(span<uint32_t>{lodDst.data, size}, pos.count, alloc);
+
+                lodSize[lod] = size;
+                primitiveLods = lod + 1;
+            }
+
+            // Lower levels only reference vertices of the full detail one, its first use order covers them all.
+            if (options.optimize)
+            {
+                primitiveVertexCount = MeshOptimize::OptimizeVertexFetchRemap(remap, primitiveIndices);
+                for (uint32_t lod = 1; lod < primitiveLods; ++lod)
+                {
+                    uint32_t *lodDst = lodIndices.data + uint64_t{lod} * primitiveIndexCount;
+                    for (uint32_t i = 0; i < lodSize[lod]; ++i)
+                        lodDst[i] = remap[lodDst[i]];
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < pos.count; ++i)
+                    remap[i] = i;
+            }
+
+            missesAfter += MeshOptimize::SimulateAcmr(primitiveIndices, primitiveVertexCount, alloc) * triCount;
+
+            for (uint32_t lod = 0; lod < kMeshBlobMaxLods; ++lod)
+            {
+                // Submeshes that stopped early repeat their last level.
+                if (lod >= primitiveLods)
+                {
+                    submesh.lods[lod] = submesh.lods[primitiveLods - 1];
+                    header.lodError[lod] = Max(header.lodError[lod], lodError[primitiveLods - 1]);
+                    continue;
+                }
+
+                const uint32_t *src = lodIndices.data + uint64_t{lod} * primitiveIndexCount;
+                for (uint32_t i = 0; i < lodSize[lod]; ++i)
+                {
+                    if (indexSize == 2)
+                        ((uint16_t *)indices)[firstIndex + i] = (uint16_t)src[i];
+                    else
+                        ((uint32_t *)indices)[firstIndex + i] = src[i];
+                }
+
+                submesh.lods[lod] = mesh_blob_lod{
+                    .firstIndex = firstIndex,
+                    .indexCount = lodSize[lod],
+                };
+                header.lodError[lod] = Max(header.lodError[lod], lodError[lod]);
+                header.lodCount = Max(header.lodCount, lod + 1);
+                firstIndex += lodSize[lod];
+            }
+
+            bool first = true;
+            for (uint32_t i = 0; i < pos.count; ++i)
+            {
+                if (remap[i] == MeshOptimize::kUnusedVertex)
+                    continue;
+
+                const float3 &p = positions[i];
+
+                float3 n{0.f, 0.f, 1.f};
+                if (hasNorm)
+                    MemCpy(n.data, GltfParser::GetAccessorElement(gltf, norm, i), sizeof(float3));
+                const float2 oct = MeshOptimize::EncodeOctahedral(n);
+
+                float2 uv{};
+                if (hasTexCoord)
+                    MemCpy(uv.data, GltfParser::GetAccessorElement(gltf, texCoord, i), sizeof(float2));
+
+                uint8_t *v = vertices + uint64_t{baseVertex + remap[i]} * vertexStride;
+                if (options.quantize)
+                {
+                    const uint16_t half4[4] = {
+                        MeshOptimize::QuantizeHalf(p[0]),
+                        MeshOptimize::QuantizeHalf(p[1]),
+                        MeshOptimize::QuantizeHalf(p[2]),
+                        MeshOptimize::QuantizeHalf(1.f),
+                    };
+                    const int16_t snorm2[2] = {MeshOptimize::QuantizeSnorm16(oct[0]),
+                                               MeshOptimize::QuantizeSnorm16(oct[1])};
+                    const uint16_t half2[2] = {MeshOptimize::QuantizeHalf(uv[0]), MeshOptimize::QuantizeHalf(uv[1])};
+
+                    MemCpy(v, half4, sizeof(half4));
+                    MemCpy(v + 8, snorm2, sizeof(snorm2));
+                    MemCpy(v + 12, half2, sizeof(half2));
+                }
+                else
+                {
+                    MemCpy(v, p.data, sizeof(float3));
+                    MemCpy(v + 12, oct.data, sizeof(float2));
+                    MemCpy(v + 20, uv.data, sizeof(float2));
+                }
+
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    submesh.boundsMin[axis] = first ? p[axis] : Min(submesh.boundsMin[axis], p[axis]);
+                    submesh.boundsMax[axis] = first ? p[axis] : Max(submesh.boundsMax[axis], p[axis]);
+                }
+                first = false;
+            }
+
+            submesh.vertexCount = primitiveVertexCount;
+            baseVertex += primitiveVertexCount;
+
+            const bool firstSubmesh = submeshIndex == 1;
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                const float lo = submesh.boundsMin[axis];
+                const float hi = submesh.boundsMax[axis];
+                header.boundsMin[axis] = firstSubmesh ? lo : Min(header.boundsMin[axis], lo);
+                header.boundsMax[axis] = firstSubmesh ? hi : Max(header.boundsMax[axis], hi);
+            }
+
+            RegionAlloc::Reset(alloc, allocMark);
+        }
+    }
+
+    header.vertexCount = baseVertex;
+    header.indexCount = firstIndex;
+
+    const float tris = float(indexCount / 3);
+    LOG("mesh cooked: %u submeshes, %u lods, ACMR %f -> %f, vertex bytes %" PRIu64 " -> %" PRIu64, submeshCount,
+        header.lodCount, tris > 0.f ? missesBefore / tris : 0.f, tris > 0.f ? missesAfter / tris : 0.f,
+        vertexCount * kAuthoredVertexStride, uint64_t{baseVertex} * vertexStride);
+    for (uint32_t lod = 1; lod < header.lodCount; ++lod)
+        LOG("    lod %u error %f", lod, header.lodError[lod]);
+
+    const uint64_t totalSize = AlignedUp(indexOffset + uint64_t{firstIndex} * indexSize, 8);
+    return byteview{dst.data, totalSize};
+}
+
+} // namespace nyla
\ No newline at end of file
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+
+#include "nyla/commons/asset_file_format.h"
+#include "nyla/commons/gltf.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/region_alloc_def.h"
 #include "nyla/commons/span_def.h"
@@ -12,4 +16,18 @@ namespace nyla
 // allocated in `alloc`. Returns an empty byteview on decode failure.
 auto API ImportTextureFromPngOrJpg(byteview rawBytes, region_alloc &alloc) -> byteview;
 
+struct mesh_import_options
+{
+    bool optimize = true; // vertex cache, overdraw and vertex fetch order
+    bool quantize = true; // mesh_blob_vertex_format::Quantized instead of Float32
+    uint32_t maxLods = kMeshBlobMaxLods; // 1 disables simplification
+    float lodMaxError = .1f;             // relative to the submesh extent
+};
+
+// Cook a parsed glTF (json and bin chunk set) into the mesh blob format (mesh_blob_header, submeshes, interleaved
+// vertices, indices of every lod). Every triangle primitive of every mesh becomes a submesh. imageGuids maps glTF
+// image indices to texture asset guids, 0 for unknown. Returns an empty byteview on failure.
+auto API ImportMeshFromGltf(gltf_parser &gltf, span<const uint64_t> imageGuids, const mesh_import_options &options,
+                            region_alloc &alloc) -> byteview;
+
 } // namespace nyla
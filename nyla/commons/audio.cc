@@ -4,14 +4,20 @@
 #include "nyla/commons/asset_manager.h"
 #include "nyla/commons/fmt.h"
 #include "nyla/commons/handle_pool.h"
+#include "nyla/commons/intrin.h"
 #include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/platform.h"
 #include "nyla/commons/platform_audio.h"
-#include "nyla/commons/platform_mutex.h"
+#include "nyla/commons/platform_thread.h"
+#include "nyla/commons/qoa.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/wave.h"
 
 #include <cinttypes>
 #include <cstdint>
+#include <immintrin.h>
 
 namespace nyla
 {
@@ -19,15 +25,110 @@ namespace nyla
 namespace
 {
 
+constexpr uint32_t kMaxVoices = kAudioMaxVoices;
+constexpr uint32_t kVoiceIndexBits = 10;
+static_assert(kMaxVoices == 1u << kVoiceIndexBits);
+constexpr uint32_t kCommandRingSize = 2048;
+constexpr uint32_t kMixChunkFrames = 512;
+constexpr uint32_t kMaxChannels = 8;
+
+constexpr uint32_t kSincTaps = 32;
+constexpr uint32_t kSincPhases = 256;
+constexpr uint32_t kMaxResampleBanks = 8;
+constexpr uint32_t kCubicTaps = 4;
+constexpr float kPi = 3.14159265f;
+
+constexpr uint32_t kMaxStreams = 16;
+constexpr uint32_t kStreamRingFrames = kAudioStreamRingFrames;
+constexpr uint32_t kStreamMaxChannels = 2;
+constexpr uint32_t kStreamMargin = kSincTaps / 2; // frames either side of a piece the resampler may touch
+constexpr uint32_t kStreamStageFrames = 2048;
+constexpr uint32_t kDecodeIntervalMs = 5;
+
+// Below one LSB of the output at full scale.
+constexpr float kInaudibleGain = 1.f / 32768;
+
+// Rows of kSincTaps coefficients for fractional offsets 0, 1/kSincPhases, ... 1. Tap k weights source frame
+// floor(position) - kSincTaps / 2 + 1 + k, the extra last row lets the mixer interpolate between neighboring phases.
+struct resample_bank
+{
+    uint32_t srcRate;
+    alignas(32) float coeffs[(kSincPhases + 1) * kSincTaps];
+};
+
+enum class stream_state : uint32_t
+{
+    Free,     // the game thread may claim it
+    Decoding, // owned by a voice, the decoder keeps the ring ahead of the mixer
+    Retiring, // the mixer let go of it, the decoder hands it back
+};
+
+// Frames count from the start of playback and keep counting through loops, frame n lives in the ring at
+// n % kStreamRingFrames. The decoder publishes written, the mixer publishes consumed, everything before it may be
+// overwritten. A one shot gets kStreamMargin frames of silence after its end.
+struct audio_stream
+{
+    uint32_t state;
+    byteview blob;
+    qoa_desc desc;
+    bool loop;
+    uint64_t nextOffset; // of the next QOA frame to decode
+    bool finished;
+
+    alignas(64) uint64_t written;
+    alignas(64) uint64_t consumed;
+    alignas(32) int16_t ring[kStreamRingFrames * kStreamMaxChannels];
+};
+
+enum class audio_command_kind : uint32_t
+{
+    Play,
+    Stop,
+    SetVolume,
+    SetMasterVolume,
+    SetVoiceBudget,
+};
+
+struct audio_command
+{
+    audio_command_kind kind;
+    voice v;
+    float volume;
+    bool loop;
+    uint8_t priority;
+    uint32_t voiceBudget;
+    audio_clip clip;
+    const resample_bank *bank; // null when the clip plays at the device rate or with the cubic tier
+    audio_stream *stream;
+};
+
+// Owned by the mixer. gen is zero while the voice is idle. Clips at the device rate advance cursor a frame at a time,
+// resampled ones advance position, 32.32 fixed point in source frames, by step per device frame. Streams always
+// advance position. A voice that is not real this chunk advances the same way without being mixed.
 struct voice_data
 {
     const int16_t *samples;
     uint32_t numFrames;
-    uint32_t sampleRate;
-    uint16_t channels;
     uint32_t cursor;
+    uint32_t gen;
+    uint16_t channels;
+    float volume;
+    bool loop;
+    uint8_t priority;
+    bool real;
+
+    uint64_t position;
+    uint64_t step;
+    const resample_bank *bank; // null for the cubic tier
+    audio_stream *stream;      // null for a resident clip
+};
+
+// What the game thread remembers about a voice it handed out.
+struct voice_info
+{
     float volume;
     bool loop;
+    uint8_t priority;
 };
 
 struct clip_slot
@@ -36,87 +137,912 @@ struct clip_slot
     audio_clip clip;
 };
 
+// The game thread owns the handle pools and produces commands, the mixer owns the voices and consumes them. A one
+// shot voice that runs out is reported back through doneGen, the game thread frees its handle the next time it looks.
+// Streams are shared by all three threads, see audio_stream.
 struct audio_state
 {
-    handle_pool<voice, voice_data, 64> voices;
+    handle_pool<voice, voice_info, kMaxVoices> voices;
     handle_pool<audio_clip_handle, clip_slot, 64> clips;
-    platform_mutex *mutex;
     uint32_t deviceSampleRate;
     uint32_t deviceChannels;
+    bool headless;
+    resample_bank *banks[kMaxResampleBanks];
+    uint32_t bankCount;
+    int16_t primeScratch[(kQoaFrameLen + kStreamMargin) * kStreamMaxChannels];
+
+    audio_stream streams[kMaxStreams];
+    platform_thread *decoder;
+    uint32_t decoderQuit;
+    int16_t decodeScratch[(kQoaFrameLen + kStreamMargin) * kStreamMaxChannels];
+
+    alignas(64) uint32_t commandHead;
+    alignas(64) uint32_t commandTail;
+    audio_command commands[kCommandRingSize];
+
+    uint64_t stolenVoices;
+    uint64_t droppedVoices;
+
+    alignas(64) uint32_t doneGen[kMaxVoices];
+    voice_data mixVoices[kMaxVoices];
+    uint16_t activeVoices[kMaxVoices]; // indices into mixVoices, finished ones drop out at the next chunk
+    uint32_t activeCount;
+    bool listed[kMaxVoices];
     float masterVolume;
+    uint32_t voiceBudget;
+    uint64_t ranks[kMaxVoices];
+    alignas(64) uint32_t playingVoices;
+    uint32_t realVoices;
+    uint64_t streamStarves;
+    alignas(32) float accum[kMixChunkFrames * kMaxChannels];
+    alignas(32) int16_t stage[kStreamStageFrames * kStreamMaxChannels];
 };
 audio_state *audio;
 
-void MixCallback(void *, int16_t *out, uint32_t numFrames)
+void PushCommand(const audio_command &cmd)
 {
-    PlatformMutex::Lock(*audio->mutex);
+    const uint32_t head = audio->commandHead;
+    while (head - AtomicLoad32(&audio->commandTail) == kCommandRingSize)
+    {
+        ASSERT(!audio->headless, "audio command ring full, nothing calls Audio::Mix");
+        CpuRelax();
+    }
 
-    const uint32_t outCh = audio->deviceChannels;
-    const float master = audio->masterVolume;
+    audio->commands[head & (kCommandRingSize - 1)] = cmd;
+    AtomicStore32(&audio->commandHead, head + 1);
+}
 
-    for (uint32_t i = 0; i < numFrames * outCh; ++i)
-        out[i] = 0;
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+auto BesselI0(double x) -> double
+{
+    double sum = 1;
+    double term = 1;
+    for (uint32_t k = 1; k < 32; ++k)
+    {
+        const double half = x / (2 * k);
+        term *= half * half;
+        sum += term;
+    }
+    return sum;
+}
 
-    for (uint32_t i = 0; i < HandlePool::Capacity(audio->voices); ++i)
+// Built by the game thread the first time a rate shows up and never freed, the Play command that publishes the
+// pointer also publishes the coefficients.
+auto GetResampleBank(uint32_t srcRate) -> const resample_bank *
+{
+    for (uint32_t i = 0; i < audio->bankCount; ++i)
+    {
+        if (audio->banks[i]->srcRate == srcRate)
+            return audio->banks[i];
+    }
+    ASSERT(audio->bankCount < kMaxResampleBanks, "too many distinct clip sample rates");
+
+    resample_bank &bank = RegionAlloc::Alloc<resample_bank>(RegionAlloc::g_BootstrapAlloc);
+    bank.srcRate = srcRate;
+
+    // 32 taps with beta 7 leave a transition band of about 0.14 cycles per source frame and a stopband near -70 dB.
+    // Centering it half a band below the lower Nyquist frequency keeps images and aliases in the stopband.
+    constexpr double kBeta = 7.0;
+    constexpr double kHalfLength = kSincTaps / 2;
+    const double scale = Min(1.0, (double)audio->deviceSampleRate / srcRate);
+    const double cutoff = scale * 0.5 - 0.07;
+    const double windowNorm = 1.0 / BesselI0(kBeta);
+
+    for (uint32_t phase = 0; phase <= kSincPhases; ++phase)
+    {
+        float *row = bank.coeffs + phase * kSincTaps;
+        const double frac = (double)phase / kSincPhases;
+
+        double sum = 0;
+        for (uint32_t k = 0; k < kSincTaps; ++k)
+        {
+            const double t = (double)k - (kHalfLength - 1) - frac;
+            const double x = 2 * cutoff * t;
+            const double sinc = x == 0 ? 1.0 : Sin((float)(kPi * x)) / (kPi * x);
+            const double r = t / kHalfLength;
+            const double window = r * r < 1 ? BesselI0(kBeta * Sqrt((float)(1 - r * r))) * windowNorm : 0;
+
+            row[k] = (float)(2 * cutoff * sinc * window);
+            sum += row[k];
+        }
+        for (uint32_t k = 0; k < kSincTaps; ++k)
+            row[k] = (float)(row[k] / sum);
+    }
+
+    audio->banks[audio->bankCount++] = &bank;
+    return &bank;
+}
+
+// Frees the handles of one shot voices the mixer has finished.
+void ReapVoices()
+{
+    for (uint32_t i = 0; i < kMaxVoices; ++i)
     {
         auto &slot = audio->voices[i];
-        if (!slot.used)
+        if (slot.used && AtomicLoad32(&audio->doneGen[i]) == slot.gen)
+            HandlePool::Free(slot);
+    }
+}
+
+// Orders voices by priority and then by gain. The master volume scales every voice alike, so it does not change the
+// order. Positive floats order like their bits.
+INLINE auto Importance(uint8_t priority, float gain) -> uint64_t
+{
+    uint32_t bits;
+    MemCpy(&bits, &gain, sizeof(bits));
+    return ((uint64_t)priority << 31) | (bits & 0x7FFFFFFF);
+}
+
+// A handle for a new voice. With every handle taken, the least important voice makes room unless it matters at least
+// as much as the new one. Finished voices only give back their handles here, so the common case is a single scan.
+auto AcquireVoice(const voice_info &info, voice &out) -> bool
+{
+    if (HandlePool::TryAcquire(audio->voices, info, out))
+        return true;
+
+    ReapVoices();
+    if (HandlePool::TryAcquire(audio->voices, info, out))
+        return true;
+
+    uint32_t victim = kMaxVoices;
+    uint64_t victimImportance = Importance(info.priority, info.volume);
+    for (uint32_t i = 0; i < kMaxVoices; ++i)
+    {
+        const auto &slot = audio->voices[i];
+        const uint64_t importance = Importance(slot.data.priority, slot.data.volume);
+        if (importance < victimImportance)
+        {
+            victim = i;
+            victimImportance = importance;
+        }
+    }
+    if (victim == kMaxVoices)
+        return false;
+
+    auto &slot = audio->voices[victim];
+    voice stolen{};
+    stolen.gen = slot.gen;
+    stolen.index = victim;
+    HandlePool::Free(slot);
+    PushCommand({.kind = audio_command_kind::Stop, .v = stolen});
+    ++audio->stolenVoices;
+
+    ASSERT(HandlePool::TryAcquire(audio->voices, info, out));
+    return true;
+}
+
+// Decodes up to maxQoaFrames whole QOA frames while they fit in the ring. Runs on the decoder thread, except for
+// the first frame which the game thread decodes before the slot is published.
+void FillStream(audio_stream &s, int16_t *scratch, uint32_t maxQoaFrames)
+{
+    const uint32_t channels = s.desc.channels;
+    uint64_t written = s.written;
+    for (uint32_t i = 0; i < maxQoaFrames && !s.finished; ++i)
+    {
+        if (written - AtomicLoad64(&s.consumed) + kQoaFrameLen + kStreamMargin > kStreamRingFrames)
+            break;
+
+        uint32_t numFrames = 0;
+        const uint64_t next = Qoa::DecodeFrame(s.blob, s.desc, s.nextOffset, scratch, numFrames);
+        ASSERT(next, "corrupt qoa stream");
+
+        if (next < s.blob.size)
+        {
+            s.nextOffset = next;
+        }
+        else if (s.loop)
+        {
+            s.nextOffset = kQoaFileHeaderSize;
+        }
+        else
+        {
+            MemZero(scratch + numFrames * channels, kStreamMargin * channels * sizeof(int16_t));
+            numFrames += kStreamMargin;
+            s.finished = true;
+        }
+
+        const uint32_t at = (uint32_t)(written & (kStreamRingFrames - 1));
+        const uint32_t first = Min(numFrames, kStreamRingFrames - at);
+        MemCpy(s.ring + at * channels, scratch, first * channels * sizeof(int16_t));
+        MemCpy(s.ring, scratch + first * channels, (numFrames - first) * channels * sizeof(int16_t));
+
+        written += numFrames;
+        AtomicStore64(&s.written, written);
+    }
+}
+
+auto StartStream(const audio_clip &clip, bool loop) -> audio_stream *
+{
+    for (audio_stream &s : audio->streams)
+    {
+        if (AtomicLoad32(&s.state) != (uint32_t)stream_state::Free)
             continue;
 
-        voice_data &v = slot.data;
-        uint32_t framesProduced = 0;
+        s.blob = clip.stream;
+        ASSERT(Qoa::ParseHeader(s.blob, s.desc));
+        s.loop = loop;
+        s.nextOffset = kQoaFileHeaderSize;
+        s.finished = false;
+        s.written = 0;
+        s.consumed = 0;
 
-        while (framesProduced < numFrames)
+        // So the voice has something to play before the decoder first looks at it.
+        FillStream(s, audio->primeScratch, 1);
+        AtomicStore32(&s.state, (uint32_t)stream_state::Decoding);
+        return &s;
+    }
+    return nullptr;
+}
+
+void DecodeStreams()
+{
+    for (audio_stream &s : audio->streams)
+    {
+        const uint32_t state = AtomicLoad32(&s.state);
+        if (state == (uint32_t)stream_state::Decoding)
+            FillStream(s, audio->decodeScratch, UINT32_MAX);
+        else if (state == (uint32_t)stream_state::Retiring)
+            AtomicStore32(&s.state, (uint32_t)stream_state::Free);
+    }
+}
+
+void DecoderMain(void *)
+{
+    while (!AtomicLoad32(&audio->decoderQuit))
+    {
+        DecodeStreams();
+        Sleep(kDecodeIntervalMs);
+    }
+}
+
+// The voice stops on the mixer side, its stream goes back to the decoder.
+void ReleaseVoice(voice_data &v)
+{
+    if (v.stream)
+        AtomicStore32(&v.stream->state, (uint32_t)stream_state::Retiring);
+    v.stream = nullptr;
+    v.gen = 0;
+}
+
+void ApplyCommand(const audio_command &cmd)
+{
+    voice_data &v = audio->mixVoices[cmd.v.index];
+    switch (cmd.kind)
+    {
+    case audio_command_kind::Play: {
+        if (!audio->listed[cmd.v.index])
         {
-            if (v.cursor >= v.numFrames)
+            audio->listed[cmd.v.index] = true;
+            audio->activeVoices[audio->activeCount++] = (uint16_t)cmd.v.index;
+        }
+        v = voice_data{
+            .samples = cmd.clip.samples,
+            .numFrames = cmd.clip.numFrames,
+            .cursor = 0,
+            .gen = cmd.v.gen,
+            .channels = cmd.clip.channels,
+            .volume = cmd.volume,
+            .loop = cmd.loop,
+            .priority = cmd.priority,
+            .position = 0,
+            .step = cmd.clip.sampleRate == audio->deviceSampleRate
+                        ? 0
+                        : ((uint64_t)cmd.clip.sampleRate << 32) / audio->deviceSampleRate,
+            .bank = cmd.bank,
+            .stream = cmd.stream,
+        };
+        break;
+    }
+    case audio_command_kind::Stop: {
+        if (v.gen == cmd.v.gen)
+            ReleaseVoice(v);
+        break;
+    }
+    case audio_command_kind::SetVolume: {
+        if (v.gen == cmd.v.gen)
+            v.volume = cmd.volume;
+        break;
+    }
+    case audio_command_kind::SetMasterVolume: {
+        audio->masterVolume = cmd.volume;
+        break;
+    }
+    case audio_command_kind::SetVoiceBudget: {
+        audio->voiceBudget = cmd.voiceBudget;
+        break;
+    }
+    }
+}
+
+void DrainCommands()
+{
+    const uint32_t head = AtomicLoad32(&audio->commandHead);
+    uint32_t tail = audio->commandTail;
+    for (; tail != head; ++tail)
+        ApplyCommand(audio->commands[tail & (kCommandRingSize - 1)]);
+    AtomicStore32(&audio->commandTail, tail);
+}
+
+INLINE auto LoadSamples(const int16_t *src) -> __m256
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)src)));
+}
+
+// Source and destination interleave the same channels, count is in samples.
+void AccumulateSameLayout(float *dst, const int16_t *src, uint32_t count, float gain)
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(LoadSamples(src + i), g)));
+    for (; i < count; ++i)
+        dst[i] += (float)src[i] * gain;
+}
+
+void AccumulateMonoToStereo(float *dst, const int16_t *src, uint32_t numFrames, float gain)
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    uint32_t f = 0;
+    for (; f + 8 <= numFrames; f += 8)
+    {
+        const __m256 s = _mm256_mul_ps(LoadSamples(src + f), g);
+        const __m256 lo = _mm256_unpacklo_ps(s, s); // 0 0 1 1 | 4 4 5 5
+        const __m256 hi = _mm256_unpackhi_ps(s, s); // 2 2 3 3 | 6 6 7 7
+        float *d = dst + f * 2;
+        _mm256_storeu_ps(d, _mm256_add_ps(_mm256_loadu_ps(d), _mm256_permute2f128_ps(lo, hi, 0x20)));
+        _mm256_storeu_ps(d + 8, _mm256_add_ps(_mm256_loadu_ps(d + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+    }
+    for (; f < numFrames; ++f)
+    {
+        const float s = (float)src[f] * gain;
+        dst[f * 2 + 0] += s;
+        dst[f * 2 + 1] += s;
+    }
+}
+
+// Mono goes to every channel, extra output channels repeat the last source channel.
+void AccumulateAnyLayout(float *dst, uint32_t outCh, const int16_t *src, uint32_t srcCh, uint32_t numFrames,
+                         float gain)
+{
+    for (uint32_t f = 0; f < numFrames; ++f)
+    {
+        for (uint32_t c = 0; c < outCh; ++c)
+            dst[f * outCh + c] += (float)src[f * srcCh + Min(c, srcCh - 1)] * gain;
+    }
+}
+
+// Frames around the edges of the clip, wrapped for a loop and silence for a one shot.
+auto GatherWindow(const voice_data &v, int64_t first, uint32_t count, int16_t *scratch) -> const int16_t *
+{
+    const int64_t n = v.numFrames;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        int64_t at = first + i;
+        if (v.loop)
+            at = (at % n + n) % n;
+        for (uint32_t c = 0; c < v.channels; ++c)
+            scratch[i * v.channels + c] = at >= 0 && at < n ? v.samples[at * v.channels + c] : 0;
+    }
+    return scratch;
+}
+
+// count frames of the clip starting at first, the clip itself unless the window crosses an edge.
+INLINE auto Window(const voice_data &v, int64_t first, uint32_t count, int16_t *scratch) -> const int16_t *
+{
+    if (first >= 0 && first + count <= v.numFrames) [[likely]]
+        return v.samples + first * v.channels;
+    return GatherWindow(v, first, count, scratch);
+}
+
+INLINE auto LerpCoeffs(const float *c0, const float *c1, __m256 t) -> __m256
+{
+    const __m256 a = _mm256_load_ps(c0);
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(c1), a), t));
+}
+
+// One output frame of every source channel from the kSincTaps frames at w. Mono and stereo, the common cases, are
+// vectorized, Ch is zero for any other channel count.
+template <uint32_t Ch>
+INLINE void SincTaps(const int16_t *w, const resample_bank &bank, uint32_t frac, uint32_t channels, float *out)
+{
+    const float *c0 = bank.coeffs + (frac >> 24) * kSincTaps;
+    const float *c1 = c0 + kSincTaps;
+    const float tf = (float)(frac & 0xFFFFFF) * (1.f / (1 << 24));
+    const __m256 t = _mm256_set1_ps(tf);
+
+    if constexpr (Ch == 1)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        for (uint32_t k = 0; k < kSincTaps; k += 8)
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(LoadSamples(w + k), LerpCoeffs(c0 + k, c1 + k, t)));
+
+        __m128 x = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+        out[0] = _mm_cvtss_f32(_mm_add_ss(x, _mm_shuffle_ps(x, x, 1)));
+    }
+    else if constexpr (Ch == 2)
+    {
+        // Same duplication of the coefficients as AccumulateMonoToStereo, the sum ends up as L R L R ...
+        __m256 acc = _mm256_setzero_ps();
+        for (uint32_t k = 0; k < kSincTaps; k += 8)
+        {
+            const __m256 c = LerpCoeffs(c0 + k, c1 + k, t);
+            const __m256 lo = _mm256_unpacklo_ps(c, c);
+            const __m256 hi = _mm256_unpackhi_ps(c, c);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(LoadSamples(w + k * 2), _mm256_permute2f128_ps(lo, hi, 0x20)));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(LoadSamples(w + k * 2 + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+        }
+
+        __m128 x = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+        out[0] = _mm_cvtss_f32(x);
+        out[1] = _mm_cvtss_f32(_mm_shuffle_ps(x, x, 1));
+    }
+    else
+    {
+        float c[kSincTaps];
+        for (uint32_t k = 0; k < kSincTaps; ++k)
+            c[k] = c0[k] + (c1[k] - c0[k]) * tf;
+        for (uint32_t ch = 0; ch < channels; ++ch)
+        {
+            float sum = 0;
+            for (uint32_t k = 0; k < kSincTaps; ++k)
+                sum += (float)w[k * channels + ch] * c[k];
+            out[ch] = sum;
+        }
+    }
+}
+
+INLINE void CubicTaps(const int16_t *w, uint32_t frac, uint32_t channels, float *out)
+{
+    const float t = (float)frac * (1.f / 4294967296.f);
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        const float p0 = w[c];
+        const float p1 = w[channels + c];
+        const float p2 = w[channels * 2 + c];
+        const float p3 = w[channels * 3 + c];
+        out[c] = p1 + 0.5f * t * (p2 - p0 + t * (2 * p0 - 5 * p1 + 4 * p2 - p3 + t * (3 * (p1 - p2) + p3 - p0)));
+    }
+}
+
+INLINE auto Low16(__m256i x) -> __m256
+{
+    return _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16));
+}
+
+INLINE auto High16(__m256i x) -> __m256
+{
+    return _mm256_cvtepi32_ps(_mm256_srai_epi32(x, 16));
+}
+
+INLINE auto CubicLanes(__m256 p0, __m256 p1, __m256 p2, __m256 p3, __m256 t) -> __m256
+{
+    const __m256 a = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(3.f), _mm256_sub_ps(p1, p2)), p3), p0);
+    __m256 b = _mm256_sub_ps(_mm256_add_ps(p0, p0), _mm256_mul_ps(_mm256_set1_ps(5.f), p1));
+    b = _mm256_sub_ps(_mm256_add_ps(b, _mm256_mul_ps(_mm256_set1_ps(4.f), p2)), p3);
+    const __m256 c = _mm256_sub_ps(p2, p0);
+    const __m256 poly = _mm256_add_ps(c, _mm256_mul_ps(t, _mm256_add_ps(b, _mm256_mul_ps(t, a))));
+    return _mm256_add_ps(p1, _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), t), poly));
+}
+
+// Eight stereo device frames of a mono or stereo clip whose four point windows all lie inside it. One 32 bit gather
+// per tap fetches a frame of stereo, or two neighboring samples of mono.
+template <uint32_t Ch>
+INLINE void CubicBlock(const int16_t *samples, uint64_t &position, uint64_t step, float *dst, __m256 gain)
+{
+    alignas(32) int32_t index[8];
+    alignas(32) int32_t frac[8];
+    for (uint32_t i = 0; i < 8; ++i, position += step)
+    {
+        index[i] = (int32_t)(position >> 32) - 1;
+        frac[i] = (int32_t)((uint32_t)position >> 8);
+    }
+    const __m256i at = _mm256_load_si256((const __m256i *)index);
+    const __m256 t =
+        _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_load_si256((const __m256i *)frac)), _mm256_set1_ps(1.f / (1 << 24)));
+
+    __m256 left;
+    __m256 right;
+    if constexpr (Ch == 1)
+    {
+        const __m256i p01 = _mm256_i32gather_epi32((const int *)samples, at, 2);
+        const __m256i p23 = _mm256_i32gather_epi32((const int *)(samples + 2), at, 2);
+        left = right = _mm256_mul_ps(CubicLanes(Low16(p01), High16(p01), Low16(p23), High16(p23), t), gain);
+    }
+    else
+    {
+        const __m256i f0 = _mm256_i32gather_epi32((const int *)samples, at, 4);
+        const __m256i f1 = _mm256_i32gather_epi32((const int *)(samples + 2), at, 4);
+        const __m256i f2 = _mm256_i32gather_epi32((const int *)(samples + 4), at, 4);
+        const __m256i f3 = _mm256_i32gather_epi32((const int *)(samples + 6), at, 4);
+        left = _mm256_mul_ps(CubicLanes(Low16(f0), Low16(f1), Low16(f2), Low16(f3), t), gain);
+        right = _mm256_mul_ps(CubicLanes(High16(f0), High16(f1), High16(f2), High16(f3), t), gain);
+    }
+
+    const __m256 lo = _mm256_unpacklo_ps(left, right); // L0 R0 L1 R1 | L4 R4 L5 R5
+    const __m256 hi = _mm256_unpackhi_ps(left, right); // L2 R2 L3 R3 | L6 R6 L7 R7
+    _mm256_storeu_ps(dst, _mm256_add_ps(_mm256_loadu_ps(dst), _mm256_permute2f128_ps(lo, hi, 0x20)));
+    _mm256_storeu_ps(dst + 8, _mm256_add_ps(_mm256_loadu_ps(dst + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+}
+
+using resample_fn = void (*)(voice_data &v, float *dst, uint32_t outCh, uint32_t numFrames, float gain);
+
+// numFrames device frames that all lie before the end of the clip. The sinc filter dominates its cost, so the channel
+// mapping stays scalar there. The cubic tier is cheap enough per frame that mono and stereo go eight frames at a time.
+template <uint32_t Ch, bool Sinc>
+void Resample(voice_data &v, float *dst, uint32_t outCh, uint32_t numFrames, float gain)
+{
+    constexpr uint32_t kTaps = Sinc ? kSincTaps : kCubicTaps;
+    const uint32_t channels = Ch ? Ch : v.channels;
+    const uint64_t step = v.step;
+    uint64_t position = v.position;
+
+    int16_t scratch[kTaps * kMaxChannels];
+    float s[kMaxChannels];
+    for (uint32_t f = 0; f < numFrames;)
+    {
+        if constexpr (!Sinc && Ch != 0)
+        {
+            if (outCh == 2 && f + 8 <= numFrames)
             {
-                if (v.loop)
-                {
-                    v.cursor = 0;
-                }
-                else
+                const int64_t first = (int64_t)(position >> 32) - 1;
+                const int64_t last = (int64_t)((position + 7 * step) >> 32) + 2;
+                if (first >= 0 && last < v.numFrames)
                 {
-                    HandlePool::Free(slot);
-                    break;
+                    CubicBlock<Ch>(v.samples, position, step, dst, _mm256_set1_ps(gain));
+                    f += 8;
+                    dst += 16;
+                    continue;
                 }
             }
+        }
+
+        const int64_t first = (int64_t)(position >> 32) - (kTaps / 2 - 1);
+        const int16_t *w = Window(v, first, kTaps, scratch);
+        if constexpr (Sinc)
+            SincTaps<Ch>(w, *v.bank, (uint32_t)position, channels, s);
+        else
+            CubicTaps(w, (uint32_t)position, channels, s);
+
+        if (outCh == 2)
+        {
+            dst[0] += s[0] * gain;
+            dst[1] += s[channels > 1] * gain;
+        }
+        else
+        {
+            for (uint32_t c = 0; c < outCh; ++c)
+                dst[c] += s[Min(c, channels - 1)] * gain;
+        }
+
+        ++f;
+        position += step;
+        dst += outCh;
+    }
+    v.position = position;
+}
+
+template <bool Sinc> auto ResampleFor(uint32_t channels) -> resample_fn
+{
+    if (channels == 1)
+        return &Resample<1, Sinc>;
+    if (channels == 2)
+        return &Resample<2, Sinc>;
+    return &Resample<0, Sinc>;
+}
+
+void MixResampled(voice_data &v, uint32_t voiceIndex, float *accum, uint32_t numFrames, uint32_t outCh, float gain)
+{
+    const resample_fn resample = v.bank ? ResampleFor<true>(v.channels) : ResampleFor<false>(v.channels);
+    const uint64_t end = (uint64_t)v.numFrames << 32;
+
+    for (uint32_t f = 0; f < numFrames;)
+    {
+        if (v.position >= end)
+        {
+            if (!v.loop || !end)
+            {
+                AtomicStore32(&audio->doneGen[voiceIndex], v.gen);
+                v.gen = 0;
+                return;
+            }
+            v.position %= end;
+        }
+
+        // Up to the end of the clip, where a loop wraps or a one shot stops.
+        const uint64_t untilEnd = (end - v.position + v.step - 1) / v.step;
+        const uint32_t count = (uint32_t)Min<uint64_t>(numFrames - f, untilEnd);
+        resample(v, accum + f * outCh, outCh, count, gain);
+        f += count;
+    }
+}
+
+// Frames first .. first + count of the stream into the staging buffer, silence before playback started.
+auto Stage(const audio_stream &s, int64_t first, uint32_t count) -> const int16_t *
+{
+    const uint32_t channels = s.desc.channels;
+    int16_t *dst = audio->stage;
+    if (first < 0)
+    {
+        const uint32_t silent = Min((uint32_t)-first, count);
+        MemZero(dst, silent * channels * sizeof(int16_t));
+        dst += silent * channels;
+        count -= silent;
+        first = 0;
+    }
+
+    const uint32_t at = (uint32_t)((uint64_t)first & (kStreamRingFrames - 1));
+    const uint32_t head = Min(count, kStreamRingFrames - at);
+    MemCpy(dst, s.ring + at * channels, head * channels * sizeof(int16_t));
+    MemCpy(dst + head * channels, s.ring, (count - head) * channels * sizeof(int16_t));
+    return audio->stage;
+}
+
+// count device frames of a stream from the staged source frames first .. first + staged.
+void MixStreamPiece(const voice_data &v, int64_t first, uint32_t staged, float *dst, uint32_t outCh, uint32_t count,
+                    float gain)
+{
+    const int16_t *samples = Stage(*v.stream, first, staged);
+    if (!v.step)
+    {
+        const int16_t *src = samples + kStreamMargin * v.channels;
+        if (v.channels == outCh)
+            AccumulateSameLayout(dst, src, count * outCh, gain);
+        else if (v.channels == 1 && outCh == 2)
+            AccumulateMonoToStereo(dst, src, count, gain);
+        else
+            AccumulateAnyLayout(dst, outCh, src, v.channels, count, gain);
+        return;
+    }
+
+    voice_data window{
+        .samples = samples,
+        .numFrames = staged,
+        .channels = v.channels,
+        .position = v.position - ((uint64_t)first << 32),
+        .step = v.step,
+        .bank = v.bank,
+    };
+    const resample_fn resample = v.bank ? ResampleFor<true>(v.channels) : ResampleFor<false>(v.channels);
+    resample(window, dst, outCh, count, gain);
+}
+
+// Works in pieces that fit the staging buffer, each staged with kStreamMargin frames either side so the resampler
+// sees an ordinary clip and never reaches past it. A voice whose decoder fell behind holds its position and stays
+// silent until the next chunk. A virtual voice goes through the same steps without staging or mixing, its decoder
+// keeps up with it so it can turn real at any point.
+void MixStream(voice_data &v, uint32_t voiceIndex, float *accum, uint32_t numFrames, uint32_t outCh, float gain)
+{
+    audio_stream &s = *v.stream;
+    const uint64_t written = AtomicLoad64(&s.written);
+    const uint64_t end = (uint64_t)v.numFrames << 32;
+    const uint64_t step = v.step ? v.step : (uint64_t)1 << 32;
+    const uint64_t maxPiece = ((uint64_t)(kStreamStageFrames - 2 * kStreamMargin - 2) << 32) / step;
+
+    for (uint32_t f = 0; f < numFrames;)
+    {
+        uint32_t count = (uint32_t)Min<uint64_t>(numFrames - f, maxPiece);
+        if (!v.loop)
+        {
+            if (v.position >= end)
+            {
+                AtomicStore32(&audio->doneGen[voiceIndex], v.gen);
+                ReleaseVoice(v);
+                return;
+            }
+            count = (uint32_t)Min<uint64_t>(count, (end - v.position + step - 1) / step);
+        }
+
+        const int64_t first = (int64_t)(v.position >> 32) - kStreamMargin;
+        const int64_t last = (int64_t)((v.position + (count - 1) * step) >> 32) + kStreamMargin;
+        if (last >= (int64_t)written)
+        {
+            ++audio->streamStarves;
+            break;
+        }
+
+        if (v.real)
+            MixStreamPiece(v, first, (uint32_t)(last - first + 1), accum + f * outCh, outCh, count, gain);
+
+        v.position += count * step;
+        f += count;
+    }
+
+    AtomicStore64(&s.consumed, (uint64_t)Max<int64_t>((int64_t)(v.position >> 32) - kStreamMargin, 0));
+}
+
+void StoreInt16(int16_t *out, const float *in, uint32_t count)
+{
+    const __m256 lo = _mm256_set1_ps(-32768.f);
+    const __m256 hi = _mm256_set1_ps(32767.f);
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m256i a = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), lo), hi));
+        const __m256i b = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i + 8), lo), hi));
+        // packs works per 128 bit lane, the permute puts the four quarters back in order.
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8));
+    }
+    for (; i < count; ++i)
+        out[i] = (int16_t)LRound(Clamp(in[i], -32768.f, 32767.f));
+}
+
+// Moves the count largest of n distinct keys to the front, in no particular order.
+void SelectLargest(uint64_t *keys, uint32_t n, uint32_t count)
+{
+    uint32_t lo = 0;
+    uint32_t hi = n;
+    while (hi - lo > 1)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        const uint64_t pivot = keys[mid];
+        keys[mid] = keys[hi - 1];
+        keys[hi - 1] = pivot;
+
+        uint32_t store = lo;
+        for (uint32_t i = lo; i < hi - 1; ++i)
+        {
+            if (keys[i] > pivot)
+            {
+                const uint64_t tmp = keys[i];
+                keys[i] = keys[store];
+                keys[store++] = tmp;
+            }
+        }
+        keys[hi - 1] = keys[store];
+        keys[store] = pivot;
+
+        if (store == count || store + 1 == count)
+            return;
+        if (store > count)
+            hi = store;
+        else
+            lo = store + 1;
+    }
+}
+
+// Decides which voices the chunk mixes: at most voiceBudget audible ones, the most important first. The index in the
+// low bits keeps the keys distinct, so equally important voices split by slot rather than at random. Also drops the
+// voices that finished or stopped since the last chunk from the active list.
+void PickRealVoices()
+{
+    uint32_t playing = 0;
+    uint32_t audible = 0;
+    for (uint32_t a = 0; a < audio->activeCount; ++a)
+    {
+        const uint32_t i = audio->activeVoices[a];
+        voice_data &v = audio->mixVoices[i];
+        if (!v.gen)
+        {
+            audio->listed[i] = false;
+            continue;
+        }
+
+        audio->activeVoices[playing++] = (uint16_t)i;
+        const float gain = v.volume * audio->masterVolume;
+        v.real = gain >= kInaudibleGain || gain <= -kInaudibleGain;
+        if (v.real)
+            audio->ranks[audible++] = (Importance(v.priority, gain) << kVoiceIndexBits) | i;
+    }
 
-            uint32_t take = numFrames - framesProduced;
-            uint32_t left = v.numFrames - v.cursor;
-            if (take > left)
-                take = left;
+    const uint32_t budget = audio->voiceBudget;
+    if (audible > budget)
+    {
+        SelectLargest(audio->ranks, audible, budget);
+        for (uint32_t i = budget; i < audible; ++i)
+            audio->mixVoices[audio->ranks[i] & (kMaxVoices - 1)].real = false;
+    }
+
+    audio->activeCount = playing;
+    AtomicStore32(&audio->playingVoices, playing);
+    AtomicStore32(&audio->realVoices, Min(audible, budget));
+}
+
+// A resident voice that is not real keeps time without touching its samples.
+void SkipFrames(voice_data &v, uint32_t voiceIndex, uint32_t numFrames)
+{
+    const uint64_t end = (uint64_t)v.numFrames << 32;
+    uint64_t position = v.step ? v.position : (uint64_t)v.cursor << 32;
+    position += numFrames * (v.step ? v.step : (uint64_t)1 << 32);
+    if (position >= end)
+    {
+        if (!v.loop || !end)
+        {
+            AtomicStore32(&audio->doneGen[voiceIndex], v.gen);
+            v.gen = 0;
+            return;
+        }
+        position %= end;
+    }
+
+    if (v.step)
+        v.position = position;
+    else
+        v.cursor = (uint32_t)(position >> 32);
+}
 
-            const float gain = v.volume * master;
+void MixChunk(int16_t *out, uint32_t numFrames)
+{
+    const uint32_t outCh = audio->deviceChannels;
+    float *const accum = audio->accum;
+    MemZero(accum, numFrames * outCh * sizeof(float));
+
+    PickRealVoices();
+    for (uint32_t a = 0; a < audio->activeCount; ++a)
+    {
+        const uint32_t i = audio->activeVoices[a];
+        voice_data &v = audio->mixVoices[i];
+
+        const float gain = v.volume * audio->masterVolume;
+        if (v.stream)
+        {
+            MixStream(v, i, accum, numFrames, outCh, gain);
+            continue;
+        }
+        if (!v.real)
+        {
+            SkipFrames(v, i, numFrames);
+            continue;
+        }
+        if (v.step)
+        {
+            MixResampled(v, i, accum, numFrames, outCh, gain);
+            continue;
+        }
 
-            for (uint32_t f = 0; f < take; ++f)
+        uint32_t framesProduced = 0;
+        while (framesProduced < numFrames)
+        {
+            if (v.cursor >= v.numFrames)
             {
-                for (uint32_t c = 0; c < outCh; ++c)
+                if (!v.loop || !v.numFrames)
                 {
-                    uint32_t srcCh;
-                    if (v.channels == 1)
-                        srcCh = 0;
-                    else if (c < v.channels)
-                        srcCh = c;
-                    else
-                        srcCh = v.channels - 1;
-
-                    int32_t s = (int32_t)v.samples[(v.cursor + f) * v.channels + srcCh];
-                    int32_t scaled = (int32_t)((float)s * gain);
-                    int32_t sum = (int32_t)out[(framesProduced + f) * outCh + c] + scaled;
-                    if (sum > 32767)
-                        sum = 32767;
-                    if (sum < -32768)
-                        sum = -32768;
-                    out[(framesProduced + f) * outCh + c] = (int16_t)sum;
+                    AtomicStore32(&audio->doneGen[i], v.gen);
+                    v.gen = 0;
+                    break;
                 }
+                v.cursor = 0;
             }
 
+            const uint32_t take = Min(numFrames - framesProduced, v.numFrames - v.cursor);
+            const int16_t *src = v.samples + (uint64_t)v.cursor * v.channels;
+            float *dst = accum + framesProduced * outCh;
+
+            if (v.channels == outCh)
+                AccumulateSameLayout(dst, src, take * outCh, gain);
+            else if (v.channels == 1 && outCh == 2)
+                AccumulateMonoToStereo(dst, src, take, gain);
+            else
+                AccumulateAnyLayout(dst, outCh, src, v.channels, take, gain);
+
             v.cursor += take;
             framesProduced += take;
         }
     }
 
-    PlatformMutex::Unlock(*audio->mutex);
+    StoreInt16(out, accum, numFrames * outCh);
+}
+
+auto LoadClip(byteview blob) -> audio_clip
+{
+    qoa_desc desc;
+    if (Qoa::ParseHeader(blob, desc))
+        return Audio::LoadQoa(blob);
+    return Audio::LoadWav(blob);
+}
+
+void MixCallback(void *, int16_t *out, uint32_t numFrames)
+{
+    DrainCommands();
+
+    const uint32_t outCh = audio->deviceChannels;
+    for (uint32_t done = 0; done < numFrames;)
+    {
+        const uint32_t chunk = Min(numFrames - done, kMixChunkFrames);
+        MixChunk(out + done * outCh, chunk);
+        done += chunk;
+    }
 }
 
 } // namespace
@@ -124,15 +1050,24 @@ void MixCallback(void *, int16_t *out, uint32_t numFrames)
 namespace Audio
 {
 
-void API Bootstrap(uint32_t sampleRate, uint32_t channels, uint32_t latencyUs)
+void API BootstrapHeadless(uint32_t sampleRate, uint32_t channels)
 {
     ASSERT(!audio);
 
+    ASSERT(channels <= kMaxChannels);
+
     audio = &RegionAlloc::Alloc<audio_state>(RegionAlloc::g_BootstrapAlloc);
-    audio->mutex = PlatformMutex::Create(RegionAlloc::g_BootstrapAlloc);
     audio->deviceSampleRate = sampleRate;
     audio->deviceChannels = channels;
     audio->masterVolume = 1.f;
+    audio->voiceBudget = kAudioDefaultVoiceBudget;
+    audio->headless = true;
+}
+
+void API Bootstrap(uint32_t sampleRate, uint32_t channels, uint32_t latencyUs)
+{
+    BootstrapHeadless(sampleRate, channels);
+    audio->headless = false;
 
     PlatformAudio::Init({
         .sampleRate = sampleRate,
@@ -142,6 +1077,9 @@ void API Bootstrap(uint32_t sampleRate, uint32_t channels, uint32_t latencyUs)
         .user = nullptr,
     });
 
+    audio->decoder = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &DecoderMain, nullptr);
+    PlatformThread::SetName(*audio->decoder, "nyla-audio-decode");
+
     AssetManager::Subscribe(
         [](uint64_t guid, byteview, void *) {
             for (uint32_t i = 0; i < HandlePool::Capacity(audio->clips); ++i)
@@ -152,7 +1090,7 @@ void API Bootstrap(uint32_t sampleRate, uint32_t channels, uint32_t latencyUs)
                 if (slot.data.guid != guid)
                     continue;
 
-                slot.data.clip = LoadWav(AssetManager::Get(guid));
+                slot.data.clip = LoadClip(AssetManager::Get(guid));
                 LOG("audio: reloaded clip 0x%016" PRIx64, guid);
             }
         },
@@ -164,8 +1102,29 @@ void API Shutdown()
     if (!audio)
         return;
 
+    if (audio->headless)
+        return;
+
     PlatformAudio::Destroy();
-    PlatformMutex::Destroy(*audio->mutex);
+
+    const platform_audio_stats stats = PlatformAudio::GetStats();
+    LOG("audio: %s, %s, %u frame buffer (%.1f ms) fed every %u frames, %" PRIu64 " underruns, feeder at %.2f%% of a "
+        "core",
+        stats.zeroCopy ? "zero copy" : "copying", stats.realtime ? "real time" : "normal priority", stats.bufferFrames,
+        stats.bufferFrames * 1000.0 / audio->deviceSampleRate, stats.periodFrames, stats.underruns,
+        stats.elapsedNs ? stats.feederCpuNs * 100.0 / stats.elapsedNs : 0.0);
+
+    AtomicStore32(&audio->decoderQuit, 1);
+    PlatformThread::Join(*audio->decoder);
+    if (audio->streamStarves)
+        LOG("audio: streams starved %" PRIu64 " times", audio->streamStarves);
+    if (audio->stolenVoices || audio->droppedVoices)
+        LOG("audio: %" PRIu64 " voices stolen, %" PRIu64 " dropped", audio->stolenVoices, audio->droppedVoices);
+}
+
+void API Mix(int16_t *out, uint32_t numFrames)
+{
+    MixCallback(nullptr, out, numFrames);
 }
 
 auto API LoadWav(byteview wavBlob) -> audio_clip
@@ -180,29 +1139,66 @@ auto API LoadWav(byteview wavBlob) -> audio_clip
     return clip;
 }
 
+auto API LoadQoa(byteview qoaBlob) -> audio_clip
+{
+    qoa_desc desc;
+    ASSERT(Qoa::ParseHeader(qoaBlob, desc));
+    ASSERT(desc.channels <= kStreamMaxChannels, "only mono and stereo clips stream");
+
+    audio_clip clip{};
+    clip.numFrames = desc.numFrames;
+    clip.sampleRate = desc.sampleRate;
+    clip.channels = (uint16_t)desc.channels;
+    clip.stream = qoaBlob;
+    return clip;
+}
+
 auto API Play(const audio_clip &clip, const AudioPlayDesc &desc) -> voice
 {
-    ASSERT(clip.sampleRate == audio->deviceSampleRate, "resampling not implemented");
+    ASSERT(clip.sampleRate);
+
+    const resample_bank *bank = nullptr;
+    if (clip.sampleRate != audio->deviceSampleRate && desc.quality == audio_resample_quality::Sinc)
+        bank = GetResampleBank(clip.sampleRate);
+
+    // The stream first: a voice stolen for a clip that then finds no free stream would be cut off for nothing. A
+    // stolen voice only gives its stream back after the mixer and the decoder have seen it, so the order costs nothing.
+    audio_stream *stream = nullptr;
+    if (clip.stream.size)
+    {
+        stream = StartStream(clip, desc.loop);
+        if (!stream)
+        {
+            ++audio->droppedVoices;
+            return {};
+        }
+    }
 
-    voice_data data{
-        .samples = clip.samples,
-        .numFrames = clip.numFrames,
-        .sampleRate = clip.sampleRate,
-        .channels = clip.channels,
-        .cursor = 0,
+    voice v;
+    if (!AcquireVoice({.volume = desc.volume, .loop = desc.loop, .priority = desc.priority}, v))
+    {
+        if (stream)
+            AtomicStore32(&stream->state, (uint32_t)stream_state::Retiring);
+        ++audio->droppedVoices;
+        return {};
+    }
+
+    PushCommand({
+        .kind = audio_command_kind::Play,
+        .v = v,
         .volume = desc.volume,
         .loop = desc.loop,
-    };
-
-    PlatformMutex::Lock(*audio->mutex);
-    voice v = HandlePool::Acquire(audio->voices, data);
-    PlatformMutex::Unlock(*audio->mutex);
+        .priority = desc.priority,
+        .clip = clip,
+        .bank = bank,
+        .stream = stream,
+    });
     return v;
 }
 
 auto API DeclareClip(uint64_t guid) -> audio_clip_handle
 {
-    audio_clip clip = LoadWav(AssetManager::Get(guid));
+    audio_clip clip = LoadClip(AssetManager::Get(guid));
     return HandlePool::Acquire(audio->clips, clip_slot{.guid = guid, .clip = clip});
 }
 
@@ -218,36 +1214,65 @@ auto API Play(audio_clip_handle h, const AudioPlayDesc &desc) -> voice
 
 void API Stop(voice v)
 {
-    PlatformMutex::Lock(*audio->mutex);
-    handle_slot<voice_data> *slot;
-    if (HandlePool::TryResolveSlot(audio->voices, v, slot))
-        HandlePool::Free(*slot);
-    PlatformMutex::Unlock(*audio->mutex);
+    handle_slot<voice_info> *slot;
+    if (!HandlePool::TryResolveSlot(audio->voices, v, slot))
+        return;
+
+    HandlePool::Free(*slot);
+    PushCommand({.kind = audio_command_kind::Stop, .v = v});
 }
 
 void API SetVolume(voice v, float volume)
 {
-    PlatformMutex::Lock(*audio->mutex);
-    handle_slot<voice_data> *slot;
-    if (HandlePool::TryResolveSlot(audio->voices, v, slot))
-        slot->data.volume = volume;
-    PlatformMutex::Unlock(*audio->mutex);
+    handle_slot<voice_info> *slot;
+    if (!HandlePool::TryResolveSlot(audio->voices, v, slot))
+        return;
+
+    slot->data.volume = volume;
+    PushCommand({.kind = audio_command_kind::SetVolume, .v = v, .volume = volume});
 }
 
 auto API IsPlaying(voice v) -> bool
 {
-    PlatformMutex::Lock(*audio->mutex);
-    handle_slot<voice_data> *slot;
-    bool playing = HandlePool::TryResolveSlot(audio->voices, v, slot);
-    PlatformMutex::Unlock(*audio->mutex);
-    return playing;
+    handle_slot<voice_info> *slot;
+    if (!HandlePool::TryResolveSlot(audio->voices, v, slot))
+        return false;
+
+    if (AtomicLoad32(&audio->doneGen[v.index]) != v.gen)
+        return true;
+
+    HandlePool::Free(*slot);
+    return false;
 }
 
 void API SetMasterVolume(float volume)
 {
-    PlatformMutex::Lock(*audio->mutex);
-    audio->masterVolume = volume;
-    PlatformMutex::Unlock(*audio->mutex);
+    PushCommand({.kind = audio_command_kind::SetMasterVolume, .volume = volume});
+}
+
+void API SetVoiceBudget(uint32_t realVoices)
+{
+    PushCommand({.kind = audio_command_kind::SetVoiceBudget, .voiceBudget = Min(realVoices, kMaxVoices)});
+}
+
+auto API GetVoiceStats() -> audio_voice_stats
+{
+    return {
+        .playing = AtomicLoad32(&audio->playingVoices),
+        .real = AtomicLoad32(&audio->realVoices),
+        .stolen = audio->stolenVoices,
+        .dropped = audio->droppedVoices,
+    };
+}
+
+auto API GetUnderruns() -> uint64_t
+{
+    return audio->headless ? 0 : PlatformAudio::GetUnderruns();
+}
+
+void API PumpStreams()
+{
+    DecodeStreams();
 }
 
 } // namespace Audio
@@ -9,12 +9,21 @@
 namespace nyla
 {
 
+// Decoded frames a streaming voice keeps, about a third of a second at 48 kHz.
+constexpr inline uint32_t kAudioStreamRingFrames = 16384;
+
+// Voices that may be playing at once, most of them virtual: they keep time but are not mixed.
+constexpr inline uint32_t kAudioMaxVoices = 1024;
+// Voices the mixer renders until Audio::SetVoiceBudget says otherwise.
+constexpr inline uint32_t kAudioDefaultVoiceBudget = 64;
+
 struct audio_clip
 {
     const int16_t *samples;
     uint32_t numFrames;
     uint32_t sampleRate;
     uint16_t channels;
+    byteview stream; // a QOA file decoded while it plays, samples is null then
 };
 
 struct audio_clip_handle : handle
@@ -25,23 +34,52 @@ struct voice : handle
 {
 };
 
+// Only used when the clip rate differs from the device rate.
+enum class audio_resample_quality : uint8_t
+{
+    Sinc,  // 32 tap Kaiser windowed sinc, interpolated between 256 phases
+    Cubic, // 4 point Catmull-Rom, a fraction of the cost but images and aliases audibly on bright material
+};
+
 struct AudioPlayDesc
 {
     float volume = 1.f;
     bool loop = false;
+    audio_resample_quality quality = audio_resample_quality::Sinc;
+    // Higher wins. Over the voice budget the mixer renders voices by priority and then by how loud they play, when
+    // every voice is taken a new one replaces the least important voice if it outranks it.
+    uint8_t priority = 128;
+};
+
+struct audio_voice_stats
+{
+    uint32_t playing; // as of the mixer's last chunk, real and virtual
+    uint32_t real;    // of those, the ones it mixed
+    uint64_t stolen;  // voices Play stopped early to make room
+    uint64_t dropped; // Play calls that returned an invalid voice
 };
 
 namespace Audio
 {
 
 void API Bootstrap(uint32_t sampleRate, uint32_t channels, uint32_t latencyUs);
+// No device and no asset reloads, the caller drives Mix. For tools and benchmarks.
+void API BootstrapHeadless(uint32_t sampleRate, uint32_t channels);
 void API Shutdown();
 
+// Every playing voice into numFrames interleaved frames, what the device callback runs.
+void API Mix(int16_t *out, uint32_t numFrames);
+
 auto API LoadWav(byteview wavBlob) -> audio_clip;
+// Mono or stereo. Each voice playing it keeps a short window of decoded frames, not the whole clip.
+auto API LoadQoa(byteview qoaBlob) -> audio_clip;
 
 auto API DeclareClip(uint64_t guid) -> audio_clip_handle;
 auto API ResolveClip(audio_clip_handle clip) -> audio_clip;
 
+// Voices are controlled from one thread, normally the game thread. Commands go to the mixer through a lock free queue
+// and take effect at its next callback, nothing here waits for the mixer. Play never fails loudly: when no voice or no
+// stream can be had it returns an invalid voice, which every other call accepts and ignores.
 auto API Play(const audio_clip &clip, const AudioPlayDesc &desc = {}) -> voice;
 auto API Play(audio_clip_handle clip, const AudioPlayDesc &desc = {}) -> voice;
 void API Stop(voice v);
@@ -50,6 +88,18 @@ auto API IsPlaying(voice v) -> bool;
 
 void API SetMasterVolume(float volume);
 
+// How many voices the mixer renders at most. The rest, and any voice too quiet to reach the output, play virtually
+// and become real again once they rank among the budget.
+void API SetVoiceBudget(uint32_t realVoices);
+auto API GetVoiceStats() -> audio_voice_stats;
+
+// Times the device ran dry since Bootstrap, zero when headless.
+auto API GetUnderruns() -> uint64_t;
+
+// Decodes ahead for every streaming voice. A decoder thread does this after Bootstrap, headless callers run it
+// between calls to Mix.
+void API PumpStreams();
+
 } // namespace Audio
 
 } // namespace nyla
@@ -29,10 +29,11 @@ namespace
 constexpr uint64_t kInternalAtlasGuid = 0xC11AB0BCE11A71A5;
 constexpr uint16_t kCodepointMapSize = 256;
 constexpr uint16_t kInvalidGlyph = 0xFFFFu;
+constexpr uint16_t kPixelPosFlag = 0x8000u;
 
 struct gpu_cell
 {
-    uint32_t packedXY;    // (cellY << 16) | cellX
+    uint32_t packedXY;    // (cellY << 16) | cellX, or pixel offsets when kPixelPosFlag is set
     uint32_t packedGlyph; // (flags << 16) | glyphIndex
     uint32_t fgRgba;
     uint32_t bgRgba;
@@ -63,6 +64,10 @@ struct cell_renderer_state
     uint32_t lastFrameIdx;
     uint32_t frameSliceByteOffset;
     uint32_t currentDrawByteOffset;
+
+    // BootstrapHeadless, cells are packed here instead of into the instance buffer.
+    bool headless;
+    gpu_cell *headlessCells;
 };
 
 cell_renderer_state *cr;
@@ -121,12 +126,7 @@ void BuildAtlas(byteview bdfData, uint8_t *rgbaPixels)
     RegionAlloc::Destroy(tmp);
 }
 
-} // namespace
-
-namespace CellRenderer
-{
-
-void API Bootstrap(region_alloc &, const cell_renderer_init_desc &desc)
+void BootstrapAtlas(const cell_renderer_init_desc &desc)
 {
     cr = &RegionAlloc::Alloc<cell_renderer_state>(RegionAlloc::g_BootstrapAlloc);
     cr->desc = desc;
@@ -160,6 +160,17 @@ void API Bootstrap(region_alloc &, const cell_renderer_init_desc &desc)
     cr->bytesPerFrame = desc.maxCells * sizeof(gpu_cell);
     cr->lastFrameIdx = ~0u;
     cr->frameSliceByteOffset = 0;
+}
+
+} // namespace
+
+namespace CellRenderer
+{
+
+void API Bootstrap(region_alloc &, const cell_renderer_init_desc &desc)
+{
+    BootstrapAtlas(desc);
+
     const uint32_t numFrames = Rhi::GetNumFramesInFlight();
 
     cr->instanceBuffer = Rhi::CreateBuffer(rhi_buffer_desc{
@@ -193,6 +204,19 @@ void API Bootstrap(region_alloc &, const cell_renderer_init_desc &desc)
     cr->pipeline = PipelineCache::Acquire(ID_cell_renderer_vs, ID_cell_renderer_ps, pipelineDesc);
 }
 
+void API BootstrapHeadless(const cell_renderer_init_desc &desc)
+{
+    BootstrapAtlas(desc);
+
+    cr->headless = true;
+    cr->headlessCells = RegionAlloc::AllocArray<gpu_cell>(RegionAlloc::g_BootstrapAlloc, desc.maxCells).data;
+}
+
+auto API GetDesc() -> const cell_renderer_init_desc &
+{
+    return cr->desc;
+}
+
 void API Begin(int32_t originPxX, int32_t originPxY, uint32_t cols, uint32_t rows)
 {
     cr->originPxX = originPxX;
@@ -201,8 +225,9 @@ void API Begin(int32_t originPxX, int32_t originPxY, uint32_t cols, uint32_t row
     cr->rows = rows;
     cr->cellCount = 0;
 
-    const uint32_t frameIdx = Rhi::GetFrameIndex();
-    if (frameIdx != cr->lastFrameIdx)
+    // Headless there are no frames in flight, every batch starts over at the front of the CPU cells.
+    const uint32_t frameIdx = cr->headless ? 0 : Rhi::GetFrameIndex();
+    if (cr->headless || frameIdx != cr->lastFrameIdx)
     {
         cr->lastFrameIdx = frameIdx;
         cr->frameSliceByteOffset = 0;
@@ -216,7 +241,7 @@ void API Begin(int32_t originPxX, int32_t originPxY, uint32_t cols, uint32_t row
     if (cr->cellCap > cr->desc.maxCells)
         cr->cellCap = cr->desc.maxCells;
 
-    char *base = Rhi::MapBuffer(cr->instanceBuffer);
+    char *base = cr->headless ? (char *)cr->headlessCells : Rhi::MapBuffer(cr->instanceBuffer);
     cr->frameCells =
         reinterpret_cast<gpu_cell *>(base + uint64_t{frameIdx} * cr->bytesPerFrame + cr->currentDrawByteOffset);
 }
@@ -239,7 +264,23 @@ void API PutCell(uint32_t col, uint32_t row, cell_attr cell)
 
     gpu_cell &gc = cr->frameCells[cr->cellCount++];
     gc.packedXY = (row << 16) | (col & 0xFFFFu);
-    gc.packedGlyph = (uint32_t{cell.flags} << 16) | uint32_t{cell.glyphIndex};
+    gc.packedGlyph = (uint32_t(cell.flags & ~kPixelPosFlag) << 16) | uint32_t{cell.glyphIndex};
+    gc.fgRgba = cell.fgRgba;
+    gc.bgRgba = cell.bgRgba;
+}
+
+void API PutGlyphPx(int32_t x, int32_t y, cell_attr cell)
+{
+    if (x < 0 || y < 0 || x > 0xFFFF || y > 0xFFFF)
+        return;
+    if (cr->cellCount >= cr->cellCap)
+        return;
+    if (cell.glyphIndex == kInvalidGlyph)
+        return;
+
+    gpu_cell &gc = cr->frameCells[cr->cellCount++];
+    gc.packedXY = (uint32_t(y) << 16) | uint32_t(x);
+    gc.packedGlyph = (uint32_t(cell.flags | kPixelPosFlag) << 16) | uint32_t{cell.glyphIndex};
     gc.fgRgba = cell.fgRgba;
     gc.bgRgba = cell.bgRgba;
 }
@@ -265,7 +306,7 @@ void API Text(uint32_t col, uint32_t row, byteview text, uint32_t fgRgba, uint32
 
 void API CmdFlush(rhi_cmdlist cmd)
 {
-    if (cr->cellCount == 0)
+    if (cr->cellCount == 0 || cr->headless)
         return;
 
     const uint32_t frameIdx = Rhi::GetFrameIndex();
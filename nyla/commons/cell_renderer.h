@@ -32,11 +32,19 @@ namespace CellRenderer
 {
 
 void API Bootstrap(region_alloc &alloc, const cell_renderer_init_desc &desc);
+// Builds the atlas but no GPU buffer or pipeline, cells are packed into CPU memory and CmdFlush draws nothing. For
+// tools and benchmarks.
+void API BootstrapHeadless(const cell_renderer_init_desc &desc);
+
+auto API GetDesc() -> const cell_renderer_init_desc &;
 
 void API Begin(int32_t originPxX, int32_t originPxY, uint32_t cols, uint32_t rows);
 
 void API PutCell(uint32_t col, uint32_t row, cell_attr cell);
 
+// Places a glyph at a pixel offset from the batch origin instead of on the cell grid.
+void API PutGlyphPx(int32_t x, int32_t y, cell_attr cell);
+
 void API Text(uint32_t col, uint32_t row, byteview text, uint32_t fgRgba, uint32_t bgRgba);
 
 auto API GlyphForCodepoint(uint32_t codepoint) -> uint16_t;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/rhi.h"
+
+namespace nyla
+{
+
+namespace CpuSampler
+{
+
+// F10, also in release builds. The first call samples every thread that exists at that point about 1000 times per
+// CPU second, with user space stacks unwound through frame pointers: perf_event_open where the kernel allows it, a
+// SIGPROF timer otherwise. The second call stops, symbolizes against the ELF symbol tables of the mapped modules,
+// writes nyla-cpu-N.folded (one "root;...;leaf count" line per distinct stack, the input of flamegraph tools) and
+// logs the hottest functions. Linux only.
+void API Toggle();
+auto API IsRunning() -> bool;
+
+// The hottest functions of the last report by self samples, or the sample count while running.
+void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY);
+
+} // namespace CpuSampler
+
+} // namespace nyla
@@ -0,0 +1,1020 @@
+#include "nyla/commons/cpu_sampler.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <linux/perf_event.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "nyla/commons/cell_renderer.h"
+#include "nyla/commons/elf.h"
+#include "nyla/commons/file.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/inline_string.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/mempage_pool.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/platform_thread.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/span_def.h"
+#include "nyla/commons/time.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+constexpr uint32_t kFrequencyHz = 999; // off the beat of anything that runs every millisecond
+constexpr uint32_t kMaxDepth = 64;
+constexpr uint32_t kMaxThreads = 64;
+constexpr uint32_t kRingPages = 32; // power of two, the kernel adds one header page
+constexpr uint32_t kTopCount = 16;
+constexpr uint64_t kNameCap = 64;
+
+// Samples are a (tid << 32 | depth) word followed by depth addresses, leaf first. The header is stored last, a zero
+// header is a sample a signal handler has reserved but not finished.
+constexpr uint64_t kStoreWords = 1 << 22;
+
+enum class sampler_mode
+{
+    Off,
+    Perf,
+    Timer,
+};
+
+struct sampler_row
+{
+    inline_string<kNameCap> name;
+    uint32_t self;
+    uint32_t total;
+};
+
+struct sampler_state
+{
+    sampler_mode mode;
+
+    region_alloc storeAlloc;
+    uint64_t *store;
+    uint64_t used; // may run past kStoreWords once full
+    uint64_t dropped;
+
+    int fds[kMaxThreads];
+    uint8_t *rings[kMaxThreads];
+    uint32_t ringCount;
+    uint64_t dataBytes;
+    platform_thread *reader;
+    uint32_t quit;
+
+    struct sigaction prevAction;
+
+    uint64_t startMs;
+    uint32_t reportIndex;
+    uint64_t reportSamples;
+    sampler_row top[kTopCount];
+    uint32_t topCount;
+};
+
+sampler_state *g_sampler;
+
+auto Reserve(uint64_t words) -> uint64_t *
+{
+    const uint64_t at = AtomicFetchAdd64(&g_sampler->used, words);
+    if (at + words > kStoreWords)
+    {
+        AtomicFetchAdd64(&g_sampler->dropped, 1);
+        return nullptr;
+    }
+    return g_sampler->store + at;
+}
+
+void StoreSample(uint32_t tid, const uint64_t *ips, uint32_t depth)
+{
+    uint64_t *w = Reserve(1 + depth);
+    if (!w)
+        return;
+    MemCpy(w + 1, ips, depth * sizeof(uint64_t));
+    AtomicStore64(w, ((uint64_t)tid << 32) | depth);
+}
+
+//
+
+void AddPerfSample(const uint64_t *rec, uint64_t words)
+{
+    // PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN: ip, pid and tid, nr, ips.
+    if (words < 3)
+        return;
+    const uint32_t tid = (uint32_t)(rec[1] >> 32);
+    const uint64_t nr = Min(rec[2], words - 3);
+
+    uint64_t ips[kMaxDepth];
+    uint32_t depth = 0;
+    for (uint64_t i = 0; i < nr && depth < kMaxDepth; ++i)
+    {
+        if (rec[3 + i] < PERF_CONTEXT_MAX)
+            ips[depth++] = rec[3 + i];
+    }
+    if (!depth)
+        ips[depth++] = rec[0];
+    StoreSample(tid, ips, depth);
+}
+
+void DrainRing(uint8_t *ring)
+{
+    auto *meta = (perf_event_mmap_page *)ring;
+    const uint8_t *data = ring + meta->data_offset;
+    const uint64_t size = meta->data_size;
+
+    const uint64_t head = AtomicLoad64((const uint64_t *)&meta->data_head);
+    uint64_t tail = meta->data_tail;
+    while (tail < head)
+    {
+        uint64_t rec[512];
+        perf_event_header header;
+        for (uint64_t i = 0; i < sizeof(header); ++i)
+            ((uint8_t *)&header)[i] = data[(tail + i) & (size - 1)];
+        if (header.size < sizeof(header))
+            break;
+
+        if (header.size <= sizeof(rec) + sizeof(header))
+        {
+            const uint64_t bodySize = header.size - sizeof(header);
+            const uint64_t at = (tail + sizeof(header)) & (size - 1);
+            const uint64_t first = Min(bodySize, size - at);
+            MemCpy(rec, data + at, first);
+            MemCpy((uint8_t *)rec + first, data, bodySize - first);
+
+            if (header.type == PERF_RECORD_SAMPLE)
+                AddPerfSample(rec, bodySize / sizeof(uint64_t));
+            else if (header.type == PERF_RECORD_LOST)
+                AtomicFetchAdd64(&g_sampler->dropped, rec[1]);
+        }
+        tail += header.size;
+    }
+    AtomicStore64((uint64_t *)&meta->data_tail, tail);
+}
+
+void ReaderMain(void *)
+{
+    pollfd fds[kMaxThreads];
+    for (uint32_t i = 0; i < g_sampler->ringCount; ++i)
+        fds[i] = pollfd{.fd = g_sampler->fds[i], .events = POLLIN, .revents = 0};
+
+    for (;;)
+    {
+        const bool quit = AtomicLoad32(&g_sampler->quit);
+        for (uint32_t i = 0; i < g_sampler->ringCount; ++i)
+            DrainRing(g_sampler->rings[i]);
+        if (quit)
+            break;
+        poll(fds, g_sampler->ringCount, 50);
+    }
+}
+
+void StopPerf()
+{
+    for (uint32_t i = 0; i < g_sampler->ringCount; ++i)
+        ioctl(g_sampler->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+    if (g_sampler->reader)
+    {
+        AtomicStore32(&g_sampler->quit, 1);
+        PlatformThread::Join(*g_sampler->reader);
+        g_sampler->reader = nullptr;
+    }
+
+    const uint64_t mapBytes = g_sampler->dataBytes + (uint64_t)getpagesize();
+    for (uint32_t i = 0; i < g_sampler->ringCount; ++i)
+    {
+        munmap(g_sampler->rings[i], mapBytes);
+        close(g_sampler->fds[i]);
+    }
+    g_sampler->ringCount = 0;
+}
+
+// One task-clock event per thread, since an inherited event can not be mmapped. Threads started later are missed.
+auto StartPerf(region_alloc &scratch) -> bool
+{
+    dir_iter *it = DirIter::Create(scratch, "/proc/self/task"_s);
+    if (!it)
+        return false;
+
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.config = PERF_COUNT_SW_TASK_CLOCK;
+    attr.sample_freq = kFrequencyHz;
+    attr.freq = 1;
+    attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.exclude_callchain_kernel = 1;
+    attr.sample_max_stack = kMaxDepth;
+    attr.watermark = 1;
+
+    g_sampler->dataBytes = (uint64_t)kRingPages * getpagesize();
+    attr.wakeup_watermark = (uint32_t)(g_sampler->dataBytes / 2);
+    const uint64_t mapBytes = g_sampler->dataBytes + (uint64_t)getpagesize();
+
+    bool ok = true;
+    file_metadata entry;
+    while (ok && g_sampler->ringCount < kMaxThreads && DirIter::Next(scratch, *it, entry))
+    {
+        uint64_t tid = 0;
+        for (uint64_t i = 0; i < entry.fileName.size; ++i)
+        {
+            const uint8_t ch = entry.fileName[i];
+            if (ch < '0' || ch > '9')
+            {
+                tid = 0;
+                break;
+            }
+            tid = tid * 10 + (ch - '0');
+        }
+        if (!tid)
+            continue;
+
+        const int fd = (int)syscall(SYS_perf_event_open, &attr, (pid_t)tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fd < 0)
+        {
+            LOG("cpu sampler: perf_event_open failed (errno %d), see /proc/sys/kernel/perf_event_paranoid", errno);
+            ok = false;
+            break;
+        }
+        void *ring = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ring == MAP_FAILED)
+        {
+            LOG("cpu sampler: perf ring mmap failed (errno %d)", errno);
+            close(fd);
+            ok = false;
+            break;
+        }
+
+        g_sampler->fds[g_sampler->ringCount] = fd;
+        g_sampler->rings[g_sampler->ringCount] = (uint8_t *)ring;
+        ++g_sampler->ringCount;
+    }
+    DirIter::Destroy(*it);
+
+    if (!ok || !g_sampler->ringCount)
+    {
+        StopPerf();
+        return false;
+    }
+
+    g_sampler->quit = 0;
+    g_sampler->reader = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &ReaderMain, nullptr);
+    PlatformThread::SetName(*g_sampler->reader, "nyla-sampler");
+
+    for (uint32_t i = 0; i < g_sampler->ringCount; ++i)
+        ioctl(g_sampler->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    return true;
+}
+
+//
+
+// Frame pointer walk of the interrupted thread. Every frame has to lie above the previous one and inside the stack
+// the thread cached, so a function built without frame pointers ends the stack early instead of faulting. Threads
+// that did not cache their stack (started outside PlatformThread) only get the interrupted address.
+void OnSigprof(int, siginfo_t *, void *context)
+{
+    const auto *uc = (const ucontext_t *)context;
+    const uint64_t rsp = (uint64_t)uc->uc_mcontext.gregs[REG_RSP];
+    uint64_t fp = (uint64_t)uc->uc_mcontext.gregs[REG_RBP];
+
+    uint64_t ips[kMaxDepth];
+    uint32_t depth = 0;
+    ips[depth++] = (uint64_t)uc->uc_mcontext.gregs[REG_RIP];
+
+    uint64_t stackLow;
+    uint64_t stackHigh;
+    if (PlatformThread::GetStackBounds(stackLow, stackHigh))
+    {
+        uint64_t prev = Max(rsp, stackLow);
+        while (depth < kMaxDepth && fp >= prev && fp <= stackHigh - 16 && !(fp & 7))
+        {
+            const auto *frame = (const uint64_t *)fp;
+            if (!frame[1])
+                break;
+            ips[depth++] = frame[1];
+            prev = fp + 16; // strictly above the frame just read
+            fp = frame[0];
+        }
+    }
+
+    const int savedErrno = errno;
+    const auto tid = (uint32_t)syscall(SYS_gettid);
+    errno = savedErrno;
+
+    StoreSample(tid, ips, depth);
+}
+
+auto StartTimer() -> bool
+{
+    // Toggle runs on the main thread, which did not start through PlatformThread.
+    PlatformThread::CacheStackBounds();
+
+    struct sigaction action{};
+    action.sa_sigaction = &OnSigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &g_sampler->prevAction) != 0)
+        return false;
+
+    itimerval timer{};
+    timer.it_interval.tv_usec = 1000000 / kFrequencyHz;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+        sigaction(SIGPROF, &g_sampler->prevAction, nullptr);
+        return false;
+    }
+    return true;
+}
+
+void StopTimer()
+{
+    itimerval timer{};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &g_sampler->prevAction, nullptr);
+}
+
+//
+
+struct elf_function
+{
+    uint64_t address;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t id; // 0 until the first sample lands in it
+};
+
+struct sampled_module
+{
+    uint64_t start;
+    uint64_t end;
+    uint64_t fileOffset;
+    byteview path;
+
+    bool loaded;
+    span<Elf64ProgramHeader> loads;
+    span<elf_function> functions;
+    byteview strings;
+    uint32_t unknownId;
+};
+
+struct sampled_function
+{
+    byteview name;
+    uint32_t self;
+    uint32_t total;
+    uint32_t lastSample; // sample index + 1 that already counted total
+};
+
+struct folded_stack
+{
+    uint64_t hash;
+    const uint32_t *ids; // root first
+    uint32_t depth;
+    uint32_t count;
+};
+
+constexpr uint32_t kMaxFunctions = 1 << 16;
+constexpr uint32_t kIpCacheSlots = 1 << 16;
+constexpr uint32_t kStackSlots = 1 << 18;
+
+struct report_state
+{
+    region_alloc &scratch;
+    span<sampled_module> modules;
+    sampled_function *functions;
+    uint32_t functionCount;
+    uint64_t *cacheIps;
+    uint32_t *cacheIds;
+    folded_stack *stacks;
+};
+
+auto ReadAt(file_handle file, uint64_t offset, span<uint8_t> out) -> bool
+{
+    FileSeek(file, (int64_t)offset, file_seek_mode::Begin);
+    uint64_t done = 0;
+    while (done < out.size)
+    {
+        const uint32_t chunk = (uint32_t)Min<uint64_t>(out.size - done, 1 << 30);
+        const uint32_t got = FileRead(file, chunk, out.data + done);
+        if (!got)
+            return false;
+        done += got;
+    }
+    return true;
+}
+
+// procfs files report a size of zero, so read until the end. A few thousand mappings fit easily.
+auto ReadWhole(region_alloc &alloc, byteview path) -> byteview
+{
+    file_handle file = FileOpen(path, FileOpenMode::Read);
+    if (!FileValid(file))
+        return {};
+
+    constexpr uint64_t kMaxSize = 4 << 20;
+    uint8_t *const begin = RegionAlloc::AllocUninit(alloc, kMaxSize, 1);
+    uint64_t size = 0;
+    while (size < kMaxSize)
+    {
+        const uint32_t got = FileRead(file, (uint32_t)(kMaxSize - size), begin + size);
+        if (!got)
+            break;
+        size += got;
+    }
+    RegionAlloc::Reset(alloc, begin + size);
+    FileClose(file);
+    return byteview{begin, size};
+}
+
+auto ParseHex(byteview s, uint64_t &at) -> uint64_t
+{
+    uint64_t v = 0;
+    for (; at < s.size; ++at)
+    {
+        const uint8_t ch = s[at];
+        uint64_t digit;
+        if (ch >= '0' && ch <= '9')
+            digit = ch - '0';
+        else if (ch >= 'a' && ch <= 'f')
+            digit = ch - 'a' + 10;
+        else
+            break;
+        v = (v << 4) | digit;
+    }
+    return v;
+}
+
+// Executable mappings backed by a file, in address order as the kernel lists them.
+auto ReadModules(region_alloc &alloc) -> span<sampled_module>
+{
+    const byteview maps = ReadWhole(alloc, "/proc/self/maps"_s);
+
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < maps.size; ++i)
+        count += maps[i] == '\n';
+    span<sampled_module> modules = RegionAlloc::AllocArray<sampled_module>(alloc, count);
+
+    uint64_t n = 0;
+    for (uint64_t at = 0; at < maps.size;)
+    {
+        uint64_t eol = at;
+        while (eol < maps.size && maps[eol] != '\n')
+            ++eol;
+
+        // start-end perms offset dev inode path
+        uint64_t p = at;
+        const uint64_t start = ParseHex(maps, p);
+        ++p;
+        const uint64_t end = ParseHex(maps, p);
+        ++p;
+        const bool exec = p + 2 < eol && maps[p + 2] == 'x';
+        p += 5;
+        const uint64_t offset = ParseHex(maps, p);
+
+        uint64_t pathAt = p;
+        while (pathAt < eol && maps[pathAt] != '/')
+            ++pathAt;
+
+        if (exec && pathAt < eol)
+        {
+            // Paths are handed to open, so they need a terminator of their own.
+            const uint64_t pathSize = eol - pathAt;
+            uint8_t *path = RegionAlloc::Alloc(alloc, pathSize + 1, 1);
+            MemCpy(path, maps.data + pathAt, pathSize);
+            modules[n++] = sampled_module{
+                .start = start,
+                .end = end,
+                .fileOffset = offset,
+                .path = byteview{path, pathSize},
+            };
+        }
+        at = eol + 1;
+    }
+    return span<sampled_module>{modules.data, n};
+}
+
+void SiftDown(span<elf_function> a, uint64_t root, uint64_t n)
+{
+    for (;;)
+    {
+        uint64_t child = root * 2 + 1;
+        if (child >= n)
+            return;
+        if (child + 1 < n && a[child + 1].address > a[child].address)
+            ++child;
+        if (a[root].address >= a[child].address)
+            return;
+        Swap(a[root], a[child]);
+        root = child;
+    }
+}
+
+void SortByAddress(span<elf_function> a)
+{
+    for (uint64_t i = a.size / 2; i-- > 0;)
+        SiftDown(a, i, a.size);
+    for (uint64_t n = a.size; n-- > 1;)
+    {
+        Swap(a[0], a[n]);
+        SiftDown(a, 0, n);
+    }
+}
+
+// Function symbols from .symtab, or .dynsym for stripped files, plus the PT_LOAD segments to map file offsets back.
+void LoadModule(region_alloc &alloc, sampled_module &m)
+{
+    m.loaded = true;
+
+    file_handle file = FileOpen(m.path, FileOpenMode::Read);
+    if (!FileValid(file))
+        return;
+
+    // 64-bit only, ident[4] is the class.
+    Elf64Header header;
+    constexpr uint8_t kMagic[4] = {0x7F, 'E', 'L', 'F'};
+    if (!ReadAt(file, 0, span<uint8_t>{(uint8_t *)&header, sizeof(header)}) || !MemEq(header.ident, kMagic, 4) ||
+        header.ident[4] != 2)
+    {
+        FileClose(file);
+        return;
+    }
+
+    span<Elf64ProgramHeader> phdrs =
+        RegionAlloc::AllocArray<Elf64ProgramHeader>(alloc, header.programHeaderEntryCount);
+    span<Elf64SectionHeader> shdrs =
+        RegionAlloc::AllocArray<Elf64SectionHeader>(alloc, header.sectionHeaderEntryCount);
+    if (!ReadAt(file, header.programHeaderTableOffset,
+                span<uint8_t>{(uint8_t *)phdrs.data, phdrs.size * sizeof(Elf64ProgramHeader)}) ||
+        !ReadAt(file, header.sectionHeaderTableOffset,
+                span<uint8_t>{(uint8_t *)shdrs.data, shdrs.size * sizeof(Elf64SectionHeader)}))
+    {
+        FileClose(file);
+        return;
+    }
+
+    uint64_t loadCount = 0;
+    for (uint64_t i = 0; i < phdrs.size; ++i)
+    {
+        if (phdrs[i].type == kElfProgramLoad)
+            phdrs[loadCount++] = phdrs[i];
+    }
+    m.loads = span<Elf64ProgramHeader>{phdrs.data, loadCount};
+
+    const Elf64SectionHeader *symtab = nullptr;
+    for (uint32_t pass = 0; pass < 2 && !symtab; ++pass)
+    {
+        const uint32_t want = pass == 0 ? kElfSectionSymbolTable : kElfSectionDynamicSymbols;
+        for (uint64_t i = 0; i < shdrs.size; ++i)
+        {
+            if (shdrs[i].type == want && shdrs[i].link < shdrs.size)
+            {
+                symtab = &shdrs[i];
+                break;
+            }
+        }
+    }
+    if (!symtab)
+    {
+        FileClose(file);
+        return;
+    }
+
+    const Elf64SectionHeader &strtab = shdrs[symtab->link];
+    span<Elf64Symbol> symbols = RegionAlloc::AllocArrayUninit<Elf64Symbol>(alloc, symtab->size / sizeof(Elf64Symbol));
+    span<uint8_t> strings = RegionAlloc::AllocArrayUninit<uint8_t>(alloc, strtab.size + 1);
+    strings[strtab.size] = '\0';
+    if (!ReadAt(file, symtab->offset, span<uint8_t>{(uint8_t *)symbols.data, symbols.size * sizeof(Elf64Symbol)}) ||
+        !ReadAt(file, strtab.offset, span<uint8_t>{strings.data, strtab.size}))
+    {
+        FileClose(file);
+        return;
+    }
+    FileClose(file);
+
+    // Functions overwrite the symbols they came from, both arrays are read front to back.
+    static_assert(sizeof(elf_function) == sizeof(Elf64Symbol));
+    auto *functions = (elf_function *)symbols.data;
+    uint64_t functionCount = 0;
+    for (uint64_t i = 0; i < symbols.size; ++i)
+    {
+        const Elf64Symbol sym = symbols[i];
+        if ((sym.info & 0xF) != kElfSymbolFunction || !sym.value || !sym.sectionIndex || sym.name >= strtab.size)
+            continue;
+        functions[functionCount++] = elf_function{
+            .address = sym.value,
+            .size = sym.size,
+            .nameOffset = sym.name,
+            .id = 0,
+        };
+    }
+    m.functions = span<elf_function>{functions, functionCount};
+    m.strings = byteview{strings.data, strtab.size};
+    SortByAddress(m.functions);
+}
+
+// "ns::Type::Fn" out of "ns::Type::Fn(int) const", the parameter list is noise in a flame graph.
+auto FunctionName(region_alloc &alloc, const char *mangled) -> byteview
+{
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    byteview name = Span::FromCStr(status == 0 && demangled ? demangled : mangled, 4096);
+
+    if (name.size > 6 && MemEq(name.data + name.size - 6, " const", 6))
+        name.size -= 6;
+    if (name.size && name[name.size - 1] == ')')
+    {
+        uint32_t depth = 0;
+        for (uint64_t i = name.size; i-- > 0;)
+        {
+            if (name[i] == ')')
+                ++depth;
+            else if (name[i] == '(' && --depth == 0)
+            {
+                if (i)
+                    name.size = i;
+                break;
+            }
+        }
+    }
+
+    uint8_t *copy = RegionAlloc::AllocUninit(alloc, name.size, 1);
+    for (uint64_t i = 0; i < name.size; ++i)
+        copy[i] = name[i] == ';' ? ':' : name[i]; // the folded format separates frames with ';'
+    free(demangled);
+    return byteview{copy, name.size};
+}
+
+auto NewFunction(report_state &r, byteview name) -> uint32_t
+{
+    if (r.functionCount >= kMaxFunctions)
+        return 0;
+    const uint32_t id = r.functionCount++;
+    r.functions[id] = sampled_function{.name = name};
+    return id;
+}
+
+auto ModuleName(byteview path) -> byteview
+{
+    uint64_t at = path.size;
+    while (at && path[at - 1] != '/')
+        --at;
+    return byteview{path.data + at, path.size - at};
+}
+
+auto Symbolize(report_state &r, uint64_t ip) -> uint32_t
+{
+    uint32_t slot = (uint32_t)((ip * 0x9E3779B97F4A7C15ull) >> 48) & (kIpCacheSlots - 1);
+    for (;; slot = (slot + 1) & (kIpCacheSlots - 1))
+    {
+        if (r.cacheIps[slot] == ip)
+            return r.cacheIds[slot];
+        if (!r.cacheIps[slot])
+            break;
+    }
+
+    uint32_t id = 0;
+    sampled_module *m = nullptr;
+    for (uint64_t i = 0; i < r.modules.size && !m; ++i)
+    {
+        if (ip >= r.modules[i].start && ip < r.modules[i].end)
+            m = &r.modules[i];
+    }
+
+    if (m)
+    {
+        if (!m->loaded)
+            LoadModule(r.scratch, *m);
+
+        const uint64_t fileOffset = ip - m->start + m->fileOffset;
+        uint64_t address = 0;
+        for (uint64_t i = 0; i < m->loads.size; ++i)
+        {
+            const Elf64ProgramHeader &ph = m->loads[i];
+            if (fileOffset >= ph.offset && fileOffset < ph.offset + ph.fileSize)
+                address = fileOffset - ph.offset + ph.virtualAddress;
+        }
+
+        // Last function starting at or below address.
+        uint64_t lo = 0;
+        uint64_t hi = m->functions.size;
+        while (lo < hi)
+        {
+            const uint64_t mid = (lo + hi) / 2;
+            if (m->functions[mid].address <= address)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if (address && lo && address < m->functions[lo - 1].address + Max<uint64_t>(m->functions[lo - 1].size, 1))
+        {
+            elf_function &fn = m->functions[lo - 1];
+            if (!fn.id)
+                fn.id = NewFunction(r, FunctionName(r.scratch, (const char *)m->strings.data + fn.nameOffset));
+            id = fn.id;
+        }
+        else
+        {
+            if (!m->unknownId)
+            {
+                const byteview module = ModuleName(m->path);
+                uint8_t *name = RegionAlloc::AllocUninit(r.scratch, module.size + 2, 1);
+                name[0] = '[';
+                MemCpy(name + 1, module.data, module.size);
+                name[module.size + 1] = ']';
+                m->unknownId = NewFunction(r, byteview{name, module.size + 2});
+            }
+            id = m->unknownId;
+        }
+    }
+
+    r.cacheIps[slot] = ip;
+    r.cacheIds[slot] = id;
+    return id;
+}
+
+void CountStack(report_state &r, const uint32_t *ids, uint32_t depth)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t i = 0; i < depth; ++i)
+        hash = (hash ^ ids[i]) * 1099511628211ull;
+    hash |= 1;
+
+    for (uint64_t slot = hash & (kStackSlots - 1);; slot = (slot + 1) & (kStackSlots - 1))
+    {
+        folded_stack &s = r.stacks[slot];
+        if (!s.hash)
+        {
+            uint32_t *copy = RegionAlloc::AllocArrayUninit<uint32_t>(r.scratch, depth).data;
+            MemCpy(copy, ids, depth * sizeof(uint32_t));
+            s = folded_stack{.hash = hash, .ids = copy, .depth = depth, .count = 1};
+            return;
+        }
+        if (s.hash == hash && s.depth == depth && MemEq(s.ids, ids, depth * sizeof(uint32_t)))
+        {
+            ++s.count;
+            return;
+        }
+    }
+}
+
+struct folded_writer
+{
+    file_handle file;
+    uint64_t size;
+    uint8_t buf[64 << 10];
+};
+
+void FoldedWrite(folded_writer &w, byteview s)
+{
+    while (s.size)
+    {
+        if (w.size == sizeof(w.buf))
+        {
+            FileWrite(w.file, (uint32_t)w.size, w.buf);
+            w.size = 0;
+        }
+        const uint64_t n = Min<uint64_t>(s.size, sizeof(w.buf) - w.size);
+        MemCpy(w.buf + w.size, s.data, n);
+        w.size += n;
+        s = byteview{s.data + n, s.size - n};
+    }
+}
+
+void Report()
+{
+    region_alloc scratch = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+
+    report_state r{.scratch = scratch};
+    r.modules = ReadModules(scratch);
+    r.functions = RegionAlloc::AllocArrayUninit<sampled_function>(scratch, kMaxFunctions).data;
+    r.cacheIps = RegionAlloc::AllocArray<uint64_t>(scratch, kIpCacheSlots).data;
+    r.cacheIds = RegionAlloc::AllocArrayUninit<uint32_t>(scratch, kIpCacheSlots).data;
+    r.stacks = RegionAlloc::AllocArray<folded_stack>(scratch, kStackSlots).data;
+    NewFunction(r, "[unknown]"_s);
+
+    const uint64_t used = Min(AtomicLoad64(&g_sampler->used), kStoreWords);
+    uint64_t samples = 0;
+    for (uint64_t at = 0; at < used;)
+    {
+        const uint64_t header = AtomicLoad64(&g_sampler->store[at]);
+        if (!header)
+            break;
+        const auto depth = (uint32_t)header;
+        const uint64_t *ips = g_sampler->store + at + 1;
+        at += 1 + depth;
+        ++samples;
+
+        // Return addresses point past the call, look up the call itself.
+        uint32_t ids[kMaxDepth];
+        for (uint32_t i = 0; i < depth; ++i)
+            ids[depth - 1 - i] = Symbolize(r, i ? ips[i] - 1 : ips[i]);
+
+        ++r.functions[ids[depth - 1]].self;
+        for (uint32_t i = 0; i < depth; ++i)
+        {
+            sampled_function &fn = r.functions[ids[i]];
+            if (fn.lastSample != (uint32_t)samples)
+            {
+                fn.lastSample = (uint32_t)samples;
+                ++fn.total;
+            }
+        }
+        CountStack(r, ids, depth);
+    }
+
+    const uint32_t index = ++g_sampler->reportIndex;
+    uint8_t pathBuf[64]{};
+    const uint64_t pathSize =
+        StringWriteFmt(span<uint8_t>{pathBuf, sizeof(pathBuf) - 1}, "nyla-cpu-%u.folded"_s, index);
+    const byteview path{pathBuf, pathSize};
+
+    file_handle file = FileOpen(path, FileOpenMode::Write);
+    if (FileValid(file))
+    {
+        auto &w = RegionAlloc::Alloc<folded_writer>(scratch);
+        w.file = file;
+        for (uint64_t slot = 0; slot < kStackSlots; ++slot)
+        {
+            const folded_stack &s = r.stacks[slot];
+            if (!s.hash)
+                continue;
+            for (uint32_t i = 0; i < s.depth; ++i)
+            {
+                if (i)
+                    FoldedWrite(w, ";"_s);
+                FoldedWrite(w, r.functions[s.ids[i]].name);
+            }
+            uint8_t countBuf[16];
+            FoldedWrite(w, byteview{countBuf, StringWriteFmt(span<uint8_t>{countBuf, sizeof(countBuf)}, " %u\n"_s,
+                                                             s.count)});
+        }
+        FileWrite(file, (uint32_t)w.size, w.buf);
+        FileClose(file);
+    }
+    else
+        LOG("cpu sampler: could not open " SV_FMT, SV_ARG(path));
+
+    // Top functions by self samples, ties by total.
+    g_sampler->topCount = 0;
+    for (uint32_t rank = 0; rank < kTopCount; ++rank)
+    {
+        uint32_t best = 0;
+        for (uint32_t i = 1; i < r.functionCount; ++i)
+        {
+            const sampled_function &fn = r.functions[i];
+            const sampled_function &b = r.functions[best];
+            if (fn.self > b.self || (fn.self == b.self && fn.total > b.total))
+                best = i;
+        }
+        sampled_function &fn = r.functions[best];
+        if (!fn.self)
+            break;
+
+        sampler_row &row = g_sampler->top[g_sampler->topCount++];
+        const uint64_t n = Min<uint64_t>(fn.name.size, kNameCap);
+        MemCpy(row.name.data.data, fn.name.data + fn.name.size - n, n);
+        row.name.size = n;
+        row.self = fn.self;
+        row.total = fn.total;
+        fn.self = 0;
+    }
+    g_sampler->reportSamples = samples;
+
+    const double seconds = (double)(GetMonotonicTimeMillis() - g_sampler->startMs) * 1e-3;
+    LOG("cpu sampler: %" PRIu64 " samples over %.1f s, %" PRIu64 " dropped, %u functions, wrote " SV_FMT, samples,
+        seconds, AtomicLoad64(&g_sampler->dropped), r.functionCount - 1, SV_ARG(path));
+    for (uint32_t i = 0; i < Min<uint32_t>(g_sampler->topCount, 10); ++i)
+    {
+        const sampler_row &row = g_sampler->top[i];
+        LOG("  %5.1f%% self %5.1f%% total  %.*s", 100.0 * row.self / samples, 100.0 * row.total / samples,
+            row.name.size, row.name.data.data);
+    }
+
+    RegionAlloc::Destroy(scratch);
+}
+
+void Start()
+{
+    if (!g_sampler)
+    {
+        g_sampler = &RegionAlloc::Alloc<sampler_state>(RegionAlloc::g_BootstrapAlloc);
+        g_sampler->storeAlloc = RegionAlloc::Create(kStoreWords * sizeof(uint64_t), 0);
+        g_sampler->store = RegionAlloc::AllocArray<uint64_t>(g_sampler->storeAlloc, kStoreWords).data;
+    }
+    else
+        MemZero(g_sampler->store, Min(g_sampler->used, kStoreWords) * sizeof(uint64_t));
+
+    g_sampler->used = 0;
+    g_sampler->dropped = 0;
+    g_sampler->startMs = GetMonotonicTimeMillis();
+
+    region_alloc scratch = RegionAlloc::Create(1 << 20, 0);
+    const bool perf = StartPerf(scratch);
+    RegionAlloc::Destroy(scratch);
+
+    if (perf)
+        g_sampler->mode = sampler_mode::Perf;
+    else if (StartTimer())
+        g_sampler->mode = sampler_mode::Timer;
+    else
+    {
+        LOG("cpu sampler: could not start perf_event_open or the SIGPROF timer");
+        return;
+    }
+
+    LOG("cpu sampler: started, %s, %u Hz", g_sampler->mode == sampler_mode::Perf ? "perf_event_open" : "SIGPROF",
+        kFrequencyHz);
+}
+
+void Stop()
+{
+    if (g_sampler->mode == sampler_mode::Perf)
+        StopPerf();
+    else
+        StopTimer();
+    g_sampler->mode = sampler_mode::Off;
+
+    Report();
+}
+
+} // namespace
+
+namespace CpuSampler
+{
+
+void API Toggle()
+{
+    if (IsRunning())
+        Stop();
+    else
+        Start();
+}
+
+auto API IsRunning() -> bool
+{
+    return g_sampler && g_sampler->mode != sampler_mode::Off;
+}
+
+void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY)
+{
+    if (!g_sampler)
+        return;
+
+    constexpr uint32_t kCols = 80;
+
+    const uint32_t headerFg = 0xFFFFFF80u;
+    const uint32_t headerBg = 0xFF202020u;
+    const uint32_t rowFg = 0xFFD0D0D0u;
+    const uint32_t rowBg = 0xFF202020u;
+
+    const bool running = IsRunning();
+    const uint32_t rows = 1 + (running ? 0 : g_sampler->topCount);
+    CellRenderer::Begin(originPxX, originPxY, kCols, rows);
+
+    uint8_t lineBuf[160];
+    uint64_t lineN;
+    if (running)
+        lineN = StringWriteFmt(span<uint8_t>{lineBuf, sizeof(lineBuf)},
+                               "cpu sampler running (F10 stop)  %" PRIu64 " words sampled"_s,
+                               Min(AtomicLoad64(&g_sampler->used), kStoreWords));
+    else
+        lineN = StringWriteFmt(span<uint8_t>{lineBuf, sizeof(lineBuf)},
+                               "cpu sampler (F10 start)  %" PRIu64 " samples   self%%  total%%"_s,
+                               g_sampler->reportSamples);
+    CellRenderer::Text(0, 0, byteview{lineBuf, lineN}, headerFg, headerBg);
+
+    for (uint32_t i = 0; i + 1 < rows; ++i)
+    {
+        const sampler_row &row = g_sampler->top[i];
+        const double samples = (double)Max<uint64_t>(g_sampler->reportSamples, 1);
+        lineN = StringWriteFmt(span<uint8_t>{lineBuf, sizeof(lineBuf)}, "%5.1f %5.1f  %.*s"_s,
+                               100.0 * row.self / samples, 100.0 * row.total / samples, row.name.size,
+                               row.name.data.data);
+        CellRenderer::Text(0, i + 1, byteview{lineBuf, lineN}, rowFg, rowBg);
+    }
+
+    CellRenderer::CmdFlush(cmd);
+}
+
+} // namespace CpuSampler
+
+} // namespace nyla
@@ -0,0 +1,27 @@
+#include "nyla/commons/cpu_sampler.h"
+
+#include "nyla/commons/fmt.h"
+
+namespace nyla
+{
+
+namespace CpuSampler
+{
+
+void API Toggle()
+{
+    LOG("cpu sampler: not available on Windows");
+}
+
+auto API IsRunning() -> bool
+{
+    return false;
+}
+
+void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY)
+{
+}
+
+} // namespace CpuSampler
+
+} // namespace nyla
@@ -2,16 +2,12 @@
 
 #include <cstdint>
 
-#include "nyla/commons/array.h" // IWYU pragma: keep
-#include "nyla/commons/inline_vec.h"
-#include "nyla/commons/minmax.h"
-#include "nyla/commons/pipeline_cache.h"
+#include "nyla/commons/cell_renderer.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/region_alloc_def.h"
 #include "nyla/commons/rhi.h"
 #include "nyla/commons/span.h"
 #include "nyla/commons/span_def.h"
-#include "nyla/commons/vec.h"
 
 namespace nyla
 {
@@ -19,22 +15,21 @@ namespace nyla
 namespace
 {
 
-pipeline_cache_handle m_Pipeline;
+constexpr inline uint32_t kMaxGlyphs = 32 * 1024;
+constexpr inline uint32_t kFgRgba = 0xFFFFFFFFu;
+constexpr inline uint32_t kBgRgba = 0x00000000u;
 
-struct draw_data
+struct debug_text_glyph
 {
-    array<uint4, 17> words;
-    int32_t originX;
-    int32_t originY;
-    uint32_t wordCount;
-    uint32_t pad;
-    array<float, 4> fg;
-    array<float, 4> bg;
+    int32_t x;
+    int32_t y;
+    cell_attr cell;
 };
 
 struct debug_text_renderer
 {
-    inline_vec<draw_data, 4> pendingDraws;
+    span<debug_text_glyph> glyphs;
+    uint32_t glyphCount;
 };
 debug_text_renderer *renderer;
 
@@ -46,61 +41,48 @@ namespace DebugTextRenderer
 void API Bootstrap(region_alloc &)
 {
     renderer = &RegionAlloc::Alloc<debug_text_renderer>(RegionAlloc::g_BootstrapAlloc);
-
-    rhi_texture_format colorFormat = rhi_texture_format::B8G8R8A8_sRGB;
-    const rhi_graphics_pipeline_desc pipelineDesc{
-        .debugName = "DebugTextRender"_s,
-        .colorTargetFormats = {&colorFormat, 1},
-        .depthFormat = rhi_texture_format::D32_Float_S8_UINT,
-    };
-    m_Pipeline = PipelineCache::Acquire(0xF3624967BC396A3C, 0x040C5CF806D5A00D, pipelineDesc);
+    renderer->glyphs = RegionAlloc::AllocArray<debug_text_glyph>(RegionAlloc::g_BootstrapAlloc, kMaxGlyphs);
 }
 
 void API Text(int32_t x, int32_t y, byteview text)
 {
-    draw_data drawData{
-        .originX = x,
-        .originY = y,
-        .wordCount = Min<uint32_t>((text.size + 3) / 4, 68),
-        .fg = {1.f, 1.f, 1.f, 1.f},
-    };
-
-    const uint64_t numBytes = Min(text.size, uint64_t(drawData.wordCount) * 4);
+    const int32_t advance = (int32_t)CellRenderer::GetDesc().cellPxW;
 
-    for (size_t i = 0; i < drawData.wordCount; ++i)
+    for (uint64_t i = 0; i < text.size; ++i, x += advance)
     {
-        uint32_t word = 0;
-        for (uint8_t j = 0; j < 4; ++j)
-        {
-            const uint32_t idx = i * 4 + j;
-            if (idx < numBytes)
-                word |= (uint32_t(uint8_t(text[idx])) << (8 * j));
-        }
-
-        drawData.words[i / 4][i % 4] = word;
+        if (renderer->glyphCount == kMaxGlyphs)
+            return;
+
+        renderer->glyphs[renderer->glyphCount++] = debug_text_glyph{
+            .x = x,
+            .y = y,
+            .cell =
+                {
+                    .glyphIndex = CellRenderer::GlyphForCodepoint(text[i]),
+                    .flags = 0,
+                    .fgRgba = kFgRgba,
+                    .bgRgba = kBgRgba,
+                },
+        };
     }
-
-    InlineVec::Append(renderer->pendingDraws, drawData);
 }
 
 void API CmdFlush(rhi_cmdlist cmd)
 {
-    if (renderer->pendingDraws.size == 0)
+    if (renderer->glyphCount == 0)
         return;
 
-    const uint32_t frameIndex = Rhi::GetFrameIndex();
-
-    Rhi::CmdBindGraphicsPipeline(cmd, PipelineCache::Resolve(m_Pipeline));
-
-    for (const draw_data &drawData : renderer->pendingDraws)
+    CellRenderer::Begin(0, 0, 0, 0);
+    for (uint32_t i = 0; i < renderer->glyphCount; ++i)
     {
-        Rhi::SetLargeDrawConstant(cmd, Span::ByteViewPtr(&drawData));
-        Rhi::CmdDraw(cmd, 3, 1, 0, 0);
+        const debug_text_glyph &glyph = renderer->glyphs[i];
+        CellRenderer::PutGlyphPx(glyph.x, glyph.y, glyph.cell);
     }
+    CellRenderer::CmdFlush(cmd);
 
-    InlineVec::Clear(renderer->pendingDraws);
+    renderer->glyphCount = 0;
 }
 
 } // namespace DebugTextRenderer
 
-} // namespace nyla
\ No newline at end of file
+} // namespace nyla
@@ -11,6 +11,7 @@
 namespace nyla
 {
 
+// Draws through the CellRenderer atlas and instance buffer, so CellRenderer must be bootstrapped too.
 namespace DebugTextRenderer
 {
 
@@ -12,6 +12,7 @@
 #include "nyla/commons/file.h"
 #include "nyla/commons/file_utils.h"
 #include "nyla/commons/fmt.h"
+#include "nyla/commons/gltf.h"
 #include "nyla/commons/inline_vec.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/mem.h"
@@ -200,8 +201,108 @@ void OnTextureEvent(const dir_watcher_event &ev, void *)
         SV_ARG(entry->dirPath), SV_ARG(entry->name), blob.size);
 }
 
+// Cooks like the asset packer: the .bin comes through the buffer uri, image uris resolve to the guids of their
+// indexed entries. The blob is allocated fresh from persistent on every reload, same as raw assets.
+void CookMeshEntry(const dev_asset_entry &entry)
+{
+    auto &gltfPath = RegionAlloc::AllocVec<uint8_t, 0x200>(g_dev->scratch);
+    InlineVec::Append(gltfPath, entry.dirPath);
+    InlineVec::Append(gltfPath, "/"_s);
+    InlineVec::Append(gltfPath, entry.name);
+
+    span<uint8_t> json;
+    file_handle file = FileOpen(gltfPath, FileOpenMode::Read);
+    if (!FileValid(file))
+        return;
+    bool readOk = TryFileReadFully(g_dev->scratch, file, json);
+    FileClose(file);
+    if (!readOk)
+    {
+        LOG("dev_assets: read failed " SV_FMT, SV_ARG((byteview)gltfPath));
+        return;
+    }
+
+    gltf_parser gltf{.jsonChunk = byteview{json.data, json.size}};
+    if (!GltfParser::Parse(gltf, g_dev->scratch) || gltf.buffers.size != 1 || !gltf.buffers[0].uri.size)
+    {
+        LOG("dev_assets: bad gltf " SV_FMT, SV_ARG((byteview)gltfPath));
+        return;
+    }
+
+    auto &binPath = RegionAlloc::AllocVec<uint8_t, 0x200>(g_dev->scratch);
+    InlineVec::Append(binPath, entry.dirPath);
+    InlineVec::Append(binPath, "/"_s);
+    InlineVec::Append(binPath, gltf.buffers[0].uri);
+
+    span<uint8_t> bin;
+    file = FileOpen(binPath, FileOpenMode::Read);
+    if (!FileValid(file))
+    {
+        LOG("dev_assets: open failed " SV_FMT, SV_ARG((byteview)binPath));
+        return;
+    }
+    readOk = TryFileReadFully(g_dev->scratch, file, bin);
+    FileClose(file);
+    if (!readOk)
+    {
+        LOG("dev_assets: read failed " SV_FMT, SV_ARG((byteview)binPath));
+        return;
+    }
+    gltf.binChunk = byteview{bin.data, bin.size};
+
+    span<uint64_t> imageGuids = RegionAlloc::AllocArray<uint64_t>(g_dev->scratch, gltf.images.size);
+    for (uint64_t i = 0; i < gltf.images.size; ++i)
+    {
+        const dev_asset_entry *image = FindEntry(entry.dirPath, gltf.images[i].uri);
+        imageGuids[i] = image ? image->guid : 0;
+    }
+
+    byteview blob = ImportMeshFromGltf(gltf, imageGuids, mesh_import_options{}, g_dev->persistent);
+    if (blob.size == 0)
+    {
+        LOG("dev_assets: mesh cook failed " SV_FMT, SV_ARG((byteview)gltfPath));
+        return;
+    }
+
+    AssetManager::Set(entry.guid, blob);
+    LOG("dev_assets: reloaded 0x%016" PRIx64 " " SV_FMT "/" SV_FMT " (%" PRIu64 " bytes)", entry.guid,
+        SV_ARG(entry.dirPath), SV_ARG(entry.name), blob.size);
+}
+
+void OnMeshEvent(const dir_watcher_event &ev, void *)
+{
+    RegionAlloc::Reset(g_dev->scratch);
+
+    dev_asset_entry *entry = nullptr;
+    byteview fullPath{};
+    file_handle file = LookupAndOpen(ev, entry, fullPath);
+    if (!file)
+        return;
+    FileClose(file);
+
+    CookMeshEntry(*entry);
+}
+
+// A .bin is only ever consumed through a glTF, so re-cook every glTF next to it.
+void OnMeshBufferEvent(const dir_watcher_event &ev, void *)
+{
+    if (!Any(ev.mask & (platform_dir_watch_event_type::Modified | platform_dir_watch_event_type::MovedTo)))
+        return;
+
+    for (uint64_t i = 0; i < g_dev->entries.size; ++i)
+    {
+        const dev_asset_entry &e = g_dev->entries[i];
+        if (Span::Eq(e.dirPath, ev.dirPath) && Span::EndsWith(e.name, ".gltf"_s))
+        {
+            RegionAlloc::Reset(g_dev->scratch);
+            CookMeshEntry(e);
+        }
+    }
+}
+
 // Raw passthrough — copy file bytes into persistent and route through AssetManager.
-// Used for asset types whose packed and source layout match (gltf, bin, wav, bdf).
+// Used for asset types whose packed and source layout match (wav, qoa, bdf, pipeline). A wav the
+// packer encodes to qoa reloads as wav, Audio tells the two apart by content.
 // Each reload allocates fresh from persistent — bounded by edits per session, OK for
 // dev sessions; promote to per-guid slots if memory growth becomes a problem.
 void OnRawAssetEvent(const dir_watcher_event &ev, void *)
@@ -241,14 +342,12 @@ void OnRawAssetEvent(const dir_watcher_event &ev, void *)
         SV_ARG(entry->dirPath), SV_ARG(entry->name), bytes.size);
 }
 
-void ScanDir(byteview dirPath, bool watchThis)
+void ScanDir(byteview dirPath)
 {
     dir_iter *it = DirIter::Create(g_dev->scratch, dirPath);
     if (!it)
         return;
 
-    bool watched = false;
-
     file_metadata meta;
     while (DirIter::Next(g_dev->scratch, *it, meta))
     {
@@ -263,7 +362,7 @@ void ScanDir(byteview dirPath, bool watchThis)
             InlineVec::Append(subDir, dirPath);
             InlineVec::Append(subDir, "/"_s);
             InlineVec::Append(subDir, meta.fileName);
-            ScanDir(subDir, true);
+            ScanDir(subDir);
             continue;
         }
 
@@ -295,13 +394,9 @@ void ScanDir(byteview dirPath, bool watchThis)
                                               .name = CopyByteview(g_dev->persistent, assetName),
                                               .guid = guid,
                                           });
-        watched = true;
     }
 
     DirIter::Destroy(*it);
-
-    if (watchThis && watched)
-        DirWatcher::WatchDir(g_dev->persistent, dirPath);
 }
 
 } // namespace
@@ -318,14 +413,18 @@ void API Bootstrap(span<const byteview> roots)
     DirWatcher::Subscribe(".spv"_s, OnSpvEvent, nullptr);
     DirWatcher::Subscribe(".png"_s, OnTextureEvent, nullptr);
     DirWatcher::Subscribe(".jpg"_s, OnTextureEvent, nullptr);
-    DirWatcher::Subscribe(".gltf"_s, OnRawAssetEvent, nullptr);
-    DirWatcher::Subscribe(".bin"_s, OnRawAssetEvent, nullptr);
+    DirWatcher::Subscribe(".gltf"_s, OnMeshEvent, nullptr);
+    DirWatcher::Subscribe(".bin"_s, OnMeshBufferEvent, nullptr);
     DirWatcher::Subscribe(".wav"_s, OnRawAssetEvent, nullptr);
+    DirWatcher::Subscribe(".qoa"_s, OnRawAssetEvent, nullptr);
     DirWatcher::Subscribe(".bdf"_s, OnRawAssetEvent, nullptr);
     DirWatcher::Subscribe(".pipeline"_s, OnRawAssetEvent, nullptr);
 
     for (uint64_t i = 0; i < roots.size; ++i)
-        ScanDir(roots[i], true);
+    {
+        ScanDir(roots[i]);
+        DirWatcher::WatchDir(roots[i]);
+    }
 
     RegionAlloc::Reset(g_dev->scratch);
 
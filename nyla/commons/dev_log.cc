@@ -3,10 +3,11 @@
 #include <cstdint>
 
 #include "nyla/commons/inline_string.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/log.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/mem.h"
 #include "nyla/commons/minmax.h"
-#include "nyla/commons/platform_mutex.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/region_alloc_def.h"
 #include "nyla/commons/span.h"
@@ -18,15 +19,12 @@ namespace nyla
 namespace
 {
 
-constexpr inline uint64_t kLineCap = 128;
 constexpr inline uint32_t kRingSize = 32;
 
 struct dev_log_state
 {
-    platform_mutex *mutex;
-    inline_string<kLineCap> ring[kRingSize];
-    uint32_t head;
-    uint32_t count;
+    inline_string<DevLog::kLineCap> ring[kRingSize];
+    uint64_t head; // lines ever appended, published after the slot is written
 };
 
 dev_log_state *g_dev_log;
@@ -39,27 +37,27 @@ namespace DevLog
 void API Bootstrap()
 {
     g_dev_log = &RegionAlloc::Alloc<dev_log_state>(RegionAlloc::g_BootstrapAlloc);
-    g_dev_log->mutex = PlatformMutex::Create(RegionAlloc::g_BootstrapAlloc);
     g_dev_log->head = 0;
-    g_dev_log->count = 0;
 }
 
 void API Push(byteview line)
+{
+    Log::PushDevLog(line);
+}
+
+void API Append(byteview line)
 {
     if (!g_dev_log)
         return;
 
     uint64_t n = Min<uint64_t>(line.size, kLineCap);
 
-    PlatformMutex::Lock(*g_dev_log->mutex);
-    auto &slot = g_dev_log->ring[g_dev_log->head];
+    const uint64_t head = g_dev_log->head;
+    auto &slot = g_dev_log->ring[head % kRingSize];
     if (n)
         MemCpy(slot.data.data, line.data, n);
     slot.size = n;
-    g_dev_log->head = (g_dev_log->head + 1) % kRingSize;
-    if (g_dev_log->count < kRingSize)
-        ++g_dev_log->count;
-    PlatformMutex::Unlock(*g_dev_log->mutex);
+    AtomicStore64(&g_dev_log->head, head + 1);
 }
 
 auto API Snapshot(region_alloc &alloc, uint32_t maxLines) -> span<byteview>
@@ -67,22 +65,26 @@ auto API Snapshot(region_alloc &alloc, uint32_t maxLines) -> span<byteview>
     if (!g_dev_log)
         return span<byteview>{};
 
-    PlatformMutex::Lock(*g_dev_log->mutex);
-
-    uint32_t n = Min<uint32_t>(maxLines, g_dev_log->count);
+    const uint64_t head = AtomicLoad64(&g_dev_log->head);
+    uint32_t n = (uint32_t)Min<uint64_t>(Min<uint64_t>(maxLines, head), kRingSize);
     span<byteview> out = RegionAlloc::AllocArray<byteview>(alloc, n);
 
     for (uint32_t i = 0; i < n; ++i)
     {
-        uint32_t idx = (g_dev_log->head + kRingSize - 1 - i) % kRingSize;
-        const auto &slot = g_dev_log->ring[idx];
-        span<uint8_t> bytes = RegionAlloc::AllocArray<uint8_t>(alloc, slot.size);
-        if (slot.size)
-            MemCpy(bytes.data, slot.data.data, slot.size);
-        out.data[i] = byteview{bytes.data, slot.size};
+        const auto &slot = g_dev_log->ring[(head - 1 - i) % kRingSize];
+        const uint64_t size = Min<uint64_t>(slot.size, kLineCap);
+        span<uint8_t> bytes = RegionAlloc::AllocArray<uint8_t>(alloc, size);
+        if (size)
+            MemCpy(bytes.data, slot.data.data, size);
+        out.data[i] = byteview{bytes.data, size};
     }
 
-    PlatformMutex::Unlock(*g_dev_log->mutex);
+    // Line head - 1 - i is torn once the writer has started on line head - 1 - i + kRingSize.
+    AtomicFence();
+    const uint64_t after = AtomicLoad64(&g_dev_log->head);
+    while (n && head - n + kRingSize <= after)
+        --n;
+    out.size = n;
     return out;
 }
 
@@ -12,8 +12,14 @@ namespace nyla
 namespace DevLog
 {
 
+constexpr inline uint64_t kLineCap = 128;
+
 void API Bootstrap();
+// Any thread. Routed through the log flusher, which is the ring's only writer.
 void API Push(byteview line);
+// The single writer: the log flusher, or the caller itself before Log::Bootstrap.
+void API Append(byteview line);
+// Lock-free against Append, lines overwritten while being copied are dropped.
 auto API Snapshot(region_alloc &alloc, uint32_t maxLines) -> span<byteview>;
 
 } // namespace DevLog
@@ -19,10 +19,12 @@
 #include "nyla/commons/platform_dir_watch.h"
 #include "nyla/commons/platform_mutex.h"
 #include "nyla/commons/platform_thread.h"
+#include "nyla/commons/profiler.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/region_alloc_def.h"
 #include "nyla/commons/span.h"
 #include "nyla/commons/span_def.h"
+#include "nyla/commons/time.h"
 
 namespace nyla
 {
@@ -34,23 +36,31 @@ struct dev_shader_root_entry
 {
     byteview srcDir;
     byteview outDir;
+    byteview cacheDir; // empty when it could not be created
 };
 
-constexpr inline uint64_t kQueueCap = 32;
 constexpr inline uint64_t kPathCap = 512;
-constexpr inline uint64_t kDirCap = 256;
-constexpr inline uint64_t kNameCap = 128;
 constexpr inline uint64_t kFilesCap = 256;
+constexpr inline uint64_t kQueueCap = kFilesCap; // a file is queued at most once
 constexpr inline uint64_t kIncludesPerFile = 16;
-
-struct compile_job
-{
-    inline_string<kPathCap> srcPath;
-    inline_string<kPathCap> outPath;
-    inline_string<kDirCap> dirPath;
-    inline_string<kNameCap> name;
-    const char *profile;
+constexpr inline uint64_t kSourcesCap = 32;
+constexpr inline uint64_t kMaxWorkers = 16;
+
+// Everything but the profile and the paths. Part of the cache key, so a change here misses the cache.
+constexpr const char *kDxcFlags[] = {
+    "-spirv",
+    "-DSPIRV=1",
+    "-fspv-target-env=vulkan1.3",
+    "-fvk-use-dx-layout",
+    "-fspv-reflect",
+    "-Zi",
+    "-Qembed_debug",
+    "-fspv-debug=vulkan-with-source",
+    "-Od",
+    "-E",
+    "main",
 };
+constexpr inline uint64_t kDxcFlagCount = sizeof(kDxcFlags) / sizeof(kDxcFlags[0]);
 
 struct shader_file
 {
@@ -59,19 +69,55 @@ struct shader_file
     inline_vec<uint16_t, kIncludesPerFile> includes;
 };
 
+// Workers only read root and relPath, which never change once a file is in the table.
+struct compile_job
+{
+    const shader_file *file;
+    bool cacheable; // false when the includes did not all fit in sources
+    const char *profile;
+    inline_vec<const shader_file *, kSourcesCap> sources; // the shader, then everything it includes
+};
+
+struct spv_hash
+{
+    uint64_t a;
+    uint64_t b;
+};
+
+struct shader_worker
+{
+    platform_thread *thread;
+    region_alloc scratch;
+    uint32_t index;
+    const shader_file *file; // being compiled, null while idle. Guarded by queueMutex
+
+    inline_string<kPathCap> srcPath;
+    inline_string<kPathCap> outPath;
+    inline_string<kPathCap> tmpPath;
+    inline_string<kPathCap> cachePath;
+    inline_string<kPathCap> cacheTmpPath;
+    inline_string<kPathCap> sourcePath;
+};
+
 struct dev_shaders_state
 {
     region_alloc persistent;
-    region_alloc workerScratch;
     region_alloc scratch;
     inline_vec<dev_shader_root_entry, 16> roots;
     inline_vec<shader_file, kFilesCap> files;
 
     platform_mutex *queueMutex;
     platform_condvar *queueCv;
+    platform_condvar *idleCv;
     inline_vec<compile_job, kQueueCap> queue;
+    dev_shaders_stats stats;
+
+    platform_mutex *versionMutex;
+    bool versionKnown;
+    spv_hash version; // the output of dxc --version, every cache key starts from it
 
-    platform_thread *worker;
+    uint32_t workerCount;
+    array<shader_worker, kMaxWorkers> workers;
 };
 
 dev_shaders_state *g_dev_shaders;
@@ -96,79 +142,281 @@ template <uint64_t Cap> void WriteCStrPath(inline_string<Cap> &out, byteview dir
     out.size -= 1;
 }
 
-template <uint64_t Cap> void WriteCStr(inline_string<Cap> &out, byteview src)
+//
+
+constexpr inline uint64_t kHashMulA = 0x9E3779B97F4A7C15;
+constexpr inline uint64_t kHashMulB = 0xC2B2AE3D27D4EB4F;
+
+auto Rotl(uint64_t x, uint32_t r) -> uint64_t
 {
-    out.size = 0;
-    InlineVec::Append(out, src);
-    InlineVec::Append(out, byteview{(const uint8_t *)"\0", 1});
-    out.size -= 1;
+    return (x << r) | (x >> (64 - r));
+}
+
+auto FMix64(uint64_t k) -> uint64_t
+{
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCD;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53;
+    k ^= k >> 33;
+    return k;
 }
 
-void RunCompile(const compile_job &job)
-{
-    const char *argv[] = {
-        "dxc",
-        "-spirv",
-        "-DSPIRV=1",
-        "-fspv-target-env=vulkan1.3",
-        "-fvk-use-dx-layout",
-        "-fspv-reflect",
-        "-Zi",
-        "-Qembed_debug",
-        "-fspv-debug=vulkan-with-source",
-        "-Od",
-        "-T",
-        job.profile,
-        "-E",
-        "main",
-        "-Fo",
-        (const char *)job.outPath.data.data,
-        (const char *)job.srcPath.data.data,
-        nullptr,
-    };
-
-    RegionAlloc::Reset(g_dev_shaders->workerScratch);
+// Two lanes, a collision has to happen in both before two different sources share a cache entry.
+void HashBytes(spv_hash &h, byteview bytes)
+{
+    uint64_t i = 0;
+    for (; i + 8 <= bytes.size; i += 8)
+    {
+        uint64_t w;
+        MemCpy(&w, bytes.data + i, 8);
+        h.a = Rotl(h.a ^ w, 29) * kHashMulA;
+        h.b = Rotl(h.b + w, 31) * kHashMulB;
+    }
 
-    byteview log{};
-    int32_t rc =
-        RunSync(span<const char *const>{argv, sizeof(argv) / sizeof(argv[0])}, g_dev_shaders->workerScratch, log);
+    // The length goes in with the tail, where one part ends and the next begins is part of the key.
+    uint64_t tail = 0;
+    MemCpy(&tail, bytes.data + i, bytes.size - i);
+    h.a = Rotl(h.a ^ tail ^ bytes.size, 29) * kHashMulA;
+    h.b = Rotl(h.b + tail + bytes.size, 31) * kHashMulB;
+}
+
+auto HashFinish(spv_hash h) -> spv_hash
+{
+    const uint64_t a = FMix64(h.a ^ Rotl(h.b, 17));
+    return spv_hash{a, FMix64(h.b ^ a)};
+}
 
-    if (rc == 0)
+void EnsureDxcVersion(shader_worker &worker)
+{
+    PlatformMutex::Lock(*g_dev_shaders->versionMutex);
+    if (!g_dev_shaders->versionKnown)
     {
-        LOG("dev_shaders: compiled " SV_FMT "/" SV_FMT, SV_ARG((byteview)job.dirPath), SV_ARG((byteview)job.name));
+        const char *argv[] = {"dxc", "--version", nullptr};
+        byteview log{};
+        const int32_t rc = RunSync(span<const char *const>{argv, 3}, worker.scratch, log);
+
+        spv_hash h{kHashMulA, kHashMulB};
+        HashBytes(h, Span::ByteViewPtr(&rc));
+        HashBytes(h, log);
+        g_dev_shaders->version = h;
+        g_dev_shaders->versionKnown = true;
     }
-    else
+    PlatformMutex::Unlock(*g_dev_shaders->versionMutex);
+}
+
+// Hashes what dxc reads. A source that can not be read, or one that did not fit in the job, makes the output
+// uncacheable.
+auto HashSources(shader_worker &worker, const compile_job &job, spv_hash &out) -> bool
+{
+    if (!job.cacheable)
+        return false;
+
+    spv_hash h = g_dev_shaders->version;
+    for (const char *flag : kDxcFlags)
+        HashBytes(h, Span::FromCStr(flag, kPathCap));
+    HashBytes(h, Span::FromCStr(job.profile, kPathCap));
+
+    for (const shader_file *source : job.sources)
+    {
+        WriteCStrPath(worker.sourcePath, source->root->srcDir, source->relPath, byteview{});
+
+        // dxc embeds the paths in the debug info.
+        HashBytes(h, (byteview)worker.sourcePath);
+
+        file_handle file = FileOpen((byteview)worker.sourcePath, FileOpenMode::Read);
+        span<uint8_t> bytes;
+        const bool ok = TryFileReadFully(worker.scratch, file, bytes);
+        if (FileValid(file))
+            FileClose(file);
+        if (!ok)
+            return false;
+
+        HashBytes(h, byteview{bytes.data, bytes.size});
+    }
+
+    out = HashFinish(h);
+    return true;
+}
+
+void WriteCachePath(inline_string<kPathCap> &out, byteview cacheDir, spv_hash key, byteview tail)
+{
+    constexpr char kHex[] = "0123456789abcdef";
+
+    array<uint8_t, 32> hex;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        hex[i] = kHex[(key.a >> (60 - 4 * i)) & 0xF];
+        hex[16 + i] = kHex[(key.b >> (60 - 4 * i)) & 0xF];
+    }
+    WriteCStrPath(out, cacheDir, byteview{hex.data, 32}, tail);
+}
+
+// Goes through tmp, whoever reads to sees the old file or the new one and never a part.
+auto CopyFileAtomic(region_alloc &scratch, byteview from, byteview tmp, byteview to) -> bool
+{
+    file_handle src = FileOpen(from, FileOpenMode::Read);
+    span<uint8_t> bytes;
+    const bool ok = TryFileReadFully(scratch, src, bytes);
+    if (FileValid(src))
+        FileClose(src);
+    if (!ok)
+        return false;
+
+    file_handle dst = FileOpen(tmp, FileOpenMode::Write);
+    if (!FileValid(dst))
+        return false;
+    const bool written = FileWrite(dst, (uint32_t)bytes.size, bytes.data) == bytes.size;
+    FileClose(dst);
+
+    return written && FileRename(tmp, to);
+}
+
+//
+
+void FinishJob(shader_worker &worker, const dev_shaders_stats &delta)
+{
+    PlatformMutex::Lock(*g_dev_shaders->queueMutex);
+    worker.file = nullptr;
+    g_dev_shaders->stats.compiled += delta.compiled;
+    g_dev_shaders->stats.cached += delta.cached;
+    g_dev_shaders->stats.failed += delta.failed;
+    g_dev_shaders->stats.dxcNs += delta.dxcNs;
+    const bool queued = g_dev_shaders->queue.size > 0;
+    PlatformMutex::Unlock(*g_dev_shaders->queueMutex);
+
+    // The others skip a job for the file this worker had, one of them can take it now.
+    if (queued)
+        PlatformCondvar::Broadcast(*g_dev_shaders->queueCv);
+    PlatformCondvar::Broadcast(*g_dev_shaders->idleCv);
+}
+
+void RunJob(shader_worker &worker, const compile_job &job)
+{
+    RegionAlloc::Reset(worker.scratch);
+    EnsureDxcVersion(worker);
+
+    const shader_file &f = *job.file;
+    const byteview dirPath = f.root->srcDir;
+    const byteview cacheDir = f.root->cacheDir;
+    WriteCStrPath(worker.srcPath, dirPath, f.relPath, byteview{});
+    WriteCStrPath(worker.outPath, f.root->outDir, f.relPath, ".spv"_s);
+    WriteCStrPath(worker.tmpPath, f.root->outDir, f.relPath, ".spv.tmp"_s);
+
+    spv_hash key{};
+    const bool keyed = cacheDir.size && HashSources(worker, job, key);
+    if (keyed)
     {
-        LOG("dev_shaders: dxc failed (rc=%d) " SV_FMT "/" SV_FMT "\n" SV_FMT, rc, SV_ARG((byteview)job.dirPath),
-            SV_ARG((byteview)job.name), SV_ARG(log));
+        WriteCachePath(worker.cachePath, cacheDir, key, ".spvc"_s);
+        if (CopyFileAtomic(worker.scratch, (byteview)worker.cachePath, (byteview)worker.tmpPath,
+                           (byteview)worker.outPath))
+        {
+            LOG("dev_shaders: cached " SV_FMT "/" SV_FMT, SV_ARG(dirPath), SV_ARG(f.relPath));
+            FinishJob(worker, dev_shaders_stats{.cached = 1});
+            return;
+        }
+    }
+
+    array<const char *, kDxcFlagCount + 7> argv;
+    uint32_t argc = 0;
+    argv[argc++] = "dxc";
+    for (const char *flag : kDxcFlags)
+        argv[argc++] = flag;
+    argv[argc++] = "-T";
+    argv[argc++] = job.profile;
+    argv[argc++] = "-Fo";
+    argv[argc++] = (const char *)worker.tmpPath.data.data;
+    argv[argc++] = (const char *)worker.srcPath.data.data;
+    argv[argc++] = nullptr;
+
+    byteview log{};
+    const uint64_t start = GetMonotonicTimeNanos();
+    const int32_t rc = RunSync(span<const char *const>{argv.data, argc}, worker.scratch, log);
+    const uint64_t dxcNs = GetMonotonicTimeNanos() - start;
+
+    if (rc != 0)
+    {
+        LOG("dev_shaders: dxc failed (rc=%d) " SV_FMT "/" SV_FMT "\n" SV_FMT, rc, SV_ARG(dirPath), SV_ARG(f.relPath),
+            SV_ARG(log));
 
         uint8_t lineBuf[256];
         uint64_t n = StringWriteFmt(span<uint8_t>{lineBuf, sizeof(lineBuf)}, "shader fail: " SV_FMT " rc=%d"_s,
-                                    SV_ARG((byteview)job.name), rc);
+                                    SV_ARG(f.relPath), rc);
         DevLog::Push(byteview{lineBuf, n});
+
+        FinishJob(worker, dev_shaders_stats{.failed = 1, .dxcNs = dxcNs});
+        return;
     }
+
+    if (!FileRename((byteview)worker.tmpPath, (byteview)worker.outPath))
+        LOG("dev_shaders: could not replace " SV_FMT, SV_ARG((byteview)worker.outPath));
+
+    LOG("dev_shaders: compiled " SV_FMT "/" SV_FMT " in %.0f ms", SV_ARG(dirPath), SV_ARG(f.relPath),
+        (double)dxcNs / 1e6);
+
+    // A source saved while dxc ran may or may not have made it into the output, which is only cached under a key
+    // that still describes the sources. The save queued another compile either way.
+    spv_hash after{};
+    if (keyed && HashSources(worker, job, after) && after.a == key.a && after.b == key.b)
+    {
+        uint8_t tail[16];
+        const uint64_t n = StringWriteFmt(span<uint8_t>{tail, sizeof(tail)}, ".tmp%u"_s, worker.index);
+        WriteCachePath(worker.cacheTmpPath, cacheDir, key, byteview{tail, n});
+        if (!CopyFileAtomic(worker.scratch, (byteview)worker.outPath, (byteview)worker.cacheTmpPath,
+                            (byteview)worker.cachePath))
+            LOG("dev_shaders: could not cache " SV_FMT, SV_ARG((byteview)worker.outPath));
+    }
+
+    FinishJob(worker, dev_shaders_stats{.compiled = 1, .dxcNs = dxcNs});
 }
 
-void WaitPopJob(compile_job &out)
+auto FileBusy(const shader_file *file) -> bool
 {
+    for (uint32_t i = 0; i < g_dev_shaders->workerCount; ++i)
+    {
+        if (g_dev_shaders->workers[i].file == file)
+            return true;
+    }
+    return false;
+}
+
+// Takes the oldest job whose shader no other worker is compiling, two dxc never write one output.
+void WaitPopJob(shader_worker &worker, compile_job &out)
+{
+    auto &queue = g_dev_shaders->queue;
+
     PlatformMutex::Lock(*g_dev_shaders->queueMutex);
-    while (g_dev_shaders->queue.size == 0)
+    for (;;)
+    {
+        uint64_t at = 0;
+        while (at < queue.size && FileBusy(queue[at].file))
+            ++at;
+
+        if (at < queue.size)
+        {
+            out = queue[at];
+            MemMove(queue.data.data + at, queue.data.data + at + 1, (queue.size - at - 1) * sizeof(compile_job));
+            queue.size -= 1;
+            worker.file = out.file;
+            break;
+        }
+
         PlatformCondvar::Wait(*g_dev_shaders->queueCv, *g_dev_shaders->queueMutex);
-    out = g_dev_shaders->queue.data.data[0];
-    if (g_dev_shaders->queue.size > 1)
-        MemMove(g_dev_shaders->queue.data.data, g_dev_shaders->queue.data.data + 1,
-                (g_dev_shaders->queue.size - 1) * sizeof(compile_job));
-    g_dev_shaders->queue.size -= 1;
+    }
     PlatformMutex::Unlock(*g_dev_shaders->queueMutex);
 }
 
-void WorkerMain(void *)
+void WorkerMain(void *user)
 {
+    auto &worker = *static_cast<shader_worker *>(user);
+    Profiler::SetThreadName("nyla-shadercc"_s);
+
     compile_job job;
     for (;;)
     {
-        WaitPopJob(job);
-        RunCompile(job);
+        WaitPopJob(worker, job);
+        PROFILE_SCOPE("dxc");
+        RunJob(worker, job);
     }
 }
 
@@ -334,8 +582,31 @@ void CollectDependents(uint16_t seedIdx, inline_vec<uint16_t, kFilesCap> &out)
     }
 }
 
-void EnqueueCompile(const shader_file &f)
+// Breadth first over the include index, the shader itself comes first.
+auto CollectSources(const shader_file *file, inline_vec<const shader_file *, kSourcesCap> &out) -> bool
+{
+    out.size = 0;
+    InlineVec::Append(out, file);
+
+    for (uint64_t cursor = 0; cursor < out.size; ++cursor)
+    {
+        for (uint16_t include : out[cursor]->includes)
+        {
+            const shader_file *source = &g_dev_shaders->files[include];
+            if (Span::Contains(span<const shader_file *>{out.data.data, out.size}, source))
+                continue;
+            if (out.size == kSourcesCap)
+                return false;
+            InlineVec::Append(out, source);
+        }
+    }
+    return true;
+}
+
+void EnqueueCompile(uint16_t idx)
 {
+    const shader_file &f = g_dev_shaders->files[idx];
+
     const char *profile;
     if (Span::EndsWith(f.relPath, ".vs.hlsl"_s))
         profile = "vs_6_0";
@@ -348,41 +619,30 @@ void EnqueueCompile(const shader_file &f)
     }
 
     compile_job pending;
+    pending.file = &f;
     pending.profile = profile;
-    WriteCStrPath(pending.srcPath, f.root->srcDir, f.relPath, byteview{});
-    WriteCStrPath(pending.outPath, f.root->outDir, f.relPath, ".spv"_s);
-    WriteCStr(pending.dirPath, f.root->srcDir);
-    WriteCStr(pending.name, f.relPath);
+    pending.cacheable = CollectSources(&f, pending.sources);
+    if (!pending.cacheable)
+        LOG("dev_shaders: more than %" PRIu64 " sources, not caching " SV_FMT, kSourcesCap, SV_ARG(f.relPath));
 
+    // A queued job takes the new sources, the edit may have changed what the shader includes.
     PlatformMutex::Lock(*g_dev_shaders->queueMutex);
     bool dup = false;
     for (uint64_t i = 0; i < g_dev_shaders->queue.size; ++i)
     {
-        const compile_job &j = g_dev_shaders->queue.data.data[i];
-        if (Span::Eq((byteview)j.srcPath, (byteview)pending.srcPath))
+        if (g_dev_shaders->queue[i].file == &f)
         {
+            g_dev_shaders->queue[i] = pending;
             dup = true;
             break;
         }
     }
-    bool dropped = false;
-    bool pushed = false;
     if (!dup)
-    {
-        if (g_dev_shaders->queue.size < kQueueCap)
-        {
-            g_dev_shaders->queue.data.data[g_dev_shaders->queue.size++] = pending;
-            pushed = true;
-        }
-        else
-            dropped = true;
-    }
+        InlineVec::Append(g_dev_shaders->queue, pending);
     PlatformMutex::Unlock(*g_dev_shaders->queueMutex);
 
-    if (pushed)
+    if (!dup)
         PlatformCondvar::Signal(*g_dev_shaders->queueCv);
-    if (dropped)
-        LOG("dev_shaders: queue full, dropped " SV_FMT, SV_ARG(f.relPath));
 }
 
 void OnShaderEvent(const dir_watcher_event &ev, void *)
@@ -415,7 +675,7 @@ void OnShaderEvent(const dir_watcher_event &ev, void *)
 
     if (isHlsl)
     {
-        EnqueueCompile(g_dev_shaders->files[idx]);
+        EnqueueCompile((uint16_t)idx);
         return;
     }
 
@@ -426,7 +686,7 @@ void OnShaderEvent(const dir_watcher_event &ev, void *)
     {
         const shader_file &f = g_dev_shaders->files[deps[i]];
         if (Span::EndsWith(f.relPath, ".hlsl"_s))
-            EnqueueCompile(f);
+            EnqueueCompile(deps[i]);
     }
 }
 
@@ -476,15 +736,16 @@ void ScanRoot(const dev_shader_root_entry *root)
 namespace DevShaders
 {
 
-void API Bootstrap(span<const dev_shader_root> roots)
+void API Bootstrap(span<const dev_shader_root> roots, uint32_t workers)
 {
     g_dev_shaders = &RegionAlloc::Alloc<dev_shaders_state>(RegionAlloc::g_BootstrapAlloc);
     g_dev_shaders->persistent = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
-    g_dev_shaders->workerScratch = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
     g_dev_shaders->scratch = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
 
     g_dev_shaders->queueMutex = PlatformMutex::Create(RegionAlloc::g_BootstrapAlloc);
     g_dev_shaders->queueCv = PlatformCondvar::Create(RegionAlloc::g_BootstrapAlloc);
+    g_dev_shaders->idleCv = PlatformCondvar::Create(RegionAlloc::g_BootstrapAlloc);
+    g_dev_shaders->versionMutex = PlatformMutex::Create(RegionAlloc::g_BootstrapAlloc);
 
     DirWatcher::Subscribe(".hlsl"_s, OnShaderEvent, nullptr);
     DirWatcher::Subscribe(".hlsli"_s, OnShaderEvent, nullptr);
@@ -493,11 +754,22 @@ void API Bootstrap(span<const dev_shader_root> roots)
     {
         byteview src = CopyByteview(g_dev_shaders->persistent, roots[i].srcDir);
         byteview out = CopyByteview(g_dev_shaders->persistent, roots[i].outDir);
+
+        inline_string<kPathCap> cachePath;
+        WriteCStrPath(cachePath, out, ".spvcache"_s, byteview{});
+        byteview cache = CopyByteview(g_dev_shaders->persistent, (byteview)cachePath);
+        if (!DirCreate(cache))
+        {
+            LOG("dev_shaders: could not create " SV_FMT ", not caching", SV_ARG(cache));
+            cache = byteview{};
+        }
+
         InlineVec::Append(g_dev_shaders->roots, dev_shader_root_entry{
                                                     .srcDir = src,
                                                     .outDir = out,
+                                                    .cacheDir = cache,
                                                 });
-        DirWatcher::WatchDir(g_dev_shaders->persistent, src);
+        DirWatcher::WatchDir(src);
     }
 
     for (uint64_t i = 0; i < g_dev_shaders->roots.size; ++i)
@@ -516,18 +788,53 @@ void API Bootstrap(span<const dev_shader_root> roots)
             continue;
         if (SpvMissing(f))
         {
-            EnqueueCompile(f);
+            EnqueueCompile((uint16_t)i);
             ++missingCount;
         }
     }
 
     RegionAlloc::Reset(g_dev_shaders->scratch);
 
-    g_dev_shaders->worker = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &WorkerMain, nullptr);
-    PlatformThread::SetName(*g_dev_shaders->worker, "nyla-shadercc");
+    if (!workers)
+        workers = GetProcessorCount();
+    g_dev_shaders->workerCount = workers < kMaxWorkers ? workers : kMaxWorkers;
+
+    for (uint32_t i = 0; i < g_dev_shaders->workerCount; ++i)
+    {
+        shader_worker &worker = g_dev_shaders->workers[i];
+        worker.scratch = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+        worker.index = i;
+        worker.file = nullptr;
+        worker.thread = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &WorkerMain, &worker);
+        PlatformThread::SetName(*worker.thread, "nyla-shadercc");
+    }
+
+    LOG("dev_shaders: %" PRIu64 " roots watched, %" PRIu64 " files indexed, %" PRIu64
+        " missing spv enqueued, %u workers",
+        g_dev_shaders->roots.size, g_dev_shaders->files.size, missingCount, g_dev_shaders->workerCount);
+}
+
+void API WaitIdle()
+{
+    PlatformMutex::Lock(*g_dev_shaders->queueMutex);
+    for (;;)
+    {
+        bool busy = g_dev_shaders->queue.size > 0;
+        for (uint32_t i = 0; i < g_dev_shaders->workerCount; ++i)
+            busy |= g_dev_shaders->workers[i].file != nullptr;
+        if (!busy)
+            break;
+        PlatformCondvar::Wait(*g_dev_shaders->idleCv, *g_dev_shaders->queueMutex);
+    }
+    PlatformMutex::Unlock(*g_dev_shaders->queueMutex);
+}
 
-    LOG("dev_shaders: %" PRIu64 " roots watched, %" PRIu64 " files indexed, %" PRIu64 " missing spv enqueued",
-        g_dev_shaders->roots.size, g_dev_shaders->files.size, missingCount);
+auto API GetStats() -> dev_shaders_stats
+{
+    PlatformMutex::Lock(*g_dev_shaders->queueMutex);
+    const dev_shaders_stats stats = g_dev_shaders->stats;
+    PlatformMutex::Unlock(*g_dev_shaders->queueMutex);
+    return stats;
 }
 
 } // namespace DevShaders
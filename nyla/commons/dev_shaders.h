@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "nyla/commons/macros.h"
 #include "nyla/commons/span_def.h"
 
@@ -12,10 +14,24 @@ struct dev_shader_root
     byteview outDir;
 };
 
+struct dev_shaders_stats
+{
+    uint64_t compiled; // dxc ran and succeeded
+    uint64_t cached;   // copied out of the compile cache without running dxc
+    uint64_t failed;
+    uint64_t dxcNs; // spent in dxc, summed over the workers
+};
+
 namespace DevShaders
 {
 
-void API Bootstrap(span<const dev_shader_root> roots);
+// Compiles on a pool of workers, one per processor unless workers says otherwise. Outputs are cached in
+// outDir/.spvcache by the contents of the shader and everything it includes, the profile and the dxc version.
+void API Bootstrap(span<const dev_shader_root> roots, uint32_t workers = 0);
+
+// Blocks until the queue is empty and no worker is busy.
+void API WaitIdle();
+auto API GetStats() -> dev_shaders_stats;
 
 } // namespace DevShaders
 
@@ -10,6 +10,7 @@
 #include "nyla/commons/region_alloc_def.h"
 #include "nyla/commons/span.h"
 #include "nyla/commons/span_def.h"
+#include "nyla/commons/time.h"
 
 namespace nyla
 {
@@ -17,10 +18,22 @@ namespace nyla
 namespace
 {
 
-struct watched_dir
+constexpr uint32_t kMaxPending = 1024;
+constexpr uint32_t kMaxPath = 0x200;
+constexpr uint64_t kDebounceNs = kDirWatcherDebounceMs * 1'000'000;
+
+constexpr platform_dir_watch_event_type kGone =
+    platform_dir_watch_event_type::Deleted | platform_dir_watch_event_type::MovedFrom;
+constexpr platform_dir_watch_event_type kThere =
+    platform_dir_watch_event_type::Modified | platform_dir_watch_event_type::MovedTo;
+
+struct pending_change
 {
-    byteview path;
-    platform_dir_watch *watch;
+    uint32_t hash;
+    uint32_t dirSize;
+    uint64_t lastNs;
+    platform_dir_watch_event_type mask;
+    inline_vec<uint8_t, kMaxPath> path; // the directory, '/', the name
 };
 
 struct dir_subscriber
@@ -32,42 +45,157 @@ struct dir_subscriber
 
 struct dir_watcher
 {
-    region_alloc *alloc;
-    inline_vec<watched_dir, 16> dirs;
+    platform_dir_watch *watch;
     inline_vec<dir_subscriber, 32> subs;
+
+    uint32_t pendingCount;
+    span<pending_change> pending; // in the order the paths first changed
+
+    dir_watcher_stats stats;
 };
 
 dir_watcher *g_watcher;
 
+//
+
+auto HashPath(byteview dir, byteview name) -> uint32_t
+{
+    uint32_t h = 2166136261u;
+    for (uint64_t i = 0; i < dir.size; ++i)
+        h = (h ^ dir[i]) * 16777619u;
+    h = (h ^ '/') * 16777619u;
+    for (uint64_t i = 0; i < name.size; ++i)
+        h = (h ^ name[i]) * 16777619u;
+    return h;
+}
+
+auto Wanted(byteview name) -> bool
+{
+    for (uint64_t i = 0; i < g_watcher->subs.size; ++i)
+    {
+        if (Span::EndsWith(name, g_watcher->subs[i].suffix))
+            return true;
+    }
+    return false;
+}
+
+void Dispatch(const dir_watcher_event &ev)
+{
+    ++g_watcher->stats.delivered;
+    for (uint64_t j = 0; j < g_watcher->subs.size; ++j)
+    {
+        dir_subscriber &sub = g_watcher->subs[j];
+        if (Span::EndsWith(ev.name, sub.suffix))
+            sub.cb(ev, sub.user);
+    }
+}
+
+// Hands out the changes that have been quiet long enough, or all of them with force.
+void Deliver(uint64_t nowNs, bool force)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < g_watcher->pendingCount; ++i)
+    {
+        pending_change &change = g_watcher->pending[i];
+        if (!force && nowNs - change.lastNs < kDebounceNs)
+        {
+            if (kept != i)
+                g_watcher->pending[kept] = change;
+            ++kept;
+            continue;
+        }
+
+        const byteview path{change.path.data.data, change.path.size};
+        Dispatch({
+            .dirPath = Span::SubSpan(path, 0, change.dirSize),
+            .name = Span::SubSpan(path, change.dirSize + 1),
+            .mask = change.mask,
+        });
+    }
+    g_watcher->pendingCount = kept;
+}
+
+// A file that is deleted and written again, or the other way around, only reports how it ended up.
+void Coalesce(const platform_dir_watch_event &raw, uint64_t nowNs)
+{
+    const uint32_t hash = HashPath(raw.dir, raw.name);
+    for (uint32_t i = 0; i < g_watcher->pendingCount; ++i)
+    {
+        pending_change &change = g_watcher->pending[i];
+        if (change.hash != hash || change.dirSize != raw.dir.size ||
+            change.path.size != raw.dir.size + 1 + raw.name.size)
+            continue;
+        if (!MemEq(change.path.data.data, raw.dir.data, raw.dir.size) ||
+            !MemEq(change.path.data.data + raw.dir.size + 1, raw.name.data, raw.name.size))
+            continue;
+
+        if (Any(raw.mask & kGone))
+            change.mask &= ~kThere;
+        if (Any(raw.mask & kThere))
+            change.mask &= ~kGone;
+        change.mask |= raw.mask;
+        change.lastNs = nowNs;
+        return;
+    }
+
+    if (raw.dir.size + 1 + raw.name.size >= kMaxPath)
+    {
+        Dispatch({.dirPath = raw.dir, .name = raw.name, .mask = raw.mask});
+        return;
+    }
+
+    if (g_watcher->pendingCount == kMaxPending)
+        Deliver(nowNs, true);
+
+    pending_change &change = g_watcher->pending[g_watcher->pendingCount++];
+    change.hash = hash;
+    change.dirSize = (uint32_t)raw.dir.size;
+    change.lastNs = nowNs;
+    change.mask = raw.mask;
+    InlineVec::Clear(change.path);
+    InlineVec::Append(change.path, raw.dir);
+    InlineVec::Append(change.path, (uint8_t)'/');
+    InlineVec::Append(change.path, raw.name);
+}
+
+void Drain()
+{
+    const uint64_t nowNs = GetMonotonicTimeNanos();
+
+    platform_dir_watch_event raw;
+    while (PlatformDirWatch::Poll(*g_watcher->watch, raw))
+    {
+        if (!Wanted(raw.name))
+            continue;
+        ++g_watcher->stats.raw;
+        Coalesce(raw, nowNs);
+    }
+}
+
 } // namespace
 
 namespace DirWatcher
 {
 
-void API Bootstrap(region_alloc &alloc)
+void API Bootstrap()
 {
     g_watcher = &RegionAlloc::Alloc<dir_watcher>(RegionAlloc::g_BootstrapAlloc);
-    g_watcher->alloc = &alloc;
 }
 
-void API WatchDir(region_alloc &alloc, byteview path)
+void API WatchDir(byteview path)
 {
     ASSERT(g_watcher);
 
-    span<uint8_t> pathCopy = RegionAlloc::AllocArray<uint8_t>(alloc, path.size + 1);
-    MemCpy(pathCopy.data, path.data, path.size);
-    pathCopy.data[path.size] = 0;
-    byteview storedPath{pathCopy.data, path.size};
-
-    platform_dir_watch *watch = PlatformDirWatch::Create(alloc, storedPath);
-    ASSERT(watch);
-
-    InlineVec::Append(g_watcher->dirs, watched_dir{
-                                           .path = storedPath,
-                                           .watch = watch,
-                                       });
+    if (!g_watcher->watch)
+    {
+        g_watcher->watch = PlatformDirWatch::Create(RegionAlloc::g_BootstrapAlloc);
+        g_watcher->pending = RegionAlloc::AllocArray<pending_change>(RegionAlloc::g_BootstrapAlloc, kMaxPending);
+    }
 
-    LOG("dir_watcher: watching " SV_FMT, SV_ARG(storedPath));
+    if (PlatformDirWatch::Add(*g_watcher->watch, path))
+        LOG("dir_watcher: watching " SV_FMT, SV_ARG(path));
+    else
+        LOG("dir_watcher: can not watch " SV_FMT, SV_ARG(path));
 }
 
 void API Subscribe(byteview suffix, dir_watcher_callback cb, void *user)
@@ -82,30 +210,29 @@ void API Subscribe(byteview suffix, dir_watcher_callback cb, void *user)
 
 void API Tick()
 {
-    if (!g_watcher)
+    if (!g_watcher || !g_watcher->watch)
         return;
 
-    for (uint64_t i = 0; i < g_watcher->dirs.size; ++i)
-    {
-        watched_dir &dir = g_watcher->dirs[i];
+    if (PlatformDirWatch::HasEvents(*g_watcher->watch))
+        Drain();
+    if (g_watcher->pendingCount)
+        Deliver(GetMonotonicTimeNanos(), false);
+}
 
-        platform_dir_watch_event raw;
-        while (PlatformDirWatch::Poll(*dir.watch, raw))
-        {
-            dir_watcher_event ev{
-                .dirPath = dir.path,
-                .name = raw.name,
-                .mask = raw.mask,
-            };
-
-            for (uint64_t j = 0; j < g_watcher->subs.size; ++j)
-            {
-                dir_subscriber &sub = g_watcher->subs[j];
-                if (Span::EndsWith(ev.name, sub.suffix))
-                    sub.cb(ev, sub.user);
-            }
-        }
-    }
+void API Flush()
+{
+    if (!g_watcher || !g_watcher->watch)
+        return;
+
+    Drain();
+    Deliver(0, true);
+}
+
+auto API GetStats() -> dir_watcher_stats
+{
+    if (!g_watcher)
+        return {};
+    return g_watcher->stats;
 }
 
 } // namespace DirWatcher
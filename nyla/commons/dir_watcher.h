@@ -1,13 +1,18 @@
 #pragma once
 
+#include <cstdint>
+
 #include "nyla/commons/macros.h"
 #include "nyla/commons/platform_dir_watch.h"
-#include "nyla/commons/region_alloc_def.h"
 #include "nyla/commons/span_def.h"
 
 namespace nyla
 {
 
+// Changes to one file reach subscribers as a single event, once the file has been quiet for this long. An editor's
+// save is a burst of writes and renames, and a tool regenerating assets is a burst of files.
+constexpr inline uint64_t kDirWatcherDebounceMs = 50;
+
 struct dir_watcher_event
 {
     byteview dirPath;
@@ -15,16 +20,30 @@ struct dir_watcher_event
     platform_dir_watch_event_type mask;
 };
 
+struct dir_watcher_stats
+{
+    uint64_t raw;       // events from the platform that some subscriber wanted
+    uint64_t delivered; // after coalescing
+};
+
 using dir_watcher_callback = void (*)(const dir_watcher_event &event, void *user);
 
 namespace DirWatcher
 {
 
-void API Bootstrap(region_alloc &alloc);
-void API WatchDir(region_alloc &alloc, byteview path);
+void API Bootstrap();
+
+// Watches path and every directory below it, including ones created later. dirPath of the events starts with path.
+void API WatchDir(byteview path);
 void API Subscribe(byteview suffix, dir_watcher_callback cb, void *user);
+
+// Costs no system calls while nothing changed and nothing waits out the debounce.
 void API Tick();
 
+// Hands every pending change to the subscribers without waiting out the debounce.
+void API Flush();
+auto API GetStats() -> dir_watcher_stats;
+
 } // namespace DirWatcher
 
 } // namespace nyla
@@ -48,8 +48,24 @@ struct Elf64SectionHeader
     uint32_t link;
     uint32_t info;
     uint64_t align;
-    uint64_t entrySizae;
+    uint64_t entrySize;
 };
 static_assert(sizeof(Elf64SectionHeader) == 64);
 
+struct Elf64Symbol
+{
+    uint32_t name;
+    uint8_t info; // type in the low nibble, binding in the high one
+    uint8_t other;
+    uint16_t sectionIndex;
+    uint64_t value;
+    uint64_t size;
+};
+static_assert(sizeof(Elf64Symbol) == 24);
+
+constexpr inline uint32_t kElfProgramLoad = 1;
+constexpr inline uint32_t kElfSectionSymbolTable = 2;
+constexpr inline uint32_t kElfSectionDynamicSymbols = 11;
+constexpr inline uint8_t kElfSymbolFunction = 2;
+
 } // namespace nyla
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "nyla/commons/cpu_sampler.h"
 #include "nyla/commons/dir_watcher.h"
 #include "nyla/commons/input_manager.h"
 #include "nyla/commons/intrin.h"
@@ -53,7 +54,7 @@ void API Bootstrap(region_alloc &alloc, const engine_init_desc &desc)
     WinOpen();
     Rhi::Bootstrap(alloc, rhi_init_desc{.flags = flags});
     InputManager::Bootstrap();
-    DirWatcher::Bootstrap(alloc);
+    DirWatcher::Bootstrap();
 }
 
 auto API FrameBegin(region_alloc &alloc) -> engine_frame
@@ -91,7 +92,7 @@ auto API FrameBegin(region_alloc &alloc) -> engine_frame
         switch (event.type)
         {
         case PlatformEventType::KeyDown:
-            InputManager::HandlePressed(input_interface_type::Keyboard, uint32_t(event.key), frameStart);
+            InputManager::HandlePressed(input_interface_type::Keyboard, uint32_t(event.key), event.timeNs);
 #if !defined(NDEBUG)
             switch (event.key)
             {
@@ -116,6 +117,15 @@ auto API FrameBegin(region_alloc &alloc) -> engine_frame
             case KeyPhysical::F7:
                 Profiler::ToggleVisible();
                 break;
+            case KeyPhysical::F8:
+                Profiler::Capture();
+                break;
+            case KeyPhysical::F9:
+                Profiler::ToggleSpikeCapture();
+                break;
+            case KeyPhysical::F10:
+                CpuSampler::Toggle();
+                break;
             case KeyPhysical::F11:
                 RenderDocTriggerCapture();
                 break;
@@ -123,18 +133,20 @@ auto API FrameBegin(region_alloc &alloc) -> engine_frame
                 break;
             }
 #else
+            if (event.key == KeyPhysical::F10)
+                CpuSampler::Toggle();
             if (event.key == KeyPhysical::F11)
                 RenderDocTriggerCapture();
 #endif
             break;
         case PlatformEventType::KeyUp:
-            InputManager::HandleReleased(input_interface_type::Keyboard, uint32_t(event.key), frameStart);
+            InputManager::HandleReleased(input_interface_type::Keyboard, uint32_t(event.key), event.timeNs);
             break;
         case PlatformEventType::MousePress:
-            InputManager::HandlePressed(input_interface_type::Mouse, event.mouse.code, frameStart);
+            InputManager::HandlePressed(input_interface_type::Mouse, event.mouse.code, event.timeNs);
             break;
         case PlatformEventType::MouseRelease:
-            InputManager::HandleReleased(input_interface_type::Mouse, event.mouse.code, frameStart);
+            InputManager::HandleReleased(input_interface_type::Mouse, event.mouse.code, event.timeNs);
             break;
         case PlatformEventType::WinResize:
             Rhi::TriggerSwapchainRecreate();
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "nyla/commons/libmain.h"
+
+namespace nyla
+{
+void UserMain();
+}
+
+// Instead of entrypoint.h, for console tools that must not need a display.
+auto main() -> int
+{
+    nyla::LibMainHeadless(nyla::UserMain);
+    return 0;
+}
@@ -25,6 +25,8 @@ auto API FileOpen(byteview path, FileOpenMode mode) -> file_handle;
 void API FileClose(file_handle file);
 auto API FileRead(file_handle file, uint32_t size, uint8_t *out) -> uint32_t;
 auto API FileWrite(file_handle file, uint32_t size, const uint8_t *in) -> uint32_t;
+// Writes every part in order, as one writev where the platform has it. Returns the bytes written, short only on error.
+auto API FileWriteGather(file_handle file, span<const byteview> parts) -> uint64_t;
 
 enum class file_seek_mode
 {
@@ -37,6 +39,12 @@ void API FileSeek(file_handle file, int64_t at, file_seek_mode mode);
 auto API FileTell(file_handle file) -> uint64_t;
 void API FileSetEnd(file_handle file);
 
+// Paths are null terminated. Replaces to if it exists, atomically where both are on one volume.
+auto API FileRename(byteview from, byteview to) -> bool;
+auto API FileDelete(byteview path) -> bool;
+// True when the directory exists afterwards, also when it did before.
+auto API DirCreate(byteview path) -> bool;
+
 auto API GetStdin() -> file_handle;
 auto API GetStdout() -> file_handle;
 auto API GetStderr() -> file_handle;
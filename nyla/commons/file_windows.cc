@@ -94,6 +94,19 @@ auto API FileWrite(file_handle file, uint32_t size, const uint8_t *in) -> uint32
     return bytesWritten;
 }
 
+auto API FileWriteGather(file_handle file, span<const byteview> parts) -> uint64_t
+{
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < parts.size; ++i)
+    {
+        const uint32_t written = FileWrite(file, (uint32_t)parts[i].size, parts[i].data);
+        total += written;
+        if (written != parts[i].size)
+            break;
+    }
+    return total;
+}
+
 void API FileSeek(file_handle file, int64_t at, file_seek_mode mode)
 {
     auto hFile = reinterpret_cast<HANDLE>(file);
@@ -139,6 +152,21 @@ void API FileSetEnd(file_handle file)
     ASSERT(SetEndOfFile(file));
 }
 
+auto API FileRename(byteview from, byteview to) -> bool
+{
+    return MoveFileExA(Span::CStr(from), Span::CStr(to), MOVEFILE_REPLACE_EXISTING);
+}
+
+auto API FileDelete(byteview path) -> bool
+{
+    return DeleteFileA(Span::CStr(path));
+}
+
+auto API DirCreate(byteview path) -> bool
+{
+    return CreateDirectoryA(Span::CStr(path), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
 struct dir_iter
 {
     HANDLE hDir;
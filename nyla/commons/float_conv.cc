@@ -0,0 +1,946 @@
+#include "nyla/commons/float_conv.h"
+
+#include <cstdint>
+
+#include "nyla/commons/float_conv_tables.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/span.h"
+
+namespace nyla
+{
+
+namespace FloatConv
+{
+
+namespace
+{
+
+using namespace FloatConvTables;
+
+constexpr uint64_t kMask63 = (uint64_t{1} << 63) - 1;
+constexpr uint64_t kMask32 = (uint64_t{1} << 32) - 1;
+
+constexpr int32_t kDoubleQMin = -1074;
+constexpr uint64_t kDoubleCMin = uint64_t{1} << 52;
+
+constexpr int32_t kFloatQMin = -149;
+constexpr uint32_t kFloatCMin = uint32_t{1} << 23;
+
+constexpr uint64_t kPow10U64[20] = {
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+constexpr double kPow10Double[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Significant digits of a literal the exact fallback looks at, the rest only decides whether it is above a halfway
+// point. A double halfway point needs at most 768 of them.
+constexpr uint32_t kMaxExactDigits = 800;
+
+struct decimal
+{
+    uint64_t digits;
+    int32_t exponent;
+};
+
+INLINE auto MulHigh(uint64_t a, uint64_t b) -> uint64_t
+{
+    uint64_t hi;
+    UMul128(a, b, hi);
+    return hi;
+}
+
+INLINE auto FLog10Pow2(int32_t e) -> int32_t
+{
+    return (int32_t)(((int64_t)e * 661971961083) >> 41);
+}
+
+INLINE auto FLog10ThreeQuartersPow2(int32_t e) -> int32_t
+{
+    return (int32_t)(((int64_t)e * 661971961083 - 274743187321) >> 41);
+}
+
+INLINE auto FLog2Pow10(int32_t e) -> int32_t
+{
+    return (int32_t)(((int64_t)e * 913124641741) >> 38);
+}
+
+INLINE auto FLog2Pow5(int32_t q) -> int32_t
+{
+    return (int32_t)(((int64_t)q * 1217359) >> 19);
+}
+
+INLINE auto U64Digits(uint64_t val, uint8_t *out) -> uint32_t
+{
+    uint8_t temp[20];
+    uint32_t n = 0;
+    do
+    {
+        temp[n++] = (uint8_t)('0' + val % 10);
+        val /= 10;
+    } while (val);
+
+    for (uint32_t i = 0; i < n; ++i)
+        out[i] = temp[n - 1 - i];
+    return n;
+}
+
+INLINE auto DoubleBits(double value) -> uint64_t
+{
+    uint64_t bits;
+    MemCpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+INLINE auto BitsDouble(uint64_t bits) -> double
+{
+    double value;
+    MemCpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//
+
+// Little endian 32 bit limbs, enough for 10^800 times the largest double halfway point.
+constexpr uint32_t kBigLimbs = 400;
+
+struct big_uint
+{
+    uint32_t limbs[kBigLimbs];
+    uint32_t size;
+};
+
+void BigSet(big_uint &self, uint64_t val)
+{
+    self.size = 0;
+    while (val)
+    {
+        self.limbs[self.size++] = (uint32_t)val;
+        val >>= 32;
+    }
+}
+
+void BigMulAdd(big_uint &self, uint32_t mul, uint32_t add)
+{
+    uint64_t carry = add;
+    for (uint32_t i = 0; i < self.size; ++i)
+    {
+        const uint64_t p = (uint64_t)self.limbs[i] * mul + carry;
+        self.limbs[i] = (uint32_t)p;
+        carry = p >> 32;
+    }
+    if (carry)
+    {
+        ASSERT(self.size < kBigLimbs);
+        self.limbs[self.size++] = (uint32_t)carry;
+    }
+}
+
+void BigMulPow5(big_uint &self, uint32_t n)
+{
+    constexpr uint32_t kPow5U32[14] = {1,      5,       25,       125,       625,        3125,       15625,
+                                       78125,  390625,  1953125,  9765625,   48828125,   244140625,  1220703125};
+    for (; n >= 13; n -= 13)
+        BigMulAdd(self, kPow5U32[13], 0);
+    if (n)
+        BigMulAdd(self, kPow5U32[n], 0);
+}
+
+void BigShl(big_uint &self, uint32_t bits)
+{
+    if (!self.size)
+        return;
+
+    const uint32_t words = bits / 32;
+    const uint32_t rem = bits % 32;
+    ASSERT(self.size + words + 1 <= kBigLimbs);
+
+    if (rem)
+    {
+        self.limbs[self.size + words] = self.limbs[self.size - 1] >> (32 - rem);
+        for (uint32_t i = self.size - 1; i > 0; --i)
+            self.limbs[i + words] = (self.limbs[i] << rem) | (self.limbs[i - 1] >> (32 - rem));
+        self.limbs[words] = self.limbs[0] << rem;
+        self.size += words + (self.limbs[self.size + words] ? 1 : 0);
+    }
+    else
+    {
+        for (uint32_t i = self.size; i > 0; --i)
+            self.limbs[i - 1 + words] = self.limbs[i - 1];
+        self.size += words;
+    }
+    for (uint32_t i = 0; i < words; ++i)
+        self.limbs[i] = 0;
+}
+
+// Drops the low bits, returning whether the first dropped bit was set and whether any other one was.
+void BigShr(big_uint &self, uint32_t bits, bool &half, bool &sticky)
+{
+    half = false;
+    sticky = false;
+    if (!bits)
+        return;
+
+    const uint32_t words = bits / 32;
+    const uint32_t rem = bits % 32;
+    const uint32_t halfBit = bits - 1;
+    for (uint32_t i = 0; i < self.size && i <= halfBit / 32; ++i)
+    {
+        uint32_t limb = self.limbs[i];
+        if (i == halfBit / 32)
+        {
+            half = (limb >> (halfBit % 32)) & 1;
+            limb &= (uint32_t)((uint64_t{1} << (halfBit % 32)) - 1);
+        }
+        sticky |= limb != 0;
+    }
+
+    if (words >= self.size)
+    {
+        self.size = 0;
+        return;
+    }
+
+    const uint32_t newSize = self.size - words;
+    for (uint32_t i = 0; i < newSize; ++i)
+    {
+        uint64_t v = self.limbs[i + words] >> rem;
+        if (rem && i + words + 1 < self.size)
+            v |= (uint64_t)self.limbs[i + words + 1] << (32 - rem);
+        self.limbs[i] = (uint32_t)v;
+    }
+    self.size = newSize;
+    while (self.size && !self.limbs[self.size - 1])
+        --self.size;
+}
+
+// Divides in place, returns the remainder.
+auto BigDivSmall(big_uint &self, uint32_t div) -> uint32_t
+{
+    uint64_t rem = 0;
+    for (uint32_t i = self.size; i > 0; --i)
+    {
+        const uint64_t cur = (rem << 32) | self.limbs[i - 1];
+        self.limbs[i - 1] = (uint32_t)(cur / div);
+        rem = cur % div;
+    }
+    while (self.size && !self.limbs[self.size - 1])
+        --self.size;
+    return (uint32_t)rem;
+}
+
+auto BigCompare(const big_uint &lhs, const big_uint &rhs) -> int32_t
+{
+    if (lhs.size != rhs.size)
+        return lhs.size < rhs.size ? -1 : 1;
+    for (uint32_t i = lhs.size; i > 0; --i)
+    {
+        if (lhs.limbs[i - 1] != rhs.limbs[i - 1])
+            return lhs.limbs[i - 1] < rhs.limbs[i - 1] ? -1 : 1;
+    }
+    return 0;
+}
+
+//
+
+// Schubfach, after Raffaello Giulietti's DoubleToDecimal: one rounded-to-odd 128 bit product per bound, no loops.
+auto RoundOdd(uint64_t g1, uint64_t g0, uint64_t cp) -> uint64_t
+{
+    const uint64_t x1 = MulHigh(g0, cp);
+    const uint64_t y0 = g1 * cp;
+    const uint64_t y1 = MulHigh(g1, cp);
+    const uint64_t z = (y0 >> 1) + x1;
+    const uint64_t vbp = y1 + (z >> 63);
+    return vbp | (((z & kMask63) + kMask63) >> 63);
+}
+
+auto RoundOdd32(uint64_t g, uint64_t cp) -> uint32_t
+{
+    const uint64_t x1 = MulHigh(g, cp);
+    const uint64_t vbp = x1 >> 31;
+    return (uint32_t)(vbp | (((x1 & kMask32) + kMask32) >> 32));
+}
+
+auto ShortestDouble(int32_t q, uint64_t c, int32_t dk) -> decimal
+{
+    const uint64_t out = c & 1;
+    const uint64_t cb = c << 2;
+    const uint64_t cbr = cb + 2;
+    uint64_t cbl;
+    int32_t k;
+    if (c != kDoubleCMin || q == kDoubleQMin)
+    {
+        cbl = cb - 2;
+        k = FLog10Pow2(q);
+    }
+    else
+    {
+        cbl = cb - 1;
+        k = FLog10ThreeQuartersPow2(q);
+    }
+    const int32_t h = q + FLog2Pow10(-k) + 2;
+
+    const uint64_t *g = kPow10Split[k - kPow10SplitMinK];
+    const uint64_t vb = RoundOdd(g[0], g[1], cb << h);
+    const uint64_t vbl = RoundOdd(g[0], g[1], cbl << h);
+    const uint64_t vbr = RoundOdd(g[0], g[1], cbr << h);
+
+    const uint64_t s = vb >> 2;
+    if (s >= 100)
+    {
+        const uint64_t sp10 = s / 10 * 10;
+        const uint64_t tp10 = sp10 + 10;
+        const bool upin = vbl + out <= sp10 << 2;
+        const bool wpin = (tp10 << 2) + out <= vbr;
+        if (upin != wpin)
+            return {upin ? sp10 : tp10, k};
+    }
+
+    const uint64_t t = s + 1;
+    const bool uin = vbl + out <= s << 2;
+    const bool win = (t << 2) + out <= vbr;
+    if (uin != win)
+        return {uin ? s : t, k + dk};
+
+    const int64_t cmp = (int64_t)(vb - ((s + t) << 1));
+    return {cmp < 0 || (cmp == 0 && (s & 1) == 0) ? s : t, k + dk};
+}
+
+auto ShortestFloat(int32_t q, uint32_t c, int32_t dk) -> decimal
+{
+    const uint32_t out = c & 1;
+    const uint64_t cb = (uint64_t)c << 2;
+    const uint64_t cbr = cb + 2;
+    uint64_t cbl;
+    int32_t k;
+    if (c != kFloatCMin || q == kFloatQMin)
+    {
+        cbl = cb - 2;
+        k = FLog10Pow2(q);
+    }
+    else
+    {
+        cbl = cb - 1;
+        k = FLog10ThreeQuartersPow2(q);
+    }
+    const int32_t h = q + FLog2Pow10(-k) + 33;
+
+    const uint64_t g = kPow10Split[k - kPow10SplitMinK][0] + 1;
+    const uint32_t vb = RoundOdd32(g, cb << h);
+    const uint32_t vbl = RoundOdd32(g, cbl << h);
+    const uint32_t vbr = RoundOdd32(g, cbr << h);
+
+    const uint32_t s = vb >> 2;
+    if (s >= 100)
+    {
+        const uint32_t sp10 = 10 * (uint32_t)(((uint64_t)s * 1717986919) >> 34);
+        const uint32_t tp10 = sp10 + 10;
+        const bool upin = vbl + out <= sp10 << 2;
+        const bool wpin = (tp10 << 2) + out <= vbr;
+        if (upin != wpin)
+            return {upin ? sp10 : tp10, k};
+    }
+
+    const uint32_t t = s + 1;
+    const bool uin = vbl + out <= s << 2;
+    const bool win = (t << 2) + out <= vbr;
+    if (uin != win)
+        return {uin ? s : t, k + dk};
+
+    const int32_t cmp = (int32_t)(vb - ((s + t) << 1));
+    return {cmp < 0 || (cmp == 0 && (s & 1) == 0) ? s : t, k + dk};
+}
+
+auto WriteNonFinite(bool nan, bool negative, uint8_t *out) -> uint32_t
+{
+    uint32_t n = 0;
+    if (negative)
+        out[n++] = '-';
+    MemCpy(out + n, nan ? "nan" : "inf", 3);
+    return n + 3;
+}
+
+auto WriteShortest(decimal dec, uint8_t *out) -> uint32_t
+{
+    while (dec.digits % 10 == 0)
+    {
+        dec.digits /= 10;
+        ++dec.exponent;
+    }
+
+    uint8_t digits[20];
+    const uint32_t len = U64Digits(dec.digits, digits);
+    const int32_t point = (int32_t)len + dec.exponent;
+
+    uint32_t n = 0;
+    if (point > 0 && point <= 21)
+    {
+        if (dec.exponent >= 0)
+        {
+            MemCpy(out, digits, len);
+            n = len;
+            for (int32_t i = 0; i < dec.exponent; ++i)
+                out[n++] = '0';
+        }
+        else
+        {
+            MemCpy(out, digits, (uint32_t)point);
+            n = (uint32_t)point;
+            out[n++] = '.';
+            MemCpy(out + n, digits + point, len - (uint32_t)point);
+            n += len - (uint32_t)point;
+        }
+    }
+    else if (point > -6 && point <= 0)
+    {
+        out[n++] = '0';
+        out[n++] = '.';
+        for (int32_t i = point; i < 0; ++i)
+            out[n++] = '0';
+        MemCpy(out + n, digits, len);
+        n += len;
+    }
+    else
+    {
+        out[n++] = digits[0];
+        if (len > 1)
+        {
+            out[n++] = '.';
+            MemCpy(out + n, digits + 1, len - 1);
+            n += len - 1;
+        }
+        out[n++] = 'e';
+        const int32_t exp = point - 1;
+        out[n++] = exp < 0 ? '-' : '+';
+        n += U64Digits((uint64_t)(exp < 0 ? -exp : exp), out + n);
+    }
+    return n;
+}
+
+//
+
+// Exact comparison of the literal against the halfway point above m 2^e, for when the 128 bit estimate can not
+// decide. The estimate is never above the value, so only m and m + 1 ulp are candidates.
+auto RoundExact(uint64_t m, int32_t e, uint64_t mantissa, int64_t exponent10, bool truncated, byteview text)
+    -> double
+{
+    static big_uint value;
+    static big_uint halfway;
+
+    int64_t exp10 = exponent10;
+    bool sticky = false;
+    if (!truncated)
+    {
+        BigSet(value, mantissa);
+    }
+    else
+    {
+        // Digits again, straight from the text.
+        BigSet(value, 0);
+        exp10 = 0;
+        uint32_t kept = 0;
+        uint32_t chunk = 0;
+        uint32_t chunkDigits = 0;
+        bool afterPoint = false;
+        uint64_t i = 0;
+        if (i < text.size && (text[i] == '-' || text[i] == '+'))
+            ++i;
+        for (; i < text.size; ++i)
+        {
+            const uint8_t ch = text[i];
+            if (ch == '.')
+            {
+                afterPoint = true;
+                continue;
+            }
+            if (ch < '0' || ch > '9')
+                break;
+
+            const uint32_t digit = ch - '0';
+            if (kept == 0 && digit == 0)
+            {
+                if (afterPoint)
+                    --exp10;
+                continue;
+            }
+            if (kept < kMaxExactDigits)
+            {
+                chunk = chunk * 10 + digit;
+                if (++chunkDigits == 9)
+                {
+                    BigMulAdd(value, 1000000000, chunk);
+                    chunk = 0;
+                    chunkDigits = 0;
+                }
+                ++kept;
+                if (afterPoint)
+                    --exp10;
+            }
+            else
+            {
+                sticky |= digit != 0;
+                if (!afterPoint)
+                    ++exp10;
+            }
+        }
+        if (chunkDigits)
+        {
+            BigMulAdd(value, (uint32_t)kPow10U64[chunkDigits], chunk);
+        }
+
+        if (i < text.size && (text[i] == 'e' || text[i] == 'E'))
+        {
+            ++i;
+            bool negativeExp = false;
+            if (i < text.size && (text[i] == '-' || text[i] == '+'))
+                negativeExp = text[i++] == '-';
+            int64_t exp = 0;
+            for (; i < text.size && text[i] >= '0' && text[i] <= '9'; ++i)
+            {
+                if (exp < 100000)
+                    exp = exp * 10 + (text[i] - '0');
+            }
+            exp10 += negativeExp ? -exp : exp;
+        }
+    }
+
+    // value 10^exp10 against (2m + 1) 2^(e - 1), both sides scaled to integers.
+    BigSet(halfway, 2 * m + 1);
+    const int64_t shift = exp10 - (e - 1);
+    if (exp10 >= 0)
+        BigMulPow5(value, (uint32_t)exp10);
+    else
+        BigMulPow5(halfway, (uint32_t)-exp10);
+    if (shift >= 0)
+        BigShl(value, (uint32_t)shift);
+    else
+        BigShl(halfway, (uint32_t)-shift);
+
+    int32_t cmp = BigCompare(value, halfway);
+    if (cmp == 0 && sticky)
+        cmp = 1;
+    if (cmp > 0 || (cmp == 0 && (m & 1)))
+        ++m;
+    if (m == uint64_t{1} << 53)
+    {
+        m >>= 1;
+        ++e;
+    }
+
+    if (m < kDoubleCMin)
+        return BitsDouble(m);
+    if (e + 1075 >= 2047)
+        return BitsDouble(uint64_t{0x7FF} << 52);
+    return BitsDouble(((uint64_t)(e + 1075) << 52) | (m & (kDoubleCMin - 1)));
+}
+
+} // namespace
+
+auto API FormatShortest(double value, uint8_t *out) -> uint32_t
+{
+    const uint64_t bits = DoubleBits(value);
+    const uint64_t t = bits & (kDoubleCMin - 1);
+    const uint32_t bq = (uint32_t)(bits >> 52) & 0x7FF;
+    const bool negative = bits >> 63;
+    if (bq == 0x7FF)
+        return WriteNonFinite(t != 0, negative && !t, out);
+
+    uint32_t n = 0;
+    if (negative)
+        out[n++] = '-';
+
+    decimal dec;
+    if (bq != 0)
+    {
+        const int32_t mq = 1075 - (int32_t)bq;
+        const uint64_t c = kDoubleCMin | t;
+        if (mq > 0 && mq < 53 && ((c >> mq) << mq) == c)
+            dec = {c >> mq, 0};
+        else
+            dec = ShortestDouble(-mq, c, 0);
+    }
+    else if (t != 0)
+    {
+        dec = ShortestDouble(kDoubleQMin, t, 0);
+    }
+    else
+    {
+        out[n++] = '0';
+        return n;
+    }
+    return n + WriteShortest(dec, out + n);
+}
+
+auto API FormatShortest(float value, uint8_t *out) -> uint32_t
+{
+    uint32_t bits;
+    MemCpy(&bits, &value, sizeof(bits));
+    const uint32_t t = bits & (kFloatCMin - 1);
+    const uint32_t bq = (bits >> 23) & 0xFF;
+    const bool negative = bits >> 31;
+    if (bq == 0xFF)
+        return WriteNonFinite(t != 0, negative && !t, out);
+
+    uint32_t n = 0;
+    if (negative)
+        out[n++] = '-';
+
+    decimal dec;
+    if (bq != 0)
+    {
+        const int32_t mq = 150 - (int32_t)bq;
+        const uint32_t c = kFloatCMin | t;
+        if (mq > 0 && mq < 24 && ((c >> mq) << mq) == c)
+            dec = {c >> mq, 0};
+        else
+            dec = ShortestFloat(-mq, c, 0);
+    }
+    else if (t != 0)
+    {
+        dec = ShortestFloat(kFloatQMin, t, 0);
+    }
+    else
+    {
+        out[n++] = '0';
+        return n;
+    }
+    return n + WriteShortest(dec, out + n);
+}
+
+auto API FormatFixed(double value, uint32_t precision, span<uint8_t> out) -> uint32_t
+{
+    precision = Min(precision, kMaxFixedPrecision);
+
+    const uint64_t bits = DoubleBits(value);
+    const uint64_t t = bits & (kDoubleCMin - 1);
+    const uint32_t bq = (uint32_t)(bits >> 52) & 0x7FF;
+    const bool negative = bits >> 63;
+    if (bq == 0x7FF)
+    {
+        ASSERT(out.size >= 4);
+        return WriteNonFinite(t != 0, negative, out.data);
+    }
+
+    // value 10^precision, rounded half to even to an integer, as decimal digits.
+    const uint64_t m = bq ? (kDoubleCMin | t) : t;
+    const int32_t e = bq ? (int32_t)bq - 1075 : kDoubleQMin;
+
+    uint8_t digitsBuf[310 + kMaxFixedPrecision + 10];
+    uint32_t len = 0;
+    bool fast = false;
+    if (m == 0)
+    {
+        digitsBuf[len++] = '0';
+        fast = true;
+    }
+    else if (e < 0 && e > -128 && precision < 20)
+    {
+        uint64_t hi;
+        const uint64_t lo = UMul128(m, kPow10U64[precision], hi);
+        const uint32_t shift = (uint32_t)-e;
+
+        uint64_t q;
+        bool half;
+        bool sticky;
+        if (shift < 64)
+        {
+            q = (lo >> shift) | (hi << (64 - shift));
+            half = (lo >> (shift - 1)) & 1;
+            sticky = (lo & ((uint64_t{1} << (shift - 1)) - 1)) != 0;
+            fast = (hi >> shift) == 0;
+        }
+        else
+        {
+            const uint32_t hs = shift - 64;
+            q = hs ? hi >> hs : hi;
+            half = hs ? (hi >> (hs - 1)) & 1 : lo >> 63;
+            sticky = hs ? ((hi & ((uint64_t{1} << (hs - 1)) - 1)) | lo) != 0 : (lo & kMask63) != 0;
+            fast = true;
+        }
+        if (fast && half && (sticky || (q & 1)))
+            fast = ++q != 0;
+        if (fast)
+            len = U64Digits(q, digitsBuf);
+    }
+
+    if (!fast)
+    {
+        static big_uint big;
+        BigSet(big, m);
+        BigMulPow5(big, precision);
+        const int32_t shift = e + (int32_t)precision;
+        if (shift >= 0)
+        {
+            BigShl(big, (uint32_t)shift);
+        }
+        else
+        {
+            bool half;
+            bool sticky;
+            BigShr(big, (uint32_t)-shift, half, sticky);
+            if (half && (sticky || (big.size && (big.limbs[0] & 1))))
+                BigMulAdd(big, 1, 1);
+        }
+
+        // Nine digits at a time from the bottom.
+        uint8_t reversed[sizeof(digitsBuf)];
+        uint32_t count = 0;
+        while (big.size)
+        {
+            uint32_t chunk = BigDivSmall(big, 1000000000);
+            for (uint32_t i = 0; i < 9 && (big.size || chunk); ++i)
+            {
+                reversed[count++] = (uint8_t)('0' + chunk % 10);
+                chunk /= 10;
+            }
+        }
+        if (!count)
+            reversed[count++] = '0';
+        for (uint32_t i = 0; i < count; ++i)
+            digitsBuf[i] = reversed[count - 1 - i];
+        len = count;
+    }
+
+    // Integer part, then the last precision digits after the point.
+    const uint32_t intLen = len > precision ? len - precision : 0;
+    const uint32_t total = (uint32_t)negative + (intLen ? intLen : 1) + (precision ? precision + 1 : 0);
+    ASSERT(total <= out.size);
+
+    uint32_t n = 0;
+    if (negative)
+        out[n++] = '-';
+    if (intLen)
+    {
+        MemCpy(out.data + n, digitsBuf, intLen);
+        n += intLen;
+    }
+    else
+    {
+        out[n++] = '0';
+    }
+    if (precision)
+    {
+        out[n++] = '.';
+        const uint32_t fracLen = len - intLen;
+        for (uint32_t i = fracLen; i < precision; ++i)
+            out[n++] = '0';
+        MemCpy(out.data + n, digitsBuf + intLen, fracLen);
+        n += fracLen;
+    }
+    return n;
+}
+
+auto API DecimalToDouble(uint64_t mantissa, int64_t exponent10, bool negative, bool truncated, byteview text)
+    -> double
+{
+    double result;
+    if (mantissa == 0)
+    {
+        result = 0;
+    }
+    else if (!truncated && exponent10 >= -22 && exponent10 <= 22 && mantissa <= uint64_t{1} << 53)
+    {
+        // Clinger: both operands exact, so the one rounding is the only one.
+        result = (double)mantissa;
+        if (exponent10 < 0)
+            result /= kPow10Double[-exponent10];
+        else
+            result *= kPow10Double[exponent10];
+    }
+    else if (exponent10 < kPow5MinQ)
+    {
+        result = 0;
+    }
+    else if (exponent10 > kPow5MaxQ)
+    {
+        result = BitsDouble(uint64_t{0x7FF} << 52);
+    }
+    else
+    {
+        // Eisel-Lemire: mantissa 5^q 2^s as a 192 bit product with the normalized power, the top 54 bits are the
+        // result and a round bit unless the dropped bits sit too close to a halfway point.
+        const int32_t q = (int32_t)exponent10;
+        const uint32_t lz = 63 - (uint32_t)BitScanReverse64(mantissa);
+        const uint64_t w = mantissa << lz;
+        const uint64_t *pow5 = kPow5Floor[q - kPow5MinQ];
+        const bool exactPow5 = q >= 0 && q <= 55;
+
+        uint64_t lowHi;
+        const uint64_t lo = UMul128(w, pow5[1], lowHi);
+        uint64_t hi;
+        const uint64_t midLo = UMul128(w, pow5[0], hi);
+        const uint64_t mid = midLo + lowHi;
+        hi += mid < midLo;
+
+        const uint32_t upper = (uint32_t)(hi >> 63);
+        const uint32_t shift = 9 + upper;
+        const uint64_t restMask = (uint64_t{1} << shift) - 1;
+        const uint64_t restHi = hi & restMask;
+        uint64_t mant = hi >> shift;
+        int32_t e2 = q + FLog2Pow5(q) + 11 - (int32_t)lz + (int32_t)upper;
+
+        // The true product is above the computed one by less than 2 in units of mid, or by up to 2^(lz + 1) units
+        // of hi when digits were dropped.
+        bool decided;
+        bool roundUp = false;
+        if (!(mant & 1))
+        {
+            if (truncated)
+                decided = restHi + (uint64_t{4} << lz) <= restMask;
+            else
+                decided = restHi != restMask || mid < ~uint64_t{0} - 1;
+        }
+        else if (truncated || restHi || mid)
+        {
+            decided = true;
+            roundUp = true;
+        }
+        else if (exactPow5)
+        {
+            decided = true;
+            roundUp = lo || (mant & 2);
+        }
+        else
+        {
+            decided = mant & 2;
+            roundUp = true;
+        }
+
+        if (decided && e2 + 1075 > 0)
+        {
+            mant = (mant >> 1) + roundUp;
+            if (mant == uint64_t{1} << 53)
+            {
+                mant >>= 1;
+                ++e2;
+            }
+            if (e2 + 1075 >= 2047)
+                result = BitsDouble(uint64_t{0x7FF} << 52);
+            else
+                result = BitsDouble(((uint64_t)(e2 + 1075) << 52) | (mant & (kDoubleCMin - 1)));
+        }
+        else
+        {
+            // Truncate the estimate hi 2^(q + log2(5^q) + 1 - lz) to a double and settle m against m + 1 ulp.
+            const int32_t bitLen = 63 + (int32_t)upper;
+            int32_t e = q + FLog2Pow5(q) + 1 - (int32_t)lz + bitLen - 53;
+            uint64_t m = hi >> (bitLen - 53);
+            if (e < kDoubleQMin)
+            {
+                const int32_t extra = kDoubleQMin - e;
+                m = extra >= 64 ? 0 : m >> extra;
+                e = kDoubleQMin;
+            }
+            if (e + 1075 >= 2047)
+                result = BitsDouble(uint64_t{0x7FF} << 52);
+            else
+                result = RoundExact(m, e, mantissa, exponent10, truncated, text);
+        }
+    }
+    return negative ? -result : result;
+}
+
+auto API ParseDouble(byteview text, double &out) -> uint64_t
+{
+    uint64_t i = 0;
+    const bool negative = i < text.size && text[i] == '-';
+    if (negative)
+        ++i;
+
+    uint64_t mantissa = 0;
+    uint32_t digits = 0;
+    int64_t exponent10 = 0;
+    bool truncated = false;
+    bool any = false;
+
+    for (; i < text.size && text[i] >= '0' && text[i] <= '9'; ++i)
+    {
+        any = true;
+        const uint32_t digit = text[i] - '0';
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + digit;
+            digits += mantissa != 0;
+        }
+        else
+        {
+            truncated |= digit != 0;
+            ++exponent10;
+        }
+    }
+    if (i < text.size && text[i] == '.')
+    {
+        ++i;
+        for (; i < text.size && text[i] >= '0' && text[i] <= '9'; ++i)
+        {
+            any = true;
+            const uint32_t digit = text[i] - '0';
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + digit;
+                digits += mantissa != 0;
+                --exponent10;
+            }
+            else
+            {
+                truncated |= digit != 0;
+            }
+        }
+    }
+    if (!any)
+    {
+        out = 0;
+        return 0;
+    }
+
+    if (i < text.size && (text[i] == 'e' || text[i] == 'E'))
+    {
+        uint64_t j = i + 1;
+        bool negativeExp = false;
+        if (j < text.size && (text[j] == '-' || text[j] == '+'))
+            negativeExp = text[j++] == '-';
+        if (j < text.size && text[j] >= '0' && text[j] <= '9')
+        {
+            int64_t exp = 0;
+            for (; j < text.size && text[j] >= '0' && text[j] <= '9'; ++j)
+            {
+                if (exp < 100000)
+                    exp = exp * 10 + (text[j] - '0');
+            }
+            exponent10 += negativeExp ? -exp : exp;
+            i = j;
+        }
+    }
+
+    out = DecimalToDouble(mantissa, exponent10, negative, truncated, byteview{text.data, i});
+    return i;
+}
+
+} // namespace FloatConv
+
+} // namespace nyla
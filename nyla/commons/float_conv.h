@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+namespace FloatConv
+{
+
+// Longest FormatShortest output, "-0.0000012345678901234567" or "-1.2345678901234567e-308".
+constexpr inline uint32_t kMaxShortestChars = 32;
+
+constexpr inline uint32_t kMaxFixedPrecision = 100;
+
+// Fewest digits that parse back to the same value (Schubfach). Plain notation while the decimal point lands within
+// 21 digits left or 6 digits right of the digits, scientific otherwise. out needs kMaxShortestChars.
+auto API FormatShortest(double value, uint8_t *out) -> uint32_t;
+auto API FormatShortest(float value, uint8_t *out) -> uint32_t;
+
+// Exactly rounded (half to even) like printf %.*f, including "-0.000" and "inf"/"nan". Asserts if out is too small,
+// 310 + precision bytes always fit.
+auto API FormatFixed(double value, uint32_t precision, span<uint8_t> out) -> uint32_t;
+
+// Correctly rounded value of (negative ? -1 : 1) * mantissa * 10^exponent10, where mantissa holds the first 19
+// significant digits. truncated says nonzero digits were dropped, text is then read again for the exact fallback,
+// so it has to be the whole literal ([-]digits[.digits][e[+-]digits]).
+auto API DecimalToDouble(uint64_t mantissa, int64_t exponent10, bool negative, bool truncated, byteview text)
+    -> double;
+
+// Parses a JSON style number from the start of text. Returns the bytes consumed, 0 when there is no number.
+auto API ParseDouble(byteview text, double &out) -> uint64_t;
+
+} // namespace FloatConv
+
+} // namespace nyla
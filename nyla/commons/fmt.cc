@@ -3,14 +3,15 @@
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
-#include <cstdio>
 
 #include "nyla/commons/array_def.h"
 #include "nyla/commons/byteparser.h"
 #include "nyla/commons/file.h"
+#include "nyla/commons/float_conv.h"
 #include "nyla/commons/hex.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/mem.h"
+#include "nyla/commons/minmax.h"
 #include "nyla/commons/word.h"
 
 namespace nyla
@@ -143,6 +144,24 @@ void WriteFmt(auto &&consumer, byteview fmt, va_list args)
 
             case '.': {
                 uint8_t ch2 = ByteParser::ReadOrDefault(parser, '\0');
+
+                if (ch2 >= '0' && ch2 <= '9')
+                {
+                    uint32_t precision = 0;
+                    while (ch2 >= '0' && ch2 <= '9')
+                    {
+                        precision = precision * 10 + (uint32_t)(ch2 - '0');
+                        ch2 = ByteParser::ReadOrDefault(parser, '\0');
+                    }
+                    ASSERT(ch2 == 'f');
+
+                    uint8_t buf[310 + FloatConv::kMaxFixedPrecision + 4];
+                    uint32_t len =
+                        FloatConv::FormatFixed(va_arg(args, double), precision, span<uint8_t>{buf, sizeof(buf)});
+                    EmitPadded(consumer, buf, len, width, padCh);
+                    break;
+                }
+
                 uint8_t ch3 = ByteParser::ReadOrDefault(parser, '\0');
 
                 switch ((uint16_t)(ch2 | (ch3 << 8)))
@@ -261,15 +280,16 @@ void WriteFmt(auto &&consumer, byteview fmt, va_list args)
             }
 
             case 'f': {
-                double val = va_arg(args, double);
-                char tmp[512];
-                int n = ::snprintf(tmp, sizeof(tmp), "%f", val);
-                if (n > 0)
-                {
-                    if ((uint64_t)n >= sizeof(tmp))
-                        n = sizeof(tmp) - 1;
-                    consumer((const uint8_t *)tmp, (uint64_t)n);
-                }
+                uint8_t buf[310 + 6 + 4];
+                uint32_t len = FloatConv::FormatFixed(va_arg(args, double), 6, span<uint8_t>{buf, sizeof(buf)});
+                EmitPadded(consumer, buf, len, width, padCh);
+                break;
+            }
+
+            case 'g': {
+                uint8_t buf[FloatConv::kMaxShortestChars];
+                uint32_t len = FloatConv::FormatShortest(va_arg(args, double), buf);
+                EmitPadded(consumer, buf, len, width, padCh);
                 break;
             }
 
@@ -529,6 +549,21 @@ auto API StringWriteFmt_(span<uint8_t> out, byteview fmt, va_list args) -> uint6
     return written;
 }
 
+auto API StringWriteFmtTruncate_(span<uint8_t> out, byteview fmt, va_list args) -> uint64_t
+{
+    uint64_t written = 0;
+
+    WriteFmt(
+        [&](const uint8_t *data, uint64_t dataSize) -> void {
+            const uint64_t n = Min(dataSize, out.size - written);
+            MemCpy(out.data + written, data, n);
+            written += n;
+        },
+        fmt, args);
+
+    return written;
+}
+
 void API FileWriteFmt_(file_handle handle, span<uint8_t> buffer, byteview fmt, va_list args)
 {
     BufferWriteFmt([handle](const uint8_t *data, uint64_t size) -> void { FileWrite(handle, (uint32_t)size, data); },
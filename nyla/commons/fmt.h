@@ -1,7 +1,8 @@
 #pragma once
 
 #include <cstdarg>
-#define LOG(fmt, ...) FileWriteFmt(GetStderr(), fmt "\n"_s, ##__VA_ARGS__)
+#define LOG(fmt, ...) Log::Write(fmt "\n"_s, ##__VA_ARGS__)
+#define LOG_SYNC(fmt, ...) Log::WriteSync(fmt "\n"_s, ##__VA_ARGS__)
 
 #define SV_FMT "%.*s"
 #define SV_ARG(sv) (sv).size, (sv).data
@@ -11,7 +12,7 @@
     {                                                                                                                  \
         if (!(cond)) [[unlikely]]                                                                                      \
         {                                                                                                              \
-            LOG(__FILE__ ":" XSTRINGIFY(__LINE__) ": assertion failed: " #cond __VA_OPT__(" | ") __VA_ARGS__);         \
+            LOG_SYNC(__FILE__ ":" XSTRINGIFY(__LINE__) ": assertion failed: " #cond __VA_OPT__(" | ") __VA_ARGS__);    \
             TRAP();                                                                                                    \
             UNREACHABLE();                                                                                             \
         }                                                                                                              \
@@ -28,12 +29,15 @@
 #endif
 
 #include "nyla/commons/file.h"
+#include "nyla/commons/log.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/span_def.h"
 
 namespace nyla
 {
 
+// printf subset. Floats: %f and %.Nf are exactly rounded fixed notation (FloatConv::FormatFixed), %g is the shortest
+// text that parses back to the same double rather than printf's 6 significant digits.
 void API FileWriteFmt_(file_handle handle, span<uint8_t> buffer, byteview fmt, va_list args);
 void API FileWriteFmt(file_handle handle, span<uint8_t> buffer, byteview fmt, ...);
 
@@ -43,6 +47,9 @@ void API FileWriteFmt(file_handle handle, byteview fmt, ...);
 auto API StringWriteFmt_(span<uint8_t> out, byteview fmt, va_list args) -> uint64_t;
 auto API StringWriteFmt(span<uint8_t> out, byteview fmt, ...) -> uint64_t;
 
+// Drops whatever does not fit in out instead of asserting.
+auto API StringWriteFmtTruncate_(span<uint8_t> out, byteview fmt, va_list args) -> uint64_t;
+
 auto API StringWriteFmt_(byteview fmt, va_list args) -> byteview;
 auto API StringWriteFmt(byteview fmt, ...) -> byteview;
 
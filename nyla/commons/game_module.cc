@@ -0,0 +1,254 @@
+#include "nyla/commons/game_module.h"
+
+#include <cinttypes>
+#include <cstdint>
+
+#include "nyla/commons/dir_watcher.h"
+#include "nyla/commons/file.h"
+#include "nyla/commons/file_utils.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/inline_string.h"
+#include "nyla/commons/inline_vec.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/mempage_pool.h"
+#include "nyla/commons/platform.h"
+#include "nyla/commons/platform_module.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/time.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+constexpr inline uint64_t kStateAlign = 64;
+constexpr inline uint64_t kPathCap = 512;
+
+using game_api_getter = auto (*)() -> const game_api *;
+
+} // namespace
+
+struct game_module
+{
+    region_alloc alloc;   // the state, outlives every copy of the module
+    region_alloc scratch; // the bytes of a copy while it is written
+
+    byteview dir;
+    byteview name;
+    inline_string<kPathCap> path;
+
+    platform_module *lib; // null when linked statically
+    const game_api *api;
+    void *state;
+
+    uint32_t generation;
+    inline_string<kPathCap> livePath; // the copy that is loaded
+    inline_string<kPathCap> nextPath;
+
+    bool changed;
+    game_module_stats stats;
+};
+
+namespace GameModule
+{
+
+namespace
+{
+
+void WriteCStrPath(inline_string<kPathCap> &out, byteview dir, byteview name, byteview tail)
+{
+    out.size = 0;
+    InlineVec::Append(out, dir);
+    InlineVec::Append(out, "/"_s);
+    InlineVec::Append(out, name);
+    if (tail.size)
+        InlineVec::Append(out, tail);
+    InlineVec::Append(out, byteview{(const uint8_t *)"\0", 1});
+    out.size -= 1;
+}
+
+void OnModuleEvent(const dir_watcher_event &ev, void *user)
+{
+    auto &self = *static_cast<game_module *>(user);
+    if (!Any(ev.mask & (platform_dir_watch_event_type::Modified | platform_dir_watch_event_type::MovedTo)))
+        return;
+    if (Span::Eq(ev.dirPath, self.dir) && Span::Eq(ev.name, self.name))
+        self.changed = true;
+}
+
+// Loads a fresh copy of the module. Each copy gets a name of its own: the loader hands back the module it already
+// has for a path it has seen, and on Windows the file of a loaded module can not be replaced.
+auto OpenCopy(game_module &self, platform_module *&outLib, const game_api *&outApi) -> bool
+{
+    RegionAlloc::Reset(self.scratch);
+
+    uint8_t suffix[16];
+    const uint64_t n = StringWriteFmt(span<uint8_t>{suffix, sizeof(suffix)}, ".live%u"_s, self.generation + 1);
+    WriteCStrPath(self.nextPath, self.dir, self.name, byteview{suffix, n});
+
+    file_handle src = FileOpen((byteview)self.path, FileOpenMode::Read);
+    span<uint8_t> bytes;
+    const bool ok = TryFileReadFully(self.scratch, src, bytes);
+    if (FileValid(src))
+        FileClose(src);
+    if (!ok)
+    {
+        LOG("game_module: could not read " SV_FMT, SV_ARG((byteview)self.path));
+        return false;
+    }
+
+    file_handle dst = FileOpen((byteview)self.nextPath, FileOpenMode::Write);
+    if (!FileValid(dst))
+        return false;
+    const byteview whole{bytes.data, bytes.size};
+    const bool written = FileWriteGather(dst, span<const byteview>{&whole, 1}) == whole.size;
+    FileClose(dst);
+
+    platform_module *lib = written ? PlatformModule::Open((byteview)self.nextPath) : nullptr;
+    if (!lib)
+    {
+        FileDelete((byteview)self.nextPath);
+        return false;
+    }
+
+    auto getApi = reinterpret_cast<game_api_getter>(PlatformModule::Symbol(*lib, "NylaGetGameApi"));
+    const game_api *api = getApi ? getApi() : nullptr;
+    if (!api || api->version != kGameApiVersion)
+    {
+        LOG("game_module: " SV_FMT " does not export game_api version %u", SV_ARG(self.name), kGameApiVersion);
+        PlatformModule::Close(*lib);
+        FileDelete((byteview)self.nextPath);
+        return false;
+    }
+
+    ++self.generation;
+    outLib = lib;
+    outApi = api;
+    return true;
+}
+
+void Reload(game_module &self)
+{
+    const uint64_t start = GetMonotonicTimeNanos();
+
+    platform_module *lib;
+    const game_api *api;
+    if (!OpenCopy(self, lib, api))
+    {
+        ++self.stats.rejected;
+        return;
+    }
+
+    if (api->stateSize != self.api->stateSize)
+    {
+        LOG("game_module: " SV_FMT " changed its state from %" PRIu64 " to %" PRIu64 " bytes, restart to pick it up",
+            SV_ARG(self.name), self.api->stateSize, api->stateSize);
+        PlatformModule::Close(*lib);
+        FileDelete((byteview)self.nextPath);
+        ++self.stats.rejected;
+        return;
+    }
+
+    if (self.api->unload)
+        self.api->unload(self.state);
+    PlatformModule::Close(*self.lib);
+    FileDelete((byteview)self.livePath);
+
+    self.lib = lib;
+    self.api = api;
+    self.livePath = self.nextPath;
+    self.api->init(self.state, true);
+
+    ++self.stats.reloads;
+    self.stats.lastReloadNs = GetMonotonicTimeNanos() - start;
+    LOG("game_module: reloaded " SV_FMT " in %.1f ms", SV_ARG(self.name), (double)self.stats.lastReloadNs / 1e6);
+}
+
+auto Create() -> game_module &
+{
+    auto &self = RegionAlloc::Alloc<game_module>(RegionAlloc::g_BootstrapAlloc);
+    self.alloc = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+    self.scratch = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+    return self;
+}
+
+void InitState(game_module &self)
+{
+    self.state = RegionAlloc::Alloc(self.alloc, self.api->stateSize, kStateAlign);
+    self.api->init(self.state, false);
+}
+
+} // namespace
+
+auto API Load(byteview fileName) -> game_module *
+{
+    game_module &self = Create();
+
+    const byteview exe = GetExecutablePath(self.alloc);
+    uint64_t dirSize = exe.size;
+    while (dirSize && exe[dirSize - 1] != '/' && exe[dirSize - 1] != '\\')
+        --dirSize;
+    self.dir = Span::SubSpan(exe, 0, dirSize ? dirSize - 1 : 0);
+
+    WriteCStrPath(self.path, self.dir, fileName, byteview{});
+    self.name = Span::SubSpan((byteview)self.path, self.path.size - fileName.size);
+
+    const bool loaded = OpenCopy(self, self.lib, self.api);
+    ASSERT(loaded, "could not load " SV_FMT, SV_ARG((byteview)self.path));
+    self.livePath = self.nextPath;
+    InitState(self);
+
+    DirWatcher::Subscribe(self.name, &OnModuleEvent, &self);
+    DirWatcher::WatchDir(self.dir);
+
+    LOG("game_module: loaded " SV_FMT ", %" PRIu64 " bytes of state", SV_ARG((byteview)self.path),
+        self.api->stateSize);
+    return &self;
+}
+
+auto API LoadStatic(const game_api &api) -> game_module *
+{
+    game_module &self = Create();
+    self.api = &api;
+    InitState(self);
+    return &self;
+}
+
+void API Update(game_module &self, const engine_frame &frame)
+{
+    if (self.changed)
+    {
+        self.changed = false;
+        Reload(self);
+    }
+    self.api->update(self.state, frame);
+}
+
+void API Render(game_module &self, const engine_frame &frame, uint32_t width, uint32_t height)
+{
+    self.api->render(self.state, frame, width, height);
+}
+
+auto API GetStats(game_module &self) -> game_module_stats
+{
+    return self.stats;
+}
+
+void API Unload(game_module &self)
+{
+    if (self.api->unload)
+        self.api->unload(self.state);
+    if (!self.lib)
+        return;
+
+    PlatformModule::Close(*self.lib);
+    FileDelete((byteview)self.livePath);
+    self.lib = nullptr;
+}
+
+} // namespace GameModule
+
+} // namespace nyla
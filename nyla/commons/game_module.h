@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/engine.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+// Bumped whenever game_api changes, a module built against another version is not loaded.
+constexpr inline uint32_t kGameApiVersion = 1;
+
+// What a game module exports. The host owns everything that outlives a reload: the engine, the GPU and the game
+// state, which it allocates zeroed and 64 byte aligned. The module keeps no state of its own, its statics start over
+// with every copy that is loaded.
+struct game_api
+{
+    uint32_t version;
+    uint64_t stateSize; // a rebuild that changes it needs a restart
+
+    // reloaded is false the first time, when the state is still zero. After a reload only what points into the
+    // module has to be redone, assets and handles in the state stay valid.
+    void (*init)(void *state, bool reloaded);
+    // Called before the module is closed, may be null.
+    void (*unload)(void *state);
+    void (*update)(void *state, const engine_frame &frame);
+    void (*render)(void *state, const engine_frame &frame, uint32_t width, uint32_t height);
+};
+
+#if defined(_MSC_VER)
+#define NYLA_GAME_EXPORT extern "C" __declspec(dllexport)
+#else
+#define NYLA_GAME_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+// The one symbol a game module exports.
+NYLA_GAME_EXPORT auto NylaGetGameApi() -> const game_api *;
+
+struct game_module_stats
+{
+    uint32_t reloads;
+    uint32_t rejected; // rebuilds that did not load or changed the state size
+    uint64_t lastReloadNs; // copy, load and init of the last reload
+};
+
+struct game_module;
+
+namespace GameModule
+{
+
+// Loads fileName from the executable's directory and calls init on fresh state. The module is never loaded from
+// there but from a copy next to it, so the linker can replace the file. When it does, the copy is swapped for a new
+// one at the next Update.
+auto API Load(byteview fileName) -> game_module *;
+
+// For builds without shared libraries, where the game is linked into the executable and never reloads.
+auto API LoadStatic(const game_api &api) -> game_module *;
+
+void API Update(game_module &self, const engine_frame &frame);
+void API Render(game_module &self, const engine_frame &frame, uint32_t width, uint32_t height);
+auto API GetStats(game_module &self) -> game_module_stats;
+
+// Calls unload and closes the module, deleting the copy it was loaded from. Nothing else may be called on it after.
+void API Unload(game_module &self);
+
+} // namespace GameModule
+
+} // namespace nyla
@@ -2,16 +2,52 @@
 
 #include <cstdint>
 
+#include "nyla/commons/bitenum.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/vec.h"
 
 namespace nyla
 {
 
+constexpr inline uint32_t kMaxGamepads = 4;
+
+// Named by position on an Xbox layout: A is the bottom face button, Y the top one.
+enum class gamepad_buttons : uint32_t
+{
+    A = 1 << 0,
+    B = 1 << 1,
+    X = 1 << 2,
+    Y = 1 << 3,
+    LeftShoulder = 1 << 4,
+    RightShoulder = 1 << 5,
+    Back = 1 << 6,
+    Start = 1 << 7,
+    Guide = 1 << 8,
+    LeftThumb = 1 << 9,
+    RightThumb = 1 << 10,
+    DPadUp = 1 << 11,
+    DPadDown = 1 << 12,
+    DPadLeft = 1 << 13,
+    DPadRight = 1 << 14,
+};
+NYLA_BITENUM(gamepad_buttons);
+
+// State changes UpdateGamepad picked up, and how old each was by then. On Linux the age runs from the kernel's
+// timestamp on the report. XInput has no timestamps, so there the latencies stay zero.
+struct gamepad_stats
+{
+    uint64_t reports;
+    uint64_t latencyNsSum;
+    uint64_t latencyNsMax;
+};
+
+// Samples the newest state of the pad, the getters below read that sample. False when no pad is connected at index.
 auto API UpdateGamepad(uint32_t index) -> bool;
 auto API GetGamepadLeftStick(uint32_t index) -> float2;
 auto API GetGamepadRightStick(uint32_t index) -> float2;
 auto API GetGamepadLeftTrigger(uint32_t index) -> float;
 auto API GetGamepadRightTrigger(uint32_t index) -> float;
+auto API GetGamepadButtons(uint32_t index) -> gamepad_buttons;
+auto API GetGamepadStats(uint32_t index) -> gamepad_stats;
 
-} // namespace nyla
\ No newline at end of file
+} // namespace nyla
@@ -0,0 +1,611 @@
+#include "nyla/commons/gamepad.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <linux/limits.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/limits.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/platform_thread.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+constexpr uint32_t kInotifyTag = Limits<uint32_t>::Max();
+constexpr uint32_t kNameSize = 32;
+constexpr uint32_t kReadBatch = 64;
+constexpr uint32_t kEpollBatch = 8;
+constexpr uint32_t kInotifyBufSize = 16 * (sizeof(inotify_event) + NAME_MAX + 1);
+
+// Defaults for pads that report no flat region, the same ones XInput recommends.
+constexpr float kLeftStickDeadzone = 7849.f / 32767.f;
+constexpr float kRightStickDeadzone = 8689.f / 32767.f;
+constexpr float kTriggerDeadzone = 30.f / 255.f;
+
+enum class gamepad_axis : uint8_t
+{
+    LeftX,
+    LeftY,
+    RightX,
+    RightY,
+    LeftTrigger,
+    RightTrigger,
+    HatX,
+    HatY,
+    Count,
+};
+
+constexpr array<uint16_t, (uint32_t)gamepad_axis::Count> kAxisCodes{
+    ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ, ABS_HAT0X, ABS_HAT0Y,
+};
+
+struct button_mapping
+{
+    uint16_t code;
+    gamepad_buttons button;
+};
+
+// Positional names from the kernel's gamepad spec. BTN_TL2 and BTN_TR2 are the triggers of pads without analog ones.
+constexpr button_mapping kButtons[] = {
+    {BTN_SOUTH, gamepad_buttons::A},
+    {BTN_EAST, gamepad_buttons::B},
+    {BTN_WEST, gamepad_buttons::X},
+    {BTN_NORTH, gamepad_buttons::Y},
+    {BTN_TL, gamepad_buttons::LeftShoulder},
+    {BTN_TR, gamepad_buttons::RightShoulder},
+    {BTN_SELECT, gamepad_buttons::Back},
+    {BTN_START, gamepad_buttons::Start},
+    {BTN_MODE, gamepad_buttons::Guide},
+    {BTN_THUMBL, gamepad_buttons::LeftThumb},
+    {BTN_THUMBR, gamepad_buttons::RightThumb},
+    {BTN_DPAD_UP, gamepad_buttons::DPadUp},
+    {BTN_DPAD_DOWN, gamepad_buttons::DPadDown},
+    {BTN_DPAD_LEFT, gamepad_buttons::DPadLeft},
+    {BTN_DPAD_RIGHT, gamepad_buttons::DPadRight},
+};
+
+// What the game thread sees. Sticks are in [-1, 1] with up positive, triggers in [0, 1], deadzones not applied yet.
+struct gamepad_sample
+{
+    float2 leftStick;
+    float2 rightStick;
+    float leftTrigger;
+    float rightTrigger;
+    float leftDeadzone;
+    float rightDeadzone;
+    gamepad_buttons buttons;
+    bool connected;
+    uint64_t timeNs; // CLOCK_MONOTONIC stamp of the report, from the kernel
+};
+
+// Written by the input thread only. An odd seq means a write is in progress.
+struct alignas(64) gamepad_slot
+{
+    uint32_t seq;
+    gamepad_sample sample;
+};
+
+struct gamepad_device
+{
+    int fd; // -1 while the slot is free
+    array<uint8_t, kNameSize> name;
+    uint32_t nameLen;
+    bool dropped; // the kernel lost events, resync on the next report
+    array<bool, (uint32_t)gamepad_axis::Count> hasAxis;
+    array<input_absinfo, (uint32_t)gamepad_axis::Count> axes;
+    bool digitalLeftTrigger;
+    bool digitalRightTrigger;
+    gamepad_buttons buttons;
+};
+
+struct gamepad_reader
+{
+    uint32_t seq;
+    gamepad_sample sample;
+    gamepad_stats stats;
+};
+
+struct gamepad_state
+{
+    array<gamepad_slot, kMaxGamepads> slots;
+
+    // Input thread only
+    int epoll;
+    int inotify;
+    array<gamepad_device, kMaxGamepads> devices;
+    alignas(inotify_event) array<uint8_t, kInotifyBufSize> inotifyBuf;
+    platform_thread *thread;
+
+    // Game thread only
+    array<gamepad_reader, kMaxGamepads> readers;
+};
+gamepad_state *gamepads;
+
+//
+
+auto TestBit(const uint8_t *bits, uint32_t bit) -> bool
+{
+    return bits[bit / 8] & (1 << (bit % 8));
+}
+
+auto NormalizeAxis(const input_absinfo &info, int32_t value) -> float
+{
+    if (info.maximum <= info.minimum)
+        return 0.f;
+    return Clamp((float)(value - info.minimum) / (float)(info.maximum - info.minimum), 0.f, 1.f);
+}
+
+// In [-1, 1] for sticks, the caller flips Y so that up is positive.
+auto ReadStick(const gamepad_device &device, gamepad_axis axis) -> float
+{
+    const uint32_t i = (uint32_t)axis;
+    if (!device.hasAxis[i])
+        return 0.f;
+    return NormalizeAxis(device.axes[i], device.axes[i].value) * 2.f - 1.f;
+}
+
+auto ReadTrigger(const gamepad_device &device, gamepad_axis axis, bool digital) -> float
+{
+    const uint32_t i = (uint32_t)axis;
+    if (!device.hasAxis[i])
+        return digital ? 1.f : 0.f;
+    return NormalizeAxis(device.axes[i], device.axes[i].value);
+}
+
+// The device's flat region in normalized stick units, or the fallback when it reports none.
+auto StickDeadzone(const gamepad_device &device, gamepad_axis axis, float fallback) -> float
+{
+    const input_absinfo &info = device.axes[(uint32_t)axis];
+    if (!device.hasAxis[(uint32_t)axis] || !info.flat || info.maximum <= info.minimum)
+        return fallback;
+    return Min(2.f * (float)info.flat / (float)(info.maximum - info.minimum), 0.9f);
+}
+
+void Publish(uint32_t index, uint64_t timeNs)
+{
+    const gamepad_device &device = gamepads->devices[index];
+    gamepad_slot &slot = gamepads->slots[index];
+
+    gamepad_sample sample{};
+    sample.connected = device.fd != -1;
+    sample.timeNs = timeNs;
+
+    if (sample.connected)
+    {
+        sample.leftStick = {ReadStick(device, gamepad_axis::LeftX), -ReadStick(device, gamepad_axis::LeftY)};
+        sample.rightStick = {ReadStick(device, gamepad_axis::RightX), -ReadStick(device, gamepad_axis::RightY)};
+        sample.leftTrigger = ReadTrigger(device, gamepad_axis::LeftTrigger, device.digitalLeftTrigger);
+        sample.rightTrigger = ReadTrigger(device, gamepad_axis::RightTrigger, device.digitalRightTrigger);
+        sample.leftDeadzone = StickDeadzone(device, gamepad_axis::LeftX, kLeftStickDeadzone);
+        sample.rightDeadzone = StickDeadzone(device, gamepad_axis::RightX, kRightStickDeadzone);
+
+        // Hats report -1 for up and left
+        const int32_t hatX = device.axes[(uint32_t)gamepad_axis::HatX].value;
+        const int32_t hatY = device.axes[(uint32_t)gamepad_axis::HatY].value;
+        sample.buttons = device.buttons;
+        if (hatX < 0)
+            sample.buttons |= gamepad_buttons::DPadLeft;
+        if (hatX > 0)
+            sample.buttons |= gamepad_buttons::DPadRight;
+        if (hatY < 0)
+            sample.buttons |= gamepad_buttons::DPadUp;
+        if (hatY > 0)
+            sample.buttons |= gamepad_buttons::DPadDown;
+    }
+
+    // The fence keeps the sample from being written before the odd seq is visible.
+    const uint32_t seq = slot.seq;
+    AtomicStore32(&slot.seq, seq + 1);
+    AtomicFence();
+    slot.sample = sample;
+    AtomicStore32(&slot.seq, seq + 2);
+}
+
+void SetButton(gamepad_device &device, uint16_t code, bool down)
+{
+    if (code == BTN_TL2)
+    {
+        device.digitalLeftTrigger = down;
+        return;
+    }
+    if (code == BTN_TR2)
+    {
+        device.digitalRightTrigger = down;
+        return;
+    }
+
+    for (const button_mapping &mapping : kButtons)
+    {
+        if (mapping.code != code)
+            continue;
+        if (down)
+            device.buttons |= mapping.button;
+        else
+            device.buttons &= ~mapping.button;
+        return;
+    }
+}
+
+// Reads the whole state back from the kernel, after it dropped events or when the device appears.
+void Resync(gamepad_device &device)
+{
+    array<uint8_t, KEY_MAX / 8 + 1> keys{};
+    ioctl(device.fd, EVIOCGKEY(sizeof(keys)), keys.data);
+
+    device.buttons = None<gamepad_buttons>();
+    for (const button_mapping &mapping : kButtons)
+    {
+        if (TestBit(keys.data, mapping.code))
+            device.buttons |= mapping.button;
+    }
+    device.digitalLeftTrigger = TestBit(keys.data, BTN_TL2);
+    device.digitalRightTrigger = TestBit(keys.data, BTN_TR2);
+
+    for (uint32_t i = 0; i < (uint32_t)gamepad_axis::Count; ++i)
+    {
+        if (device.hasAxis[i])
+            ioctl(device.fd, EVIOCGABS(kAxisCodes[i]), &device.axes[i]);
+    }
+}
+
+auto IsGamepad(int fd) -> bool
+{
+    array<uint8_t, EV_MAX / 8 + 1> types{};
+    array<uint8_t, KEY_MAX / 8 + 1> keys{};
+    array<uint8_t, ABS_MAX / 8 + 1> abs{};
+
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(types)), types.data) < 0)
+        return false;
+    if (!TestBit(types.data, EV_KEY) || !TestBit(types.data, EV_ABS))
+        return false;
+
+    ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys.data);
+    ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs)), abs.data);
+
+    const bool hasButtons = TestBit(keys.data, BTN_GAMEPAD) || TestBit(keys.data, BTN_JOYSTICK);
+    return hasButtons && TestBit(abs.data, ABS_X) && TestBit(abs.data, ABS_Y);
+}
+
+auto FindDevice(byteview name) -> int32_t
+{
+    for (uint32_t i = 0; i < kMaxGamepads; ++i)
+    {
+        const gamepad_device &device = gamepads->devices[i];
+        if (device.fd != -1 && Span::Eq(byteview{device.name.data, device.nameLen}, name))
+            return (int32_t)i;
+    }
+    return -1;
+}
+
+void OpenDevice(byteview name)
+{
+    if (name.size >= kNameSize || !Span::StartsWith(name, "event"_s) || FindDevice(name) != -1)
+        return;
+
+    uint32_t index = 0;
+    while (index < kMaxGamepads && gamepads->devices[index].fd != -1)
+        ++index;
+    if (index == kMaxGamepads)
+        return;
+
+    array<uint8_t, kNameSize + 16> path;
+    const uint64_t pathLen = StringWriteFmt(path, "/dev/input/" SV_FMT ""_s, SV_ARG(name));
+    path[pathLen] = 0;
+
+    // Fails until udev has fixed the permissions of a new node, IN_ATTRIB brings us back then.
+    const int fd = open((const char *)path.data, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1)
+        return;
+
+    if (!IsGamepad(fd))
+    {
+        close(fd);
+        return;
+    }
+
+    gamepad_device &device = gamepads->devices[index];
+    device = {};
+    device.fd = fd;
+    MemCpy(device.name.data, name.data, name.size);
+    device.nameLen = (uint32_t)name.size;
+
+    int clock = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clock);
+
+    array<uint8_t, ABS_MAX / 8 + 1> abs{};
+    ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs)), abs.data);
+    for (uint32_t i = 0; i < (uint32_t)gamepad_axis::Count; ++i)
+        device.hasAxis[i] = TestBit(abs.data, kAxisCodes[i]);
+
+    Resync(device);
+
+    epoll_event event{.events = EPOLLIN, .data = {.u32 = index}};
+    ASSERT(epoll_ctl(gamepads->epoll, EPOLL_CTL_ADD, fd, &event) == 0);
+
+    char deviceName[128]{};
+    ioctl(fd, EVIOCGNAME(sizeof(deviceName) - 1), deviceName);
+    LOG("gamepad %d: %s (" SV_FMT ")", index, deviceName, SV_ARG(name));
+
+    Publish(index, 0);
+}
+
+void CloseDevice(uint32_t index)
+{
+    gamepad_device &device = gamepads->devices[index];
+    if (device.fd == -1)
+        return;
+
+    LOG("gamepad %d: disconnected", index);
+    epoll_ctl(gamepads->epoll, EPOLL_CTL_DEL, device.fd, nullptr);
+    close(device.fd);
+    device.fd = -1;
+
+    Publish(index, 0);
+}
+
+void ReadDevice(uint32_t index)
+{
+    gamepad_device &device = gamepads->devices[index];
+
+    for (;;)
+    {
+        array<::input_event, kReadBatch> events;
+        const ssize_t n = read(device.fd, events.data, sizeof(events));
+        if (n < 0)
+        {
+            if (errno != EAGAIN && errno != EINTR)
+                CloseDevice(index);
+            return;
+        }
+        if (n == 0)
+            return;
+
+        for (uint32_t i = 0; i < (uint32_t)n / sizeof(::input_event); ++i)
+        {
+            const ::input_event &event = events[i];
+            switch (event.type)
+            {
+            case EV_KEY: {
+                if (!device.dropped)
+                    SetButton(device, event.code, event.value != 0);
+                break;
+            }
+            case EV_ABS: {
+                if (device.dropped)
+                    break;
+                for (uint32_t a = 0; a < (uint32_t)gamepad_axis::Count; ++a)
+                {
+                    if (kAxisCodes[a] == event.code)
+                        device.axes[a].value = event.value;
+                }
+                break;
+            }
+            case EV_SYN: {
+                if (event.code == SYN_DROPPED)
+                {
+                    device.dropped = true;
+                }
+                else if (event.code == SYN_REPORT)
+                {
+                    if (device.dropped)
+                    {
+                        Resync(device);
+                        device.dropped = false;
+                    }
+                    Publish(index, (uint64_t)event.input_event_sec * 1'000'000'000 +
+                                       (uint64_t)event.input_event_usec * 1'000);
+                }
+                break;
+            }
+            }
+        }
+    }
+}
+
+void ReadInotify()
+{
+    for (;;)
+    {
+        const ssize_t n = read(gamepads->inotify, gamepads->inotifyBuf.data, kInotifyBufSize);
+        if (n <= 0)
+            return;
+
+        for (ssize_t pos = 0; pos < n;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(gamepads->inotifyBuf.data + pos);
+            pos += sizeof(inotify_event) + event->len;
+            if (!event->len)
+                continue;
+            const byteview name = Span::FromCStr(event->name, event->len);
+
+            if (event->mask & IN_DELETE)
+            {
+                if (int32_t index = FindDevice(name); index != -1)
+                    CloseDevice((uint32_t)index);
+            }
+            else
+            {
+                OpenDevice(name);
+            }
+        }
+    }
+}
+
+void InputThread(void *)
+{
+    if (DIR *dir = opendir("/dev/input"); dir)
+    {
+        while (dirent *entry = readdir(dir))
+            OpenDevice(Span::FromCStr(entry->d_name, sizeof(entry->d_name)));
+        closedir(dir);
+    }
+
+    for (;;)
+    {
+        array<epoll_event, kEpollBatch> events;
+        const int n = epoll_wait(gamepads->epoll, events.data, kEpollBatch, -1);
+        for (int i = 0; i < n; ++i)
+        {
+            const epoll_event &event = events[i];
+            if (event.data.u32 == kInotifyTag)
+            {
+                ReadInotify();
+                continue;
+            }
+
+            ReadDevice(event.data.u32);
+            if (event.events & (EPOLLHUP | EPOLLERR))
+                CloseDevice(event.data.u32);
+        }
+    }
+}
+
+// The thread only sleeps in epoll_wait and holds no locks, so it is left running until the process exits.
+void Bootstrap()
+{
+    gamepads = &RegionAlloc::Alloc<gamepad_state>(RegionAlloc::g_BootstrapAlloc);
+    for (gamepad_device &device : gamepads->devices)
+        device.fd = -1;
+
+    gamepads->epoll = epoll_create1(EPOLL_CLOEXEC);
+    ASSERT(gamepads->epoll != -1);
+
+    gamepads->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    ASSERT(gamepads->inotify != -1);
+    if (inotify_add_watch(gamepads->inotify, "/dev/input", IN_CREATE | IN_ATTRIB | IN_DELETE) != -1)
+    {
+        epoll_event event{.events = EPOLLIN, .data = {.u32 = kInotifyTag}};
+        ASSERT(epoll_ctl(gamepads->epoll, EPOLL_CTL_ADD, gamepads->inotify, &event) == 0);
+    }
+    else
+    {
+        LOG("gamepad: cannot watch /dev/input, no hot plug");
+    }
+
+    gamepads->thread = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &InputThread, nullptr);
+    PlatformThread::SetName(*gamepads->thread, "nyla-gamepad");
+}
+
+auto Sample(uint32_t index) -> gamepad_sample
+{
+    if (!gamepads || index >= kMaxGamepads)
+        return {};
+    return gamepads->readers[index].sample;
+}
+
+// Radial deadzone, renormalized so movement starts smoothly from its edge.
+auto ApplyStickDeadzone(float2 stick, float deadzone) -> float2
+{
+    const float magnitude = Sqrt(stick[0] * stick[0] + stick[1] * stick[1]);
+    if (magnitude < deadzone)
+        return {};
+
+    const float scale = Min((magnitude - deadzone) / (1.f - deadzone), 1.f);
+    return {stick[0] / magnitude * scale, stick[1] / magnitude * scale};
+}
+
+auto ApplyTriggerDeadzone(float value) -> float
+{
+    if (value < kTriggerDeadzone)
+        return 0.f;
+    return (value - kTriggerDeadzone) / (1.f - kTriggerDeadzone);
+}
+
+} // namespace
+
+// Never blocks: a read that overlaps a publish retries, and a publish is a few dozen bytes of stores.
+auto API UpdateGamepad(uint32_t index) -> bool
+{
+    if (!gamepads)
+        Bootstrap();
+    if (index >= kMaxGamepads)
+        return false;
+
+    const gamepad_slot &slot = gamepads->slots[index];
+    gamepad_reader &reader = gamepads->readers[index];
+
+    gamepad_sample sample;
+    uint32_t seq;
+    for (;;)
+    {
+        seq = AtomicLoad32(&slot.seq);
+        if (seq & 1)
+        {
+            CpuRelax();
+            continue;
+        }
+        sample = slot.sample;
+        AtomicFence();
+        if (AtomicLoad32(&slot.seq) == seq)
+            break;
+    }
+
+    if (seq != reader.seq && sample.timeNs)
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        const uint64_t nowNs = (uint64_t)ts.tv_sec * 1'000'000'000 + (uint64_t)ts.tv_nsec;
+        const uint64_t latencyNs = nowNs - Min(nowNs, sample.timeNs);
+
+        ++reader.stats.reports;
+        reader.stats.latencyNsSum += latencyNs;
+        reader.stats.latencyNsMax = Max(reader.stats.latencyNsMax, latencyNs);
+    }
+
+    reader.seq = seq;
+    reader.sample = sample;
+    return sample.connected;
+}
+
+auto API GetGamepadLeftStick(uint32_t index) -> float2
+{
+    const gamepad_sample sample = Sample(index);
+    return ApplyStickDeadzone(sample.leftStick, sample.leftDeadzone);
+}
+
+auto API GetGamepadRightStick(uint32_t index) -> float2
+{
+    const gamepad_sample sample = Sample(index);
+    return ApplyStickDeadzone(sample.rightStick, sample.rightDeadzone);
+}
+
+auto API GetGamepadLeftTrigger(uint32_t index) -> float
+{
+    return ApplyTriggerDeadzone(Sample(index).leftTrigger);
+}
+
+auto API GetGamepadRightTrigger(uint32_t index) -> float
+{
+    return ApplyTriggerDeadzone(Sample(index).rightTrigger);
+}
+
+auto API GetGamepadButtons(uint32_t index) -> gamepad_buttons
+{
+    return Sample(index).buttons;
+}
+
+auto API GetGamepadStats(uint32_t index) -> gamepad_stats
+{
+    if (!gamepads || index >= kMaxGamepads)
+        return {};
+    return gamepads->readers[index].stats;
+}
+
+} // namespace nyla
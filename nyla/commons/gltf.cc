@@ -1,7 +1,9 @@
 #include "nyla/commons/gltf.h"
 
+#include <cinttypes>
 #include <cstdint>
 
+#include "nyla/commons/fmt.h"
 #include "nyla/commons/json_parser.h"
 #include "nyla/commons/json_value.h"
 #include "nyla/commons/region_alloc.h"
@@ -59,22 +61,57 @@ auto FindAttributeAccessor(gltf_parser &self, span<gltf_mesh_primitive_attribute
 
 auto Parse(gltf_parser &self, region_alloc &alloc) -> bool
 {
-    json_parser jsonParser;
-    JsonParser::Init(jsonParser, self.jsonChunk, RegionAlloc::AllocArray<json_value>(alloc, 1024));
+    const json_result json = JsonParser::Parse(self.jsonChunk, alloc);
+    if (json.error != json_error::None)
+    {
+        LOG("gltf: " SV_FMT " at byte %" PRIu64, SV_ARG(JsonParser::ErrorName(json.error)), json.offset);
+        return false;
+    }
 
-    json_value &jsonChunk = *JsonParser::ParseNext(jsonParser);
+    json_value &jsonChunk = *json.root;
 
+    json_value *images;
+    if (JsonValue::TryArray(jsonChunk, "images"_s, images))
     {
-        json_value *images = JsonValue::Array(jsonChunk, "images"_s);
         self.images = RegionAlloc::AllocArray<gltf_image>(alloc, JsonValue::GetCount(*images));
 
         uint64_t i = 0;
         for (auto it = images->begin(), end = images->end(); it != end; ++it, ++i)
         {
-            gltf_image &image = self.images[i];
-            image.uri = JsonValue::String(*it, "uri"_s);
-            image.mimeType = JsonValue::String(*it, "mimeType"_s);
-            image.name = JsonValue::String(*it, "name"_s);
+            gltf_image &image = self.images[i] = gltf_image{};
+            JsonValue::TryString(*it, "uri"_s, image.uri);
+            JsonValue::TryString(*it, "mimeType"_s, image.mimeType);
+            JsonValue::TryString(*it, "name"_s, image.name);
+        }
+    }
+
+    json_value *textures;
+    if (JsonValue::TryArray(jsonChunk, "textures"_s, textures))
+    {
+        self.textures = RegionAlloc::AllocArray<gltf_texture>(alloc, JsonValue::GetCount(*textures));
+
+        uint64_t i = 0;
+        for (auto it = textures->begin(), end = textures->end(); it != end; ++it, ++i)
+        {
+            gltf_texture &texture = self.textures[i];
+            if (!JsonValue::TryDWord(*it, "source"_s, texture.source))
+                texture.source = kGltfNone;
+        }
+    }
+
+    json_value *materials;
+    if (JsonValue::TryArray(jsonChunk, "materials"_s, materials))
+    {
+        self.materials = RegionAlloc::AllocArray<gltf_material>(alloc, JsonValue::GetCount(*materials));
+
+        uint64_t i = 0;
+        for (auto it = materials->begin(), end = materials->end(); it != end; ++it, ++i)
+        {
+            gltf_material &material = self.materials[i];
+
+            byteview path[] = {"pbrMetallicRoughness"_s, "baseColorTexture"_s, "index"_s};
+            if (!JsonValue::TryDWord(*it, span<byteview>{path, 3}, material.baseColorTexture))
+                material.baseColorTexture = kGltfNone;
         }
     }
 
@@ -85,8 +122,9 @@ auto Parse(gltf_parser &self, region_alloc &alloc) -> bool
         uint64_t i = 0;
         for (auto it = buffers->begin(), end = buffers->end(); it != end; ++it, ++i)
         {
-            auto &buffer = self.buffers[i];
+            auto &buffer = self.buffers[i] = gltf_buffer{};
             buffer.byteLength = JsonValue::DWord(*it, "byteLength"_s);
+            JsonValue::TryString(*it, "uri"_s, buffer.uri);
         }
     }
 
@@ -104,6 +142,9 @@ auto Parse(gltf_parser &self, region_alloc &alloc) -> bool
                 bufferView.byteOffset = 0;
 
             bufferView.byteLength = JsonValue::DWord(*it, "byteLength"_s);
+
+            if (!JsonValue::TryDWord(*it, "byteStride"_s, bufferView.byteStride))
+                bufferView.byteStride = 0;
         }
     }
 
@@ -177,8 +218,12 @@ auto Parse(gltf_parser &self, region_alloc &alloc) -> bool
             {
                 auto &primitive = mesh.primitives[i] = gltf_mesh_primitive{};
 
-                primitive.indices = JsonValue::DWord(*primitiveJson, "indices"_s);
-                primitive.material = JsonValue::DWord(*primitiveJson, "material"_s);
+                if (!JsonValue::TryDWord(*primitiveJson, "indices"_s, primitive.indices))
+                    primitive.indices = kGltfNone;
+                if (!JsonValue::TryDWord(*primitiveJson, "material"_s, primitive.material))
+                    primitive.material = kGltfNone;
+                if (!JsonValue::TryDWord(*primitiveJson, "mode"_s, primitive.mode))
+                    primitive.mode = 4; // TRIANGLES
 
                 json_value *attributesJson = JsonValue::Object(*primitiveJson, "attributes"_s);
                 uint32_t attributesCount = JsonValue::GetCount(*attributesJson);
@@ -11,8 +11,11 @@
 namespace nyla
 {
 
+constexpr inline uint32_t kGltfNone = 0xFFFFFFFF;
+
 struct gltf_buffer
 {
+    byteview uri;
     uint32_t byteLength;
 };
 
@@ -28,6 +31,17 @@ struct gltf_buffer_view
     uint32_t buffer;
     uint32_t byteOffset;
     uint32_t byteLength;
+    uint32_t byteStride; // 0 when tightly packed
+};
+
+struct gltf_texture
+{
+    uint32_t source; // image index
+};
+
+struct gltf_material
+{
+    uint32_t baseColorTexture; // texture index or kGltfNone
 };
 
 enum class gltf_accessor_component_type
@@ -121,8 +135,8 @@ struct gltf_mesh_primitive
 {
     span<gltf_mesh_primitive_attribute> attributes;
     uint32_t mode;
-    uint32_t indices;
-    uint32_t material;
+    uint32_t indices;  // kGltfNone when not indexed
+    uint32_t material; // kGltfNone when unset
 };
 
 struct gltf_mesh
@@ -159,6 +173,8 @@ struct gltf_parser
     span<gltf_buffer> buffers;
     span<gltf_accessor> accessors;
     span<gltf_image> images;
+    span<gltf_texture> textures;
+    span<gltf_material> materials;
     span<gltf_mesh> meshes;
 };
 
@@ -178,6 +194,21 @@ INLINE auto GetAccessorData(gltf_parser &self, const gltf_accessor &accessor) ->
 auto FindAttributeAccessor(gltf_parser &self, span<gltf_mesh_primitive_attribute> attributes, byteview attributeName,
                            gltf_accessor &out) -> bool;
 
+// Element i of the accessor, honoring the buffer view stride.
+INLINE auto GetAccessorElement(gltf_parser &self, const gltf_accessor &accessor, uint32_t i) -> const uint8_t *
+{
+    const auto &bufferView = self.bufferViews[accessor.bufferView];
+    ASSERT(bufferView.buffer == 0);
+    ASSERT(i < accessor.count);
+
+    const uint32_t elementSize = GetGltfAccessorSize(accessor);
+    const uint32_t stride = bufferView.byteStride ? bufferView.byteStride : elementSize;
+    const uint64_t offset = uint64_t{bufferView.byteOffset} + accessor.byteOffset + uint64_t{i} * stride;
+    ASSERT(offset + elementSize <= self.binChunk.size);
+
+    return self.binChunk.data + offset;
+}
+
 } // namespace GltfParser
 
 } // namespace nyla
\ No newline at end of file
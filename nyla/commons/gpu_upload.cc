@@ -117,6 +117,8 @@ auto API CmdCopyStaticVertices(rhi_cmdlist cmd, uint32_t copySize, uint64_t &out
 
 auto API CmdCopyStaticIndices(rhi_cmdlist cmd, uint32_t copySize, uint64_t &outBufferOffset) -> char *
 {
+    // 32-bit index buffers need a 4-byte aligned offset.
+    manager->staticIndexBufferAt = AlignedUp(manager->staticIndexBufferAt, 4);
     outBufferOffset = manager->staticIndexBufferAt;
 
     char *ret = CmdCopyBuffer(cmd, manager->staticIndexBuffer, manager->staticIndexBufferAt, copySize);
@@ -129,9 +131,9 @@ void API CmdBindStaticMeshVertexBuffer(rhi_cmdlist cmd, uint64_t offset)
     Rhi::CmdBindVertexBuffers(cmd, 0, {&manager->staticVertexBuffer, 1}, {&offset, 1});
 }
 
-void API CmdBindStaticMeshIndexBuffer(rhi_cmdlist cmd, uint64_t offset)
+void API CmdBindStaticMeshIndexBuffer(rhi_cmdlist cmd, uint64_t offset, rhi_index_format format)
 {
-    Rhi::CmdBindIndexBuffer(cmd, manager->staticIndexBuffer, offset);
+    Rhi::CmdBindIndexBuffer(cmd, manager->staticIndexBuffer, offset, format);
 }
 
 } // namespace GpuUpload
@@ -21,7 +21,7 @@ auto API CmdCopyStaticVertices(rhi_cmdlist cmd, uint32_t copySize, uint64_t &out
 auto API CmdCopyStaticIndices(rhi_cmdlist cmd, uint32_t copySize, uint64_t &outBufferOffset) -> char *;
 
 void API CmdBindStaticMeshVertexBuffer(rhi_cmdlist cmd, uint64_t offset);
-void API CmdBindStaticMeshIndexBuffer(rhi_cmdlist cmd, uint64_t offset);
+void API CmdBindStaticMeshIndexBuffer(rhi_cmdlist cmd, uint64_t offset, rhi_index_format format);
 
 } // namespace GpuUpload
 
@@ -32,10 +32,8 @@ constexpr auto Capacity(const handle_pool<HandleType, DataType, PoolCapacity> &s
 
 template <is_handle HandleType, typename DataType, uint64_t Capacity>
 [[nodiscard]]
-auto Acquire(handle_pool<HandleType, DataType, Capacity> &self, const DataType &data) -> HandleType
+auto TryAcquire(handle_pool<HandleType, DataType, Capacity> &self, const DataType &data, HandleType &out) -> bool
 {
-    HandleType ret{};
-
     for (uint32_t i = 0; i < Capacity; ++i)
     {
         auto &slot = self[i];
@@ -46,14 +44,22 @@ auto Acquire(handle_pool<HandleType, DataType, Capacity> &self, const DataType &
         slot.used = true;
         slot.data = data;
 
-        HandleType ret;
-        ret.gen = slot.gen;
-        ret.index = i;
-        return ret;
+        out = HandleType{};
+        out.gen = slot.gen;
+        out.index = i;
+        return true;
     }
 
-    ASSERT(false);
-    return {};
+    return false;
+}
+
+template <is_handle HandleType, typename DataType, uint64_t Capacity>
+[[nodiscard]]
+auto Acquire(handle_pool<HandleType, DataType, Capacity> &self, const DataType &data) -> HandleType
+{
+    HandleType ret{};
+    ASSERT(TryAcquire(self, data, ret));
+    return ret;
 }
 
 template <is_handle HandleType, typename DataType, uint64_t Capacity>
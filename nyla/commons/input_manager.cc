@@ -6,6 +6,8 @@
 #include "nyla/commons/inline_vec.h" // IWYU pragma: keep
 #include "nyla/commons/minmax.h"
 #include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/time.h"
 
 namespace nyla
 {
@@ -13,17 +15,28 @@ namespace nyla
 namespace
 {
 
+// down and heldFrom follow the events as they are consumed, the counters cover the last step.
 struct input_state
 {
-    uint64_t pressedAt;
     uint32_t code;
     input_interface_type type;
-    bool released;
+    bool down;
+    uint32_t presses;
+    uint32_t releases;
+    uint64_t heldFrom;
+    uint64_t heldNs;
 };
 
 struct input_manager
 {
-    array<input_state, 0xFF> inputStates;
+    array<input_state, 0x100> inputStates;
+
+    input_event events[kInputEventRingSize];
+    uint64_t eventHead;
+    uint64_t eventTail; // the first event no step has consumed yet
+
+    uint64_t stepBeginNs;
+    uint64_t stepEndNs;
 };
 input_manager *manager;
 
@@ -40,6 +53,31 @@ auto FindInput(input_interface_type type, uint32_t code) -> input_state *
     return nullptr;
 }
 
+// Key repeat may press a held key again, only the first press counts.
+void ApplyEvent(const input_event &event, uint64_t timeNs)
+{
+    input_state *state = FindInput(event.type, event.code);
+    if (!state || state->down == event.pressed)
+        return;
+
+    state->down = event.pressed;
+    if (event.pressed)
+    {
+        state->heldFrom = timeNs;
+        ++state->presses;
+    }
+    else
+    {
+        state->heldNs += Max(timeNs, state->heldFrom) - state->heldFrom;
+        ++state->releases;
+    }
+}
+
+auto GetState(input_id input) -> const input_state &
+{
+    return manager->inputStates[(uint8_t)input];
+}
+
 } // namespace
 
 namespace InputManager
@@ -57,36 +95,105 @@ void API Map(input_id input, input_interface_type type, uint32_t code)
     state.code = code;
 }
 
-void API HandlePressed(input_interface_type type, uint32_t code, uint64_t time)
+// A full ring makes room by letting its oldest event take effect outside of any step, so nothing stays stuck down.
+void API HandleEvent(const input_event &event)
 {
-    if (auto state = FindInput(type, code); state)
-        state->pressedAt = Max(state->pressedAt, time);
+    if (manager->eventHead - manager->eventTail == kInputEventRingSize)
+    {
+        const input_event &oldest = manager->events[manager->eventTail++ % kInputEventRingSize];
+        if (input_state *state = FindInput(oldest.type, oldest.code); state)
+            state->down = oldest.pressed;
+    }
+
+    manager->events[manager->eventHead++ % kInputEventRingSize] = event;
 }
 
-void API HandleReleased(input_interface_type type, uint32_t code, uint64_t time)
+void API HandlePressed(input_interface_type type, uint32_t code, uint64_t timeNs)
 {
-    if (auto state = FindInput(type, code); state)
-        state->released = true;
+    HandleEvent({.timeNs = timeNs, .code = code, .type = type, .pressed = true});
 }
 
-auto API IsPressed(input_id input) -> bool
+void API HandleReleased(input_interface_type type, uint32_t code, uint64_t timeNs)
 {
-    auto &state = manager->inputStates[(uint8_t)input];
-    return !state.released && state.pressedAt;
+    HandleEvent({.timeNs = timeNs, .code = code, .type = type, .pressed = false});
 }
 
-void API Update()
+// An event stamped before the step began, one that arrived late, counts from the start of the step.
+void API Step(uint64_t untilNs)
 {
+    const uint64_t beginNs = manager->stepEndNs ? Min(manager->stepEndNs, untilNs) : untilNs;
+
     for (auto &state : manager->inputStates)
     {
-        if (state.released)
-        {
-            state.pressedAt = 0;
-            state.released = false;
-        }
+        state.presses = 0;
+        state.releases = 0;
+        state.heldNs = 0;
+        if (state.down)
+            state.heldFrom = beginNs;
     }
+
+    for (; manager->eventTail != manager->eventHead; ++manager->eventTail)
+    {
+        const input_event &event = manager->events[manager->eventTail % kInputEventRingSize];
+        if (event.timeNs >= untilNs)
+            break;
+        ApplyEvent(event, Max(event.timeNs, beginNs));
+    }
+
+    for (auto &state : manager->inputStates)
+    {
+        if (state.down)
+            state.heldNs += untilNs - state.heldFrom;
+    }
+
+    manager->stepBeginNs = beginNs;
+    manager->stepEndNs = untilNs;
+}
+
+void API Update()
+{
+    Step(GetMonotonicTimeNanos());
+}
+
+auto API IsPressed(input_id input) -> bool
+{
+    const input_state &state = GetState(input);
+    return state.down || state.presses;
+}
+
+auto API WasPressed(input_id input) -> bool
+{
+    return GetState(input).presses;
+}
+
+auto API WasReleased(input_id input) -> bool
+{
+    return GetState(input).releases;
+}
+
+auto API GetPressCount(input_id input) -> uint32_t
+{
+    return GetState(input).presses;
+}
+
+auto API GetHeldFraction(input_id input) -> float
+{
+    const uint64_t stepNs = manager->stepEndNs - manager->stepBeginNs;
+    if (!stepNs)
+        return 0.f;
+    return (float)((double)GetState(input).heldNs / (double)stepNs);
+}
+
+auto API CopyRecentEvents(span<input_event> out) -> uint32_t
+{
+    const uint64_t available = Min<uint64_t>(manager->eventHead, kInputEventRingSize);
+    const uint32_t count = (uint32_t)Min<uint64_t>(available, out.size);
+    const uint64_t first = manager->eventHead - count;
+    for (uint32_t i = 0; i < count; ++i)
+        out[i] = manager->events[(first + i) % kInputEventRingSize];
+    return count;
 }
 
 } // namespace InputManager
 
-} // namespace nyla
\ No newline at end of file
+} // namespace nyla
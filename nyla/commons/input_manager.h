@@ -3,6 +3,7 @@
 #include <cstdint>
 
 #include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
 
 namespace nyla
 {
@@ -16,18 +17,45 @@ enum class input_interface_type : uint8_t
 
 enum class input_id : uint8_t;
 
+// A press or release as the platform reported it. Kept in a ring until a step consumes it, so replaying a recording
+// through the same steps reproduces the same input state.
+struct input_event
+{
+    uint64_t timeNs; // GetMonotonicTimeNanos clock
+    uint32_t code;
+    input_interface_type type;
+    bool pressed;
+};
+
+constexpr inline uint32_t kInputEventRingSize = 1024;
+
 namespace InputManager
 {
 
 void API Bootstrap();
 
+// Consumes every event so far as one step, for loops without a fixed timestep.
 void API Update();
+// Consumes the events before untilNs. The step runs from where the previous one ended, the queries below answer for
+// it. Events after untilNs wait for a later step.
+void API Step(uint64_t untilNs);
 
 void API Map(input_id input, input_interface_type type, uint32_t code);
+// Held at the end of the step, or pressed at some point during it.
 auto API IsPressed(input_id input) -> bool;
+auto API WasPressed(input_id input) -> bool;
+auto API WasReleased(input_id input) -> bool;
+auto API GetPressCount(input_id input) -> uint32_t;
+// Of the step's duration, how much the input spent held. Zero for a step of no duration.
+auto API GetHeldFraction(input_id input) -> float;
+
+void API HandlePressed(input_interface_type type, uint32_t code, uint64_t timeNs);
+void API HandleReleased(input_interface_type type, uint32_t code, uint64_t timeNs);
+void API HandleEvent(const input_event &event);
 
-void API HandlePressed(input_interface_type type, uint32_t code, uint64_t time);
-void API HandleReleased(input_interface_type type, uint32_t code, uint64_t time);
+// The latest events, at most out.size and oldest first, consumed or not. Feeding them back through HandleEvent into
+// a fresh InputManager replays them.
+auto API CopyRecentEvents(span<input_event> out) -> uint32_t;
 
 } // namespace InputManager
 
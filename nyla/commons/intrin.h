@@ -66,6 +66,27 @@ INLINE auto BitScanForward64(uint64_t n) -> uint64_t
 #endif
 }
 
+INLINE auto BitScanReverse64(uint64_t n) -> uint64_t
+{
+    DASSERT(n != 0);
+#if defined(__clang__) || defined(__GNUC__)
+    return 63 - (uint32_t)__builtin_clzll(n);
+#else
+    unsigned long index;
+    ::_BitScanReverse64(&index, n);
+    return (uint32_t)index;
+#endif
+}
+
+INLINE auto PopCount64(uint64_t n) -> uint32_t
+{
+#if defined(__clang__) || defined(__GNUC__)
+    return (uint32_t)__builtin_popcountll(n);
+#else
+    return (uint32_t)__popcnt64(n);
+#endif
+}
+
 INLINE auto ByteSwap16(uint16_t val) -> uint16_t
 {
 #if defined(__clang__) || defined(__GNUC__)
@@ -208,4 +229,62 @@ INLINE void AtomicStore64(uint64_t *p, uint64_t v)
 #endif
 }
 
+INLINE auto AtomicCompareExchange32(uint32_t *p, uint32_t expected, uint32_t desired) -> bool
+{
+#if defined(__clang__) || defined(__GNUC__)
+    return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+    return (uint32_t)_InterlockedCompareExchange((volatile long *)p, (long)desired, (long)expected) == expected;
+#endif
+}
+
+// Returns the value before the add.
+INLINE auto AtomicFetchAdd64(uint64_t *p, uint64_t v) -> uint64_t
+{
+#if defined(__clang__) || defined(__GNUC__)
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+#else
+    return (uint64_t)_InterlockedExchangeAdd64((volatile long long *)p, (long long)v);
+#endif
+}
+
+// On failure expected is updated to the current value.
+INLINE auto AtomicCompareExchange64(uint64_t *p, uint64_t &expected, uint64_t desired) -> bool
+{
+#if defined(__clang__) || defined(__GNUC__)
+    return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+    const uint64_t prev =
+        (uint64_t)_InterlockedCompareExchange64((volatile long long *)p, (long long)desired, (long long)expected);
+    const bool ok = prev == expected;
+    expected = prev;
+    return ok;
+#endif
+}
+
+INLINE void AtomicFence()
+{
+#if defined(__clang__) || defined(__GNUC__)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+    _ReadWriteBarrier();
+    _mm_mfence();
+#endif
+}
+
+INLINE void CpuRelax()
+{
+    _mm_pause();
+}
+
+// Invariant TSC, not serializing. Ticks are only comparable to other ticks, calibrate against GetMonotonicTimeNanos.
+INLINE auto ReadTimestampCounter() -> uint64_t
+{
+#if defined(__clang__) || defined(__GNUC__)
+    return __builtin_ia32_rdtsc();
+#else
+    return __rdtsc();
+#endif
+}
+
 } // namespace nyla
\ No newline at end of file
@@ -0,0 +1,435 @@
+#include "nyla/commons/job_system.h"
+
+#include <cstdint>
+
+#include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/inline_vec.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/mempage_pool.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/platform.h"
+#include "nyla/commons/platform_condvar.h"
+#include "nyla/commons/platform_mutex.h"
+#include "nyla/commons/platform_thread.h"
+#include "nyla/commons/profiler.h"
+#include "nyla/commons/region_alloc.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+constexpr inline uint32_t kMaxWorkers = 64;
+constexpr inline uint64_t kDequeCap = 4096; // a power of two
+constexpr inline uint64_t kInjectedCap = 1024;
+
+// Failed rounds of looking for work before a worker sleeps, or a waiter starts yielding its time slice.
+constexpr inline uint32_t kSpinRounds = 64;
+
+struct job
+{
+    job_fn fn;
+    void *user;
+    job_counter *counter;
+};
+
+// Chase-Lev: the owner pushes and pops at the bottom, thieves take from the top. The size is fixed, when the deque
+// is full the owner runs the job right away.
+struct job_deque
+{
+    alignas(64) uint64_t top;
+    alignas(64) uint64_t bottom;
+    alignas(64) array<job, kDequeCap> jobs;
+};
+
+struct job_worker
+{
+    job_deque deque;
+    region_alloc scratch;
+    platform_thread *thread;
+    uint32_t index;
+    uint64_t rng;
+
+    // written by this worker only
+    uint64_t stolen;
+    uint64_t sleeps;
+};
+
+struct job_system_state
+{
+    uint32_t workerCount;
+    array<job_worker *, kMaxWorkers> workers;
+
+    platform_mutex *mutex;
+    platform_condvar *wake;
+    uint32_t sleepers;
+
+    // Jobs from threads outside the pool, guarded by mutex. injectedSize follows injected.size, so that finding it
+    // empty takes no lock.
+    inline_vec<job, kInjectedCap> injected;
+    uint32_t injectedSize;
+    uint64_t injectedTotal;
+};
+job_system_state *g_jobs;
+
+thread_local job_worker *t_worker;
+
+// top and bottom only grow, but bottom dips one below top while the owner pops from an empty deque.
+auto Signed(uint64_t v) -> int64_t
+{
+    return (int64_t)v;
+}
+
+auto Push(job_deque &self, const job &j) -> bool
+{
+    const uint64_t b = self.bottom;
+    const uint64_t t = AtomicLoad64(&self.top);
+    if (b - t >= kDequeCap)
+        return false;
+
+    self.jobs[b & (kDequeCap - 1)] = j;
+    AtomicStore64(&self.bottom, b + 1);
+    return true;
+}
+
+auto Pop(job_deque &self, job &out) -> bool
+{
+    const uint64_t b = self.bottom - 1;
+    AtomicStore64(&self.bottom, b);
+    AtomicFence();
+    uint64_t t = AtomicLoad64(&self.top);
+
+    if (Signed(t) > Signed(b))
+    {
+        AtomicStore64(&self.bottom, b + 1);
+        return false;
+    }
+
+    out = self.jobs[b & (kDequeCap - 1)];
+    if (t != b)
+        return true;
+
+    // The last job, a thief may be taking it right now.
+    const bool won = AtomicCompareExchange64(&self.top, t, t + 1);
+    AtomicStore64(&self.bottom, b + 1);
+    return won;
+}
+
+// The slot is only written again after top moved past it, and then the exchange fails and the copy is dropped.
+auto Steal(job_deque &self, job &out) -> bool
+{
+    uint64_t t = AtomicLoad64(&self.top);
+    AtomicFence();
+    const uint64_t b = AtomicLoad64(&self.bottom);
+    if (Signed(t) >= Signed(b))
+        return false;
+
+    out = self.jobs[t & (kDequeCap - 1)];
+    return AtomicCompareExchange64(&self.top, t, t + 1);
+}
+
+auto TakeInjected(job &out) -> bool
+{
+    if (!AtomicLoad32(&g_jobs->injectedSize))
+        return false;
+
+    PlatformMutex::Lock(*g_jobs->mutex);
+    const bool taken = g_jobs->injected.size > 0;
+    if (taken)
+    {
+        out = InlineVec::PopBack(g_jobs->injected);
+        AtomicStore32(&g_jobs->injectedSize, (uint32_t)g_jobs->injected.size);
+    }
+    PlatformMutex::Unlock(*g_jobs->mutex);
+    return taken;
+}
+
+// Own deque first, newest job first while its data is still in cache. Then the other threads' jobs, starting at a
+// random victim so that thieves spread out.
+auto FindJob(job_worker &self, job &out) -> bool
+{
+    if (Pop(self.deque, out))
+        return true;
+    if (TakeInjected(out))
+        return true;
+
+    self.rng ^= self.rng << 13;
+    self.rng ^= self.rng >> 7;
+    self.rng ^= self.rng << 17;
+
+    const uint32_t n = g_jobs->workerCount;
+    const uint32_t first = (uint32_t)(self.rng % n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        job_worker &victim = *g_jobs->workers[(first + i) % n];
+        if (&victim == &self)
+            continue;
+        if (Steal(victim.deque, out))
+        {
+            AtomicStore64(&self.stolen, self.stolen + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+auto HasWork() -> bool
+{
+    if (AtomicLoad32(&g_jobs->injectedSize))
+        return true;
+    for (uint32_t i = 0; i < g_jobs->workerCount; ++i)
+    {
+        const job_deque &deque = g_jobs->workers[i]->deque;
+        if (Signed(AtomicLoad64(&deque.top)) < Signed(AtomicLoad64(&deque.bottom)))
+            return true;
+    }
+    return false;
+}
+
+void Execute(job_worker &self, const job &j)
+{
+    uint8_t *mark = self.scratch.at;
+    j.fn(j.user);
+    if (self.scratch.at != mark)
+        RegionAlloc::Reset(self.scratch, mark);
+
+    if (j.counter)
+        AtomicFetchAdd64(&j.counter->pending, ~uint64_t{0});
+}
+
+// Pairs with the fence in SleepUntilWork: either the sleeper sees the new job, or the pusher sees the sleeper.
+void WakeOne()
+{
+    AtomicFence();
+    if (!AtomicLoad32(&g_jobs->sleepers))
+        return;
+
+    PlatformMutex::Lock(*g_jobs->mutex);
+    PlatformCondvar::Signal(*g_jobs->wake);
+    PlatformMutex::Unlock(*g_jobs->mutex);
+}
+
+void SleepUntilWork(job_worker &self)
+{
+    PlatformMutex::Lock(*g_jobs->mutex);
+    AtomicStore32(&g_jobs->sleepers, g_jobs->sleepers + 1);
+    AtomicFence();
+    if (!HasWork())
+    {
+        AtomicStore64(&self.sleeps, self.sleeps + 1);
+        PlatformCondvar::Wait(*g_jobs->wake, *g_jobs->mutex);
+    }
+    AtomicStore32(&g_jobs->sleepers, g_jobs->sleepers - 1);
+    PlatformMutex::Unlock(*g_jobs->mutex);
+}
+
+void WorkerMain(void *user)
+{
+    auto &self = *static_cast<job_worker *>(user);
+    t_worker = &self;
+    Profiler::SetThreadName("nyla-job"_s);
+
+    job j;
+    for (;;)
+    {
+        bool found = false;
+        for (uint32_t i = 0; i < kSpinRounds && !found; ++i)
+        {
+            found = FindJob(self, j);
+            if (!found)
+                CpuRelax();
+        }
+
+        if (found)
+            Execute(self, j);
+        else
+            SleepUntilWork(self);
+    }
+}
+
+struct parallel_for
+{
+    parallel_for_fn fn;
+    void *user;
+    uint64_t count;
+    uint64_t grain;
+    alignas(64) uint64_t next;
+};
+
+// Every helper keeps claiming ranges until none are left, so a slow range does not hold up the others.
+void RunRanges(void *user)
+{
+    auto &pf = *static_cast<parallel_for *>(user);
+    for (;;)
+    {
+        const uint64_t begin = AtomicFetchAdd64(&pf.next, pf.grain);
+        if (begin >= pf.count)
+            return;
+        pf.fn(pf.user, begin, Min(begin + pf.grain, pf.count));
+    }
+}
+
+} // namespace
+
+namespace JobSystem
+{
+
+void API Bootstrap(uint32_t workers)
+{
+    ASSERT(!g_jobs);
+    g_jobs = &RegionAlloc::Alloc<job_system_state>(RegionAlloc::g_BootstrapAlloc);
+    g_jobs->mutex = PlatformMutex::Create(RegionAlloc::g_BootstrapAlloc);
+    g_jobs->wake = PlatformCondvar::Create(RegionAlloc::g_BootstrapAlloc);
+
+    // Worker 0 only runs jobs while it waits, so there is always at least one thread for the jobs that threads
+    // outside the pool start and wait on.
+    if (!workers)
+        workers = GetProcessorCount();
+    g_jobs->workerCount = Min(Max(workers, 2u), kMaxWorkers);
+
+    // All of them exist before the first thread starts looking for victims.
+    for (uint32_t i = 0; i < g_jobs->workerCount; ++i)
+    {
+        auto &worker = RegionAlloc::Alloc<job_worker>(RegionAlloc::g_BootstrapAlloc);
+        worker.scratch = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+        worker.index = i;
+        worker.rng = 0x9E3779B97F4A7C15ull * (i + 1);
+        g_jobs->workers[i] = &worker;
+    }
+
+    t_worker = g_jobs->workers[0];
+    for (uint32_t i = 1; i < g_jobs->workerCount; ++i)
+    {
+        job_worker &worker = *g_jobs->workers[i];
+        worker.thread = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &WorkerMain, &worker);
+        PlatformThread::SetName(*worker.thread, "nyla-job");
+    }
+
+    LOG("job_system: %u workers", g_jobs->workerCount);
+}
+
+auto API GetWorkerCount() -> uint32_t
+{
+    return g_jobs->workerCount;
+}
+
+auto API GetWorkerIndex() -> uint32_t
+{
+    ASSERT(t_worker, "not a job system worker");
+    return t_worker->index;
+}
+
+auto API GetScratch() -> region_alloc &
+{
+    ASSERT(t_worker, "not a job system worker");
+    return t_worker->scratch;
+}
+
+void API Run(job_fn fn, void *user, job_counter *counter)
+{
+    if (counter)
+        AtomicFetchAdd64(&counter->pending, 1);
+
+    const job j{.fn = fn, .user = user, .counter = counter};
+    if (t_worker)
+    {
+        if (!Push(t_worker->deque, j))
+        {
+            Execute(*t_worker, j);
+            return;
+        }
+    }
+    else
+    {
+        for (;;)
+        {
+            PlatformMutex::Lock(*g_jobs->mutex);
+            const bool queued = g_jobs->injected.size < kInjectedCap;
+            if (queued)
+            {
+                InlineVec::Append(g_jobs->injected, j);
+                AtomicStore32(&g_jobs->injectedSize, (uint32_t)g_jobs->injected.size);
+                ++g_jobs->injectedTotal;
+            }
+            PlatformMutex::Unlock(*g_jobs->mutex);
+
+            if (queued)
+                break;
+            Sleep(1);
+        }
+    }
+
+    WakeOne();
+}
+
+void API Wait(job_counter &counter)
+{
+    job j;
+    uint32_t idle = 0;
+    while (AtomicLoad64(&counter.pending))
+    {
+        if (t_worker && FindJob(*t_worker, j))
+        {
+            Execute(*t_worker, j);
+            idle = 0;
+            continue;
+        }
+
+        // What is left runs on other workers, which do not signal when they finish.
+        if (++idle < kSpinRounds)
+            CpuRelax();
+        else
+            Sleep(0);
+    }
+}
+
+void API ParallelFor(uint64_t count, uint64_t grain, parallel_for_fn fn, void *user, uint32_t width)
+{
+    if (!count)
+        return;
+    if (!grain)
+        grain = 1;
+    if (!width || width > g_jobs->workerCount)
+        width = g_jobs->workerCount;
+
+    const uint64_t ranges = (count + grain - 1) / grain;
+    const uint64_t helpers = Min<uint64_t>(ranges, width) - 1;
+    if (!helpers)
+    {
+        fn(user, 0, count);
+        return;
+    }
+
+    parallel_for pf{.fn = fn, .user = user, .count = count, .grain = grain};
+    job_counter counter{};
+    for (uint64_t i = 0; i < helpers; ++i)
+        Run(&RunRanges, &pf, &counter);
+
+    if (t_worker)
+        Execute(*t_worker, job{.fn = &RunRanges, .user = &pf});
+    else
+        RunRanges(&pf);
+
+    Wait(counter);
+}
+
+auto API GetStats() -> job_system_stats
+{
+    job_system_stats stats{};
+    for (uint32_t i = 0; i < g_jobs->workerCount; ++i)
+    {
+        stats.stolen += AtomicLoad64(&g_jobs->workers[i]->stolen);
+        stats.sleeps += AtomicLoad64(&g_jobs->workers[i]->sleeps);
+    }
+
+    PlatformMutex::Lock(*g_jobs->mutex);
+    stats.injected = g_jobs->injectedTotal;
+    PlatformMutex::Unlock(*g_jobs->mutex);
+    return stats;
+}
+
+} // namespace JobSystem
+
+} // namespace nyla
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/region_alloc_def.h"
+
+namespace nyla
+{
+
+using job_fn = void (*)(void *user);
+using parallel_for_fn = void (*)(void *user, uint64_t begin, uint64_t end);
+
+// Counts the jobs started against it that have not finished yet. Zeroed is ready to use.
+struct job_counter
+{
+    uint64_t pending;
+};
+
+struct job_system_stats
+{
+    uint64_t stolen;   // jobs taken from another worker's deque
+    uint64_t injected; // jobs started from threads outside the pool
+    uint64_t sleeps;   // times a worker ran out of work and blocked
+};
+
+namespace JobSystem
+{
+
+// The calling thread becomes worker 0 and workers - 1 threads are started, one per processor unless workers says
+// otherwise, and at least one. Only call Run, Wait and ParallelFor after this.
+void API Bootstrap(uint32_t workers = 0);
+
+// Including the thread that called Bootstrap.
+auto API GetWorkerCount() -> uint32_t;
+
+// Index of the calling worker below GetWorkerCount, for per-worker data. Asserts outside the pool.
+auto API GetWorkerIndex() -> uint32_t;
+
+// Per-worker scratch. What a job allocates is given back when the job returns.
+auto API GetScratch() -> region_alloc &;
+
+// counter may be null. Workers push to their own deque, other threads through a shared queue.
+void API Run(job_fn fn, void *user, job_counter *counter);
+
+// Returns once every job started against counter has finished. Workers run jobs meanwhile, other threads poll.
+void API Wait(job_counter &counter);
+
+// Calls fn on [begin, end) ranges of at most grain indices covering [0, count), on up to width workers counting the
+// caller, all of them unless width says otherwise. Returns when every range is done.
+void API ParallelFor(uint64_t count, uint64_t grain, parallel_for_fn fn, void *user, uint32_t width = 0);
+
+auto API GetStats() -> job_system_stats;
+
+} // namespace JobSystem
+
+} // namespace nyla
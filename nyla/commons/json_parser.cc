@@ -1,9 +1,16 @@
+#include "nyla/commons/json_parser.h"
+
 #include <cstdint>
 
+#include <immintrin.h>
+
 #include "nyla/commons/byteparser.h"
 #include "nyla/commons/fmt.h"
-#include "nyla/commons/json_parser.h"
+#include "nyla/commons/intrin.h"
 #include "nyla/commons/json_value.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
 #include "nyla/commons/stringparser.h"
 
 namespace nyla
@@ -15,201 +22,439 @@ namespace JsonParser
 namespace
 {
 
-auto PushOut(json_parser &self, const json_value &value) -> json_value *
+struct json_block
 {
-    ASSERT(self.outSize > 0);
+    __m256i lo;
+    __m256i hi;
+};
 
-    json_value *ret = self.out;
-    *ret = value;
+struct json_index
+{
+    span<uint32_t> offsets;
+    uint32_t size;
+    uint32_t separators; // ',' and ':', they produce no tape entry
+    uint32_t strings;    // closing quotes are indexed too, consumed by their string
+};
 
-    ++self.out;
-    --self.outSize;
+struct json_frame
+{
+    json_value *begin;
+    uint32_t count;
+    bool object;
+};
 
-    return ret;
+INLINE auto Eq(const json_block &block, uint8_t ch) -> uint64_t
+{
+    const __m256i c = _mm256_set1_epi8((char)ch);
+    const uint32_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block.lo, c));
+    const uint32_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block.hi, c));
+    return uint64_t{lo} | (uint64_t{hi} << 32);
 }
 
-auto ParseLiteral(json_parser &self) -> json_value *
+// Bytes below 0x20.
+INLINE auto Control(const json_block &block) -> uint64_t
 {
-    switch (ByteParser::Read(self))
-    {
-    case 'n': {
-        ASSERT(ByteParser::Read(self) == 'u');
-        ASSERT(ByteParser::Read(self) == 'l');
-        ASSERT(ByteParser::Read(self) == 'l');
+    const __m256i c = _mm256_set1_epi8(0x1F);
+    const uint32_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(block.lo, c), c));
+    const uint32_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(block.hi, c), c));
+    return uint64_t{lo} | (uint64_t{hi} << 32);
+}
 
-        return PushOut(self, json_value{});
-    }
+// Bit i is the xor of bits 0..i, turns quote positions into string interiors.
+INLINE auto PrefixXor(uint64_t bits) -> uint64_t
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
 
-    case 't': {
-        ASSERT(ByteParser::Read(self) == 'r');
-        ASSERT(ByteParser::Read(self) == 'u');
-        ASSERT(ByteParser::Read(self) == 'e');
+INLINE auto AddOverflow(uint64_t a, uint64_t b, uint64_t &out) -> uint64_t
+{
+#if defined(__clang__) || defined(__GNUC__)
+    return __builtin_add_overflow(a, b, &out);
+#else
+    return _addcarry_u64(0, a, b, &out);
+#endif
+}
 
-        json_value val;
-        JsonValue::SetValue(val, true);
+// Characters preceded by an odd run of backslashes. Runs are split into the ones starting on even and odd bits,
+// adding the starts to the run carries through it and flips the parity of the even ones. escapedCarry is 1 when
+// the block ends on an unpaired backslash.
+INLINE auto FindEscaped(uint64_t backslash, uint64_t &escapedCarry) -> uint64_t
+{
+    constexpr uint64_t kEvenBits = 0x5555555555555555;
 
-        return PushOut(self, val);
-    }
+    backslash &= ~escapedCarry;
+    const uint64_t followsEscape = backslash << 1 | escapedCarry;
+    const uint64_t oddStarts = backslash & ~kEvenBits & ~followsEscape;
 
-    case 'f': {
-        ASSERT(ByteParser::Read(self) == 'a');
-        ASSERT(ByteParser::Read(self) == 'l');
-        ASSERT(ByteParser::Read(self) == 's');
-        ASSERT(ByteParser::Read(self) == 'e');
+    uint64_t evenStartRuns;
+    escapedCarry = AddOverflow(oddStarts, backslash, evenStartRuns);
+    return (kEvenBits ^ (evenStartRuns << 1)) & followsEscape;
+}
 
-        json_value val;
-        JsonValue::SetValue(val, false);
+INLINE auto IsValidEscape(const json_block &block) -> uint64_t
+{
+    return Eq(block, '"') | Eq(block, '\\') | Eq(block, '/') | Eq(block, 'b') | Eq(block, 'f') | Eq(block, 'n') |
+           Eq(block, 'r') | Eq(block, 't') | Eq(block, 'u');
+}
 
-        return PushOut(self, val);
-    }
+auto BuildIndex(byteview in, json_index &index, uint64_t &errorOffset) -> json_error
+{
+    uint64_t escapedCarry = 0;
+    uint64_t inStringCarry = 0;
+    uint64_t scalarCarry = 0;
+
+    uint32_t *out = index.offsets.data;
+    uint32_t separators = 0;
+    uint32_t strings = 0;
 
-    default: {
-        ASSERT(false);
-        return nullptr;
+    alignas(32) uint8_t tail[64];
+
+    for (uint64_t base = 0; base < in.size; base += 64)
+    {
+        const uint8_t *p = in.data + base;
+        if (in.size - base < 64)
+        {
+            // Spaces are neutral, they neither start a scalar nor end a string.
+            MemSet(tail, ' ', sizeof(tail));
+            MemCpy(tail, p, in.size - base);
+            p = tail;
+        }
+
+        const json_block block{
+            .lo = _mm256_loadu_si256((const __m256i *)p),
+            .hi = _mm256_loadu_si256((const __m256i *)(p + 32)),
+        };
+
+        const uint64_t backslash = Eq(block, '\\');
+        uint64_t escaped = 0;
+        if (backslash | escapedCarry)
+            escaped = FindEscaped(backslash, escapedCarry);
+
+        const uint64_t quote = Eq(block, '"') & ~escaped;
+        const uint64_t inString = PrefixXor(quote) ^ inStringCarry;
+        inStringCarry = uint64_t(int64_t(inString) >> 63);
+
+        if (const uint64_t bad = (Control(block) | (escaped & ~IsValidEscape(block))) & inString)
+        {
+            errorOffset = base + BitScanForward64(bad);
+            return json_error::InvalidString;
+        }
+
+        // '[' and ']' become '{' and '}' with bit 5 set, nothing else does.
+        const json_block folded{
+            .lo = _mm256_or_si256(block.lo, _mm256_set1_epi8(0x20)),
+            .hi = _mm256_or_si256(block.hi, _mm256_set1_epi8(0x20)),
+        };
+        const uint64_t strs = inString | quote;
+        const uint64_t separator = (Eq(block, ',') | Eq(block, ':')) & ~strs;
+        const uint64_t op = ((Eq(folded, '{') | Eq(folded, '}')) & ~strs) | separator;
+        const uint64_t whitespace = Eq(block, ' ') | Eq(block, '\n') | Eq(block, '\r') | Eq(block, '\t');
+
+        const uint64_t scalar = ~(op | whitespace | strs);
+        const uint64_t scalarStart = scalar & ~(scalar << 1 | scalarCarry);
+        scalarCarry = scalar >> 63;
+
+        separators += PopCount64(separator);
+        strings += PopCount64(quote & ~inString);
+
+        uint64_t structural = op | quote | scalarStart;
+        while (structural)
+        {
+            *out++ = uint32_t(base + BitScanForward64(structural));
+            structural &= structural - 1;
+        }
     }
+
+    index.size = uint32_t(out - index.offsets.data);
+    index.separators = separators;
+    index.strings = strings;
+
+    if (inStringCarry)
+    {
+        errorOffset = index.offsets[index.size - 1];
+        return json_error::UnterminatedString;
     }
+    return json_error::None;
+}
+
+INLINE auto IsScalarEnd(byteview in, uint64_t at) -> bool
+{
+    if (at == in.size)
+        return true;
+
+    const uint8_t ch = in[at];
+    return IsWhitespace(ch) || ch == ',' || ch == ']' || ch == '}';
+}
+
+INLINE auto MatchLiteral(byteview in, uint64_t at, byteview literal) -> bool
+{
+    return in.size - at >= literal.size && MemEq(in.data + at, literal.data, literal.size) &&
+           IsScalarEnd(in, at + literal.size);
 }
 
-auto ParseNumber(json_parser &self) -> json_value *
+auto ParseNumber(byteview in, uint64_t at, json_value &out) -> bool
 {
+    const uint64_t digit = at + (in[at] == '-');
+    if (digit == in.size || !IsNumber(in[digit]))
+        return false;
+
+    byte_parser parser;
+    ByteParser::Init(parser, in.data + at, in.size - at);
+
     double doubleVal;
     int64_t longVal;
-
-    json_value val;
-    switch (StringParser::ParseDecimal(self, doubleVal, longVal))
+    switch (StringParser::ParseDecimal(parser, doubleVal, longVal))
     {
     case StringParser::ParseNumberResult::Double: {
-        JsonValue::SetValue(val, doubleVal);
+        JsonValue::SetValue(out, doubleVal);
         break;
     }
     case StringParser::ParseNumberResult::Long: {
-        JsonValue::SetValue(val, longVal);
+        JsonValue::SetValue(out, longVal);
         break;
     }
     }
 
-    return PushOut(self, val);
+    return IsScalarEnd(in, uint64_t(parser.at - in.data));
 }
 
-auto ParseString(json_parser &self) -> json_value *
+auto BuildTape(byteview in, const json_index &index, span<json_value> tape, span<json_frame> stack,
+               uint64_t &errorOffset) -> json_error
 {
-    const uint8_t *base = self.at;
-    uint64_t count = 0;
-
-    uint8_t prevch = 0;
-    while (ByteParser::HasNext(self))
+    const uint32_t *offsets = index.offsets.data;
+    const uint32_t n = index.size;
+    uint32_t pos = 0;
+
+    json_value *out = tape.data;
+    uint32_t depth = 0;
+    uint64_t at = 0;
+
+#define JSON_FAIL(err)                                                                                                 \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        errorOffset = at;                                                                                              \
+        return json_error::err;                                                                                        \
+    } while (0)
+
+#define JSON_NEXT()                                                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (pos == n)                                                                                                  \
+        {                                                                                                              \
+            at = in.size;                                                                                              \
+            JSON_FAIL(UnexpectedEnd);                                                                                  \
+        }                                                                                                              \
+        at = offsets[pos++];                                                                                           \
+    } while (0)
+
+value:
+    JSON_NEXT();
+    switch (in[at])
     {
-        const uint8_t ch = ByteParser::Read(self);
-        if (ch == '"' /*  && prevch != '\\' */)
-            break;
+    case '{':
+    case '[': {
+        if (depth == stack.size)
+            JSON_FAIL(TooDeep);
 
-        prevch = ch;
+        const bool object = in[at] == '{';
+        stack[depth++] = json_frame{.begin = out++, .count = 0, .object = object};
 
-        ++count;
+        if (pos < n && in[offsets[pos]] == (object ? '}' : ']'))
+        {
+            at = offsets[pos++];
+            goto close;
+        }
+        if (object)
+            goto key;
+        goto value;
     }
 
-    json_value val;
-    JsonValue::SetValue(val, byteview{base, count});
+    case '"': {
+        const uint64_t begin = at + 1;
+        at = offsets[pos++]; // the closing quote, always indexed
+        JsonValue::SetValue(*out++, byteview{in.data + begin, at - begin});
+        break;
+    }
 
-    return PushOut(self, val);
-}
+    case 't':
+        if (!MatchLiteral(in, at, "true"_s))
+            JSON_FAIL(InvalidLiteral);
+        JsonValue::SetValue(*out++, true);
+        break;
 
-auto ParseArray(json_parser &self) -> json_value *
-{
-    json_value *begin = PushOut(self, json_value());
-    int32_t count = 0;
+    case 'f':
+        if (!MatchLiteral(in, at, "false"_s))
+            JSON_FAIL(InvalidLiteral);
+        JsonValue::SetValue(*out++, false);
+        break;
 
-    for (;;)
+    case 'n':
+        if (!MatchLiteral(in, at, "null"_s))
+            JSON_FAIL(InvalidLiteral);
+        JsonValue::SetValue(*out++, json_tag::Null);
+        break;
+
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        if (!ParseNumber(in, at, *out++))
+            JSON_FAIL(InvalidNumber);
+        break;
+
+    default:
+        JSON_FAIL(UnexpectedChar);
+    }
+
+after:
+    if (!depth)
     {
-        if (ByteParser::Peek(self) == ']')
+        if (pos != n)
         {
-            ByteParser::Advance(self);
-            break;
+            at = offsets[pos];
+            JSON_FAIL(TrailingData);
         }
 
-        ++count;
-
-        json_value *elem = ParseNext(self);
+        DASSERT(out == tape.data + tape.size);
+        return json_error::None;
+    }
 
-        StringParser::SkipWhitespace(self);
-        const uint8_t ch = ByteParser::Read(self);
-        if (ch == ']')
-            break;
+    ++stack[depth - 1].count;
 
-        ASSERT(ch == ',');
+    JSON_NEXT();
+    switch (in[at])
+    {
+    case ',':
+        if (stack[depth - 1].object)
+            goto key;
+        goto value;
+
+    case '}':
+        if (!stack[depth - 1].object)
+            JSON_FAIL(UnexpectedChar);
+        goto close;
+
+    case ']':
+        if (stack[depth - 1].object)
+            JSON_FAIL(UnexpectedChar);
+        goto close;
+
+    default:
+        JSON_FAIL(UnexpectedChar);
     }
 
-    json_value *end = PushOut(self, json_value());
+key:
+    JSON_NEXT();
+    if (in[at] != '"')
+        JSON_FAIL(UnexpectedChar);
+    {
+        const uint64_t begin = at + 1;
+        at = offsets[pos++];
+        JsonValue::SetValue(*out++, byteview{in.data + begin, at - begin});
+    }
 
-    JsonValue::SetValue(*begin, json_tag::ArrayBegin, count, end);
-    JsonValue::SetValue(*end, json_tag::ArrayEnd);
+    JSON_NEXT();
+    if (in[at] != ':')
+        JSON_FAIL(UnexpectedChar);
+    goto value;
+
+close: {
+    const json_frame &frame = stack[--depth];
+    json_value *end = out++;
+    JsonValue::SetValue(*frame.begin, frame.object ? json_tag::ObjectBegin : json_tag::ArrayBegin, frame.count, end);
+    JsonValue::SetValue(*end, frame.object ? json_tag::ObjectEnd : json_tag::ArrayEnd);
+    goto after;
+}
 
-    return begin;
+#undef JSON_NEXT
+#undef JSON_FAIL
 }
 
-auto ParseObject(json_parser &self) -> json_value *
-{
-    auto *begin = PushOut(self, json_value{});
-    uint32_t count = 0;
+} // namespace
 
-    for (;;)
-    {
-        if (ByteParser::Peek(self) == '}')
-        {
-            ByteParser::Advance(self);
-            break;
-        }
+auto API Parse(byteview in, region_alloc &alloc) -> json_result
+{
+    ASSERT(in.size < 0xFFFFFFFF);
 
-        ++count;
+    auto allocMark = alloc.at;
+    json_result ret{};
 
-        json_value *key = ParseNext(self);
-        ASSERT(key->tag == json_tag::String);
+    // Every byte is at most one index entry, the unused part is handed back before the tape is allocated.
+    json_index index{};
+    index.offsets = RegionAlloc::AllocArrayUninit<uint32_t>(alloc, in.size);
 
-        StringParser::SkipWhitespace(self);
-        ASSERT(ByteParser::Read(self) == ':');
+    ret.error = BuildIndex(in, index, ret.offset);
+    if (ret.error == json_error::None && !index.size)
+    {
+        ret.error = json_error::UnexpectedEnd;
+        ret.offset = in.size;
+    }
+    if (ret.error != json_error::None)
+    {
+        RegionAlloc::Reset(alloc, allocMark);
+        return ret;
+    }
+    if (index.size < in.size)
+        RegionAlloc::Reset(alloc, index.offsets.data + index.size);
 
-        json_value *val = ParseNext(self);
+    // Brackets give one entry each (begin or end), strings and scalars one, separators and closing quotes none.
+    const uint32_t tapeSize = index.size - index.separators - index.strings;
+    span<json_value> tape = RegionAlloc::AllocArrayUninit<json_value>(alloc, tapeSize);
 
-        StringParser::SkipWhitespace(self);
-        const uint8_t ch = ByteParser::Read(self);
-        if (ch == '}')
-            break;
+    auto stackMark = alloc.at;
+    span<json_frame> stack = RegionAlloc::AllocArray<json_frame>(alloc, kMaxDepth);
 
-        ASSERT(ch == ',');
+    ret.error = BuildTape(in, index, tape, stack, ret.offset);
+    if (ret.error != json_error::None)
+    {
+        RegionAlloc::Reset(alloc, allocMark);
+        return ret;
     }
 
-    json_value *end = PushOut(self, json_value());
-
-    JsonValue::SetValue(*begin, json_tag::ObjectBegin, count, end);
-    JsonValue::SetValue(*end, json_tag::ObjectEnd);
-
-    return begin;
+    RegionAlloc::Reset(alloc, stackMark);
+    ret.root = tape.data;
+    return ret;
 }
 
-} // namespace
-
-auto ParseNext(json_parser &self) -> json_value *
+auto API ErrorName(json_error error) -> byteview
 {
-    StringParser::SkipWhitespace(self);
-
-    uint8_t ch = ByteParser::Peek(self);
-    if (IsNumber(ch) || ch == '-')
-        return ParseNumber(self);
-    if (IsAlpha(ch))
-        return ParseLiteral(self);
-
-    ByteParser::Advance(self);
-    if (ch == '"')
-        return ParseString(self);
-    if (ch == '[')
-        return ParseArray(self);
-    if (ch == '{')
-        return ParseObject(self);
-
-    ASSERT(false);
-    return nullptr;
+    switch (error)
+    {
+    case json_error::None:
+        return "None"_s;
+    case json_error::UnexpectedEnd:
+        return "UnexpectedEnd"_s;
+    case json_error::UnexpectedChar:
+        return "UnexpectedChar"_s;
+    case json_error::UnterminatedString:
+        return "UnterminatedString"_s;
+    case json_error::InvalidString:
+        return "InvalidString"_s;
+    case json_error::InvalidLiteral:
+        return "InvalidLiteral"_s;
+    case json_error::InvalidNumber:
+        return "InvalidNumber"_s;
+    case json_error::TooDeep:
+        return "TooDeep"_s;
+    case json_error::TrailingData:
+        return "TrailingData"_s;
+    }
+    return "Unknown"_s;
 }
 
 } // namespace JsonParser
 
-} // namespace nyla
\ No newline at end of file
+} // namespace nyla
@@ -2,30 +2,47 @@
 
 #include <cstdint>
 
-#include "nyla/commons/byteparser.h"
 #include "nyla/commons/json_value.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/region_alloc_def.h"
+#include "nyla/commons/span_def.h"
 
 namespace nyla
 {
 
-struct json_parser : byte_parser
+enum class json_error : uint32_t
 {
-    json_value *out;
-    uint64_t outSize;
+    None = 0,
+    UnexpectedEnd,
+    UnexpectedChar,
+    UnterminatedString,
+    InvalidString, // unescaped control character or unknown escape
+    InvalidLiteral,
+    InvalidNumber,
+    TooDeep,
+    TrailingData,
 };
 
-namespace JsonParser
+struct json_result
 {
+    json_value *root; // nullptr on error
+    json_error error;
+    uint64_t offset; // of the offending byte
+};
 
-INLINE auto Init(json_parser &self, byteview in, span<json_value> jsonStorage)
+namespace JsonParser
 {
-    ByteParser::Init(self, in.data, in.size);
-    self.out = jsonStorage.data;
-    self.outSize = jsonStorage.size;
-}
 
-auto ParseNext(json_parser &self) -> json_value *;
+constexpr inline uint32_t kMaxDepth = 1024;
+
+// Two stages: an AVX2 pass classifies 64 bytes at a time into a structural index (brackets, ':', ',', quotes and
+// the first byte of every scalar outside strings), then a pass over the index builds the json_value tape, sized
+// exactly from the index. Strings are views into in, escapes are validated but not decoded. On error nothing is
+// left allocated from alloc.
+auto API Parse(byteview in, region_alloc &alloc) -> json_result;
+
+auto API ErrorName(json_error error) -> byteview;
 
 } // namespace JsonParser
 
-} // namespace nyla
\ No newline at end of file
+} // namespace nyla
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "nyla/commons/log.h"
 #include "nyla/commons/mem.h"
 #include "nyla/commons/mempage_pool.h"
 #include "nyla/commons/region_alloc.h"
@@ -10,11 +11,15 @@
 namespace nyla
 {
 
-void PlatformInit0(); // nothing is inited yet including memory allocators
-void PlatformInit1(); // memory alloactors are available
+void PlatformInit0();         // nothing is inited yet including memory allocators
+void PlatformInit1();         // memory alloactors are available
+void PlatformInitWindowing(); // connects to the window system, LibMainHeadless skips it
 void PlatformTearDown();
 
-void API LibMain(void (*userMain)())
+namespace
+{
+
+void Run(void (*userMain)(), bool windowing)
 {
     PlatformInit0();
 
@@ -27,8 +32,24 @@ void API LibMain(void (*userMain)())
     MemPagePool::Bootstrap();
 
     PlatformInit1();
+    if (windowing)
+        PlatformInitWindowing();
+    Log::Bootstrap();
     userMain();
+    Log::Shutdown();
     PlatformTearDown();
 }
 
+} // namespace
+
+void API LibMain(void (*userMain)())
+{
+    Run(userMain, true);
+}
+
+void API LibMainHeadless(void (*userMain)())
+{
+    Run(userMain, false);
+}
+
 } // namespace nyla
\ No newline at end of file
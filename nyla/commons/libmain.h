@@ -7,4 +7,8 @@ namespace nyla
 
 void API LibMain(void (*userMain)());
 
+// LibMain without the window system connection, for tools that never open a window and have to run without a
+// display. Any X11 or Win call asserts or crashes.
+void API LibMainHeadless(void (*userMain)());
+
 } // namespace nyla
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "nyla/commons/log.h"
+
+#include <cstdarg>
+#include <cstdint>
+
+#include "nyla/commons/dev_log.h"
+#include "nyla/commons/file.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/platform_condvar.h"
+#include "nyla/commons/platform_mutex.h"
+#include "nyla/commons/platform_thread.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+// Records are an 8 byte header (committed bit, kind, size) followed by the line, padded to 8 bytes so a header never
+// wraps. Producers reserve with a CAS on head, copy, then publish the header. The consumer zeroes what it drained
+// before moving tail, so a stale header is never mistaken for a committed one.
+constexpr uint64_t kRingSize = 1 << 20;
+constexpr uint64_t kCommitted = uint64_t{1} << 63;
+constexpr uint32_t kMaxBatch = 256;
+
+enum class log_record_kind : uint32_t
+{
+    Stderr,
+    DevLog,
+};
+
+struct log_state
+{
+    alignas(64) uint64_t head;
+    alignas(64) uint64_t tail;
+    uint32_t draining; // held by whoever consumes: the flusher, or WriteSync
+    uint32_t sleeping;
+    uint32_t quit;
+
+    uint8_t *ring;
+    platform_mutex *mutex;
+    platform_condvar *cv;
+    platform_thread *thread;
+};
+
+log_state *g_log;
+
+thread_local uint8_t t_line[Log::kMaxLineSize];
+thread_local bool t_isFlusher;
+
+INLINE auto RecordSize(uint64_t size) -> uint64_t
+{
+    return 8 + ((size + 7) & ~uint64_t{7});
+}
+
+INLINE auto HeaderAt(uint64_t pos) -> uint64_t *
+{
+    return (uint64_t *)(g_log->ring + (pos & (kRingSize - 1)));
+}
+
+// At most two contiguous pieces of ring starting at pos.
+INLINE auto RingSplit(uint64_t pos, uint64_t size, byteview &second) -> byteview
+{
+    const uint64_t at = pos & (kRingSize - 1);
+    const uint64_t first = Min(size, kRingSize - at);
+    second = byteview{g_log->ring, size - first};
+    return byteview{g_log->ring + at, first};
+}
+
+void Wake()
+{
+    PlatformMutex::Lock(*g_log->mutex);
+    PlatformCondvar::Signal(*g_log->cv);
+    PlatformMutex::Unlock(*g_log->mutex);
+}
+
+void Publish(const uint8_t *data, uint64_t size, log_record_kind kind)
+{
+    const uint64_t need = RecordSize(size);
+
+    uint64_t head = AtomicLoad64(&g_log->head);
+    for (;;)
+    {
+        if (head + need - AtomicLoad64(&g_log->tail) > kRingSize)
+        {
+            if (AtomicLoad32(&g_log->sleeping))
+                Wake();
+            CpuRelax();
+            head = AtomicLoad64(&g_log->head);
+            continue;
+        }
+        if (AtomicCompareExchange64(&g_log->head, head, head + need))
+            break;
+    }
+
+    byteview second;
+    byteview first = RingSplit(head + 8, size, second);
+    MemCpy((uint8_t *)first.data, data, first.size);
+    if (second.size)
+        MemCpy((uint8_t *)second.data, data + first.size, second.size);
+    AtomicStore64(HeaderAt(head), kCommitted | ((uint64_t)kind << 32) | size);
+
+    // Pairs with the flusher storing sleeping before its last look at the ring.
+    AtomicFence();
+    if (AtomicLoad32(&g_log->sleeping))
+        Wake();
+}
+
+// Caller holds draining. One gather write for up to kMaxBatch committed records, returns whether there were any.
+auto Drain() -> bool
+{
+    byteview parts[kMaxBatch * 2];
+    uint32_t partCount = 0;
+
+    const uint64_t tail = AtomicLoad64(&g_log->tail);
+    uint64_t pos = tail;
+    for (uint32_t i = 0; i < kMaxBatch; ++i)
+    {
+        const uint64_t header = AtomicLoad64(HeaderAt(pos));
+        if (!(header & kCommitted))
+            break;
+
+        const uint64_t size = (uint32_t)header;
+        const auto kind = (log_record_kind)((header >> 32) & 0xFF);
+
+        byteview second;
+        byteview first = RingSplit(pos + 8, size, second);
+        if (kind == log_record_kind::DevLog)
+        {
+            uint8_t line[DevLog::kLineCap];
+            MemCpy(line, first.data, first.size);
+            MemCpy(line + first.size, second.data, second.size);
+            DevLog::Append(byteview{line, size});
+        }
+        else
+        {
+            parts[partCount++] = first;
+            if (second.size)
+                parts[partCount++] = second;
+        }
+
+        pos += RecordSize(size);
+    }
+
+    if (pos == tail)
+        return false;
+
+    if (partCount)
+        FileWriteGather(GetStderr(), span<const byteview>{parts, partCount});
+
+    byteview second;
+    byteview first = RingSplit(tail, pos - tail, second);
+    MemZero((uint8_t *)first.data, first.size);
+    if (second.size)
+        MemZero((uint8_t *)second.data, second.size);
+    AtomicStore64(&g_log->tail, pos);
+    return true;
+}
+
+void FlusherMain(void *)
+{
+    t_isFlusher = true;
+
+    for (;;)
+    {
+        bool any = false;
+        if (AtomicCompareExchange32(&g_log->draining, 0, 1))
+        {
+            while (Drain())
+                any = true;
+            AtomicStore32(&g_log->draining, 0);
+        }
+        if (any)
+            continue;
+        if (AtomicLoad32(&g_log->quit))
+            break;
+
+        PlatformMutex::Lock(*g_log->mutex);
+        AtomicStore32(&g_log->sleeping, 1);
+        AtomicFence();
+        const bool pending = AtomicLoad64(HeaderAt(AtomicLoad64(&g_log->tail))) & kCommitted;
+        if (!pending && !AtomicLoad32(&g_log->quit))
+            PlatformCondvar::Wait(*g_log->cv, *g_log->mutex);
+        AtomicStore32(&g_log->sleeping, 0);
+        PlatformMutex::Unlock(*g_log->mutex);
+    }
+}
+
+auto FormatLine(byteview fmt, va_list args) -> uint64_t
+{
+    uint64_t size = StringWriteFmtTruncate_(span<uint8_t>{t_line, Log::kMaxLineSize}, fmt, args);
+    if (size == Log::kMaxLineSize)
+        t_line[size - 1] = '\n';
+    return size;
+}
+
+} // namespace
+
+namespace Log
+{
+
+void API Bootstrap()
+{
+    ASSERT(!g_log);
+
+    log_state &self = RegionAlloc::Alloc<log_state>(RegionAlloc::g_BootstrapAlloc);
+    self.ring = RegionAlloc::AllocArray<uint8_t>(RegionAlloc::g_BootstrapAlloc, kRingSize).data;
+    self.mutex = PlatformMutex::Create(RegionAlloc::g_BootstrapAlloc);
+    self.cv = PlatformCondvar::Create(RegionAlloc::g_BootstrapAlloc);
+    g_log = &self;
+
+    self.thread = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, FlusherMain, nullptr);
+    PlatformThread::SetName(*self.thread, "nyla-log");
+}
+
+void API Shutdown()
+{
+    if (!g_log)
+        return;
+
+    AtomicStore32(&g_log->quit, 1);
+    Wake();
+    PlatformThread::Join(*g_log->thread);
+
+    // Lines published between the flusher's last drain and its quit check.
+    while (!AtomicCompareExchange32(&g_log->draining, 0, 1))
+        CpuRelax();
+    while (Drain())
+        ;
+    g_log = nullptr;
+}
+
+void API Flush()
+{
+    if (!g_log || t_isFlusher)
+        return;
+
+    // Drain stops at a record that is reserved but not committed yet, its producer is about to finish it.
+    const uint64_t head = AtomicLoad64(&g_log->head);
+    while (AtomicLoad64(&g_log->tail) < head)
+    {
+        if (AtomicCompareExchange32(&g_log->draining, 0, 1))
+        {
+            while (Drain())
+                ;
+            AtomicStore32(&g_log->draining, 0);
+        }
+        CpuRelax();
+    }
+}
+
+void API Write(byteview fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const uint64_t size = FormatLine(fmt, args);
+    va_end(args);
+
+    // The flusher can not wait on its own ring.
+    if (!g_log || t_isFlusher)
+    {
+        FileWrite(GetStderr(), (uint32_t)size, t_line);
+        return;
+    }
+    Publish(t_line, size, log_record_kind::Stderr);
+}
+
+void API WriteSync(byteview fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const uint64_t size = FormatLine(fmt, args);
+    va_end(args);
+
+    // Bounded: a flusher stuck mid-batch must not hang an assert.
+    if (g_log && !t_isFlusher)
+    {
+        for (uint32_t spin = 0; spin < (1u << 16); ++spin)
+        {
+            if (AtomicCompareExchange32(&g_log->draining, 0, 1))
+            {
+                while (Drain())
+                    ;
+                AtomicStore32(&g_log->draining, 0);
+                break;
+            }
+            CpuRelax();
+        }
+    }
+
+    FileWrite(GetStderr(), (uint32_t)size, t_line);
+}
+
+void API PushDevLog(byteview line)
+{
+    line.size = Min<uint64_t>(line.size, DevLog::kLineCap);
+    if (!g_log || t_isFlusher)
+    {
+        DevLog::Append(line);
+        return;
+    }
+    Publish(line.data, line.size, log_record_kind::DevLog);
+}
+
+} // namespace Log
+
+} // namespace nyla
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+namespace Log
+{
+
+// Longer lines are cut.
+constexpr inline uint32_t kMaxLineSize = 16 << 10;
+
+// Starts the flusher thread. Until then, and again after Shutdown, every line is a single synchronous write.
+void API Bootstrap();
+// Writes out everything published so far and joins the flusher.
+void API Shutdown();
+
+// Returns once every line published before the call is written, the flusher keeps running.
+void API Flush();
+
+// LOG. Formats on the calling thread into a per-thread buffer and publishes the line to a lock-free ring, the flusher
+// drains the ring with one gather write per batch. Only blocks when the ring is full.
+void API Write(byteview fmt, ...);
+
+// LOG_SYNC, for ASSERT and crash paths. Drains what is already queued (unless the flusher is mid-batch or this is
+// the flusher), then writes the line directly before returning.
+void API WriteSync(byteview fmt, ...);
+
+// Hands a preformatted line to the flusher, which is the only thread that stores into the DevLog ring.
+void API PushDevLog(byteview line);
+
+} // namespace Log
+
+} // namespace nyla
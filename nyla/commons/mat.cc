@@ -1,5 +1,11 @@
 #include "nyla/commons/mat.h"
 
+#include <cstdint>
+
+#include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/span.h"  // IWYU pragma: keep
+#include "nyla/commons/vec.h"
+
 namespace nyla
 {
 
@@ -72,18 +78,147 @@ bool invert4x4f(const float m[16], float invOut[16])
     return true;
 }
 
+#define NYLA_SHUFFLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+
+// 2x2 blocks stored row-major in one register.
+
+INLINE auto Mat2Mul(__m128 a, __m128 b) -> __m128
+{
+    return _mm_add_ps(_mm_mul_ps(a, NYLA_SHUFFLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(NYLA_SHUFFLE(a, 1, 0, 3, 2), NYLA_SHUFFLE(b, 2, 1, 2, 1)));
+}
+
+// adj(a) * b
+INLINE auto Mat2AdjMul(__m128 a, __m128 b) -> __m128
+{
+    return _mm_sub_ps(_mm_mul_ps(NYLA_SHUFFLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(NYLA_SHUFFLE(a, 1, 1, 2, 2), NYLA_SHUFFLE(b, 2, 3, 0, 1)));
+}
+
+// a * adj(b)
+INLINE auto Mat2MulAdj(__m128 a, __m128 b) -> __m128
+{
+    return _mm_sub_ps(_mm_mul_ps(a, NYLA_SHUFFLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(NYLA_SHUFFLE(a, 1, 0, 3, 2), NYLA_SHUFFLE(b, 2, 1, 2, 1)));
+}
+
+template <int J>
+INLINE void StoreTranslateScale(float *dst, __m128 sx, __m128 sy, __m128 sz, __m128 t, const __m128 (&masks)[3])
+{
+    _mm_storeu_ps(dst + 0, _mm_and_ps(NYLA_SHUFFLE(sx, J, J, J, J), masks[0]));
+    _mm_storeu_ps(dst + 4, _mm_and_ps(NYLA_SHUFFLE(sy, J, J, J, J), masks[1]));
+    _mm_storeu_ps(dst + 8, _mm_and_ps(NYLA_SHUFFLE(sz, J, J, J, J), masks[2]));
+    _mm_storeu_ps(dst + 12, t);
+}
+
 } // namespace
 
 namespace Mat
 {
 
+// Block-wise inverse: with M = |A B; C D|, the 2x2 adjugates give all four blocks of adj(M) without a full
+// cofactor expansion. Works on the column-major storage as is, since inverse(transpose(M)) = transpose(inverse(M)).
 auto API Inverse(const mat<4, 4, float> &m) -> mat<4, 4, float>
+{
+    const float *f = (const float *)&m;
+    const __m128 v0 = _mm_loadu_ps(f + 0);
+    const __m128 v1 = _mm_loadu_ps(f + 4);
+    const __m128 v2 = _mm_loadu_ps(f + 8);
+    const __m128 v3 = _mm_loadu_ps(f + 12);
+
+    const __m128 a = _mm_movelh_ps(v0, v1);
+    const __m128 b = _mm_movehl_ps(v1, v0);
+    const __m128 c = _mm_movelh_ps(v2, v3);
+    const __m128 d = _mm_movehl_ps(v3, v2);
+
+    // (|A|, |B|, |C|, |D|)
+    const __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(v0, v2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(v1, v3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(v0, v2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(v1, v3, _MM_SHUFFLE(2, 0, 2, 0))));
+    const __m128 detA = NYLA_SHUFFLE(detSub, 0, 0, 0, 0);
+    const __m128 detB = NYLA_SHUFFLE(detSub, 1, 1, 1, 1);
+    const __m128 detC = NYLA_SHUFFLE(detSub, 2, 2, 2, 2);
+    const __m128 detD = NYLA_SHUFFLE(detSub, 3, 3, 3, 3);
+
+    const __m128 dc = Mat2AdjMul(d, c);
+    const __m128 ab = Mat2AdjMul(a, b);
+
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Mul(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Mul(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MulAdj(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MulAdj(a, dc));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 tr = _mm_mul_ps(ab, NYLA_SHUFFLE(dc, 0, 2, 1, 3));
+    tr = _mm_hadd_ps(tr, tr);
+    tr = _mm_hadd_ps(tr, tr);
+
+    __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+    detM = _mm_sub_ps(detM, tr);
+    ASSERT(_mm_cvtss_f32(detM) != 0.f);
+
+    const __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), detM);
+    x = _mm_mul_ps(x, rDetM);
+    y = _mm_mul_ps(y, rDetM);
+    z = _mm_mul_ps(z, rDetM);
+    w = _mm_mul_ps(w, rDetM);
+
+    mat<4, 4, float> out;
+    float *o = (float *)&out;
+    _mm_storeu_ps(o + 0, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(o + 4, _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(o + 8, _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(o + 12, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+    return out;
+}
+
+auto API InverseScalar(const mat<4, 4, float> &m) -> mat<4, 4, float>
 {
     mat<4, 4, float> out;
     ASSERT(invert4x4f((const float *)&m, (float *)&out));
     return out;
 }
 
+void API TranslateScaleBatch(const translate_scale_soa &in, span<mat<4, 4, float>> out)
+{
+    const uint64_t n = out.size;
+    ASSERT(in.posX.size == n && in.posY.size == n && in.posZ.size == n);
+    ASSERT(in.scaleX.size == n && in.scaleY.size == n && in.scaleZ.size == n);
+
+    const __m128 masks[3] = {
+        _mm_castsi128_ps(_mm_setr_epi32(-1, 0, 0, 0)),
+        _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, 0)),
+        _mm_castsi128_ps(_mm_setr_epi32(0, 0, -1, 0)),
+    };
+
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128 sx = _mm_loadu_ps(in.scaleX.data + i);
+        const __m128 sy = _mm_loadu_ps(in.scaleY.data + i);
+        const __m128 sz = _mm_loadu_ps(in.scaleZ.data + i);
+
+        // Transposing (x, y, z, 1) rows yields the translation column of each of the four matrices.
+        __m128 t0 = _mm_loadu_ps(in.posX.data + i);
+        __m128 t1 = _mm_loadu_ps(in.posY.data + i);
+        __m128 t2 = _mm_loadu_ps(in.posZ.data + i);
+        __m128 t3 = _mm_set1_ps(1.f);
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+
+        float *dst = (float *)(out.data + i);
+        StoreTranslateScale<0>(dst + 0, sx, sy, sz, t0, masks);
+        StoreTranslateScale<1>(dst + 16, sx, sy, sz, t1, masks);
+        StoreTranslateScale<2>(dst + 32, sx, sy, sz, t2, masks);
+        StoreTranslateScale<3>(dst + 48, sx, sy, sz, t3, masks);
+    }
+
+    for (; i < n; ++i)
+    {
+        out[i] = TranslateScale(float3{in.posX[i], in.posY[i], in.posZ[i]},
+                                float3{in.scaleX[i], in.scaleY[i], in.scaleZ[i]});
+    }
+}
+
 } // namespace Mat
 
 } // namespace nyla
\ No newline at end of file
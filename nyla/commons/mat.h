@@ -3,6 +3,7 @@
 #include "nyla/commons/fmt.h"
 #include "nyla/commons/intrin.h"
 #include "nyla/commons/mem.h"
+#include "nyla/commons/span_def.h"
 #include "nyla/commons/vec.h"
 
 #include <cstdint>
@@ -12,7 +13,7 @@ namespace nyla
 
 template <uint64_t N, uint64_t M, typename T> struct mat : array<array<T, M>, N>
 {
-    auto operator*(const mat &rhs) -> mat
+    auto operator*(const mat &rhs) const -> mat
     {
         mat ret{};
         for (uint64_t row = 0; row < N; ++row)
@@ -29,6 +30,46 @@ template <uint64_t N, uint64_t M, typename T> struct mat : array<array<T, M>, N>
 
 using float4x4 = mat<4, 4, float>;
 
+// Every result column is a linear combination of the lhs columns; two result columns per ymm.
+template <> inline auto mat<4, 4, float>::operator*(const mat &rhs) const -> mat
+{
+    const float *a = (const float *)this;
+    const float *b = (const float *)&rhs;
+
+    const __m256 a0 = _mm256_broadcast_ps((const __m128 *)(a + 0));
+    const __m256 a1 = _mm256_broadcast_ps((const __m128 *)(a + 4));
+    const __m256 a2 = _mm256_broadcast_ps((const __m128 *)(a + 8));
+    const __m256 a3 = _mm256_broadcast_ps((const __m128 *)(a + 12));
+
+    mat ret;
+    float *out = (float *)&ret;
+
+    for (uint32_t col = 0; col < 4; col += 2)
+    {
+        const __m256 bb = _mm256_loadu_ps(b + col * 4);
+
+        __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(bb, bb, 0x00));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_shuffle_ps(bb, bb, 0x55)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_shuffle_ps(bb, bb, 0xAA)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_shuffle_ps(bb, bb, 0xFF)));
+
+        _mm256_storeu_ps(out + col * 4, r);
+    }
+
+    return ret;
+}
+
+// SoA inputs for TranslateScaleBatch, all spans must be the same size.
+struct translate_scale_soa
+{
+    span<const float> posX;
+    span<const float> posY;
+    span<const float> posZ;
+    span<const float> scaleX;
+    span<const float> scaleY;
+    span<const float> scaleZ;
+};
+
 namespace Mat
 {
 
@@ -43,6 +84,85 @@ template <uint64_t N, uint64_t M, typename T> INLINE void Identity(mat<N, M, T>
 [[nodiscard]]
 auto API Inverse(const mat<4, 4, float> &m) -> mat<4, 4, float>;
 
+// Reference cofactor expansion, kept for comparing against Inverse.
+[[nodiscard]]
+auto API InverseScalar(const mat<4, 4, float> &m) -> mat<4, 4, float>;
+
+[[nodiscard]]
+INLINE auto TransformPoint(const mat<4, 4, float> &m, const array<float, 3> &p) -> array<float, 3>
+{
+    const float *c = (const float *)&m;
+
+    __m128 r = _mm_loadu_ps(c + 12);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(c + 0), _mm_set1_ps(p[0])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(c + 4), _mm_set1_ps(p[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(c + 8), _mm_set1_ps(p[2])));
+
+    alignas(16) float out[4];
+    _mm_store_ps(out, r);
+    return {out[0], out[1], out[2]};
+}
+
+// Same as Translate(pos) * Scale(scale) without the multiply.
+[[nodiscard]]
+INLINE auto TranslateScale(const array<float, 3> &pos, const array<float, 3> &scale) -> mat<4, 4, float>
+{
+    return {
+        scale[0],
+        0.f,
+        0.f,
+        0.f,
+        //
+        0.f,
+        scale[1],
+        0.f,
+        0.f,
+        //
+        0.f,
+        0.f,
+        scale[2],
+        0.f,
+        //
+        pos[0],
+        pos[1],
+        pos[2],
+        1.f,
+    };
+}
+
+// Same as Translate(pos) * Rotate(radians) * Scale(scale) without the multiplies.
+[[nodiscard]]
+INLINE auto TranslateRotateScale(const array<float, 3> &pos, float radians, const array<float, 3> &scale)
+    -> mat<4, 4, float>
+{
+    const float c = Cos(radians);
+    const float s = Sin(radians);
+
+    return {
+        c * scale[0],
+        s * scale[0],
+        0.f,
+        0.f,
+        //
+        -s * scale[1],
+        c * scale[1],
+        0.f,
+        0.f,
+        //
+        0.f,
+        0.f,
+        scale[2],
+        0.f,
+        //
+        pos[0],
+        pos[1],
+        pos[2],
+        1.f,
+    };
+}
+
+void API TranslateScaleBatch(const translate_scale_soa &in, span<mat<4, 4, float>> out);
+
 [[nodiscard]]
 INLINE auto Translate(const array<float, 4> &v) -> mat<4, 4, float>
 {
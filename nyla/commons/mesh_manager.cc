@@ -5,10 +5,13 @@
 
 #include "assets.h"
 #include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/asset_file_format.h"
 #include "nyla/commons/asset_manager.h"
-#include "nyla/commons/gltf.h"
+#include "nyla/commons/byteliterals.h"
 #include "nyla/commons/gpu_upload.h"
 #include "nyla/commons/handle_pool.h"
+#include "nyla/commons/inline_vec.h"
+#include "nyla/commons/inline_vec_def.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/mem.h"
 #include "nyla/commons/region_alloc.h"
@@ -23,26 +26,45 @@ namespace nyla
 namespace
 {
 
+constexpr uint32_t kMaxSubmeshes = 16;
+constexpr uint64_t kHeadlessStreamSize = 16_MiB;
+
 enum class mesh_state
 {
     NotUploaded = 0,
     Uploaded
 };
 
+struct mesh_submesh
+{
+    mesh_blob_lod lods[kMeshBlobMaxLods];
+    uint32_t baseVertex;
+    uint64_t textureGuid;
+    texture_handle texture;
+};
+
 struct mesh_metadata
 {
-    uint64_t guidGltf;
-    uint64_t guidBin;
+    uint64_t guid;
     mesh_state state;
     uint64_t vertexBufferOffset;
     uint64_t indexBufferOffset;
-    uint32_t indexCount;
-    texture_handle texture;
+    rhi_index_format indexFormat;
+    mesh_blob_vertex_format vertexFormat;
+    uint32_t lodCount;
+    float lodError[kMeshBlobMaxLods];
+    mesh_bounds bounds;
+    inline_vec<mesh_submesh, kMaxSubmeshes> submeshes;
 };
 
 struct mesh_manager
 {
-    handle_pool<mesh_handle, mesh_metadata, 128> meshes;
+    handle_pool<mesh_handle, mesh_metadata, MeshManager::kMaxMeshes> meshes;
+
+    // BootstrapHeadless, every load copies its streams here instead of to the static GPU buffers.
+    bool headless;
+    span<uint8_t> headlessVertices;
+    span<uint8_t> headlessIndices;
 };
 mesh_manager *manager;
 
@@ -54,7 +76,7 @@ void OnAssetChanged(uint64_t guid, byteview, void *)
             continue;
 
         mesh_metadata &metadata = slot.data;
-        if (metadata.guidGltf != guid && metadata.guidBin != guid)
+        if (metadata.guid != guid)
             continue;
 
         metadata.state = mesh_state::NotUploaded;
@@ -72,10 +94,17 @@ void API Bootstrap()
     AssetManager::Subscribe(OnAssetChanged, nullptr);
 }
 
-void API Update(region_alloc &alloc, rhi_cmdlist cmd)
+void API BootstrapHeadless()
 {
-    void *allocMark = alloc.at;
+    Bootstrap();
 
+    manager->headless = true;
+    manager->headlessVertices = RegionAlloc::AllocArray<uint8_t>(RegionAlloc::g_BootstrapAlloc, kHeadlessStreamSize);
+    manager->headlessIndices = RegionAlloc::AllocArray<uint8_t>(RegionAlloc::g_BootstrapAlloc, kHeadlessStreamSize);
+}
+
+void API Update(rhi_cmdlist cmd)
+{
     for (auto &slot : manager->meshes)
     {
         if (!slot.used)
@@ -85,121 +114,82 @@ void API Update(region_alloc &alloc, rhi_cmdlist cmd)
         if (metadata.state != mesh_state::NotUploaded)
             continue;
 
-        LOG("Uploading mesh '%" PRIu64 "' '%" PRIu64 "'", metadata.guidGltf, metadata.guidBin);
-        RegionAlloc::Reset(alloc, allocMark);
+        // Tools and benchmarks reload the same mesh over and over.
+        if (!manager->headless)
+            LOG("Uploading mesh '%" PRIu64 "'", metadata.guid);
+
+        // Cooked by asset_packer, both streams go to the GPU as is.
+        byteview blob = AssetManager::Get(metadata.guid);
+        ASSERT(blob.size >= sizeof(mesh_blob_header));
+
+        const auto &header = *(const mesh_blob_header *)blob.data;
+        ASSERT(header.magic == kMeshBlobMagic);
+        ASSERT(header.vertexFormat == mesh_blob_vertex_format::Quantized
+                   ? header.vertexStride == kMeshBlobQuantizedVertexStride
+                   : header.vertexStride == kMeshBlobFloat32VertexStride);
+        ASSERT(header.indexSize == 2 || header.indexSize == 4);
+        ASSERT(header.submeshCount <= kMaxSubmeshes);
+        ASSERT(header.lodCount >= 1 && header.lodCount <= kMeshBlobMaxLods);
+
+        const uint32_t vertexBytes = header.vertexCount * header.vertexStride;
+        const uint32_t indexBytes = header.indexCount * header.indexSize;
+        ASSERT(uint64_t{header.vertexOffset} + vertexBytes <= blob.size);
+        ASSERT(uint64_t{header.indexOffset} + indexBytes <= blob.size);
+
+        if (manager->headless)
+        {
+            ASSERT(vertexBytes <= manager->headlessVertices.size && indexBytes <= manager->headlessIndices.size);
+            metadata.vertexBufferOffset = 0;
+            metadata.indexBufferOffset = 0;
+            MemCpy(manager->headlessVertices.data, blob.data + header.vertexOffset, vertexBytes);
+            MemCpy(manager->headlessIndices.data, blob.data + header.indexOffset, indexBytes);
+        }
+        else
+        {
+            MemCpy(GpuUpload::CmdCopyStaticVertices(cmd, vertexBytes, metadata.vertexBufferOffset),
+                   blob.data + header.vertexOffset, vertexBytes);
+            MemCpy(GpuUpload::CmdCopyStaticIndices(cmd, indexBytes, metadata.indexBufferOffset),
+                   blob.data + header.indexOffset, indexBytes);
+        }
 
-        gltf_parser parser{};
-        parser.jsonChunk = AssetManager::Get(metadata.guidGltf);
-        parser.binChunk = AssetManager::Get(metadata.guidBin);
+        metadata.indexFormat = header.indexSize == 4 ? rhi_index_format::UInt32 : rhi_index_format::UInt16;
+        metadata.vertexFormat = header.vertexFormat;
+        metadata.lodCount = header.lodCount;
+        MemCpy(metadata.lodError, header.lodError, sizeof(header.lodError));
+        metadata.bounds = mesh_bounds{
+            .min = {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]},
+            .max = {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]},
+        };
+
+        const auto *submeshes = (const mesh_blob_submesh *)(blob.data + sizeof(mesh_blob_header));
+        for (uint32_t i = 0; i < header.submeshCount; ++i)
+        {
+            const mesh_blob_submesh &src = submeshes[i];
 
-        ASSERT(GltfParser::Parse(parser, alloc));
+            // Meshes without a material texture fall back to the wall texture.
+            const uint64_t textureGuid = src.textureGuid ? src.textureGuid : ID_texture_wall;
 
-        ASSERT(parser.images.size == 1);
+            if (i == metadata.submeshes.size)
+                InlineVec::Append(metadata.submeshes, mesh_submesh{});
 
-        { // TODO: probably deal with this at packing stage - add custom attributes into gltf? or resolve via path <-
-          // this is ugly
-            gltf_image image = Span::Front(parser.images);
-            if (!metadata.texture)
-                metadata.texture = TextureManager::DeclareTexture(ID_texture_wall);
-        }
+            mesh_submesh &dst = metadata.submeshes[i];
+            if (!dst.texture || dst.textureGuid != textureGuid)
+                dst.texture = TextureManager::DeclareTexture(textureGuid);
 
-        for (const auto &mesh : parser.meshes)
-        {
-            const auto &meshPrimitive = Span::Front(mesh.primitives);
-
-            {
-                gltf_accessor indices = parser.accessors[meshPrimitive.indices];
-                ASSERT(indices.type == gltf_accessor_type::SCALAR);
-                ASSERT(indices.componentType == gltf_accessor_component_type::UNSIGNED_SHORT);
-
-                gltf_buffer_view bufferView = parser.bufferViews[indices.bufferView];
-
-                uint32_t bufferSize = indices.count * GetGltfAccessorSize(indices);
-                char *const uploadMemory = GpuUpload::CmdCopyStaticIndices(cmd, bufferSize, metadata.indexBufferOffset);
-
-                byteview indicesData = GltfParser::GetAccessorData(parser, indices);
-                ASSERT((Span::SizeBytes(indicesData) % sizeof(uint16_t)) == 0);
-
-                MemCpy(uploadMemory, indicesData.data, Span::SizeBytes(indicesData));
-
-                metadata.indexCount = Span::SizeBytes(indicesData) / sizeof(uint16_t);
-                ASSERT(metadata.indexCount % 3 == 0);
-            }
-
-            {
-                auto &attrs = meshPrimitive.attributes;
-
-                uint32_t stride = 0;
-
-                auto alignStride = [&](gltf_accessor accessor) -> void {
-                    const uint32_t componentSize = GetGltfAccessorComponentSize(accessor.componentType);
-                    stride = AlignedUp(stride, componentSize);
-                };
-                auto countStride = [&](gltf_accessor accessor) -> uint32_t {
-                    alignStride(accessor);
-                    const uint32_t offset = stride;
-
-                    stride += GetGltfAccessorSize(accessor);
-                    return offset;
-                };
-
-                gltf_accessor pos;
-
-                ASSERT(GltfParser::FindAttributeAccessor(parser, attrs, "POSITION"_s, pos));
-                ASSERT(pos.type == gltf_accessor_type::VEC3);
-                ASSERT(pos.componentType == gltf_accessor_component_type::FLOAT);
-                const uint32_t posOffset = countStride(pos);
-
-                gltf_accessor norm;
-                ASSERT(GltfParser::FindAttributeAccessor(parser, attrs, "NORMAL"_s, norm));
-                ASSERT(norm.type == gltf_accessor_type::VEC3);
-                ASSERT(norm.componentType == gltf_accessor_component_type::FLOAT);
-                ASSERT(norm.count == pos.count);
-                const uint32_t normOffset = countStride(norm);
-
-                gltf_accessor texCoord;
-                ASSERT(GltfParser::FindAttributeAccessor(parser, attrs, "TEXCOORD_0"_s, texCoord));
-                ASSERT(texCoord.type == gltf_accessor_type::VEC2);
-                ASSERT(texCoord.componentType == gltf_accessor_component_type::FLOAT);
-                ASSERT(texCoord.count == pos.count);
-                const uint32_t texCoordOffset = countStride(texCoord);
-
-                alignStride(pos);
-                const uint32_t bufferSize = stride * pos.count;
-
-                byteview posBufferView = GltfParser::GetAccessorData(parser, pos);
-                byteview normBufferView = GltfParser::GetAccessorData(parser, norm);
-                byteview texCoordBufferView = GltfParser::GetAccessorData(parser, texCoord);
-
-                char *const uploadMemory =
-                    GpuUpload::CmdCopyStaticVertices(cmd, bufferSize, metadata.vertexBufferOffset);
-
-                for (uint32_t i = 0; i < pos.count; ++i)
-                {
-                    auto copyAttribute = [uploadMemory, i, stride](gltf_accessor accessor, uint32_t offset,
-                                                                   const uint8_t *byteBufferViewData) -> void {
-                        void *const dst = uploadMemory + static_cast<uint64_t>(i * stride + offset);
-                        const void *const src =
-                            byteBufferViewData + static_cast<uint64_t>(i * GetGltfAccessorSize(accessor));
-                        MemCpy(dst, src, GetGltfAccessorSize(accessor));
-                    };
-
-                    copyAttribute(pos, posOffset, posBufferView.data);
-                    copyAttribute(norm, normOffset, normBufferView.data);
-                    copyAttribute(texCoord, texCoordOffset, texCoordBufferView.data);
-                }
-            }
+            MemCpy(dst.lods, src.lods, sizeof(src.lods));
+            dst.baseVertex = src.baseVertex;
+            dst.textureGuid = textureGuid;
         }
+        InlineVec::Resize(metadata.submeshes, header.submeshCount);
 
         metadata.state = mesh_state::Uploaded;
     }
 }
 
-auto API DeclareMesh(uint64_t guidGltf, uint64_t guidBin) -> mesh_handle
+auto API DeclareMesh(uint64_t guid) -> mesh_handle
 {
     return HandlePool::Acquire(manager->meshes, mesh_metadata{
-                                                    .guidGltf = guidGltf,
-                                                    .guidBin = guidBin,
+                                                    .guid = guid,
                                                     .state = mesh_state::NotUploaded,
                                                 });
 }
@@ -210,23 +200,58 @@ void API CmdBindMesh(rhi_cmdlist cmd, mesh_handle Mesh)
     ASSERT(meshData.state == mesh_state::Uploaded);
 
     GpuUpload::CmdBindStaticMeshVertexBuffer(cmd, meshData.vertexBufferOffset);
-    GpuUpload::CmdBindStaticMeshIndexBuffer(cmd, meshData.indexBufferOffset);
+    GpuUpload::CmdBindStaticMeshIndexBuffer(cmd, meshData.indexBufferOffset, meshData.indexFormat);
 }
 
-void API CmdDrawMesh(rhi_cmdlist cmd, mesh_handle Mesh)
+void API CmdDrawMesh(rhi_cmdlist cmd, mesh_handle Mesh, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance)
 {
     const auto &meshData = HandlePool::ResolveData(manager->meshes, Mesh);
     ASSERT(meshData.state == mesh_state::Uploaded);
 
-    Rhi::CmdDrawIndexed(cmd, meshData.indexCount, 0, 1, 0, 0);
+    // A reload may have cooked fewer levels than the caller picked from.
+    if (lod >= meshData.lodCount)
+        lod = meshData.lodCount - 1;
+
+    for (const mesh_submesh &submesh : meshData.submeshes)
+    {
+        const mesh_blob_lod &range = submesh.lods[lod];
+        Rhi::CmdDrawIndexed(cmd, range.indexCount, (int32_t)submesh.baseVertex, instanceCount, range.firstIndex,
+                            firstInstance);
+    }
 }
 
 auto API GetTexture(mesh_handle Mesh) -> texture_handle
 {
-    if (Mesh)
-        return HandlePool::ResolveData(manager->meshes, Mesh).texture;
-    else
+    if (!Mesh)
         return {};
+
+    const auto &meshData = HandlePool::ResolveData(manager->meshes, Mesh);
+    if (!meshData.submeshes.size)
+        return {};
+    return meshData.submeshes[0].texture;
+}
+
+auto API GetBounds(mesh_handle Mesh) -> mesh_bounds
+{
+    return HandlePool::ResolveData(manager->meshes, Mesh).bounds;
+}
+
+auto API GetLodCount(mesh_handle Mesh) -> uint32_t
+{
+    const auto &meshData = HandlePool::ResolveData(manager->meshes, Mesh);
+    return meshData.state == mesh_state::Uploaded ? meshData.lodCount : 1;
+}
+
+auto API GetLodError(mesh_handle Mesh, uint32_t lod) -> float
+{
+    const auto &meshData = HandlePool::ResolveData(manager->meshes, Mesh);
+    ASSERT(lod < meshData.lodCount);
+    return meshData.lodError[lod];
+}
+
+auto API GetVertexFormat(mesh_handle Mesh) -> mesh_blob_vertex_format
+{
+    return HandlePool::ResolveData(manager->meshes, Mesh).vertexFormat;
 }
 
 } // namespace MeshManager
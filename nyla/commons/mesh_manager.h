@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstdint>
+
+#include "nyla/commons/asset_file_format.h"
 #include "nyla/commons/handle.h"
 #include "nyla/commons/macros.h"
-#include "nyla/commons/region_alloc_def.h"
 #include "nyla/commons/rhi.h"
 #include "nyla/commons/texture_manager.h"
+#include "nyla/commons/vec.h"
 
 namespace nyla
 {
@@ -13,19 +16,42 @@ struct mesh_handle : handle
 {
 };
 
+struct mesh_bounds
+{
+    float3 min;
+    float3 max;
+};
+
 namespace MeshManager
 {
 
+constexpr uint32_t kMaxMeshes = 128;
+constexpr uint32_t kMaxLods = kMeshBlobMaxLods;
+
 void API Bootstrap();
+// No static GPU buffers: every load copies its streams to the same CPU buffer, so lods, bounds and textures are
+// what can be read back. Update ignores cmd. For tools and benchmarks.
+void API BootstrapHeadless();
 
-void API Update(region_alloc &alloc, rhi_cmdlist cmd);
+void API Update(rhi_cmdlist cmd);
 
-auto API DeclareMesh(uint64_t guidGltf, uint64_t guidBin) -> mesh_handle;
+// guid of a mesh blob cooked by asset_packer from a .gltf
+auto API DeclareMesh(uint64_t guid) -> mesh_handle;
 
 void API CmdBindMesh(rhi_cmdlist cmd, mesh_handle Mesh);
-void API CmdDrawMesh(rhi_cmdlist cmd, mesh_handle Mesh);
+void API CmdDrawMesh(rhi_cmdlist cmd, mesh_handle Mesh, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance);
 
+// Texture of the first submesh.
 auto API GetTexture(mesh_handle Mesh) -> texture_handle;
+auto API GetBounds(mesh_handle Mesh) -> mesh_bounds;
+
+// Level 0 is full detail. The error is the worst object space deviation of a level from it, 1 level until the
+// mesh is uploaded.
+auto API GetLodCount(mesh_handle Mesh) -> uint32_t;
+auto API GetLodError(mesh_handle Mesh, uint32_t lod) -> float;
+
+// Layout of the bound vertex stream, draws need a pipeline with matching vertex attributes.
+auto API GetVertexFormat(mesh_handle Mesh) -> mesh_blob_vertex_format;
 
 } // namespace MeshManager
 
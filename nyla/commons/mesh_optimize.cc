@@ -0,0 +1,807 @@
+#include "nyla/commons/mesh_optimize.h"
+
+#include <cstdint>
+
+#include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/vec.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+// Forsyth scoring, see "Linear-Speed Vertex Cache Optimisation". The modelled LRU cache is deliberately larger
+// than the FIFO the result is measured against, it only steers the greedy choice.
+constexpr uint32_t kScoreCacheSize = 32;
+constexpr uint32_t kMaxScoredValence = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriScore = 0.75f;
+constexpr float kValenceBoostScale = 2.f;
+constexpr float kValenceBoostPower = 0.5f;
+constexpr uint32_t kNoTriangle = 0xFFFFFFFF;
+
+struct forsyth_tables
+{
+    float cache[kScoreCacheSize];
+    float valence[kMaxScoredValence];
+};
+
+auto MakeForsythTables() -> forsyth_tables
+{
+    forsyth_tables tables;
+    for (uint32_t i = 0; i < kScoreCacheSize; ++i)
+    {
+        if (i < 3)
+            tables.cache[i] = kLastTriScore;
+        else
+            tables.cache[i] = Pow(1.f - float(i - 3) / float(kScoreCacheSize - 3), kCacheDecayPower);
+    }
+
+    tables.valence[0] = 0.f;
+    for (uint32_t i = 1; i < kMaxScoredValence; ++i)
+        tables.valence[i] = kValenceBoostScale * Pow(float(i), -kValenceBoostPower);
+    return tables;
+}
+
+auto VertexScore(const forsyth_tables &tables, int32_t cachePos, uint32_t valence) -> float
+{
+    if (!valence)
+        return -1.f;
+
+    float score = cachePos >= 0 ? tables.cache[cachePos] : 0.f;
+    score += valence < kMaxScoredValence ? tables.valence[valence]
+                                         : kValenceBoostScale * Pow(float(valence), -kValenceBoostPower);
+    return score;
+}
+
+struct cluster_key
+{
+    float key;
+    uint32_t first;
+    uint32_t count;
+};
+
+auto AbsF(float x) -> float
+{
+    return x < 0.f ? -x : x;
+}
+
+// Symmetric 4x4 plane quadric, area weighted. w is the total weight so error / w is a squared distance.
+struct quadric
+{
+    double a00, a01, a02, a03;
+    double a11, a12, a13;
+    double a22, a23;
+    double a33;
+    double w;
+};
+
+void QuadricAdd(quadric &self, const quadric &rhs)
+{
+    self.a00 += rhs.a00;
+    self.a01 += rhs.a01;
+    self.a02 += rhs.a02;
+    self.a03 += rhs.a03;
+    self.a11 += rhs.a11;
+    self.a12 += rhs.a12;
+    self.a13 += rhs.a13;
+    self.a22 += rhs.a22;
+    self.a23 += rhs.a23;
+    self.a33 += rhs.a33;
+    self.w += rhs.w;
+}
+
+auto QuadricFromPlane(const float3 &n, float d, float w) -> quadric
+{
+    const double a = n[0];
+    const double b = n[1];
+    const double c = n[2];
+    const double e = d;
+    return quadric{
+        .a00 = w * a * a,
+        .a01 = w * a * b,
+        .a02 = w * a * c,
+        .a03 = w * a * e,
+        .a11 = w * b * b,
+        .a12 = w * b * c,
+        .a13 = w * b * e,
+        .a22 = w * c * c,
+        .a23 = w * c * e,
+        .a33 = w * e * e,
+        .w = w,
+    };
+}
+
+auto QuadricError(const quadric &q, const float3 &p) -> double
+{
+    const double x = p[0];
+    const double y = p[1];
+    const double z = p[2];
+
+    const double rx = q.a00 * x + q.a01 * y + q.a02 * z + q.a03;
+    const double ry = q.a01 * x + q.a11 * y + q.a12 * z + q.a13;
+    const double rz = q.a02 * x + q.a12 * y + q.a22 * z + q.a23;
+    const double rw = q.a03 * x + q.a13 * y + q.a23 * z + q.a33;
+
+    const double error = rx * x + ry * y + rz * z + rw;
+    if (q.w <= 0.0)
+        return 0.0;
+    return error > 0.0 ? error / q.w : 0.0;
+}
+
+constexpr uint64_t kEmptyEdge = ~uint64_t{0};
+
+auto EdgeKey(uint32_t a, uint32_t b) -> uint64_t
+{
+    return (uint64_t{a} << 32) | b;
+}
+
+auto EdgeSlot(uint64_t key, uint64_t mask) -> uint64_t
+{
+    return ((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+void EdgeInsert(span<uint64_t> table, uint64_t key)
+{
+    const uint64_t mask = table.size - 1;
+    for (uint64_t slot = EdgeSlot(key, mask);; slot = (slot + 1) & mask)
+    {
+        if (table[slot] == key)
+            return;
+        if (table[slot] == kEmptyEdge)
+        {
+            table[slot] = key;
+            return;
+        }
+    }
+}
+
+auto EdgeContains(span<const uint64_t> table, uint64_t key) -> bool
+{
+    const uint64_t mask = table.size - 1;
+    for (uint64_t slot = EdgeSlot(key, mask);; slot = (slot + 1) & mask)
+    {
+        if (table[slot] == key)
+            return true;
+        if (table[slot] == kEmptyEdge)
+            return false;
+    }
+}
+
+// LSD radix sort of order by keys[order[i]], 8 bits per pass. Non-negative floats sort correctly by their bits.
+void RadixSort(span<uint32_t> order, span<const uint32_t> keys, region_alloc &scratch)
+{
+    auto allocMark = scratch.at;
+    span<uint32_t> tmp = RegionAlloc::AllocArray<uint32_t>(scratch, order.size);
+
+    uint32_t *src = order.data;
+    uint32_t *dst = tmp.data;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t offsets[256] = {};
+        for (uint64_t i = 0; i < order.size; ++i)
+            ++offsets[(keys[src[i]] >> shift) & 0xFF];
+
+        uint32_t sum = 0;
+        for (uint32_t &offset : offsets)
+        {
+            const uint32_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+
+        for (uint64_t i = 0; i < order.size; ++i)
+            dst[offsets[(keys[src[i]] >> shift) & 0xFF]++] = src[i];
+
+        uint32_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // Four passes, the result is back in order.
+    RegionAlloc::Reset(scratch, allocMark);
+}
+
+} // namespace
+
+namespace MeshOptimize
+{
+
+auto API SimulateAcmr(span<const uint32_t> indices, uint32_t vertexCount, region_alloc &scratch, uint32_t cacheSize)
+    -> float
+{
+    const uint64_t triCount = indices.size / 3;
+    if (!triCount)
+        return 0.f;
+
+    auto allocMark = scratch.at;
+
+    // Timestamps instead of a real FIFO: a vertex is resident while fewer than cacheSize misses happened since
+    // it was loaded. Starting the clock past cacheSize makes every vertex cold.
+    span<uint32_t> timestamps = RegionAlloc::AllocArray<uint32_t>(scratch, vertexCount);
+
+    uint32_t time = cacheSize + 1;
+    uint64_t misses = 0;
+    for (uint32_t index : indices)
+    {
+        ASSERT(index < vertexCount);
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            ++misses;
+        }
+    }
+
+    RegionAlloc::Reset(scratch, allocMark);
+    return float(misses) / float(triCount);
+}
+
+void API OptimizeVertexCache(span<uint32_t> indices, uint32_t vertexCount, region_alloc &scratch)
+{
+    const uint32_t triCount = uint32_t(indices.size / 3);
+    if (triCount < 2)
+        return;
+
+    static const forsyth_tables tables = MakeForsythTables();
+
+    auto allocMark = scratch.at;
+
+    span<uint32_t> valence = RegionAlloc::AllocArray<uint32_t>(scratch, vertexCount);
+    span<uint32_t> adjOffset = RegionAlloc::AllocArray<uint32_t>(scratch, vertexCount + 1);
+    span<uint32_t> adjTris = RegionAlloc::AllocArray<uint32_t>(scratch, indices.size);
+    span<int32_t> cachePos = RegionAlloc::AllocArray<int32_t>(scratch, vertexCount);
+    span<float> vertScore = RegionAlloc::AllocArray<float>(scratch, vertexCount);
+    span<float> triScore = RegionAlloc::AllocArray<float>(scratch, triCount);
+    span<uint8_t> triEmitted = RegionAlloc::AllocArray<uint8_t>(scratch, triCount);
+    span<uint32_t> result = RegionAlloc::AllocArray<uint32_t>(scratch, indices.size);
+
+    for (uint32_t index : indices)
+        ++valence[index];
+
+    adjOffset[0] = 0;
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        adjOffset[v + 1] = adjOffset[v] + valence[v];
+
+    // Fill back to front so adjOffset ends up pointing at each list's start again.
+    for (uint32_t i = uint32_t(indices.size); i-- > 0;)
+    {
+        const uint32_t v = indices[i];
+        adjTris[--adjOffset[v + 1]] = i / 3;
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        adjOffset[v + 1] = adjOffset[v] + valence[v];
+
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        cachePos[v] = -1;
+        vertScore[v] = VertexScore(tables, -1, valence[v]);
+    }
+
+    uint32_t bestTri = 0;
+    for (uint32_t t = 0; t < triCount; ++t)
+    {
+        triScore[t] = vertScore[indices[t * 3 + 0]] + vertScore[indices[t * 3 + 1]] + vertScore[indices[t * 3 + 2]];
+        if (triScore[t] > triScore[bestTri])
+            bestTri = t;
+    }
+
+    uint32_t cache[kScoreCacheSize + 3];
+    uint32_t cacheSize = 0;
+    uint32_t cursor = 0;
+
+    for (uint32_t out = 0; out < triCount; ++out)
+    {
+        if (bestTri == kNoTriangle)
+        {
+            while (triEmitted[cursor])
+                ++cursor;
+            bestTri = cursor;
+        }
+
+        const uint32_t tri = bestTri;
+        triEmitted[tri] = 1;
+        MemCpy(&result[out * 3], &indices[tri * 3], 3 * sizeof(uint32_t));
+
+        uint32_t newCache[kScoreCacheSize + 3];
+        uint32_t newCacheSize = 0;
+
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            const uint32_t v = indices[tri * 3 + k];
+
+            // Swap-remove the emitted triangle, the first valence entries stay the live adjacency.
+            uint32_t *list = &adjTris[adjOffset[v]];
+            for (uint32_t j = 0; j < valence[v]; ++j)
+            {
+                if (list[j] == tri)
+                {
+                    list[j] = list[valence[v] - 1];
+                    break;
+                }
+            }
+            --valence[v];
+
+            newCache[newCacheSize++] = v;
+        }
+
+        for (uint32_t i = 0; i < cacheSize; ++i)
+        {
+            const uint32_t v = cache[i];
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+                newCache[newCacheSize++] = v;
+        }
+
+        for (uint32_t i = 0; i < newCacheSize; ++i)
+        {
+            const uint32_t v = newCache[i];
+            cachePos[v] = i < kScoreCacheSize ? int32_t(i) : -1;
+
+            const float score = VertexScore(tables, cachePos[v], valence[v]);
+            const float delta = score - vertScore[v];
+            vertScore[v] = score;
+
+            for (uint32_t j = 0; j < valence[v]; ++j)
+                triScore[adjTris[adjOffset[v] + j]] += delta;
+        }
+
+        // Only triangles touching the cache changed score, the best one is almost always among them.
+        bestTri = kNoTriangle;
+        float bestScore = -1.f;
+        for (uint32_t i = 0; i < newCacheSize; ++i)
+        {
+            const uint32_t v = newCache[i];
+            for (uint32_t j = 0; j < valence[v]; ++j)
+            {
+                const uint32_t t = adjTris[adjOffset[v] + j];
+                if (triScore[t] > bestScore)
+                {
+                    bestScore = triScore[t];
+                    bestTri = t;
+                }
+            }
+        }
+
+        cacheSize = Min(newCacheSize, kScoreCacheSize);
+        MemCpy(cache, newCache, cacheSize * sizeof(uint32_t));
+    }
+
+    MemCpy(indices.data, result.data, indices.size * sizeof(uint32_t));
+    RegionAlloc::Reset(scratch, allocMark);
+}
+
+void API OptimizeOverdraw(span<uint32_t> indices, span<const float3> positions, float threshold,
+                          region_alloc &scratch)
+{
+    constexpr uint32_t kCacheSize = 16;
+
+    const uint32_t triCount = uint32_t(indices.size / 3);
+    if (triCount < 2)
+        return;
+
+    auto allocMark = scratch.at;
+
+    const uint32_t vertexCount = uint32_t(positions.size);
+    span<uint32_t> timestamps = RegionAlloc::AllocArray<uint32_t>(scratch, vertexCount);
+
+    span<uint32_t> hard = RegionAlloc::AllocArray<uint32_t>(scratch, triCount + 1);
+    uint32_t hardCount = 0;
+
+    // Hard boundaries: a triangle that misses on all three vertices starts from a cold cache anyway.
+    uint32_t time = kCacheSize + 1;
+    for (uint32_t t = 0; t < triCount; ++t)
+    {
+        uint32_t misses = 0;
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            const uint32_t v = indices[t * 3 + k];
+            if (time - timestamps[v] > kCacheSize)
+            {
+                timestamps[v] = time++;
+                ++misses;
+            }
+        }
+        if (t == 0 || misses == 3)
+            hard[hardCount++] = t;
+    }
+    hard[hardCount] = triCount;
+
+    span<uint32_t> clusterStarts = RegionAlloc::AllocArray<uint32_t>(scratch, triCount + 1);
+    uint32_t clusterCount = 0;
+
+    // Soft boundaries: split a hard cluster wherever the prefix since the last split is already within threshold
+    // of the whole cluster's ACMR, so drawing the pieces apart costs at most that much.
+    for (uint32_t h = 0; h < hardCount; ++h)
+    {
+        const uint32_t begin = hard[h];
+        const uint32_t end = hard[h + 1];
+
+        time += kCacheSize + 1;
+        uint32_t clusterMisses = 0;
+        for (uint32_t i = begin * 3; i < end * 3; ++i)
+        {
+            const uint32_t v = indices[i];
+            if (time - timestamps[v] > kCacheSize)
+            {
+                timestamps[v] = time++;
+                ++clusterMisses;
+            }
+        }
+        const float clusterAcmr = float(clusterMisses) / float(end - begin);
+
+        clusterStarts[clusterCount++] = begin;
+
+        time += kCacheSize + 1;
+        uint32_t misses = 0;
+        uint32_t splitAt = begin;
+        for (uint32_t t = begin; t < end; ++t)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t v = indices[t * 3 + k];
+                if (time - timestamps[v] > kCacheSize)
+                {
+                    timestamps[v] = time++;
+                    ++misses;
+                }
+            }
+
+            const uint32_t tris = t + 1 - splitAt;
+            if (t + 1 < end && float(misses) <= clusterAcmr * threshold * float(tris))
+            {
+                clusterStarts[clusterCount++] = t + 1;
+                splitAt = t + 1;
+                misses = 0;
+                time += kCacheSize + 1;
+            }
+        }
+    }
+    clusterStarts[clusterCount] = triCount;
+
+    if (clusterCount < 2)
+    {
+        RegionAlloc::Reset(scratch, allocMark);
+        return;
+    }
+
+    float3 meshCentroid{};
+    float meshArea = 0.f;
+    for (uint32_t t = 0; t < triCount; ++t)
+    {
+        const float3 &p0 = positions[indices[t * 3 + 0]];
+        const float3 &p1 = positions[indices[t * 3 + 1]];
+        const float3 &p2 = positions[indices[t * 3 + 2]];
+        const float area = Vec::Len(Vec::Cross(p1 - p0, p2 - p0));
+        meshCentroid += (p0 + p1 + p2) * (area / 3.f);
+        meshArea += area;
+    }
+    if (meshArea > 0.f)
+        meshCentroid /= meshArea;
+
+    span<cluster_key> keys = RegionAlloc::AllocArray<cluster_key>(scratch, clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c)
+    {
+        const uint32_t begin = clusterStarts[c];
+        const uint32_t end = clusterStarts[c + 1];
+
+        float3 centroid{};
+        float3 normal{};
+        float area = 0.f;
+        for (uint32_t t = begin; t < end; ++t)
+        {
+            const float3 &p0 = positions[indices[t * 3 + 0]];
+            const float3 &p1 = positions[indices[t * 3 + 1]];
+            const float3 &p2 = positions[indices[t * 3 + 2]];
+            const float3 n = Vec::Cross(p1 - p0, p2 - p0);
+            const float a = Vec::Len(n);
+            centroid += (p0 + p1 + p2) * (a / 3.f);
+            normal += n;
+            area += a;
+        }
+
+        if (area > 0.f)
+            centroid /= area;
+        const float normalLen = Vec::Len(normal);
+        if (normalLen > 0.f)
+            normal /= normalLen;
+
+        keys[c] = cluster_key{
+            .key = Vec::Dot(centroid - meshCentroid, normal),
+            .first = begin,
+            .count = end - begin,
+        };
+    }
+
+    // Insertion sort, descending. Stable, and cluster counts stay in the thousands at most.
+    for (uint32_t i = 1; i < clusterCount; ++i)
+    {
+        const cluster_key k = keys[i];
+        uint32_t j = i;
+        for (; j > 0 && keys[j - 1].key < k.key; --j)
+            keys[j] = keys[j - 1];
+        keys[j] = k;
+    }
+
+    span<uint32_t> result = RegionAlloc::AllocArray<uint32_t>(scratch, indices.size);
+    uint32_t at = 0;
+    for (const cluster_key &k : keys)
+    {
+        MemCpy(&result[at], &indices[k.first * 3], uint64_t{k.count} * 3 * sizeof(uint32_t));
+        at += k.count * 3;
+    }
+    MemCpy(indices.data, result.data, indices.size * sizeof(uint32_t));
+
+    RegionAlloc::Reset(scratch, allocMark);
+}
+
+auto API OptimizeVertexFetchRemap(span<uint32_t> remap, span<uint32_t> indices) -> uint32_t
+{
+    for (uint32_t &r : remap)
+        r = kUnusedVertex;
+
+    uint32_t next = 0;
+    for (uint32_t &index : indices)
+    {
+        ASSERT(index < remap.size);
+        if (remap[index] == kUnusedVertex)
+            remap[index] = next++;
+        index = remap[index];
+    }
+    return next;
+}
+
+auto API Simplify(span<uint32_t> dst, span<const uint32_t> indices, span<const float3> positions,
+                  uint32_t targetIndexCount, float maxError, float &outError, region_alloc &scratch) -> uint32_t
+{
+    ASSERT(dst.size >= indices.size);
+
+    outError = 0.f;
+    MemCpy(dst.data, indices.data, indices.size * sizeof(uint32_t));
+
+    uint32_t indexCount = uint32_t(indices.size);
+    if (indexCount <= targetIndexCount)
+        return indexCount;
+
+    auto allocMark = scratch.at;
+    const uint32_t vertexCount = uint32_t(positions.size);
+
+    span<quadric> quadrics = RegionAlloc::AllocArray<quadric>(scratch, vertexCount);
+    for (uint32_t i = 0; i < indexCount; i += 3)
+    {
+        const float3 &p0 = positions[dst[i + 0]];
+        const float3 &p1 = positions[dst[i + 1]];
+        const float3 &p2 = positions[dst[i + 2]];
+
+        float3 n = Vec::Cross(p1 - p0, p2 - p0);
+        const float len = Vec::Len(n);
+        if (len == 0.f)
+            continue;
+        n /= len;
+
+        const quadric q = QuadricFromPlane(n, -Vec::Dot(n, p0), len * .5f);
+        for (uint32_t k = 0; k < 3; ++k)
+            QuadricAdd(quadrics[dst[i + k]], q);
+    }
+
+    // A directed edge without its twin is on a border (or a seam, which splits the vertices).
+    uint64_t tableSize = 16;
+    while (tableSize < uint64_t{indexCount} * 2)
+        tableSize *= 2;
+    span<uint64_t> edges = RegionAlloc::AllocArray<uint64_t>(scratch, tableSize);
+    MemSet(edges.data, 0xFF, edges.size * sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < indexCount; ++i)
+        EdgeInsert(edges, EdgeKey(dst[i], dst[i - i % 3 + (i + 1) % 3]));
+
+    span<uint8_t> locked = RegionAlloc::AllocArray<uint8_t>(scratch, vertexCount);
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        const uint32_t a = dst[i];
+        const uint32_t b = dst[i - i % 3 + (i + 1) % 3];
+        if (!EdgeContains(edges, EdgeKey(b, a)))
+        {
+            locked[a] = 1;
+            locked[b] = 1;
+        }
+    }
+
+    span<uint32_t> remap = RegionAlloc::AllocArray<uint32_t>(scratch, vertexCount);
+    span<uint8_t> touched = RegionAlloc::AllocArray<uint8_t>(scratch, vertexCount);
+    span<uint32_t> adjOffset = RegionAlloc::AllocArray<uint32_t>(scratch, vertexCount + 1);
+    span<uint32_t> adjTris = RegionAlloc::AllocArray<uint32_t>(scratch, indexCount);
+
+    // Every corner gives both directions of its outgoing edge, interior edges end up listed twice each way.
+    span<uint32_t> candFrom = RegionAlloc::AllocArray<uint32_t>(scratch, uint64_t{indexCount} * 2);
+    span<uint32_t> candTo = RegionAlloc::AllocArray<uint32_t>(scratch, uint64_t{indexCount} * 2);
+    span<uint32_t> candCost = RegionAlloc::AllocArray<uint32_t>(scratch, uint64_t{indexCount} * 2);
+    span<uint32_t> order = RegionAlloc::AllocArray<uint32_t>(scratch, uint64_t{indexCount} * 2);
+
+    const double maxErrorSq = double(maxError) * double(maxError);
+    double worstSq = 0.0;
+
+    while (indexCount > targetIndexCount)
+    {
+        MemZero(adjOffset.data, adjOffset.size * sizeof(uint32_t));
+        for (uint32_t i = 0; i < indexCount; ++i)
+            ++adjOffset[dst[i] + 1];
+        for (uint32_t v = 0; v < vertexCount; ++v)
+            adjOffset[v + 1] += adjOffset[v];
+        for (uint32_t i = 0; i < indexCount; ++i)
+            adjTris[adjOffset[dst[i]]++] = i / 3;
+        for (uint32_t v = vertexCount; v > 0; --v)
+            adjOffset[v] = adjOffset[v - 1];
+        adjOffset[0] = 0;
+
+        uint32_t candidateCount = 0;
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            const uint32_t a = dst[i];
+            const uint32_t b = dst[i - i % 3 + (i + 1) % 3];
+
+            for (uint32_t dir = 0; dir < 2; ++dir)
+            {
+                const uint32_t from = dir ? b : a;
+                const uint32_t to = dir ? a : b;
+                if (locked[from])
+                    continue;
+
+                quadric q = quadrics[from];
+                QuadricAdd(q, quadrics[to]);
+                const double cost = QuadricError(q, positions[to]);
+                if (cost > maxErrorSq)
+                    continue;
+
+                const float costF = float(cost);
+                uint32_t costBits;
+                MemCpy(&costBits, &costF, sizeof(costBits));
+
+                candFrom[candidateCount] = from;
+                candTo[candidateCount] = to;
+                candCost[candidateCount] = costBits;
+                order[candidateCount] = candidateCount;
+                ++candidateCount;
+            }
+        }
+        if (!candidateCount)
+            break;
+
+        RadixSort(span<uint32_t>{order.data, candidateCount}, candCost, scratch);
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+            remap[v] = v;
+        MemZero(touched.data, touched.size);
+
+        // Collapses within a pass must not share a one-ring, otherwise the flip test below would be stale.
+        const uint32_t needed = indexCount - targetIndexCount;
+        uint32_t removed = 0;
+        uint32_t collapses = 0;
+
+        for (uint32_t c = 0; c < candidateCount && removed < needed; ++c)
+        {
+            const uint32_t cand = order[c];
+            const uint32_t from = candFrom[cand];
+            const uint32_t to = candTo[cand];
+            if (touched[from] || touched[to])
+                continue;
+
+            const float3 &pFrom = positions[from];
+            const float3 &pTo = positions[to];
+
+            bool flips = false;
+            for (uint32_t j = adjOffset[from]; j < adjOffset[from + 1] && !flips; ++j)
+            {
+                const uint32_t t = adjTris[j];
+                const uint32_t *tri = &dst[t * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to)
+                    continue;
+
+                // Rotate so that `from` comes first, winding preserved.
+                const uint32_t k = tri[0] == from ? 0 : tri[1] == from ? 1 : 2;
+                const float3 &p1 = positions[tri[(k + 1) % 3]];
+                const float3 &p2 = positions[tri[(k + 2) % 3]];
+
+                // Rejects normals turning by more than ~75 degrees, not just full flips, slivers fold otherwise.
+                const float3 before = Vec::Cross(p1 - pFrom, p2 - pFrom);
+                const float3 after = Vec::Cross(p1 - pTo, p2 - pTo);
+                flips = Vec::Dot(before, after) <= .25f * Vec::Len(before) * Vec::Len(after);
+            }
+            if (flips)
+                continue;
+
+            remap[from] = to;
+            QuadricAdd(quadrics[to], quadrics[from]);
+
+            uint32_t costBits = candCost[cand];
+            float cost;
+            MemCpy(&cost, &costBits, sizeof(cost));
+            worstSq = Max(worstSq, double(cost));
+
+            for (uint32_t j = adjOffset[from]; j < adjOffset[from + 1]; ++j)
+            {
+                const uint32_t t = adjTris[j];
+                touched[dst[t * 3 + 0]] = 1;
+                touched[dst[t * 3 + 1]] = 1;
+                touched[dst[t * 3 + 2]] = 1;
+            }
+            touched[to] = 1;
+
+            // An interior edge collapse removes the two triangles sharing it.
+            removed += 6;
+            ++collapses;
+        }
+
+        if (!collapses)
+            break;
+
+        uint32_t write = 0;
+        for (uint32_t i = 0; i < indexCount; i += 3)
+        {
+            const uint32_t a = remap[dst[i + 0]];
+            const uint32_t b = remap[dst[i + 1]];
+            const uint32_t c = remap[dst[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+
+            dst[write++] = a;
+            dst[write++] = b;
+            dst[write++] = c;
+        }
+        indexCount = write;
+    }
+
+    outError = float(Sqrt(float(worstSq)));
+    RegionAlloc::Reset(scratch, allocMark);
+    return indexCount;
+}
+
+auto API QuantizeHalf(float value) -> uint16_t
+{
+    uint32_t bits;
+    MemCpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t em = bits & 0x7FFFFFFF;
+
+    // Rebias the exponent (127 - 15 = 112) and round to nearest.
+    uint32_t half = (em - (112u << 23) + (1u << 12)) >> 13;
+    if (em < (113u << 23)) // below the smallest normal half, flush to zero
+        half = 0;
+    if (em >= (143u << 23)) // overflow
+        half = 0x7C00;
+    if (em > (255u << 23)) // nan
+        half = 0x7E00;
+    return uint16_t(sign | half);
+}
+
+auto API QuantizeSnorm16(float value) -> int16_t
+{
+    value = Clamp(value, -1.f, 1.f) * 32767.f;
+    return int16_t(value >= 0.f ? value + .5f : value - .5f);
+}
+
+auto API EncodeOctahedral(float3 n) -> float2
+{
+    const float l1 = AbsF(n[0]) + AbsF(n[1]) + AbsF(n[2]);
+    if (l1 == 0.f)
+        return float2{0.f, 0.f};
+
+    float2 e{n[0] / l1, n[1] / l1};
+    if (n[2] < 0.f)
+    {
+        const float x = e[0];
+        const float y = e[1];
+        e[0] = (1.f - AbsF(y)) * (x >= 0.f ? 1.f : -1.f);
+        e[1] = (1.f - AbsF(x)) * (y >= 0.f ? 1.f : -1.f);
+    }
+    return e;
+}
+
+} // namespace MeshOptimize
+
+} // namespace nyla
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/region_alloc_def.h"
+#include "nyla/commons/span_def.h"
+#include "nyla/commons/vec.h"
+
+namespace nyla
+{
+
+namespace MeshOptimize
+{
+
+constexpr inline uint32_t kUnusedVertex = 0xFFFFFFFF;
+
+// Average cache miss ratio: transformed vertices per triangle through a FIFO post-transform cache. 0.5 is the
+// theoretical floor for large regular meshes, 3 is no reuse at all.
+auto API SimulateAcmr(span<const uint32_t> indices, uint32_t vertexCount, region_alloc &scratch,
+                      uint32_t cacheSize = 16) -> float;
+
+// Reorders triangles for the post-transform cache (Forsyth, linear speed). Indices are local, < vertexCount.
+void API OptimizeVertexCache(span<uint32_t> indices, uint32_t vertexCount, region_alloc &scratch);
+
+// Splits a cache optimized index stream into clusters at cache flushes and wherever the running ACMR is still
+// within threshold of the cluster's, then sorts the clusters outward facing first so they occlude the rest.
+// threshold 1.05 trades up to 5% ACMR for the ordering.
+void API OptimizeOverdraw(span<uint32_t> indices, span<const float3> positions, float threshold,
+                          region_alloc &scratch);
+
+// Numbers vertices in order of first use and rewrites indices accordingly. remap[old] is the new index or
+// kUnusedVertex. Returns the number of vertices still referenced.
+auto API OptimizeVertexFetchRemap(span<uint32_t> remap, span<uint32_t> indices) -> uint32_t;
+
+// Edge collapse simplification driven by quadric error (Garland-Heckbert). Vertices only collapse onto other
+// existing vertices, so the result indexes the same vertex buffer. Border vertices, which includes both sides of
+// uv seams, never move. Stops at targetIndexCount or when the next collapse would exceed maxError (a distance).
+// dst needs indices.size room; returns the index count and the largest error accepted in outError.
+auto API Simplify(span<uint32_t> dst, span<const uint32_t> indices, span<const float3> positions,
+                  uint32_t targetIndexCount, float maxError, float &outError, region_alloc &scratch) -> uint32_t;
+
+auto API QuantizeHalf(float value) -> uint16_t;
+auto API QuantizeSnorm16(float value) -> int16_t;
+
+// Unit vector to the [-1, 1]^2 octahedral map.
+auto API EncodeOctahedral(float3 n) -> float2;
+
+} // namespace MeshOptimize
+
+} // namespace nyla
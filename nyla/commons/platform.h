@@ -59,10 +59,15 @@ struct PlatformEvent
             uint32_t code;
         } mouse;
     };
+    uint64_t timeNs; // when the input happened on the GetMonotonicTimeNanos clock, set for keys and buttons
 };
 
 auto API GenRandom64() -> uint64_t;
 void API Sleep(uint64_t millis);
+// Logical processors available to the process.
+auto API GetProcessorCount() -> uint32_t;
+// Full path of the running executable, null terminated.
+auto API GetExecutablePath(region_alloc &alloc) -> byteview;
 auto API Spawn(span<const char *const> cmd) -> bool;
 auto API RunSync(span<const char *const> cmd, region_alloc &alloc, byteview &outLog) -> int32_t;
 void API WinOpen();
@@ -16,6 +16,22 @@ struct PlatformAudioInitDesc
     uint32_t latencyUs;
     PlatformAudioCallback callback;
     void *user;
+    const char *device;  // null for the default output. On Linux any ALSA pcm, such as "null" for tests
+    bool copy;           // Linux: mix into a scratch buffer and copy it out, rather than into the device buffer
+    bool normalPriority; // keep the feeder off real time priority, for devices that never block such as "null"
+};
+
+// Since Init. Still readable after Destroy, frozen at that point.
+struct platform_audio_stats
+{
+    uint32_t bufferFrames; // the latency the device granted
+    uint32_t periodFrames; // frames between wakeups of the feeder
+    uint64_t underruns;
+    uint64_t frames;      // handed to the device
+    uint64_t feederCpuNs; // CPU time of the feeder thread, including the callback
+    uint64_t elapsedNs;
+    bool zeroCopy; // the callback writes straight into the device buffer
+    bool realtime; // the feeder runs at real time priority
 };
 
 namespace PlatformAudio
@@ -25,6 +41,8 @@ void API Init(const PlatformAudioInitDesc &desc);
 void API Destroy();
 auto API GetSampleRate() -> uint32_t;
 auto API GetChannels() -> uint32_t;
+auto API GetUnderruns() -> uint64_t;
+auto API GetStats() -> platform_audio_stats;
 
 } // namespace PlatformAudio
 
@@ -3,11 +3,21 @@
 #include "nyla/commons/fmt.h"
 #include "nyla/commons/intrin.h"
 #include "nyla/commons/macros.h"
+#include "nyla/commons/minmax.h"
 #include "nyla/commons/platform_thread.h"
+#include "nyla/commons/profiler.h"
 #include "nyla/commons/region_alloc.h"
+#include "nyla/commons/time.h"
 
 #include <alsa/asoundlib.h>
 #include <cstdint>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
 
 namespace nyla
 {
@@ -18,6 +28,12 @@ namespace
 constexpr uint32_t kMaxFramesPerWrite = 512;
 constexpr uint32_t kMaxChannels = 8;
 
+// Low among real time threads, the sound server and the kernel's interrupt threads should still win. RTKit caps
+// what it grants at 20 by default.
+constexpr int kRealtimePriority = 10;
+// RTKit only promotes threads of processes that bound their real time CPU use, past this the kernel sends SIGXCPU.
+constexpr rlim_t kRealtimeBudgetUs = 200'000;
+
 struct platform_audio
 {
     snd_pcm_t *pcm;
@@ -25,21 +41,180 @@ struct platform_audio
     void *user;
     uint32_t sampleRate;
     uint32_t channels;
+    uint32_t bufferFrames;
+    uint32_t periodFrames;
+    bool zeroCopy;
+    bool normalPriority;
+    bool realtime;
     platform_thread *thread;
     uint32_t running;
+    uint64_t underruns;
+    uint64_t frames;
+    uint64_t feederCpuNs;
+    uint64_t startNs;
+    uint64_t stopNs;
     int16_t scratch[kMaxFramesPerWrite * kMaxChannels];
 };
 platform_audio *audio;
 
-void FeederMain(void *)
+// -EPIPE is an underrun, the device played everything it had before the next write arrived.
+auto Recover(int err) -> bool
+{
+    if (err == -EPIPE)
+        AtomicFetchAdd64(&audio->underruns, 1);
+    return snd_pcm_recover(audio->pcm, err, 1) >= 0;
+}
+
+auto ThreadCpuNs() -> uint64_t
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1'000'000'000 + (uint64_t)ts.tv_nsec;
+}
+
+// Desktop sessions rarely get RLIMIT_RTPRIO, RTKit hands out SCHED_FIFO over the system bus instead. libdbus is
+// loaded when needed so that it does not become a link dependency.
+auto MakeRealtimeWithRtkit() -> bool
+{
+    void *lib = dlopen("libdbus-1.so.3", RTLD_NOW | RTLD_LOCAL);
+    if (!lib)
+        return false;
+
+    using bus_get_fn = void *(*)(int type, void *error);
+    using new_method_call_fn = void *(*)(const char *dest, const char *path, const char *iface, const char *method);
+    using append_args_fn = uint32_t (*)(void *msg, int firstType, ...);
+    using send_fn = void *(*)(void *conn, void *msg, int timeoutMs, void *error);
+    using unref_fn = void (*)(void *msg);
+    const auto busGet = (bus_get_fn)dlsym(lib, "dbus_bus_get");
+    const auto newMethodCall = (new_method_call_fn)dlsym(lib, "dbus_message_new_method_call");
+    const auto appendArgs = (append_args_fn)dlsym(lib, "dbus_message_append_args");
+    const auto send = (send_fn)dlsym(lib, "dbus_connection_send_with_reply_and_block");
+    const auto unref = (unref_fn)dlsym(lib, "dbus_message_unref");
+    if (!busGet || !newMethodCall || !appendArgs || !send || !unref)
+        return false;
+
+    rlimit limit;
+    getrlimit(RLIMIT_RTTIME, &limit);
+    limit.rlim_max = Min(limit.rlim_max, kRealtimeBudgetUs);
+    limit.rlim_cur = limit.rlim_max;
+    if (setrlimit(RLIMIT_RTTIME, &limit) != 0)
+        return false;
+
+    constexpr int kBusSystem = 1;
+    constexpr int kTypeInvalid = 0;
+    constexpr int kTypeUint32 = 'u';
+    constexpr int kTypeUint64 = 't';
+
+    void *bus = busGet(kBusSystem, nullptr);
+    if (!bus)
+        return false;
+
+    void *msg = newMethodCall("org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1",
+                              "org.freedesktop.RealtimeKit1", "MakeThreadRealtime");
+    if (!msg)
+        return false;
+
+    uint64_t tid = (uint64_t)syscall(SYS_gettid);
+    uint32_t priority = kRealtimePriority;
+    void *reply = nullptr;
+    if (appendArgs(msg, kTypeUint64, &tid, kTypeUint32, &priority, kTypeInvalid))
+        reply = send(bus, msg, 1000, nullptr);
+    unref(msg);
+    if (!reply)
+        return false;
+
+    unref(reply);
+    return true;
+}
+
+void RaisePriority()
+{
+    if (audio->normalPriority)
+        return;
+
+    const sched_param param{.sched_priority = kRealtimePriority};
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 || MakeRealtimeWithRtkit())
+    {
+        audio->realtime = true;
+        return;
+    }
+    LOG("audio: no real time priority for the feeder, neither SCHED_FIFO nor RTKit");
+}
+
+// The callback mixes straight into the device buffer. A wakeup per period, snd_pcm_set_params makes the period the
+// avail_min that snd_pcm_wait waits for.
+void FeedMmap()
 {
     while (AtomicLoad32(&audio->running))
     {
-        snd_pcm_sframes_t avail = snd_pcm_avail(audio->pcm);
+        AtomicStore64(&audio->feederCpuNs, ThreadCpuNs());
+
+        const snd_pcm_sframes_t avail = snd_pcm_avail_update(audio->pcm);
         if (avail < 0)
         {
-            int rc = snd_pcm_recover(audio->pcm, (int)avail, 1);
+            if (!Recover((int)avail))
+                return;
+            continue;
+        }
+
+        if ((uint32_t)avail < audio->periodFrames)
+        {
+            const int rc = snd_pcm_wait(audio->pcm, 100);
+            if (rc < 0 && !Recover(rc))
+                return;
+            continue;
+        }
+
+        PROFILE_SCOPE("audio mix");
+        for (snd_pcm_uframes_t left = (snd_pcm_uframes_t)avail; left > 0;)
+        {
+            const snd_pcm_channel_area_t *areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t frames = left;
+            int rc = snd_pcm_mmap_begin(audio->pcm, &areas, &offset, &frames);
             if (rc < 0)
+            {
+                if (!Recover(rc))
+                    return;
+                break;
+            }
+            DASSERT(areas[0].first == 0 && areas[0].step == audio->channels * 16);
+
+            auto *out = (int16_t *)((uint8_t *)areas[0].addr + offset * audio->channels * sizeof(int16_t));
+            audio->callback(audio->user, out, (uint32_t)frames);
+
+            const snd_pcm_sframes_t committed = snd_pcm_mmap_commit(audio->pcm, offset, frames);
+            if (committed < 0 || (snd_pcm_uframes_t)committed != frames)
+            {
+                if (!Recover(committed < 0 ? (int)committed : -EPIPE))
+                    return;
+                break;
+            }
+            left -= frames;
+            AtomicStore64(&audio->frames, audio->frames + frames);
+        }
+
+        // Nothing starts an mmap stream by itself, both at first and after recovering from an underrun.
+        if (snd_pcm_state(audio->pcm) == SND_PCM_STATE_PREPARED)
+        {
+            const int rc = snd_pcm_start(audio->pcm);
+            if (rc < 0 && !Recover(rc))
+                return;
+        }
+    }
+}
+
+// Mixes into scratch and copies it to the device, for devices without mmap support.
+void FeedCopy()
+{
+    while (AtomicLoad32(&audio->running))
+    {
+        AtomicStore64(&audio->feederCpuNs, ThreadCpuNs());
+
+        snd_pcm_sframes_t avail = snd_pcm_avail(audio->pcm);
+        if (avail < 0)
+        {
+            if (!Recover((int)avail))
                 break;
             continue;
         }
@@ -49,7 +224,7 @@ void FeederMain(void *)
             int rc = snd_pcm_wait(audio->pcm, 100);
             if (rc < 0)
             {
-                if (snd_pcm_recover(audio->pcm, rc, 1) < 0)
+                if (!Recover(rc))
                     break;
             }
             continue;
@@ -59,7 +234,10 @@ void FeederMain(void *)
         if (want > kMaxFramesPerWrite)
             want = kMaxFramesPerWrite;
 
-        audio->callback(audio->user, audio->scratch, want);
+        {
+            PROFILE_SCOPE("audio mix");
+            audio->callback(audio->user, audio->scratch, want);
+        }
 
         const uint8_t *p = (const uint8_t *)audio->scratch;
         uint32_t framesLeft = want;
@@ -70,16 +248,30 @@ void FeederMain(void *)
             snd_pcm_sframes_t written = snd_pcm_writei(audio->pcm, p, framesLeft);
             if (written < 0)
             {
-                if (snd_pcm_recover(audio->pcm, (int)written, 1) < 0)
+                if (!Recover((int)written))
                     return;
                 break;
             }
             framesLeft -= (uint32_t)written;
             p += (size_t)written * frameSize;
+            AtomicStore64(&audio->frames, audio->frames + (uint64_t)written);
         }
     }
 }
 
+void FeederMain(void *)
+{
+    Profiler::SetThreadName("nyla-audio"_s);
+    RaisePriority();
+
+    if (audio->zeroCopy)
+        FeedMmap();
+    else
+        FeedCopy();
+
+    AtomicStore64(&audio->feederCpuNs, ThreadCpuNs());
+}
+
 } // namespace
 
 namespace PlatformAudio
@@ -87,31 +279,55 @@ namespace PlatformAudio
 
 void API Init(const PlatformAudioInitDesc &desc)
 {
-    ASSERT(!audio);
+    ASSERT(!audio || !audio->pcm);
     ASSERT(desc.channels <= kMaxChannels);
     ASSERT(desc.callback);
 
-    audio = &RegionAlloc::Alloc<platform_audio>(RegionAlloc::g_BootstrapAlloc);
+    // Reused after Destroy, so that a tool can compare configurations one after the other.
+    if (!audio)
+        audio = &RegionAlloc::Alloc<platform_audio>(RegionAlloc::g_BootstrapAlloc);
+    *audio = platform_audio{};
     audio->callback = desc.callback;
     audio->user = desc.user;
     audio->sampleRate = desc.sampleRate;
     audio->channels = desc.channels;
+    audio->normalPriority = desc.normalPriority;
 
-    int res = snd_pcm_open(&audio->pcm, "default", SND_PCM_STREAM_PLAYBACK, 0);
+    const char *device = desc.device ? desc.device : "default";
+    int res = snd_pcm_open(&audio->pcm, device, SND_PCM_STREAM_PLAYBACK, 0);
     if (res != 0)
     {
-        LOG("snd_pcm_open: %s", snd_strerror(res));
+        LOG("snd_pcm_open %s: %s", device, snd_strerror(res));
         ASSERT(false);
     }
 
-    res = snd_pcm_set_params(audio->pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, desc.channels,
-                             desc.sampleRate, 1, desc.latencyUs);
-    if (res != 0)
+    res = -1;
+    if (!desc.copy)
     {
-        LOG("snd_pcm_set_params: %s", snd_strerror(res));
-        ASSERT(false);
+        res = snd_pcm_set_params(audio->pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_MMAP_INTERLEAVED, desc.channels,
+                                 desc.sampleRate, 1, desc.latencyUs);
+        if (res != 0)
+            LOG("audio: %s has no mmap access (%s), copying instead", device, snd_strerror(res));
     }
+    audio->zeroCopy = res == 0;
+    if (!audio->zeroCopy)
+    {
+        res = snd_pcm_set_params(audio->pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, desc.channels,
+                                 desc.sampleRate, 1, desc.latencyUs);
+        if (res != 0)
+        {
+            LOG("snd_pcm_set_params: %s", snd_strerror(res));
+            ASSERT(false);
+        }
+    }
+
+    snd_pcm_uframes_t bufferFrames;
+    snd_pcm_uframes_t periodFrames;
+    ASSERT(snd_pcm_get_params(audio->pcm, &bufferFrames, &periodFrames) == 0);
+    audio->bufferFrames = (uint32_t)bufferFrames;
+    audio->periodFrames = (uint32_t)periodFrames;
 
+    audio->startNs = GetMonotonicTimeNanos();
     AtomicStore32(&audio->running, 1);
     audio->thread = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &FeederMain, nullptr);
     PlatformThread::SetName(*audio->thread, "nyla-audio");
@@ -128,7 +344,11 @@ void API Destroy()
         snd_pcm_drop(audio->pcm);
 
     if (audio->thread)
+    {
         PlatformThread::Join(*audio->thread);
+        audio->thread = nullptr;
+    }
+    audio->stopNs = GetMonotonicTimeNanos();
 
     if (audio->pcm)
     {
@@ -147,6 +367,25 @@ auto API GetChannels() -> uint32_t
     return audio->channels;
 }
 
+auto API GetUnderruns() -> uint64_t
+{
+    return AtomicLoad64(&audio->underruns);
+}
+
+auto API GetStats() -> platform_audio_stats
+{
+    return platform_audio_stats{
+        .bufferFrames = audio->bufferFrames,
+        .periodFrames = audio->periodFrames,
+        .underruns = AtomicLoad64(&audio->underruns),
+        .frames = AtomicLoad64(&audio->frames),
+        .feederCpuNs = AtomicLoad64(&audio->feederCpuNs),
+        .elapsedNs = (audio->stopNs ? audio->stopNs : GetMonotonicTimeNanos()) - audio->startNs,
+        .zeroCopy = audio->zeroCopy,
+        .realtime = audio->realtime,
+    };
+}
+
 } // namespace PlatformAudio
 
 } // namespace nyla
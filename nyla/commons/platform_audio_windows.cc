@@ -5,7 +5,9 @@
 #include "nyla/commons/intrin.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/platform_thread.h"
+#include "nyla/commons/profiler.h"
 #include "nyla/commons/region_alloc.h"
+#include "nyla/commons/time.h"
 
 #include <cstdint>
 
@@ -32,15 +34,35 @@ struct platform_audio
     uint32_t sampleRate;
     uint32_t channels;
     UINT32 bufferFrames;
+    UINT32 periodFrames;
     platform_thread *thread;
     uint32_t running;
+    bool primed;
+    uint64_t underruns;
+    uint64_t frames;
+    uint64_t feederCpuNs;
+    uint64_t startNs;
+    uint64_t stopNs;
 };
 platform_audio *audio;
 
+auto ThreadCpuNs() -> uint64_t
+{
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    const uint64_t k = (uint64_t)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime;
+    const uint64_t u = (uint64_t)user.dwHighDateTime << 32 | user.dwLowDateTime;
+    return (k + u) * 100;
+}
+
 void FeederMain(void *)
 {
+    Profiler::SetThreadName("nyla-audio"_s);
+
     while (AtomicLoad32(&audio->running))
     {
+        AtomicStore64(&audio->feederCpuNs, ThreadCpuNs());
+
         DWORD wait = WaitForSingleObject(audio->event, 200);
         if (!AtomicLoad32(&audio->running))
             break;
@@ -51,6 +73,10 @@ void FeederMain(void *)
         if (FAILED(audio->client->GetCurrentPadding(&padding)))
             continue;
 
+        // Nothing queued once the first buffer went out means the device ran dry.
+        if (padding == 0 && audio->primed)
+            AtomicFetchAdd64(&audio->underruns, 1);
+
         UINT32 avail = audio->bufferFrames - padding;
         if (avail == 0)
             continue;
@@ -59,10 +85,17 @@ void FeederMain(void *)
         if (FAILED(audio->render->GetBuffer(avail, &buf)))
             continue;
 
-        audio->callback(audio->user, (int16_t *)buf, avail);
+        {
+            PROFILE_SCOPE("audio mix");
+            audio->callback(audio->user, (int16_t *)buf, avail);
+        }
 
         audio->render->ReleaseBuffer(avail, 0);
+        audio->primed = true;
+        AtomicStore64(&audio->frames, audio->frames + avail);
     }
+
+    AtomicStore64(&audio->feederCpuNs, ThreadCpuNs());
 }
 
 } // namespace
@@ -117,6 +150,11 @@ void API Init(const PlatformAudioInitDesc &desc)
     hr = audio->client->GetBufferSize(&audio->bufferFrames);
     ASSERT(SUCCEEDED(hr));
 
+    REFERENCE_TIME period;
+    hr = audio->client->GetDevicePeriod(&period, nullptr);
+    ASSERT(SUCCEEDED(hr));
+    audio->periodFrames = (UINT32)(period * desc.sampleRate / 10'000'000);
+
     audio->event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
     ASSERT(audio->event);
 
@@ -131,6 +169,7 @@ void API Init(const PlatformAudioInitDesc &desc)
     hr = audio->client->Start();
     ASSERT(SUCCEEDED(hr));
 
+    audio->startNs = GetMonotonicTimeNanos();
     audio->thread = PlatformThread::Create(RegionAlloc::g_BootstrapAlloc, &FeederMain, nullptr);
     PlatformThread::SetName(*audio->thread, "nyla-audio");
 }
@@ -146,6 +185,7 @@ void API Destroy()
 
     if (audio->thread)
         PlatformThread::Join(*audio->thread);
+    audio->stopNs = GetMonotonicTimeNanos();
 
     if (audio->client)
         audio->client->Stop();
@@ -172,6 +212,25 @@ auto API GetChannels() -> uint32_t
     return audio->channels;
 }
 
+auto API GetUnderruns() -> uint64_t
+{
+    return AtomicLoad64(&audio->underruns);
+}
+
+auto API GetStats() -> platform_audio_stats
+{
+    return platform_audio_stats{
+        .bufferFrames = audio->bufferFrames,
+        .periodFrames = audio->periodFrames,
+        .underruns = AtomicLoad64(&audio->underruns),
+        .frames = AtomicLoad64(&audio->frames),
+        .feederCpuNs = AtomicLoad64(&audio->feederCpuNs),
+        .elapsedNs = (audio->stopNs ? audio->stopNs : GetMonotonicTimeNanos()) - audio->startNs,
+        .zeroCopy = true,
+        .realtime = false,
+    };
+}
+
 } // namespace PlatformAudio
 
 } // namespace nyla
\ No newline at end of file
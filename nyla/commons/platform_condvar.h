@@ -16,6 +16,7 @@ auto API Create(region_alloc &alloc) -> platform_condvar *;
 void API Destroy(platform_condvar &self);
 void API Wait(platform_condvar &self, platform_mutex &mutex);
 void API Signal(platform_condvar &self);
+void API Broadcast(platform_condvar &self);
 
 } // namespace PlatformCondvar
 
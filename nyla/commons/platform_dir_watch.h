@@ -21,8 +21,10 @@ enum class platform_dir_watch_event_type : uint8_t
 };
 NYLA_BITENUM(platform_dir_watch_event_type);
 
+// dir is the watched path followed by the subdirectories the file is in, separated by '/'.
 struct platform_dir_watch_event
 {
+    byteview dir;
     byteview name;
     platform_dir_watch_event_type mask;
 };
@@ -30,8 +32,17 @@ struct platform_dir_watch_event
 namespace PlatformDirWatch
 {
 
-auto API Create(region_alloc &alloc, byteview path) -> platform_dir_watch *;
+auto API Create(region_alloc &alloc) -> platform_dir_watch *;
 void API Destroy(platform_dir_watch &self);
+
+// Watches path and every directory below it. Directories created or moved in later are followed, and files already
+// in them are reported as MovedTo. Hidden directories are skipped.
+auto API Add(platform_dir_watch &self, byteview path) -> bool;
+
+// Whether Poll may return something. Never calls into the OS, so checking an idle watch costs nothing.
+auto API HasEvents(platform_dir_watch &self) -> bool;
+
+// The event's views stay valid until the next call.
 auto API Poll(platform_dir_watch &self, platform_dir_watch_event &out) -> bool;
 
 } // namespace PlatformDirWatch
@@ -1,12 +1,22 @@
 #include "nyla/commons/platform_dir_watch.h"
 
 #include <cstdint>
+#include <dirent.h>
+#include <fcntl.h>
 #include <linux/limits.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/inotify.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
-#include "nyla/commons/array_def.h"
+#include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/binary_search.h"
 #include "nyla/commons/fmt.h"
+#include "nyla/commons/inline_vec.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/platform_thread.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/span.h"
 
@@ -16,13 +26,47 @@ namespace nyla
 namespace
 {
 
-constexpr uint32_t kBufSize = sizeof(inotify_event) + NAME_MAX + 1;
+constexpr uint32_t kMaxDirs = 2048;
+constexpr uint32_t kMaxPath = 0x200;
+constexpr uint32_t kMaxNewFiles = 256;
+
+// Big enough that a save storm drains in a few reads rather than one per event.
+constexpr uint32_t kBufSize = 64 * 1024;
+
+constexpr uint32_t kDirMask =
+    IN_MODIFY | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+struct watched_dir
+{
+    int wd;
+    bool live; // false once the kernel dropped the watch, the slot goes on the next compaction
+    inline_vec<uint8_t, kMaxPath> path;
+};
+
+// Files found in a directory that appeared after its parent was watched. They may have been written before the
+// new directory had a watch of its own, so they are reported once.
+struct new_file
+{
+    int wd;
+    inline_vec<uint8_t, NAME_MAX + 1> name;
+};
 
 } // namespace
 
 struct platform_dir_watch
 {
     int fd;
+    int epoll;
+    int quit;
+    uint32_t ready; // set by the thread when fd turns readable, cleared by Poll once it is drained
+    platform_thread *thread;
+
+    uint32_t dirCount;
+    array<watched_dir, kMaxDirs> dirs; // sorted by wd
+
+    inline_vec<new_file, kMaxNewFiles> newFiles;
+    uint32_t newFilesPos;
+
     uint32_t bufPos;
     uint32_t bufLen;
     alignas(inotify_event) array<uint8_t, kBufSize> buf;
@@ -31,37 +75,263 @@ struct platform_dir_watch
 namespace PlatformDirWatch
 {
 
-auto API Create(region_alloc &alloc, byteview path) -> platform_dir_watch *
+namespace
+{
+
+// The thread only turns readiness into a flag: the inotify fd is armed one shot, so it sleeps until Poll has
+// drained the fd and armed it again.
+void WatchThread(void *user)
+{
+    auto &self = *static_cast<platform_dir_watch *>(user);
+    for (;;)
+    {
+        epoll_event event;
+        if (epoll_wait(self.epoll, &event, 1, -1) != 1)
+            continue;
+        if (event.data.fd == self.quit)
+            return;
+        AtomicStore32(&self.ready, 1);
+    }
+}
+
+void Arm(platform_dir_watch &self, int op)
+{
+    epoll_event event{.events = EPOLLIN | EPOLLONESHOT, .data = {.fd = self.fd}};
+    ASSERT(epoll_ctl(self.epoll, op, self.fd, &event) == 0);
+}
+
+auto Dirs(platform_dir_watch &self) -> span<watched_dir>
+{
+    return span<watched_dir>{self.dirs.data, self.dirCount};
+}
+
+auto FindDir(platform_dir_watch &self, int wd) -> watched_dir *
+{
+    watched_dir *dir = BinarySearch::Find(Dirs(self), wd, [](const watched_dir &d) { return d.wd; });
+    return dir && dir->live ? dir : nullptr;
+}
+
+void Compact(platform_dir_watch &self)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < self.dirCount; ++i)
+    {
+        if (!self.dirs[i].live)
+            continue;
+        if (kept != i)
+            self.dirs[kept] = self.dirs[i];
+        ++kept;
+    }
+    self.dirCount = kept;
+}
+
+auto DirView(const watched_dir &dir) -> byteview
+{
+    return byteview{dir.path.data.data, dir.path.size};
+}
+
+auto IsHidden(byteview name) -> bool
+{
+    return name.size && name[0] == '.';
+}
+
+auto IsDir(DIR *dir, const dirent &entry) -> bool
+{
+    if (entry.d_type != DT_UNKNOWN)
+        return entry.d_type == DT_DIR;
+
+    struct stat st;
+    return fstatat(dirfd(dir), entry.d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+}
+
+auto JoinPath(inline_vec<uint8_t, kMaxPath> &out, byteview dir, byteview name) -> bool
+{
+    if (dir.size + 1 + name.size + 1 >= kMaxPath)
+        return false;
+
+    InlineVec::Clear(out);
+    InlineVec::Append(out, dir);
+    InlineVec::Append(out, (uint8_t)'/');
+    InlineVec::Append(out, name);
+    return true;
+}
+
+auto AddDir(platform_dir_watch &self, byteview path, bool reportFiles) -> bool
+{
+    if (path.size + 1 >= kMaxPath)
+    {
+        LOG("platform_dir_watch: path too long " SV_FMT, SV_ARG(path));
+        return false;
+    }
+
+    inline_vec<uint8_t, kMaxPath> cpath{};
+    InlineVec::Append(cpath, path);
+    InlineVec::Append(cpath, (uint8_t)0);
+
+    const int wd = inotify_add_watch(self.fd, (const char *)cpath.data.data, kDirMask);
+    if (wd == -1)
+        return false; // gone again already, or not a directory
+
+    // Another root may cover this directory already, inotify hands out one wd per directory.
+    if (FindDir(self, wd))
+        return true;
+
+    if (self.dirCount == kMaxDirs)
+        Compact(self);
+    if (self.dirCount == kMaxDirs)
+    {
+        LOG("platform_dir_watch: more than %u directories, not watching " SV_FMT, kMaxDirs, SV_ARG(path));
+        inotify_rm_watch(self.fd, wd);
+        return false;
+    }
+
+    const uint64_t at = BinarySearch::LowerBound(Dirs(self), wd, [](const watched_dir &d) { return d.wd; });
+    if (at < self.dirCount && self.dirs[at].wd == wd)
+    {
+        self.dirs[at].live = true;
+    }
+    else
+    {
+        for (uint64_t i = self.dirCount; i > at; --i)
+            self.dirs[i] = self.dirs[i - 1];
+        ++self.dirCount;
+    }
+
+    watched_dir &dir = self.dirs[at];
+    dir.wd = wd;
+    dir.live = true;
+    InlineVec::Clear(dir.path);
+    InlineVec::Append(dir.path, path);
+
+    DIR *d = opendir((const char *)cpath.data.data);
+    if (!d)
+        return true;
+
+    while (dirent *entry = readdir(d))
+    {
+        const byteview name = Span::FromCStr(entry->d_name, sizeof(entry->d_name));
+        if (Span::Eq(name, "."_s) || Span::Eq(name, ".."_s))
+            continue;
+
+        if (IsDir(d, *entry))
+        {
+            if (IsHidden(name))
+                continue;
+
+            inline_vec<uint8_t, kMaxPath> child;
+            if (JoinPath(child, path, name))
+                AddDir(self, child, reportFiles);
+        }
+        else if (reportFiles && self.newFiles.size < kMaxNewFiles)
+        {
+            new_file &file = InlineVec::Append(self.newFiles);
+            file.wd = wd;
+            InlineVec::Clear(file.name);
+            InlineVec::Append(file.name, name);
+        }
+    }
+
+    closedir(d);
+    return true;
+}
+
+// A directory moved away keeps its watches, but under a path we no longer know. Drop them, and their
+// subdirectories', the kernel confirms each with IN_IGNORED.
+void RemoveTree(platform_dir_watch &self, byteview path)
+{
+    for (watched_dir &dir : Dirs(self))
+    {
+        if (!dir.live)
+            continue;
+
+        const byteview dirPath = DirView(dir);
+        const bool below = Span::StartsWith(dirPath, path) &&
+                           (dirPath.size == path.size || dirPath[path.size] == '/');
+        if (!below)
+            continue;
+
+        inotify_rm_watch(self.fd, dir.wd);
+        dir.live = false;
+    }
+}
+
+} // namespace
+
+auto API Create(region_alloc &alloc) -> platform_dir_watch *
 {
     auto &self = RegionAlloc::Alloc<platform_dir_watch>(alloc);
 
-    self.fd = inotify_init1(IN_NONBLOCK);
-    ASSERT(self.fd > 0);
+    self.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    ASSERT(self.fd != -1);
+
+    self.quit = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ASSERT(self.quit != -1);
 
-    int wd = inotify_add_watch(self.fd, Span::CStr(path), IN_MODIFY | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
-    ASSERT(wd != -1);
+    self.epoll = epoll_create1(EPOLL_CLOEXEC);
+    ASSERT(self.epoll != -1);
+
+    Arm(self, EPOLL_CTL_ADD);
+    epoll_event quit{.events = EPOLLIN, .data = {.fd = self.quit}};
+    ASSERT(epoll_ctl(self.epoll, EPOLL_CTL_ADD, self.quit, &quit) == 0);
+
+    self.thread = PlatformThread::Create(alloc, &WatchThread, &self);
+    PlatformThread::SetName(*self.thread, "nyla-dirwatch");
 
     return &self;
 }
 
 void API Destroy(platform_dir_watch &self)
 {
-    if (self.fd)
-        close(self.fd);
+    const uint64_t one = 1;
+    ASSERT(write(self.quit, &one, sizeof(one)) == sizeof(one));
+    PlatformThread::Join(*self.thread);
+
+    close(self.epoll);
+    close(self.quit);
+    close(self.fd);
+}
+
+auto API Add(platform_dir_watch &self, byteview path) -> bool
+{
+    return AddDir(self, path, false);
+}
+
+auto API HasEvents(platform_dir_watch &self) -> bool
+{
+    return AtomicLoad32(&self.ready) || self.newFilesPos < self.newFiles.size;
 }
 
 auto API Poll(platform_dir_watch &self, platform_dir_watch_event &out) -> bool
 {
     for (;;)
     {
+        if (self.newFilesPos < self.newFiles.size)
+        {
+            const new_file &file = self.newFiles[self.newFilesPos++];
+            const watched_dir *dir = FindDir(self, file.wd);
+            if (!dir)
+                continue;
+
+            out.dir = DirView(*dir);
+            out.name = byteview{file.name.data.data, file.name.size};
+            out.mask = platform_dir_watch_event_type::MovedTo;
+            return true;
+        }
+        InlineVec::Clear(self.newFiles);
+        self.newFilesPos = 0;
+
         ASSERT(self.bufPos <= self.bufLen);
-        if (!self.bufPos || self.bufPos == self.bufLen)
+        if (self.bufPos == self.bufLen)
         {
-            ssize_t n = read(self.fd, self.buf.data, kBufSize);
+            const ssize_t n = read(self.fd, self.buf.data, kBufSize);
             if (n <= 0)
             {
                 self.bufPos = 0;
                 self.bufLen = 0;
+
+                // Cleared before arming again, so a wakeup right after is not lost.
+                AtomicStore32(&self.ready, 0);
+                Arm(self, EPOLL_CTL_MOD);
                 return false;
             }
             self.bufPos = 0;
@@ -69,14 +339,47 @@ auto API Poll(platform_dir_watch &self, platform_dir_watch_event &out) -> bool
         }
 
         const auto *event = reinterpret_cast<const inotify_event *>(self.buf.data + self.bufPos);
-        self.bufPos += sizeof(inotify_event);
+        self.bufPos += sizeof(inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW)
+        {
+            LOG("platform_dir_watch: the kernel queue overflowed, changes were lost");
+            continue;
+        }
+
+        watched_dir *dir = FindDir(self, event->wd);
+        if (!dir)
+            continue;
+
+        if (event->mask & IN_IGNORED)
+        {
+            dir->live = false;
+            continue;
+        }
+
+        const byteview name = Span::FromCStr(event->name, event->len);
 
         if (event->mask & IN_ISDIR)
         {
-            self.bufPos += event->len;
+            if (IsHidden(name))
+                continue;
+
+            inline_vec<uint8_t, kMaxPath> child;
+            if (!JoinPath(child, DirView(*dir), name))
+                continue;
+
+            // A deleted directory cleans up after itself through IN_IGNORED.
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                AddDir(self, child, true);
+            else if (event->mask & IN_MOVED_FROM)
+                RemoveTree(self, child);
             continue;
         }
 
+        // Only watched to follow new directories, a new file reports its first write as IN_MODIFY.
+        if (event->mask & IN_CREATE)
+            continue;
+
         out.mask = None<platform_dir_watch_event_type>();
         if (event->mask & IN_MODIFY)
             out.mask |= platform_dir_watch_event_type::Modified;
@@ -87,13 +390,8 @@ auto API Poll(platform_dir_watch &self, platform_dir_watch_event &out) -> bool
         if (event->mask & IN_MOVED_TO)
             out.mask |= platform_dir_watch_event_type::MovedTo;
 
-        const uint8_t *name = self.buf.data + self.bufPos;
-        uint32_t nameLen = 0;
-        while (nameLen < event->len && name[nameLen] != 0)
-            ++nameLen;
-        out.name = byteview{name, nameLen};
-
-        self.bufPos += event->len;
+        out.dir = DirView(*dir);
+        out.name = name;
         return true;
     }
 }
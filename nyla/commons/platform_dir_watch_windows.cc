@@ -2,10 +2,12 @@
 
 #include <cstdint>
 
-#include "nyla/commons/array_def.h"
+#include "nyla/commons/array.h" // IWYU pragma: keep
 #include "nyla/commons/cast.h"
 #include "nyla/commons/fmt.h"
 #include "nyla/commons/headers_windows.h"
+#include "nyla/commons/inline_vec.h"
+#include "nyla/commons/mem.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/span.h"
 
@@ -17,126 +19,194 @@ namespace
 
 constexpr uint32_t kBufSize = 64 * 1024;
 constexpr uint32_t kNameBufSize = 4 * 1024;
+constexpr uint32_t kMaxRoots = 64;
 
-} // namespace
-
-struct platform_dir_watch
+// One overlapped read per root, the subtree flag makes it cover every directory below.
+struct watched_root
 {
     HANDLE hDir;
     OVERLAPPED overlapped;
     bool pending;
     uint32_t bufPos;
     uint32_t bufLen;
-    array<uint8_t, kNameBufSize> nameUtf8;
+    byteview path;
     alignas(DWORD) array<uint8_t, kBufSize> buf;
 };
 
+} // namespace
+
+struct platform_dir_watch
+{
+    region_alloc *alloc;
+    inline_vec<watched_root *, kMaxRoots> roots;
+    array<uint8_t, kNameBufSize> nameUtf8;
+    inline_vec<uint8_t, kNameBufSize> dir;
+};
+
 namespace PlatformDirWatch
 {
 
 namespace
 {
 
-void IssueRead(platform_dir_watch &self)
+void IssueRead(watched_root &root)
 {
-    self.bufPos = 0;
-    self.bufLen = 0;
-    self.pending =
-        ReadDirectoryChangesW(self.hDir, self.buf.data, kBufSize, FALSE,
+    root.bufPos = 0;
+    root.bufLen = 0;
+    root.pending =
+        ReadDirectoryChangesW(root.hDir, root.buf.data, kBufSize, TRUE,
                               FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
-                              nullptr, &self.overlapped, nullptr);
+                              nullptr, &root.overlapped, nullptr);
 }
 
-} // namespace
-
-auto API Create(region_alloc &alloc, byteview path) -> platform_dir_watch *
+// Takes the next event of one root, if its read has completed.
+auto PollRoot(platform_dir_watch &self, watched_root &root, platform_dir_watch_event &out) -> bool
 {
-    auto &self = RegionAlloc::Alloc<platform_dir_watch>(alloc);
+    if (!root.bufLen)
+    {
+        if (!root.pending)
+            IssueRead(root);
 
-    self.hDir =
-        CreateFileA(Span::CStr(path), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-                    nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
-    ASSERT(self.hDir != INVALID_HANDLE_VALUE);
+        DWORD transferred = 0;
+        if (!GetOverlappedResult(root.hDir, &root.overlapped, &transferred, FALSE))
+            return false;
 
-    self.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-    ASSERT(self.overlapped.hEvent);
+        root.pending = false;
+        root.bufPos = 0;
+        root.bufLen = transferred;
 
-    IssueRead(self);
-    return &self;
+        if (!root.bufLen)
+        {
+            IssueRead(root);
+            return false;
+        }
+    }
+
+    const auto *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(root.buf.data + root.bufPos);
+
+    out.mask = None<platform_dir_watch_event_type>();
+    switch (info->Action)
+    {
+    case FILE_ACTION_MODIFIED:
+        out.mask |= platform_dir_watch_event_type::Modified;
+        break;
+    case FILE_ACTION_REMOVED:
+        out.mask |= platform_dir_watch_event_type::Deleted;
+        break;
+    case FILE_ACTION_RENAMED_OLD_NAME:
+        out.mask |= platform_dir_watch_event_type::MovedFrom;
+        break;
+    case FILE_ACTION_ADDED:
+    case FILE_ACTION_RENAMED_NEW_NAME:
+        out.mask |= platform_dir_watch_event_type::MovedTo;
+        break;
+    }
+
+    // FileName is relative to the root, "sub\dir\name".
+    int outLen = WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / 2,
+                                     (char *)self.nameUtf8.data, kNameBufSize, nullptr, nullptr);
+    byteview relative{self.nameUtf8.data, (uint64_t)outLen};
+
+    uint64_t nameStart = relative.size;
+    while (nameStart && relative[nameStart - 1] != '\\')
+        --nameStart;
+
+    InlineVec::Clear(self.dir);
+    InlineVec::Append(self.dir, root.path);
+    if (nameStart && root.path.size + nameStart < kNameBufSize)
+    {
+        InlineVec::Append(self.dir, (uint8_t)'/');
+        for (uint64_t i = 0; i + 1 < nameStart; ++i)
+            InlineVec::Append(self.dir, relative[i] == '\\' ? (uint8_t)'/' : relative[i]);
+    }
+
+    out.dir = byteview{self.dir.data.data, self.dir.size};
+    out.name = Span::SubSpan(relative, nameStart);
+
+    if (info->NextEntryOffset)
+    {
+        root.bufPos += info->NextEntryOffset;
+    }
+    else
+    {
+        root.bufLen = 0;
+        IssueRead(root);
+    }
+
+    return true;
 }
 
-void API Destroy(platform_dir_watch &self)
+} // namespace
+
+auto API Create(region_alloc &alloc) -> platform_dir_watch *
 {
-    if (self.pending)
-        CancelIoEx(self.hDir, &self.overlapped);
-    if (self.overlapped.hEvent)
-        CloseHandle(self.overlapped.hEvent);
-    if (self.hDir && self.hDir != INVALID_HANDLE_VALUE)
-        CloseHandle(self.hDir);
+    auto &self = RegionAlloc::Alloc<platform_dir_watch>(alloc);
+    self.alloc = &alloc;
+    return &self;
 }
 
-auto API Poll(platform_dir_watch &self, platform_dir_watch_event &out) -> bool
+void API Destroy(platform_dir_watch &self)
 {
-    for (;;)
+    for (watched_root *root : self.roots)
     {
-        if (!self.bufLen)
-        {
-            if (!self.pending)
-                IssueRead(self);
-
-            DWORD transferred = 0;
-            if (!GetOverlappedResult(self.hDir, &self.overlapped, &transferred, FALSE))
-                return false;
-
-            self.pending = false;
-            self.bufPos = 0;
-            self.bufLen = transferred;
-
-            if (!self.bufLen)
-            {
-                IssueRead(self);
-                return false;
-            }
-        }
-
-        const auto *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(self.buf.data + self.bufPos);
-
-        out.mask = None<platform_dir_watch_event_type>();
-        switch (info->Action)
-        {
-        case FILE_ACTION_MODIFIED:
-            out.mask |= platform_dir_watch_event_type::Modified;
-            break;
-        case FILE_ACTION_REMOVED:
-            out.mask |= platform_dir_watch_event_type::Deleted;
-            break;
-        case FILE_ACTION_RENAMED_OLD_NAME:
-            out.mask |= platform_dir_watch_event_type::MovedFrom;
-            break;
-        case FILE_ACTION_ADDED:
-        case FILE_ACTION_RENAMED_NEW_NAME:
-            out.mask |= platform_dir_watch_event_type::MovedTo;
-            break;
-        }
+        if (root->pending)
+            CancelIoEx(root->hDir, &root->overlapped);
+        if (root->overlapped.hEvent)
+            CloseHandle(root->overlapped.hEvent);
+        if (root->hDir && root->hDir != INVALID_HANDLE_VALUE)
+            CloseHandle(root->hDir);
+    }
+    InlineVec::Clear(self.roots);
+}
 
-        int outLen = WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / 2,
-                                         (char *)self.nameUtf8.data, kNameBufSize, nullptr, nullptr);
-        out.name = byteview{self.nameUtf8.data, (uint64_t)outLen};
+auto API Add(platform_dir_watch &self, byteview path) -> bool
+{
+    if (self.roots.size == kMaxRoots)
+        return false;
+
+    span<uint8_t> pathCopy = RegionAlloc::AllocArray<uint8_t>(*self.alloc, path.size + 1);
+    MemCpy(pathCopy.data, path.data, path.size);
+    pathCopy.data[path.size] = 0;
+
+    HANDLE hDir =
+        CreateFileA((const char *)pathCopy.data, FILE_LIST_DIRECTORY,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (hDir == INVALID_HANDLE_VALUE)
+        return false;
+
+    auto &root = RegionAlloc::Alloc<watched_root>(*self.alloc);
+    root.hDir = hDir;
+    root.path = byteview{pathCopy.data, path.size};
+    root.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    ASSERT(root.overlapped.hEvent);
+
+    IssueRead(root);
+    InlineVec::Append(self.roots, &root);
+    return true;
+}
 
-        if (info->NextEntryOffset)
-        {
-            self.bufPos += info->NextEntryOffset;
-        }
-        else
-        {
-            self.bufLen = 0;
-            IssueRead(self);
-        }
+// HasOverlappedIoCompleted only reads the OVERLAPPED the kernel fills in.
+auto API HasEvents(platform_dir_watch &self) -> bool
+{
+    for (watched_root *root : self.roots)
+    {
+        if (root->bufLen || !root->pending || HasOverlappedIoCompleted(&root->overlapped))
+            return true;
+    }
+    return false;
+}
 
-        return true;
+auto API Poll(platform_dir_watch &self, platform_dir_watch_event &out) -> bool
+{
+    for (watched_root *root : self.roots)
+    {
+        if (PollRoot(self, *root, out))
+            return true;
     }
+    return false;
 }
 
 } // namespace PlatformDirWatch
 
-} // namespace nyla
\ No newline at end of file
+} // namespace nyla
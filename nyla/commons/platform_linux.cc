@@ -5,17 +5,22 @@
 #include "nyla/commons/platform.h"
 #include "nyla/commons/region_alloc.h"
 
+#include <cerrno>
+#include <climits>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <dirent.h>
 #include <fcntl.h>
 #include <linux/close_range.h>
+#include <linux/limits.h>
+#include <sched.h>
 #include <sys/mman.h>
 #include <sys/random.h>
 #include <sys/signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <xcb/xcb.h>
@@ -50,11 +55,58 @@ platform_state *platform;
 
 //
 
+// argv without going through main, /proc/self/cmdline is every argument followed by a NUL.
+void API ParseStdArgs(byteview *args, uint32_t maxArgs)
+{
+    const int fd = open("/proc/self/cmdline", O_RDONLY);
+    ASSERT(fd >= 0);
+
+    constexpr uint64_t kMaxSize = 64 << 10;
+    uint8_t *const cmdLine = RegionAlloc::AllocUninit(RegionAlloc::g_BootstrapAlloc, kMaxSize, 1);
+    uint64_t size = 0;
+    for (ssize_t got; size < kMaxSize && (got = read(fd, cmdLine + size, kMaxSize - size)) > 0;)
+        size += (uint64_t)got;
+    close(fd);
+    RegionAlloc::Reset(RegionAlloc::g_BootstrapAlloc, cmdLine + size);
+
+    uint32_t argCount = 0;
+    for (uint64_t at = 0; at < size && argCount < maxArgs;)
+    {
+        const uint64_t len = CStrLen(cmdLine + at, size - at);
+        args[argCount++] = byteview{cmdLine + at, len};
+        at += len + 1;
+    }
+}
+
 void API Sleep(uint64_t millis)
 {
     usleep(millis * 1000L);
 }
 
+auto API GetProcessorCount() -> uint32_t
+{
+    // Honours taskset and cgroup cpusets, which the online count does not.
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        const int count = CPU_COUNT(&set);
+        if (count > 0)
+            return (uint32_t)count;
+    }
+
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+auto API GetExecutablePath(region_alloc &alloc) -> byteview
+{
+    span<uint8_t> buf = RegionAlloc::AllocArray<uint8_t>(alloc, PATH_MAX + 1);
+    const ssize_t len = readlink("/proc/self/exe", (char *)buf.data, PATH_MAX);
+    ASSERT(len > 0);
+    buf.data[len] = 0;
+    return byteview{buf.data, (uint64_t)len};
+}
+
 //
 
 auto API FileValid(file_handle file) -> bool
@@ -113,6 +165,47 @@ auto API FileWrite(file_handle file, uint32_t size, const uint8_t *in) -> uint32
     return (uint32_t)ret;
 }
 
+auto API FileWriteGather(file_handle file, span<const byteview> parts) -> uint64_t
+{
+    int fd = (int)(int64_t)file;
+    uint64_t total = 0;
+
+    uint64_t part = 0;
+    uint64_t partOffset = 0;
+    while (part < parts.size)
+    {
+        // One writev takes up to IOV_MAX parts, so a full log batch goes out in a single call.
+        iovec iov[IOV_MAX];
+        int iovCount = 0;
+        for (uint64_t i = part; i < parts.size && iovCount < IOV_MAX; ++i)
+        {
+            const uint64_t skip = i == part ? partOffset : 0;
+            iov[iovCount].iov_base = (void *)(parts[i].data + skip);
+            iov[iovCount].iov_len = parts[i].size - skip;
+            ++iovCount;
+        }
+
+        ssize_t ret = writev(fd, iov, iovCount);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            break;
+        total += (uint64_t)ret;
+
+        // Short writes (pipes, terminals) continue from where the kernel stopped.
+        uint64_t advance = (uint64_t)ret;
+        while (part < parts.size && advance >= parts[part].size - partOffset)
+        {
+            advance -= parts[part].size - partOffset;
+            partOffset = 0;
+            ++part;
+        }
+        partOffset += advance;
+    }
+
+    return total;
+}
+
 void API FileSeek(file_handle file, int64_t at, file_seek_mode mode)
 {
     int fd = (int)(int64_t)file;
@@ -142,6 +235,21 @@ auto API FileTell(file_handle file) -> uint64_t
     return ret;
 }
 
+auto API FileRename(byteview from, byteview to) -> bool
+{
+    return rename(Span::CStr(from), Span::CStr(to)) == 0;
+}
+
+auto API FileDelete(byteview path) -> bool
+{
+    return unlink(Span::CStr(path)) == 0;
+}
+
+auto API DirCreate(byteview path) -> bool
+{
+    return mkdir(Span::CStr(path), 0755) == 0 || errno == EEXIST;
+}
+
 auto API GetStdin() -> file_handle
 {
     return (void *)0;
@@ -235,31 +343,6 @@ auto API GenRandom64() -> uint64_t
 
 //
 
-auto API UpdateGamepad(uint32_t index) -> bool
-{
-    return false;
-}
-
-auto API GetGamepadLeftStick(uint32_t index) -> float2
-{
-    return {};
-}
-
-auto API GetGamepadRightStick(uint32_t index) -> float2
-{
-    return {};
-}
-
-auto API GetGamepadLeftTrigger(uint32_t index) -> float
-{
-    return 0.f;
-}
-
-auto API GetGamepadRightTrigger(uint32_t index) -> float
-{
-    return 0.f;
-}
-
 auto API GetMonotonicTimeMillis() -> uint64_t
 {
     timespec ts{};
@@ -330,6 +413,19 @@ void API WinOpen()
 namespace
 {
 
+// The X server stamps input with CLOCK_MONOTONIC milliseconds cut to 32 bits. How long ago that was carries over to
+// the raw clock GetMonotonicTimeNanos reads. A server with some other clock, a remote one, gets the time of the poll.
+auto XTimeToNanos(xcb_timestamp_t time) -> uint64_t
+{
+    timespec ts{};
+    ASSERT(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+    const uint32_t nowMs = (uint32_t)(ts.tv_sec * 1'000 + ts.tv_nsec / 1'000'000);
+    const uint32_t ageMs = nowMs - time;
+
+    const uint64_t nowNs = GetMonotonicTimeNanos();
+    return ageMs < 1'000 ? nowNs - ageMs * 1'000'000ULL : nowNs;
+}
+
 INLINE auto ProcessXEvent(xcb_generic_event_t *event, PlatformEvent &outEvent) -> bool
 {
     const uint8_t eventType = event->response_type & 0x7F;
@@ -346,6 +442,7 @@ INLINE auto ProcessXEvent(xcb_generic_event_t *event, PlatformEvent &outEvent) -
                 outEvent = PlatformEvent{
                     .type = PlatformEventType::KeyDown,
                     .key = static_cast<KeyPhysical>(i),
+                    .timeNs = XTimeToNanos(keypress->time),
                 };
                 return true;
             }
@@ -364,6 +461,7 @@ INLINE auto ProcessXEvent(xcb_generic_event_t *event, PlatformEvent &outEvent) -
                 outEvent = PlatformEvent{
                     .type = PlatformEventType::KeyUp,
                     .key = static_cast<KeyPhysical>(i),
+                    .timeNs = XTimeToNanos(keyrelease->time),
                 };
                 return true;
             }
@@ -377,6 +475,7 @@ INLINE auto ProcessXEvent(xcb_generic_event_t *event, PlatformEvent &outEvent) -
         outEvent = PlatformEvent{
             .type = PlatformEventType::MousePress,
             .mouse = {.code = buttonpress->detail},
+            .timeNs = XTimeToNanos(buttonpress->time),
         };
         return true;
     }
@@ -386,6 +485,7 @@ INLINE auto ProcessXEvent(xcb_generic_event_t *event, PlatformEvent &outEvent) -
         outEvent = PlatformEvent{
             .type = PlatformEventType::MouseRelease,
             .mouse = {.code = buttonrelease->detail},
+            .timeNs = XTimeToNanos(buttonrelease->time),
         };
         return true;
     }
@@ -607,7 +707,10 @@ void PlatformInit0()
 void PlatformInit1()
 {
     platform = &RegionAlloc::Alloc<platform_state>(RegionAlloc::g_BootstrapAlloc);
+}
 
+void PlatformInitWindowing()
+{
     {
         platform->x11.conn = xcb_connect(nullptr, &platform->x11.screenIndex);
         if (xcb_connection_has_error(X11GetConn()))
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+struct platform_module;
+
+namespace PlatformModule
+{
+
+// path is null terminated. Null when the module can not be loaded, the reason goes to the log.
+auto API Open(byteview path) -> platform_module *;
+void API Close(platform_module &self);
+auto API Symbol(platform_module &self, const char *name) -> void *;
+
+} // namespace PlatformModule
+
+} // namespace nyla
@@ -0,0 +1,34 @@
+#include "nyla/commons/platform_module.h"
+
+#include <dlfcn.h>
+
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/span.h"
+
+namespace nyla
+{
+
+namespace PlatformModule
+{
+
+auto API Open(byteview path) -> platform_module *
+{
+    void *handle = dlopen(Span::CStr(path), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+        LOG("platform_module: %s", dlerror());
+    return static_cast<platform_module *>(handle);
+}
+
+void API Close(platform_module &self)
+{
+    dlclose(&self);
+}
+
+auto API Symbol(platform_module &self, const char *name) -> void *
+{
+    return dlsym(&self, name);
+}
+
+} // namespace PlatformModule
+
+} // namespace nyla
@@ -0,0 +1,33 @@
+#include "nyla/commons/platform_module.h"
+
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/headers_windows.h"
+#include "nyla/commons/span.h"
+
+namespace nyla
+{
+
+namespace PlatformModule
+{
+
+auto API Open(byteview path) -> platform_module *
+{
+    HMODULE handle = LoadLibraryA(Span::CStr(path));
+    if (!handle)
+        LOG("platform_module: LoadLibrary failed " SV_FMT " (%u)", SV_ARG(path), (uint32_t)GetLastError());
+    return reinterpret_cast<platform_module *>(handle);
+}
+
+void API Close(platform_module &self)
+{
+    FreeLibrary(reinterpret_cast<HMODULE>(&self));
+}
+
+auto API Symbol(platform_module &self, const char *name) -> void *
+{
+    return reinterpret_cast<void *>(GetProcAddress(reinterpret_cast<HMODULE>(&self), name));
+}
+
+} // namespace PlatformModule
+
+} // namespace nyla
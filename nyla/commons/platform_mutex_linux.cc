@@ -77,6 +77,11 @@ void API Signal(platform_condvar &self)
     pthread_cond_signal(&self.handle);
 }
 
+void API Broadcast(platform_condvar &self)
+{
+    pthread_cond_broadcast(&self.handle);
+}
+
 } // namespace PlatformCondvar
 
 } // namespace nyla
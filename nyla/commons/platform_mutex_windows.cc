@@ -72,6 +72,11 @@ void API Signal(platform_condvar &self)
     WakeConditionVariable(&self.handle);
 }
 
+void API Broadcast(platform_condvar &self)
+{
+    WakeAllConditionVariable(&self.handle);
+}
+
 } // namespace PlatformCondvar
 
 } // namespace nyla
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "nyla/commons/macros.h"
 #include "nyla/commons/region_alloc_def.h"
 
@@ -17,6 +19,13 @@ auto API Create(region_alloc &alloc, platform_thread_fn fn, void *userdata) -> p
 void API Join(platform_thread &self);
 void API SetName(platform_thread &self, const char *name);
 
+// Looks up [low, high) of the calling thread's stack and keeps it thread local. Threads started through Create do
+// this before fn runs.
+void API CacheStackBounds();
+
+// What CacheStackBounds kept for the calling thread, false when it never ran there. Async signal safe.
+auto API GetStackBounds(uint64_t &low, uint64_t &high) -> bool;
+
 } // namespace PlatformThread
 
 } // namespace nyla
@@ -21,9 +21,13 @@ namespace PlatformThread
 namespace
 {
 
+thread_local uint64_t t_stackLow;
+thread_local uint64_t t_stackHigh;
+
 auto Trampoline(void *arg) -> void *
 {
     auto *self = static_cast<platform_thread *>(arg);
+    CacheStackBounds();
     self->fn(self->userdata);
     return nullptr;
 }
@@ -53,6 +57,32 @@ void API SetName(platform_thread &self, const char *name)
     pthread_setname_np(self.handle, name);
 }
 
+void API CacheStackBounds()
+{
+    if (t_stackHigh)
+        return;
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+        return;
+
+    void *addr;
+    size_t size;
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0)
+    {
+        t_stackLow = (uint64_t)addr;
+        t_stackHigh = (uint64_t)addr + size;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+auto API GetStackBounds(uint64_t &low, uint64_t &high) -> bool
+{
+    low = t_stackLow;
+    high = t_stackHigh;
+    return high != 0;
+}
+
 } // namespace PlatformThread
 
 } // namespace nyla
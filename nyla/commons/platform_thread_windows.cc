@@ -20,9 +20,13 @@ namespace PlatformThread
 namespace
 {
 
+thread_local uint64_t t_stackLow;
+thread_local uint64_t t_stackHigh;
+
 auto WINAPI Trampoline(LPVOID arg) -> DWORD
 {
     auto *self = static_cast<platform_thread *>(arg);
+    CacheStackBounds();
     self->fn(self->userdata);
     return 0;
 }
@@ -56,6 +60,22 @@ void API SetName(platform_thread &self, const char *name)
         SetThreadDescription(self.handle, wide);
 }
 
+void API CacheStackBounds()
+{
+    ULONG_PTR low;
+    ULONG_PTR high;
+    GetCurrentThreadStackLimits(&low, &high);
+    t_stackLow = (uint64_t)low;
+    t_stackHigh = (uint64_t)high;
+}
+
+auto API GetStackBounds(uint64_t &low, uint64_t &high) -> bool
+{
+    low = t_stackLow;
+    high = t_stackHigh;
+    return high != 0;
+}
+
 } // namespace PlatformThread
 
 } // namespace nyla
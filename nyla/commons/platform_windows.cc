@@ -32,6 +32,7 @@ HWND g_HWnd{};
 RECT g_WinRect{};
 
 array<XINPUT_STATE, 1> g_Gamepads{};
+array<gamepad_stats, 1> g_GamepadStats{};
 
 static inline constexpr uint32_t kFlagQuit = 1 << 0;
 static inline constexpr uint32_t kFlagWinResize = 1 << 1;
@@ -72,6 +73,15 @@ auto TicksTo(uint64_t ticks, uint64_t scale) -> uint64_t
     return UDiv128(hi, lo, GetPerformanceFreq(), rem);
 }
 
+// GetMessageTime is in GetTickCount milliseconds, how long ago the message was posted carries over to the
+// performance counter.
+auto MessageTimeNs() -> uint64_t
+{
+    const uint64_t nowNs = TicksTo(GetPerformanceTicks(), 1'000'000'000ULL);
+    const DWORD ageMs = GetTickCount() - (DWORD)GetMessageTime();
+    return ageMs < 1000 ? nowNs - ageMs * 1'000'000ULL : nowNs;
+}
+
 } // namespace
 
 auto API GenRandom64() -> uint64_t
@@ -91,11 +101,30 @@ auto API GetMonotonicTimeMicros() -> uint64_t
     return TicksTo(GetPerformanceTicks(), 1'000'000ULL);
 }
 
+auto API GetMonotonicTimeNanos() -> uint64_t
+{
+    return TicksTo(GetPerformanceTicks(), 1'000'000'000ULL);
+}
+
 void API Sleep(uint64_t millis)
 {
     ::Sleep((DWORD)millis);
 }
 
+auto API GetProcessorCount() -> uint32_t
+{
+    return g_SysInfo.dwNumberOfProcessors ? g_SysInfo.dwNumberOfProcessors : 1;
+}
+
+auto API GetExecutablePath(region_alloc &alloc) -> byteview
+{
+    span<uint8_t> buf = RegionAlloc::AllocArray<uint8_t>(alloc, MAX_PATH + 1);
+    const DWORD len = GetModuleFileNameA(nullptr, (char *)buf.data, MAX_PATH);
+    ASSERT(len > 0 && len < MAX_PATH);
+    buf.data[len] = 0;
+    return byteview{buf.data, len};
+}
+
 namespace
 {
 
@@ -367,9 +396,12 @@ void WindowsPlatform::SetHInstance(HINSTANCE hInstance)
 auto UpdateGamepad(uint32_t index) -> bool
 {
     auto &state = g_Gamepads[index];
+    const DWORD lastPacket = state.dwPacketNumber;
     MemZero(&state.Gamepad);
 
     const DWORD dwResult = XInputGetState(0, &state);
+    if (dwResult == ERROR_SUCCESS && state.dwPacketNumber != lastPacket)
+        ++g_GamepadStats[index].reports;
     return (dwResult == ERROR_SUCCESS);
 }
 
@@ -442,6 +474,44 @@ auto API GetGamepadRightTrigger(uint32_t index) -> float
     return GetGamepadTrigger(gamepad.bRightTrigger, XINPUT_GAMEPAD_TRIGGER_THRESHOLD);
 }
 
+auto API GetGamepadButtons(uint32_t index) -> gamepad_buttons
+{
+    constexpr struct
+    {
+        WORD bit;
+        gamepad_buttons button;
+    } kButtons[] = {
+        {XINPUT_GAMEPAD_A, gamepad_buttons::A},
+        {XINPUT_GAMEPAD_B, gamepad_buttons::B},
+        {XINPUT_GAMEPAD_X, gamepad_buttons::X},
+        {XINPUT_GAMEPAD_Y, gamepad_buttons::Y},
+        {XINPUT_GAMEPAD_LEFT_SHOULDER, gamepad_buttons::LeftShoulder},
+        {XINPUT_GAMEPAD_RIGHT_SHOULDER, gamepad_buttons::RightShoulder},
+        {XINPUT_GAMEPAD_BACK, gamepad_buttons::Back},
+        {XINPUT_GAMEPAD_START, gamepad_buttons::Start},
+        {XINPUT_GAMEPAD_LEFT_THUMB, gamepad_buttons::LeftThumb},
+        {XINPUT_GAMEPAD_RIGHT_THUMB, gamepad_buttons::RightThumb},
+        {XINPUT_GAMEPAD_DPAD_UP, gamepad_buttons::DPadUp},
+        {XINPUT_GAMEPAD_DPAD_DOWN, gamepad_buttons::DPadDown},
+        {XINPUT_GAMEPAD_DPAD_LEFT, gamepad_buttons::DPadLeft},
+        {XINPUT_GAMEPAD_DPAD_RIGHT, gamepad_buttons::DPadRight},
+    };
+
+    const WORD raw = g_Gamepads[index].Gamepad.wButtons;
+    gamepad_buttons ret = None<gamepad_buttons>();
+    for (const auto &mapping : kButtons)
+    {
+        if (raw & mapping.bit)
+            ret |= mapping.button;
+    }
+    return ret;
+}
+
+auto API GetGamepadStats(uint32_t index) -> gamepad_stats
+{
+    return g_GamepadStats[index];
+}
+
 auto CALLBACK WindowsPlatform::MainWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) -> LRESULT
 {
     switch (uMsg)
@@ -485,6 +555,7 @@ auto CALLBACK WindowsPlatform::MainWndProc(HWND hwnd, UINT uMsg, WPARAM wParam,
             InlineQueue::Write(g_EventsQueue, PlatformEvent{
                                                   .type = PlatformEventType::KeyDown,
                                                   .key = key,
+                                                  .timeNs = MessageTimeNs(),
                                               });
         }
         return 0;
@@ -499,6 +570,7 @@ auto CALLBACK WindowsPlatform::MainWndProc(HWND hwnd, UINT uMsg, WPARAM wParam,
         InlineQueue::Write(g_EventsQueue, PlatformEvent{
                                               .type = PlatformEventType::KeyUp,
                                               .key = key,
+                                              .timeNs = MessageTimeNs(),
                                           });
         return 0;
     }
@@ -774,6 +846,10 @@ void PlatformInit1()
 #endif
 }
 
+void PlatformInitWindowing()
+{
+}
+
 void PlatformTearDown()
 {
 #ifndef NDEBUG
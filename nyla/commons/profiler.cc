@@ -1,17 +1,23 @@
 #include "nyla/commons/profiler.h"
 
+#include <cinttypes>
 #include <cstdint>
 
 #include "nyla/commons/cell_renderer.h"
+#include "nyla/commons/file.h"
 #include "nyla/commons/fmt.h"
 #include "nyla/commons/inline_string.h"
+#include "nyla/commons/intrin.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/mem.h"
 #include "nyla/commons/minmax.h"
+#include "nyla/commons/platform_mutex.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/rhi.h"
+#include "nyla/commons/span.h"
 #include "nyla/commons/span_def.h"
 #include "nyla/commons/time.h"
+#include "nyla/commons/tunables.h"
 
 namespace nyla
 {
@@ -23,14 +29,73 @@ constexpr inline uint32_t kMaxEntries = 64;
 constexpr inline uint32_t kMaxStack = 8;
 constexpr inline uint64_t kNameCap = 32;
 
+// Id 0 is the name every lookup gets once the table is full.
+constexpr inline uint32_t kMaxNames = 1024;
+constexpr inline uint32_t kNameSlots = 2048;
+
+// A thread keeps its slot and event buffer for the rest of the run.
+constexpr inline uint32_t kMaxThreads = 32;
+constexpr inline uint32_t kMaxEvents = 1 << 16;
+
+// Rolling statistics over the last kHistoryFrames frames, per scope name. Track 0 is the frame itself.
+constexpr inline uint32_t kHistoryFrames = 256;
+constexpr inline uint32_t kMaxTracks = 64;
+constexpr inline uint32_t kAbsent = 0xFFFFFFFFu;
+// Nearest rank p99 of up to kHistoryFrames samples is at most the kTopK-th largest.
+constexpr inline uint32_t kTopK = kHistoryFrames - (kHistoryFrames * 99 + 99) / 100 + 1;
+
+constexpr inline uint32_t kGraphRows = 4;
+
 struct profile_entry
 {
-    inline_string<kNameCap> name;
+    uint32_t nameId;
     uint64_t startUs;
     uint64_t durationUs;
     uint8_t depth;
 };
 
+enum class profile_event_kind : uint32_t
+{
+    Begin,
+    End,
+};
+
+struct profile_event
+{
+    uint64_t tsc;
+    uint32_t nameId;
+    profile_event_kind kind;
+};
+
+// Only the owning thread writes. cursor packs the capture generation over the event count and is stored after the
+// event, so the trace writer sees whole events of the current capture or skips the thread.
+struct profile_thread
+{
+    uint64_t cursor;
+    profile_event *events;
+    inline_string<kNameCap> name;
+};
+
+// sumUs and present follow every frame, min/max/p99 are rescanned for one track per frame.
+struct scope_track
+{
+    uint32_t nameId;
+    uint32_t present;
+    uint64_t sumUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t p99Us;
+    uint32_t *history; // kHistoryFrames durations in us, kAbsent for frames the scope did not run in
+};
+
+struct trace_writer
+{
+    file_handle file;
+    uint64_t size;
+    uint64_t eventCount;
+    uint8_t buf[64 << 10];
+};
+
 struct profiler_state
 {
     profile_entry current[kMaxEntries];
@@ -44,13 +109,48 @@ struct profiler_state
 
     uint64_t frameStartUs;
     uint64_t lastFrameUs;
+    uint64_t displayFrameUs;
     uint32_t overflowCount;
 
     bool visible;
+
+    scope_track tracks[kMaxTracks];
+    uint32_t trackCount;
+    uint8_t trackForName[kMaxNames]; // track + 1, 0 while untracked
+    uint32_t historyPos;
+    uint32_t statsCursor;
+
+    float spikeMs;
+    bool spikeArmed;
+    bool frozen;
+
+    inline_string<kNameCap> names[kMaxNames];
+    uint32_t nameCount;
+    uint32_t nameSlots[kNameSlots];
+    platform_mutex *mutex; // name inserts and thread registration
+
+    profile_thread threads[kMaxThreads];
+    uint32_t threadCount;
+    region_alloc eventAlloc;
+    trace_writer *writer;
+
+    int32_t captureFrames;
+    int32_t captureFramesLeft;
+    bool captureRequested;
+    uint32_t capturing;
+    uint32_t captureGen;
+    uint64_t captureStartTsc;
+    uint64_t captureStartNs;
+    uint32_t frameNameId;
 };
 
 profiler_state *g_profiler;
 
+thread_local profile_thread *t_thread;
+thread_local bool t_threadsFull;
+thread_local bool t_isMainThread;
+thread_local inline_string<kNameCap> t_threadName;
+
 void StoreName(inline_string<kNameCap> &dst, byteview name)
 {
     uint64_t n = Min<uint64_t>(name.size, kNameCap);
@@ -59,6 +159,395 @@ void StoreName(inline_string<kNameCap> &dst, byteview name)
     dst.size = n;
 }
 
+INLINE auto NameView(const inline_string<kNameCap> &name) -> byteview
+{
+    return byteview{name.data.data, name.size};
+}
+
+INLINE auto HashName(byteview name) -> uint32_t
+{
+    uint32_t h = 2166136261u;
+    for (uint64_t i = 0; i < name.size; ++i)
+        h = (h ^ name[i]) * 16777619u;
+    return h;
+}
+
+// Returns the slot holding name, or the empty slot where it would go.
+auto ProbeName(byteview name, uint32_t h, uint32_t &id) -> uint32_t
+{
+    for (uint32_t i = h & (kNameSlots - 1);; i = (i + 1) & (kNameSlots - 1))
+    {
+        id = AtomicLoad32(&g_profiler->nameSlots[i]);
+        if (!id || Span::Eq(NameView(g_profiler->names[id]), name))
+            return i;
+    }
+}
+
+auto RegisterThread() -> profile_thread *
+{
+    profile_thread *t = nullptr;
+
+    PlatformMutex::Lock(*g_profiler->mutex);
+    const uint32_t index = g_profiler->threadCount;
+    if (index < kMaxThreads)
+    {
+        t = &g_profiler->threads[index];
+        t->events = RegionAlloc::AllocArrayUninit<profile_event>(g_profiler->eventAlloc, kMaxEvents).data;
+        if (t_threadName.size)
+            t->name = t_threadName;
+        else
+            t->name.size = StringWriteFmt(span<uint8_t>{t->name.data.data, kNameCap}, "thread %u"_s, index);
+        AtomicStore32(&g_profiler->threadCount, index + 1);
+    }
+    PlatformMutex::Unlock(*g_profiler->mutex);
+
+    return t;
+}
+
+void Record(uint32_t nameId, profile_event_kind kind)
+{
+    profile_thread *t = t_thread;
+    if (!t)
+    {
+        if (t_threadsFull)
+            return;
+        t = t_thread = RegisterThread();
+        if (!t)
+        {
+            t_threadsFull = true;
+            return;
+        }
+    }
+
+    const uint64_t gen = AtomicLoad32(&g_profiler->captureGen);
+    uint32_t count = 0;
+    if ((t->cursor >> 32) == gen)
+        count = (uint32_t)t->cursor;
+    if (count >= kMaxEvents)
+        return;
+
+    t->events[count] = profile_event{ReadTimestampCounter(), nameId, kind};
+    AtomicStore64(&t->cursor, (gen << 32) | (count + 1));
+}
+
+void OverlayBegin(uint32_t nameId)
+{
+    if (g_profiler->currentCount >= kMaxEntries || g_profiler->stackDepth >= kMaxStack)
+    {
+        ++g_profiler->overflowCount;
+        return;
+    }
+
+    const uint16_t idx = (uint16_t)g_profiler->currentCount++;
+    auto &e = g_profiler->current[idx];
+    e.nameId = nameId;
+    e.startUs = GetMonotonicTimeMicros();
+    e.durationUs = 0;
+    e.depth = g_profiler->stackDepth;
+    g_profiler->stack[g_profiler->stackDepth++] = idx;
+}
+
+void OverlayEnd()
+{
+    if (g_profiler->stackDepth == 0)
+        return;
+
+    const uint16_t idx = g_profiler->stack[--g_profiler->stackDepth];
+    auto &e = g_profiler->current[idx];
+    e.durationUs = GetMonotonicTimeMicros() - e.startUs;
+}
+
+auto TrackFor(uint32_t nameId) -> scope_track *
+{
+    uint8_t &slot = g_profiler->trackForName[nameId];
+    if (!slot)
+    {
+        if (g_profiler->trackCount >= kMaxTracks)
+            return nullptr;
+        scope_track &t = g_profiler->tracks[g_profiler->trackCount];
+        t.nameId = nameId;
+        MemSet(t.history, 0xFF, kHistoryFrames * sizeof(uint32_t));
+        slot = (uint8_t)++g_profiler->trackCount;
+    }
+    return &g_profiler->tracks[slot - 1];
+}
+
+void AddSample(scope_track &t, uint32_t at, uint64_t us)
+{
+    const uint32_t d = (uint32_t)Min<uint64_t>(us, kAbsent - 1);
+    uint32_t &v = t.history[at];
+    if (v == kAbsent)
+    {
+        v = d;
+        ++t.present;
+    }
+    else
+        v = (uint32_t)Min<uint64_t>((uint64_t)v + d, kAbsent - 1);
+    t.sumUs += d;
+}
+
+void RefreshStats(scope_track &t)
+{
+    uint32_t top[kTopK]{};
+    uint32_t minUs = kAbsent;
+    uint32_t maxUs = 0;
+    for (uint32_t i = 0; i < kHistoryFrames; ++i)
+    {
+        const uint32_t v = t.history[i];
+        if (v == kAbsent)
+            continue;
+        minUs = Min(minUs, v);
+        maxUs = Max(maxUs, v);
+        if (v > top[kTopK - 1])
+        {
+            uint32_t j = kTopK - 1;
+            for (; j && top[j - 1] < v; --j)
+                top[j] = top[j - 1];
+            top[j] = v;
+        }
+    }
+
+    if (!t.present)
+    {
+        t.minUs = t.maxUs = t.p99Us = 0;
+        return;
+    }
+    t.minUs = minUs;
+    t.maxUs = maxUs;
+    t.p99Us = top[t.present - (t.present * 99 + 99) / 100];
+}
+
+// Once per unfrozen frame. Several entries with the same name in one frame add up.
+void RecordHistory()
+{
+    const uint32_t at = g_profiler->historyPos++ % kHistoryFrames;
+    for (uint32_t i = 0; i < g_profiler->trackCount; ++i)
+    {
+        scope_track &t = g_profiler->tracks[i];
+        uint32_t &v = t.history[at];
+        if (v != kAbsent)
+        {
+            t.sumUs -= v;
+            --t.present;
+            v = kAbsent;
+        }
+    }
+
+    AddSample(g_profiler->tracks[0], at, g_profiler->lastFrameUs);
+    for (uint32_t i = 0; i < g_profiler->displayCount; ++i)
+    {
+        const profile_entry &e = g_profiler->display[i];
+        if (scope_track *t = TrackFor(e.nameId))
+            AddSample(*t, at, e.durationUs);
+    }
+
+    // A new extreme shows up right away, an evicted one waits for the track's rescan.
+    for (uint32_t i = 0; i < g_profiler->trackCount; ++i)
+    {
+        scope_track &t = g_profiler->tracks[i];
+        const uint32_t v = t.history[at];
+        if (v == kAbsent)
+            continue;
+        t.minUs = t.present == 1 ? v : Min(t.minUs, v);
+        t.maxUs = Max(t.maxUs, v);
+    }
+
+    RefreshStats(g_profiler->tracks[g_profiler->statsCursor++ % g_profiler->trackCount]);
+}
+
+// Indented name, then cur/avg/min/max/p99 columns. Without a track only the column titles are written.
+auto FormatScopeRow(span<uint8_t> out, uint32_t depth, byteview name, const scope_track *t, uint64_t curUs)
+    -> uint64_t
+{
+    constexpr uint32_t kIndent = 2;
+    constexpr uint32_t kNameCols = 24;
+
+    uint64_t n = 0;
+    for (uint32_t i = 0; i < depth * kIndent && n < kNameCols - 1; ++i)
+        out[n++] = ' ';
+    const uint64_t nameN = Min<uint64_t>(name.size, kNameCols - 1 - n);
+    MemCpy(out.data + n, name.data, nameN);
+    n += nameN;
+    while (n < kNameCols)
+        out[n++] = ' ';
+
+    const span<uint8_t> rest{out.data + n, out.size - n};
+    if (!t)
+        return n + StringWriteFmt(rest, "    cur     avg     min     max     p99"_s);
+
+    const double avgMs = t->present ? (double)t->sumUs / t->present * 1e-3 : 0.0;
+    return n + StringWriteFmt(rest, "%7.2f %7.2f %7.2f %7.2f %7.2f"_s, (double)curUs * 1e-3, avgMs,
+                              (double)t->minUs * 1e-3, (double)t->maxUs * 1e-3, (double)t->p99Us * 1e-3);
+}
+
+// Frame times of the last cols frames as bars, newest on the right, one cell of height per kGraphRows-th of the
+// scale. Returns the scale: the slowest frame shown, at least the spike threshold.
+auto DrawGraph(uint32_t row0, uint32_t cols, uint32_t bgRgba) -> uint32_t
+{
+    constexpr uint32_t kBarRgba = 0xFF60C060u;
+    constexpr uint32_t kSpikeRgba = 0xFF4040E0u;
+
+    const scope_track &t = g_profiler->tracks[0];
+    const uint32_t frames = Min(g_profiler->historyPos, Min(cols, kHistoryFrames));
+    const uint32_t spikeUs = (uint32_t)(g_profiler->spikeMs * 1e3f);
+
+    uint32_t scaleUs = Max(spikeUs, 1u);
+    for (uint32_t i = 0; i < frames; ++i)
+        scaleUs = Max(scaleUs, t.history[(g_profiler->historyPos - 1 - i) % kHistoryFrames]);
+
+    const uint16_t space = CellRenderer::GlyphForCodepoint(' ');
+    for (uint32_t col = 0; col < cols; ++col)
+    {
+        uint32_t v = 0;
+        if (col + frames >= cols)
+            v = t.history[(g_profiler->historyPos - cols + col) % kHistoryFrames];
+
+        // Rounded to the nearest cell, but a frame that ran always shows.
+        uint32_t height = (uint32_t)(((uint64_t)v * kGraphRows * 2 + scaleUs) / (scaleUs * 2));
+        if (v && !height)
+            height = 1;
+
+        const uint32_t barRgba = v > spikeUs ? kSpikeRgba : kBarRgba;
+        for (uint32_t r = 0; r < kGraphRows; ++r)
+        {
+            const cell_attr cell{
+                .glyphIndex = space,
+                .flags = 0,
+                .fgRgba = barRgba,
+                .bgRgba = r < height ? barRgba : bgRgba,
+            };
+            CellRenderer::PutCell(col, row0 + kGraphRows - 1 - r, cell);
+        }
+    }
+
+    return scaleUs;
+}
+
+// Room for the longest event with a fully escaped name.
+constexpr inline uint64_t kMaxTraceEventSize = 512;
+
+void TraceFlush(trace_writer &w)
+{
+    if (w.size)
+        FileWrite(w.file, (uint32_t)w.size, w.buf);
+    w.size = 0;
+}
+
+void TraceEmit(trace_writer &w, byteview fmt, ...)
+{
+    if (sizeof(w.buf) - w.size < kMaxTraceEventSize)
+        TraceFlush(w);
+
+    va_list args;
+    va_start(args, fmt);
+    w.size += StringWriteFmt_(span<uint8_t>{w.buf + w.size, sizeof(w.buf) - w.size}, fmt, args);
+    va_end(args);
+}
+
+void TraceEmitString(trace_writer &w, byteview s)
+{
+    w.buf[w.size++] = '"';
+    for (uint64_t i = 0; i < s.size; ++i)
+    {
+        const uint8_t ch = s[i];
+        if (ch == '"' || ch == '\\')
+        {
+            w.buf[w.size++] = '\\';
+            w.buf[w.size++] = ch;
+        }
+        else if (ch < 0x20)
+            w.size += StringWriteFmt(span<uint8_t>{w.buf + w.size, 6}, "\\u%04x"_s, ch);
+        else
+            w.buf[w.size++] = ch;
+    }
+    w.buf[w.size++] = '"';
+}
+
+void TraceEmitEvent(trace_writer &w, const char *ph, uint32_t nameId, double ts, uint32_t tid)
+{
+    TraceEmit(w, "%s{\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"name\":"_s, w.eventCount ? ",\n" : "", ph, ts,
+              tid);
+    TraceEmitString(w, NameView(g_profiler->names[nameId]));
+    w.buf[w.size++] = '}';
+    ++w.eventCount;
+}
+
+// Unmatched ends (scopes opened before the capture) are dropped, scopes still open at the end are closed there.
+void WriteTrace(uint64_t endTsc, uint64_t endNs)
+{
+    const uint64_t gen = g_profiler->captureGen;
+
+    uint8_t pathBuf[64]{};
+    const uint64_t pathSize =
+        StringWriteFmt(span<uint8_t>{pathBuf, sizeof(pathBuf) - 1}, "nyla-trace-%u.json"_s, (uint32_t)gen);
+    const byteview path{pathBuf, pathSize};
+
+    file_handle file = FileOpen(path, FileOpenMode::Write);
+    if (!FileValid(file))
+    {
+        LOG("profiler: could not open " SV_FMT, SV_ARG(path));
+        return;
+    }
+
+    const uint64_t ticks = Max<uint64_t>(endTsc - g_profiler->captureStartTsc, 1);
+    const double usPerTick = (double)(endNs - g_profiler->captureStartNs) * 1e-3 / (double)ticks;
+    const double endUs = (double)ticks * usPerTick;
+
+    trace_writer &w = *g_profiler->writer;
+    w.file = file;
+    w.size = 0;
+    w.eventCount = 0;
+    TraceEmit(w, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"_s);
+
+    const uint32_t threadCount = AtomicLoad32(&g_profiler->threadCount);
+    uint32_t truncated = 0;
+    for (uint32_t tid = 0; tid < threadCount; ++tid)
+    {
+        const profile_thread &t = g_profiler->threads[tid];
+        const uint64_t cursor = AtomicLoad64(&t.cursor);
+        if ((cursor >> 32) != gen)
+            continue;
+
+        const uint32_t count = (uint32_t)cursor;
+        truncated += count == kMaxEvents;
+
+        TraceEmit(w, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":"_s,
+                  w.eventCount ? ",\n" : "", tid);
+        TraceEmitString(w, NameView(t.name));
+        TraceEmit(w, "}}"_s);
+        ++w.eventCount;
+
+        uint32_t stack[kMaxStack * 8];
+        uint32_t depth = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const profile_event &e = t.events[i];
+            const double ts = e.tsc > g_profiler->captureStartTsc
+                                  ? (double)(e.tsc - g_profiler->captureStartTsc) * usPerTick
+                                  : 0.0;
+            if (e.kind == profile_event_kind::Begin)
+            {
+                if (depth < sizeof(stack) / sizeof(stack[0]))
+                {
+                    stack[depth++] = e.nameId;
+                    TraceEmitEvent(w, "B", e.nameId, ts, tid);
+                }
+            }
+            else if (depth)
+                TraceEmitEvent(w, "E", stack[--depth], ts, tid);
+        }
+        while (depth)
+            TraceEmitEvent(w, "E", stack[--depth], endUs, tid);
+    }
+
+    TraceEmit(w, "\n]}\n"_s);
+    TraceFlush(w);
+    FileClose(file);
+
+    LOG("profiler: %" PRIu64 " events over %.3f ms to " SV_FMT "%s", w.eventCount, endUs * 1e-3, SV_ARG(path),
+        truncated ? " (some threads ran out of event space)" : "");
+}
+
 } // namespace
 
 namespace Profiler
@@ -74,6 +563,29 @@ void API Bootstrap()
     g_profiler->lastFrameUs = 0;
     g_profiler->overflowCount = 0;
     g_profiler->visible = true;
+
+    StoreName(g_profiler->names[0], "(names full)"_s);
+    g_profiler->nameCount = 1;
+    g_profiler->mutex = PlatformMutex::Create(RegionAlloc::g_BootstrapAlloc);
+    g_profiler->eventAlloc = RegionAlloc::Create(kMaxThreads * kMaxEvents * sizeof(profile_event), 0);
+    g_profiler->writer = &RegionAlloc::Alloc<trace_writer>(RegionAlloc::g_BootstrapAlloc);
+
+    g_profiler->captureFrames = 120;
+    Tunables::RegisterInt("profiler.captureFrames"_s, &g_profiler->captureFrames, 30, 1, 3600);
+    g_profiler->frameNameId = InternName("frame"_s);
+
+    uint32_t *history =
+        RegionAlloc::AllocArrayUninit<uint32_t>(RegionAlloc::g_BootstrapAlloc, kMaxTracks * kHistoryFrames).data;
+    for (uint32_t i = 0; i < kMaxTracks; ++i)
+        g_profiler->tracks[i].history = history + i * kHistoryFrames;
+    TrackFor(g_profiler->frameNameId);
+
+    g_profiler->spikeMs = 33.f;
+    Tunables::RegisterFloat("profiler.spikeMs"_s, &g_profiler->spikeMs, 1.f, 1.f, 1000.f);
+
+    t_isMainThread = true;
+    if (!t_threadName.size)
+        StoreName(t_threadName, "main"_s);
 }
 
 void API FrameBegin()
@@ -84,6 +596,18 @@ void API FrameBegin()
     g_profiler->stackDepth = 0;
     g_profiler->overflowCount = 0;
     g_profiler->frameStartUs = GetMonotonicTimeMicros();
+
+    if (g_profiler->captureRequested)
+    {
+        g_profiler->captureRequested = false;
+        g_profiler->captureFramesLeft = g_profiler->captureFrames;
+        g_profiler->captureStartNs = GetMonotonicTimeNanos();
+        g_profiler->captureStartTsc = ReadTimestampCounter();
+        AtomicStore32(&g_profiler->captureGen, g_profiler->captureGen + 1);
+        AtomicStore32(&g_profiler->capturing, 1);
+    }
+    if (g_profiler->capturing)
+        Record(g_profiler->frameNameId, profile_event_kind::Begin);
 }
 
 void API FrameEnd()
@@ -101,41 +625,116 @@ void API FrameEnd()
         e.durationUs = now - e.startUs;
     }
 
-    const uint32_t n = Min<uint32_t>(g_profiler->currentCount, kMaxEntries);
-    for (uint32_t i = 0; i < n; ++i)
-        g_profiler->display[i] = g_profiler->current[i];
-    g_profiler->displayCount = n;
+    if (!g_profiler->frozen)
+    {
+        const uint32_t n = Min<uint32_t>(g_profiler->currentCount, kMaxEntries);
+        for (uint32_t i = 0; i < n; ++i)
+            g_profiler->display[i] = g_profiler->current[i];
+        g_profiler->displayCount = n;
+        g_profiler->displayFrameUs = g_profiler->lastFrameUs;
+        RecordHistory();
+
+        if (g_profiler->spikeArmed && (double)g_profiler->lastFrameUs > (double)g_profiler->spikeMs * 1e3)
+        {
+            g_profiler->spikeArmed = false;
+            g_profiler->frozen = true;
+        }
+    }
+
+    if (g_profiler->capturing)
+    {
+        Record(g_profiler->frameNameId, profile_event_kind::End);
+        if (--g_profiler->captureFramesLeft <= 0)
+        {
+            AtomicStore32(&g_profiler->capturing, 0);
+            const uint64_t endTsc = ReadTimestampCounter();
+            WriteTrace(endTsc, GetMonotonicTimeNanos());
+        }
+    }
 }
 
-void API BeginScope(byteview name)
+auto API InternName(byteview name) -> uint32_t
 {
     if (!g_profiler)
-        return;
-    if (g_profiler->currentCount >= kMaxEntries || g_profiler->stackDepth >= kMaxStack)
+        return 0;
+
+    name.size = Min<uint64_t>(name.size, kNameCap);
+    const uint32_t h = HashName(name);
+
+    uint32_t id;
+    ProbeName(name, h, id);
+    if (id)
+        return id;
+
+    PlatformMutex::Lock(*g_profiler->mutex);
+    const uint32_t slot = ProbeName(name, h, id);
+    if (!id && g_profiler->nameCount < kMaxNames)
     {
-        ++g_profiler->overflowCount;
-        return;
+        id = g_profiler->nameCount;
+        StoreName(g_profiler->names[id], name);
+        AtomicStore32(&g_profiler->nameCount, id + 1);
+        AtomicStore32(&g_profiler->nameSlots[slot], id);
     }
+    PlatformMutex::Unlock(*g_profiler->mutex);
 
-    const uint16_t idx = (uint16_t)g_profiler->currentCount++;
-    auto &e = g_profiler->current[idx];
-    StoreName(e.name, name);
-    e.startUs = GetMonotonicTimeMicros();
-    e.durationUs = 0;
-    e.depth = g_profiler->stackDepth;
-    g_profiler->stack[g_profiler->stackDepth++] = idx;
+    return id;
+}
+
+void API BeginScope(uint32_t nameId)
+{
+    if (!g_profiler)
+        return;
+    if (t_isMainThread)
+        OverlayBegin(nameId);
+    if (AtomicLoad32(&g_profiler->capturing))
+        Record(nameId, profile_event_kind::Begin);
+}
+
+void API BeginScope(byteview name)
+{
+    if (!g_profiler)
+        return;
+    BeginScope(InternName(name));
 }
 
 void API EndScope()
 {
     if (!g_profiler)
         return;
-    if (g_profiler->stackDepth == 0)
+    if (t_isMainThread)
+        OverlayEnd();
+    if (AtomicLoad32(&g_profiler->capturing))
+        Record(0, profile_event_kind::End);
+}
+
+void API SetThreadName(byteview name)
+{
+    StoreName(t_threadName, name);
+}
+
+void API Capture()
+{
+    if (!g_profiler || g_profiler->capturing)
         return;
+    g_profiler->captureRequested = true;
+}
 
-    const uint16_t idx = g_profiler->stack[--g_profiler->stackDepth];
-    auto &e = g_profiler->current[idx];
-    e.durationUs = GetMonotonicTimeMicros() - e.startUs;
+auto API IsCapturing() -> bool
+{
+    return g_profiler && (g_profiler->capturing || g_profiler->captureRequested);
+}
+
+void API ToggleSpikeCapture()
+{
+    if (!g_profiler)
+        return;
+    if (g_profiler->frozen)
+    {
+        g_profiler->frozen = false;
+        g_profiler->spikeArmed = true;
+    }
+    else
+        g_profiler->spikeArmed = !g_profiler->spikeArmed;
 }
 
 void API ToggleVisible()
@@ -156,13 +755,10 @@ void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY, uint32_
         return;
 
     constexpr uint32_t kCols = 64;
-    constexpr uint32_t kIndent = 2;
-    constexpr uint32_t kHeaderRows = 1;
+    constexpr uint32_t kHeaderRows = 1 + kGraphRows + 2;
 
-    const uint32_t scopeRows = Min<uint32_t>(g_profiler->displayCount, kMaxEntries);
+    const uint32_t scopeRows = 1 + Min<uint32_t>(g_profiler->displayCount, kMaxEntries);
     const uint32_t rows = kHeaderRows + scopeRows;
-    if (!rows)
-        return;
 
     const uint32_t headerFg = 0xFFFFFF80u;
     const uint32_t headerBg = 0xFF202020u;
@@ -171,28 +767,46 @@ void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY, uint32_
 
     CellRenderer::Begin(originPxX, originPxY, kCols, rows);
 
-    const double frameMs = (double)g_profiler->lastFrameUs * 1e-3;
+    const double frameMs = (double)g_profiler->displayFrameUs * 1e-3;
     uint8_t headerBuf[128];
-    const uint64_t headerN = StringWriteFmt(span<uint8_t>{headerBuf, sizeof(headerBuf)},
-                                            "profiler (F7 hide)  frame %f ms  %u fps"_s, frameMs, fps);
+    uint64_t headerN;
+    if (g_profiler->capturing)
+        headerN = StringWriteFmt(span<uint8_t>{headerBuf, sizeof(headerBuf)},
+                                 "profiler (capturing, %d frames left)  frame %f ms  %u fps"_s,
+                                 g_profiler->captureFramesLeft, frameMs, fps);
+    else if (g_profiler->frozen)
+        headerN = StringWriteFmt(span<uint8_t>{headerBuf, sizeof(headerBuf)},
+                                 "profiler (FROZEN on a %.2f ms spike, F9 resume)"_s, frameMs);
+    else
+        headerN = StringWriteFmt(span<uint8_t>{headerBuf, sizeof(headerBuf)},
+                                 "profiler (F7 hide, F8 capture, F9 spike %s)  frame %f ms  %u fps"_s,
+                                 g_profiler->spikeArmed ? "on" : "off", frameMs, fps);
     CellRenderer::Text(0, 0, byteview{headerBuf, headerN}, headerFg, headerBg);
 
-    for (uint32_t i = 0; i < scopeRows; ++i)
-    {
-        const auto &e = g_profiler->display[i];
-        const double ms = (double)e.durationUs * 1e-3;
+    const uint32_t scaleUs = DrawGraph(1, kCols, rowBg);
 
-        uint8_t lineBuf[160];
-        uint32_t col = 0;
-        for (uint8_t d = 0; d < e.depth && col < (uint32_t)sizeof(lineBuf); ++d)
-        {
-            for (uint32_t k = 0; k < kIndent && col < (uint32_t)sizeof(lineBuf); ++k)
-                lineBuf[col++] = ' ';
-        }
+    uint8_t lineBuf[160];
+    uint64_t lineN = StringWriteFmt(span<uint8_t>{lineBuf, sizeof(lineBuf)},
+                                    "last %u frames, graph top %.2f ms, spike > %.2f ms"_s,
+                                    Min<uint32_t>(g_profiler->historyPos, kCols), (double)scaleUs * 1e-3,
+                                    (double)g_profiler->spikeMs);
+    CellRenderer::Text(0, 1 + kGraphRows, byteview{lineBuf, lineN}, rowFg, rowBg);
 
-        const uint64_t bodyN = StringWriteFmt(span<uint8_t>{lineBuf + col, (uint64_t)sizeof(lineBuf) - col},
-                                              "%.*s  %f ms"_s, e.name.size, e.name.data.data, ms);
-        CellRenderer::Text(0, i + 1, byteview{lineBuf, col + bodyN}, rowFg, rowBg);
+    lineN = FormatScopeRow(span<uint8_t>{lineBuf, sizeof(lineBuf)}, 0, "scope (ms)"_s, nullptr, 0);
+    CellRenderer::Text(0, 2 + kGraphRows, byteview{lineBuf, lineN}, headerFg, headerBg);
+
+    lineN = FormatScopeRow(span<uint8_t>{lineBuf, sizeof(lineBuf)}, 0, "frame"_s, &g_profiler->tracks[0],
+                           g_profiler->displayFrameUs);
+    CellRenderer::Text(0, kHeaderRows, byteview{lineBuf, lineN}, rowFg, rowBg);
+
+    for (uint32_t i = 1; i < scopeRows; ++i)
+    {
+        const auto &e = g_profiler->display[i - 1];
+        const uint8_t slot = g_profiler->trackForName[e.nameId];
+        lineN = FormatScopeRow(span<uint8_t>{lineBuf, sizeof(lineBuf)}, e.depth + 1u,
+                               NameView(g_profiler->names[e.nameId]), slot ? &g_profiler->tracks[slot - 1] : nullptr,
+                               e.durationUs);
+        CellRenderer::Text(0, kHeaderRows + i, byteview{lineBuf, lineN}, rowFg, rowBg);
     }
 
     CellRenderer::CmdFlush(cmd);
@@ -200,4 +814,4 @@ void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY, uint32_
 
 } // namespace Profiler
 
-} // namespace nyla
\ No newline at end of file
+} // namespace nyla
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "nyla/commons/intrin.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/rhi.h"
 #include "nyla/commons/span_def.h"
@@ -12,23 +13,58 @@ namespace nyla
 namespace Profiler
 {
 
+// Registers the profiler.captureFrames tunable, so it goes after Tunables::Bootstrap.
 void API Bootstrap();
 
 void API FrameBegin();
 void API FrameEnd();
 
+// Ids are stable for the whole run. Lookups are lock-free, only the first sighting of a name takes a lock.
+auto API InternName(byteview name) -> uint32_t;
+
+// Any thread. The overlay follows the thread that called Bootstrap, a capture records every thread.
+void API BeginScope(uint32_t nameId);
 void API BeginScope(byteview name);
 void API EndScope();
 
+// Label for the calling thread in captures. Works before Bootstrap, taken at the thread's first captured scope.
+void API SetThreadName(byteview name);
+
+// Records the next profiler.captureFrames frames on every thread into per-thread buffers, then writes them out as
+// Chrome trace JSON (nyla-trace-N.json, loads in chrome://tracing and ui.perfetto.dev). Ignored while one is running.
+void API Capture();
+auto API IsCapturing() -> bool;
+
+// Arms a freeze of the overlay, graph and statistics on the first frame slower than profiler.spikeMs. While frozen,
+// resumes and re-arms.
+void API ToggleSpikeCapture();
+
 void API ToggleVisible();
 auto API IsVisible() -> bool;
 
+// Frame time graph, then every scope of the last frame with cur/avg/min/max/p99 over the last 256 frames.
 void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY, uint32_t fps);
 
+// For PROFILE_SCOPE, interns once per call site. Racing threads intern the same name, so a plain cache is enough.
+INLINE auto CachedName(uint32_t &cache, byteview name) -> uint32_t
+{
+    uint32_t id = AtomicLoad32(&cache);
+    if (!id)
+    {
+        id = InternName(name);
+        AtomicStore32(&cache, id);
+    }
+    return id;
+}
+
 } // namespace Profiler
 
 struct profile_scope
 {
+    profile_scope(uint32_t nameId)
+    {
+        Profiler::BeginScope(nameId);
+    }
     profile_scope(byteview name)
     {
         Profiler::BeginScope(name);
@@ -46,7 +82,8 @@ struct profile_scope
 #define PROFILE_SCOPE_PASTE_2(a, b) a##b
 #define PROFILE_SCOPE_PASTE(a, b) PROFILE_SCOPE_PASTE_2(a, b)
 #define PROFILE_SCOPE(NAME_LIT)                                                                                        \
+    static uint32_t PROFILE_SCOPE_PASTE(_psid_, __LINE__);                                                             \
     ::nyla::profile_scope PROFILE_SCOPE_PASTE(_ps_, __LINE__)                                                          \
     {                                                                                                                  \
-        NAME_LIT##_s                                                                                                   \
+        ::nyla::Profiler::CachedName(PROFILE_SCOPE_PASTE(_psid_, __LINE__), NAME_LIT##_s)                              \
     }
@@ -0,0 +1,319 @@
+#include "nyla/commons/qoa.h"
+
+#include <cstdint>
+
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/span_def.h"
+#include "nyla/commons/word.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+constexpr uint32_t kLmsLen = 4;
+constexpr uint64_t kMagic = DWordBE("qoaf");
+
+// Residuals are quantized to round(residual / scalefactor) clamped to -8..8 and stored as 3 bits. Scalefactors grow
+// as (s + 1) ^ 2.75, dividing goes through a 16.16 reciprocal.
+constexpr int32_t kQuantTab[17] = {7, 7, 7, 5, 5, 3, 3, 1, 0, 0, 2, 2, 4, 4, 6, 6, 6};
+constexpr int32_t kReciprocalTab[16] = {65536, 9363, 3121, 1457, 781, 475, 311, 216,
+                                        156,   117,  90,   71,   57,  47,  39,  32};
+constexpr int32_t kDequantTab[16][8] = {
+    {1, -1, 3, -3, 5, -5, 7, -7},
+    {5, -5, 18, -18, 32, -32, 49, -49},
+    {16, -16, 53, -53, 95, -95, 147, -147},
+    {34, -34, 113, -113, 203, -203, 315, -315},
+    {63, -63, 210, -210, 378, -378, 588, -588},
+    {104, -104, 345, -345, 621, -621, 966, -966},
+    {158, -158, 528, -528, 950, -950, 1477, -1477},
+    {228, -228, 760, -760, 1368, -1368, 2128, -2128},
+    {316, -316, 1053, -1053, 1895, -1895, 2947, -2947},
+    {422, -422, 1405, -1405, 2529, -2529, 3934, -3934},
+    {548, -548, 1828, -1828, 3290, -3290, 5117, -5117},
+    {696, -696, 2320, -2320, 4176, -4176, 6496, -6496},
+    {868, -868, 2893, -2893, 5207, -5207, 8099, -8099},
+    {1064, -1064, 3548, -3548, 6386, -6386, 9933, -9933},
+    {1286, -1286, 4288, -4288, 7718, -7718, 12005, -12005},
+    {1536, -1536, 5120, -5120, 9216, -9216, 14336, -14336},
+};
+
+struct qoa_lms
+{
+    int32_t history[kLmsLen];
+    int32_t weights[kLmsLen];
+};
+
+INLINE auto Predict(const qoa_lms &lms) -> int32_t
+{
+    int32_t prediction = 0;
+    for (uint32_t i = 0; i < kLmsLen; ++i)
+        prediction += lms.weights[i] * lms.history[i];
+    return prediction >> 13;
+}
+
+INLINE void Update(qoa_lms &lms, int32_t sample, int32_t residual)
+{
+    const int32_t delta = residual >> 4;
+    for (uint32_t i = 0; i < kLmsLen; ++i)
+        lms.weights[i] += lms.history[i] < 0 ? -delta : delta;
+    for (uint32_t i = 0; i < kLmsLen - 1; ++i)
+        lms.history[i] = lms.history[i + 1];
+    lms.history[kLmsLen - 1] = sample;
+}
+
+INLINE auto ClampS16(int32_t v) -> int32_t
+{
+    return Clamp(v, -32768, 32767);
+}
+
+// Rounds away from zero.
+INLINE auto Div(int32_t v, uint32_t scalefactor) -> int32_t
+{
+    const int32_t n = (v * kReciprocalTab[scalefactor] + (1 << 15)) >> 16;
+    return n + ((v > 0) - (v < 0)) - ((n > 0) - (n < 0));
+}
+
+INLINE auto ReadU64(const uint8_t *p) -> uint64_t
+{
+    return ByteSwap64(LoadU<uint64_t>(p));
+}
+
+INLINE void WriteU64(uint8_t *p, uint64_t v)
+{
+    WriteU(p, ByteSwap64(v));
+}
+
+// Every sample depends on the one before it through the predictor, so a channel decodes at the latency of that
+// chain. The channels of a slice are independent, decoding them side by side keeps more of the core busy. Ch is zero
+// for channel counts other than mono and stereo.
+template <uint32_t Ch>
+void DecodeSlices(const uint8_t *p, qoa_lms *lms, uint32_t channels, uint32_t frameLen, int16_t *out)
+{
+    if constexpr (Ch != 0)
+        channels = Ch;
+
+    for (uint32_t sampleIndex = 0; sampleIndex < frameLen; sampleIndex += kQoaSliceLen)
+    {
+        uint64_t slice[kQoaMaxChannels];
+        const int32_t *dequant[kQoaMaxChannels];
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            slice[c] = ReadU64(p + c * 8) << 4;
+            dequant[c] = kDequantTab[ReadU64(p + c * 8) >> 60];
+        }
+        p += channels * 8;
+
+        const uint32_t sliceLen = Min(kQoaSliceLen, frameLen - sampleIndex);
+        int16_t *dst = out + (uint64_t)sampleIndex * channels;
+        for (uint32_t i = 0; i < sliceLen; ++i)
+        {
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                const int32_t predicted = Predict(lms[c]);
+                const int32_t dequantized = dequant[c][slice[c] >> 61];
+                const int32_t reconstructed = ClampS16(predicted + dequantized);
+                dst[i * channels + c] = (int16_t)reconstructed;
+                slice[c] <<= 3;
+                Update(lms[c], reconstructed, dequantized);
+            }
+        }
+    }
+}
+
+auto FrameSize(uint32_t channels, uint32_t numSlices) -> uint64_t
+{
+    return 8 + kLmsLen * 4 * channels + 8 * numSlices * channels;
+}
+
+} // namespace
+
+namespace Qoa
+{
+
+auto API EncodeBound(uint32_t numFrames, uint32_t channels) -> uint64_t
+{
+    const uint64_t numQoaFrames = (numFrames + kQoaFrameLen - 1) / kQoaFrameLen;
+    const uint64_t numSlices = (numFrames + kQoaSliceLen - 1) / kQoaSliceLen;
+    return kQoaFileHeaderSize + numQoaFrames * FrameSize(channels, 0) + numSlices * channels * 8;
+}
+
+auto API Encode(const int16_t *pcm, const qoa_desc &desc, span<uint8_t> out) -> uint64_t
+{
+    const uint32_t channels = desc.channels;
+    ASSERT(channels > 0 && channels <= kQoaMaxChannels);
+    ASSERT(desc.sampleRate > 0 && desc.sampleRate < (1 << 24));
+    ASSERT(out.size >= EncodeBound(desc.numFrames, channels));
+
+    uint8_t *p = out.data;
+    WriteU64(p, kMagic << 32 | desc.numFrames);
+    p += 8;
+
+    qoa_lms lms[kQoaMaxChannels];
+    uint32_t prevScalefactor[kQoaMaxChannels];
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        lms[c] = qoa_lms{.weights = {0, 0, -(1 << 13), 1 << 14}};
+        prevScalefactor[c] = 0;
+    }
+
+    for (uint32_t frameStart = 0; frameStart < desc.numFrames; frameStart += kQoaFrameLen)
+    {
+        const uint32_t frameLen = Min(kQoaFrameLen, desc.numFrames - frameStart);
+        const uint32_t numSlices = (frameLen + kQoaSliceLen - 1) / kQoaSliceLen;
+        const int16_t *in = pcm + (uint64_t)frameStart * channels;
+
+        WriteU64(p, (uint64_t)channels << 56 | (uint64_t)desc.sampleRate << 32 | (uint64_t)frameLen << 16 |
+                        FrameSize(channels, numSlices));
+        p += 8;
+
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            uint64_t history = 0;
+            uint64_t weights = 0;
+            for (uint32_t i = 0; i < kLmsLen; ++i)
+            {
+                history = history << 16 | (uint16_t)lms[c].history[i];
+                weights = weights << 16 | (uint16_t)lms[c].weights[i];
+            }
+            WriteU64(p, history);
+            WriteU64(p + 8, weights);
+            p += 16;
+        }
+
+        for (uint32_t sampleIndex = 0; sampleIndex < frameLen; sampleIndex += kQoaSliceLen)
+        {
+            const uint32_t sliceLen = Min(kQoaSliceLen, frameLen - sampleIndex);
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                // Every scalefactor, starting from the previous one since neighboring slices tend to agree. An
+                // attempt stops as soon as it is worse than the best so far. Large weights are penalized, they let
+                // the predictor run away on some inputs.
+                uint64_t bestError = UINT64_MAX;
+                uint64_t bestSlice = 0;
+                qoa_lms bestLms{};
+                uint32_t bestScalefactor = 0;
+
+                for (uint32_t attempt = 0; attempt < 16; ++attempt)
+                {
+                    const uint32_t scalefactor = (attempt + prevScalefactor[c]) & 15;
+                    qoa_lms trial = lms[c];
+                    uint64_t slice = scalefactor;
+                    uint64_t error = 0;
+
+                    for (uint32_t i = 0; i < sliceLen; ++i)
+                    {
+                        const int32_t sample = in[(sampleIndex + i) * channels + c];
+                        const int32_t predicted = Predict(trial);
+                        const int32_t scaled = Div(sample - predicted, scalefactor);
+                        const int32_t quantized = kQuantTab[Clamp(scaled, -8, 8) + 8];
+                        const int32_t dequantized = kDequantTab[scalefactor][quantized];
+                        const int32_t reconstructed = ClampS16(predicted + dequantized);
+
+                        int64_t penalty = ((int64_t)trial.weights[0] * trial.weights[0] +
+                                           (int64_t)trial.weights[1] * trial.weights[1] +
+                                           (int64_t)trial.weights[2] * trial.weights[2] +
+                                           (int64_t)trial.weights[3] * trial.weights[3]) >>
+                                              18;
+                        penalty = Max<int64_t>(penalty - 0x8FF, 0);
+
+                        const int64_t diff = sample - reconstructed;
+                        error += (uint64_t)(diff * diff) + (uint64_t)(penalty * penalty);
+                        if (error > bestError)
+                            break;
+
+                        Update(trial, reconstructed, dequantized);
+                        slice = slice << 3 | (uint64_t)quantized;
+                    }
+
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestSlice = slice;
+                        bestLms = trial;
+                        bestScalefactor = scalefactor;
+                    }
+                }
+
+                prevScalefactor[c] = bestScalefactor;
+                lms[c] = bestLms;
+
+                // A short last slice is padded with zero residuals.
+                WriteU64(p, bestSlice << ((kQoaSliceLen - sliceLen) * 3));
+                p += 8;
+            }
+        }
+    }
+
+    return (uint64_t)(p - out.data);
+}
+
+auto API ParseHeader(byteview blob, qoa_desc &out) -> bool
+{
+    if (blob.size < kQoaFileHeaderSize + 8)
+        return false;
+
+    const uint64_t fileHeader = ReadU64(blob.data);
+    if (fileHeader >> 32 != kMagic)
+        return false;
+
+    const uint64_t frameHeader = ReadU64(blob.data + kQoaFileHeaderSize);
+    out = qoa_desc{
+        .numFrames = (uint32_t)fileHeader,
+        .sampleRate = (uint32_t)(frameHeader >> 32) & 0xFFFFFF,
+        .channels = (uint32_t)(frameHeader >> 56),
+    };
+    return out.channels > 0 && out.channels <= kQoaMaxChannels && out.sampleRate > 0;
+}
+
+auto API DecodeFrame(byteview blob, const qoa_desc &desc, uint64_t offset, int16_t *out, uint32_t &numFrames)
+    -> uint64_t
+{
+    const uint32_t channels = desc.channels;
+    if (offset + 8 + kLmsLen * 4 * channels > blob.size)
+        return 0;
+
+    const uint8_t *p = blob.data + offset;
+    const uint64_t frameHeader = ReadU64(p);
+    const uint32_t frameLen = (uint32_t)(frameHeader >> 16) & 0xFFFF;
+    const uint32_t frameSize = (uint32_t)frameHeader & 0xFFFF;
+    if (frameHeader >> 56 != channels || ((frameHeader >> 32) & 0xFFFFFF) != desc.sampleRate ||
+        frameLen > kQoaFrameLen || frameSize < FrameSize(channels, (frameLen + kQoaSliceLen - 1) / kQoaSliceLen) ||
+        offset + frameSize > blob.size)
+    {
+        return 0;
+    }
+    p += 8;
+
+    qoa_lms lms[kQoaMaxChannels];
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        uint64_t history = ReadU64(p);
+        uint64_t weights = ReadU64(p + 8);
+        p += 16;
+        for (uint32_t i = 0; i < kLmsLen; ++i)
+        {
+            lms[c].history[i] = (int16_t)(history >> 48);
+            lms[c].weights[i] = (int16_t)(weights >> 48);
+            history <<= 16;
+            weights <<= 16;
+        }
+    }
+
+    if (channels == 1)
+        DecodeSlices<1>(p, lms, channels, frameLen, out);
+    else if (channels == 2)
+        DecodeSlices<2>(p, lms, channels, frameLen, out);
+    else
+        DecodeSlices<0>(p, lms, channels, frameLen, out);
+
+    numFrames = frameLen;
+    return offset + frameSize;
+}
+
+} // namespace Qoa
+
+} // namespace nyla
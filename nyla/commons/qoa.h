@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+// The Quite OK Audio format: 3.2 bits per sample, an LMS predictor per channel and frames of up to 5120 samples per
+// channel that each restart the predictor, so any frame decodes on its own. Blobs are plain .qoa files.
+constexpr inline uint32_t kQoaSliceLen = 20;
+constexpr inline uint32_t kQoaSlicesPerFrame = 256;
+constexpr inline uint32_t kQoaFrameLen = kQoaSliceLen * kQoaSlicesPerFrame;
+constexpr inline uint32_t kQoaMaxChannels = 8;
+constexpr inline uint32_t kQoaFileHeaderSize = 8;
+
+struct qoa_desc
+{
+    uint32_t numFrames; // samples per channel
+    uint32_t sampleRate;
+    uint32_t channels;
+};
+
+namespace Qoa
+{
+
+// Enough for Encode of numFrames interleaved frames.
+auto API EncodeBound(uint32_t numFrames, uint32_t channels) -> uint64_t;
+
+// Interleaved int16 in, a complete .qoa file out. Returns the size written.
+auto API Encode(const int16_t *pcm, const qoa_desc &desc, span<uint8_t> out) -> uint64_t;
+
+// Reads the file header and the first frame header.
+auto API ParseHeader(byteview blob, qoa_desc &out) -> bool;
+
+// Decodes the frame at offset into interleaved int16, at most kQoaFrameLen frames. Returns the offset of the next
+// frame, or zero when the frame is truncated or does not match the file.
+auto API DecodeFrame(byteview blob, const qoa_desc &desc, uint64_t offset, int16_t *out, uint32_t &numFrames)
+    -> uint64_t;
+
+} // namespace Qoa
+
+} // namespace nyla
@@ -54,8 +54,9 @@ INLINE void Reset(region_alloc &self, void *p)
     self.at = (uint8_t *)p;
 }
 
+// Leaves the memory as is, for buffers that are fully written before they are read.
 [[nodiscard]]
-INLINE auto Alloc(region_alloc &self, uint64_t size, uint64_t align) -> uint8_t *
+INLINE auto AllocUninit(region_alloc &self, uint64_t size, uint64_t align) -> uint8_t *
 {
     self.at = AlignedUp(self.at, Max(align, kMinAlign));
     uint8_t *const ret = self.at;
@@ -75,6 +76,13 @@ INLINE auto Alloc(region_alloc &self, uint64_t size, uint64_t align) -> uint8_t
         CommitMemPages(oldCommitedEnd, self.commitedEnd - oldCommitedEnd);
     }
 
+    return ret;
+}
+
+[[nodiscard]]
+INLINE auto Alloc(region_alloc &self, uint64_t size, uint64_t align) -> uint8_t *
+{
+    uint8_t *const ret = AllocUninit(self, size, align);
     MemZero(ret, size);
     return ret;
 }
@@ -95,6 +103,14 @@ INLINE auto AllocArray(region_alloc &self, uint64_t n) -> span<T>
     return span<T>{(T *)mem, n};
 }
 
+template <typename T>
+[[nodiscard]]
+INLINE auto AllocArrayUninit(region_alloc &self, uint64_t n) -> span<T>
+{
+    uint8_t *mem = AllocUninit(self, sizeof(T) * n, required_align_v<T>);
+    return span<T>{(T *)mem, n};
+}
+
 template <typename T>
 [[nodiscard]]
 INLINE auto AllocArray(region_alloc &self, span<T> data) -> span<T>
@@ -3,11 +3,19 @@
 #include <cstdint>
 
 #include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/asset_file_format.h"
+#include "nyla/commons/byteliterals.h"
+#include "nyla/commons/gpu_upload.h"
+#include "nyla/commons/handle.h"
 #include "nyla/commons/inline_vec.h"
 #include "nyla/commons/inline_vec_def.h"
+#include "nyla/commons/intrin.h"
 #include "nyla/commons/macros.h"
 #include "nyla/commons/mat.h"
 #include "nyla/commons/math.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/mesh_manager.h"
+#include "nyla/commons/minmax.h"
 #include "nyla/commons/pipeline_cache.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/region_alloc_def.h"
@@ -15,6 +23,7 @@
 #include "nyla/commons/sampler_manager.h"
 #include "nyla/commons/span.h"
 #include "nyla/commons/texture_manager.h"
+#include "nyla/commons/tunables.h"
 #include "nyla/commons/vec.h"
 
 namespace nyla
@@ -23,75 +32,424 @@ namespace nyla
 namespace
 {
 
+constexpr uint32_t kMaxInstances = 128 * 1024;
+constexpr uint32_t kMaxTransientInstances = 256;
+constexpr uint32_t kNoVertexFormat = 0xFFFFFFFF;
+constexpr uint32_t kNumGroups = MeshManager::kMaxMeshes * MeshManager::kMaxLods;
+
+// Share of the per-frame staging buffer instance uploads may take, the rest stays dirty until the next frame.
+constexpr uint64_t kInstanceUploadBudget = 2_MiB;
+
+// A level is used while its simplification error projects to at most this many pixels (scaled by the lod bias).
+constexpr float kLodPixelError = 1.f;
+// Keeps instances at or behind the camera plane at the finest level.
+constexpr float kLodMinW = 1e-3f;
+// Clean instances whose level is rechecked per frame, so camera, bias and mesh upload changes settle over a few
+// frames instead of every instance being visited every frame.
+constexpr uint32_t kLodSweepPerFrame = 8192;
+
 struct scene // Per Frame
 {
     float4x4 vp;
     float4x4 invVp;
 };
 
-struct entity
+struct gpu_instance // Per Instance vertex stream
 {
     float4x4 model;
     uint32_t srvTextureIndex;
     uint32_t samplerIndex;
+    uint32_t pad0;
+    uint32_t pad1;
 };
+static_assert(sizeof(gpu_instance) == 80);
 
 struct draw_call
 {
-    entity Entity;
     mesh_handle Mesh;
+    float3 Pos;
+    float3 Scale;
+};
+
+struct lod_view
+{
+    float4 wRow;      // clip space w of a world position
+    float errorScale; // pixels per world unit at w = 1, relative to the pixel threshold; 0 keeps the finest level
+};
+
+struct instance_slot
+{
+    uint32_t gen;
+    uint32_t dense; // next free slot while unused
+    bool used;
 };
 
 struct renderer_state
 {
     float4x4 View;
     float4x4 Proj;
-    pipeline_cache_handle Pipeline;
-    inline_vec<draw_call, 256> DrawQueue;
+    float ViewportHeight; // 0 until set through SetOrthoProjection or SetPerspectiveProjection
+    float LodBias;
+    array<pipeline_cache_handle, 2> Pipelines; // by mesh_blob_vertex_format
+
+    // Retained instances, dense and grouped by mesh index then lod so every group is one instanced draw.
+    span<float3> Pos;
+    span<float3> Scale;
+    span<float> Rotation;
+    span<mesh_handle> Meshes;
+    span<texture_handle> Textures;
+    span<uint8_t> Lods;
+    span<uint32_t> DenseToSlot;
+    span<uint64_t> Dirty;
+    uint32_t DirtyCursor; // word the next upload starts at, so a budget cut does not starve later instances
+    array<uint32_t, kNumGroups + 1> GroupBegin;
+    span<uint32_t> LodQueue; // slots of the dirty instances, which moves do not reorder
+    uint32_t LodCursor;      // next instance the lod sweep rechecks
+
+    span<instance_slot> Slots;
+    uint32_t FreeSlot;
+    uint32_t SlotsUsed;
+
+    rhi_buffer InstanceBuffer;
+
+    rhi_buffer TransientBuffer;
+    inline_vec<draw_call, kMaxTransientInstances> DrawQueue;
+
+    // BootstrapHeadless, instances are written here instead of to the GPU.
+    bool Headless;
+    span<gpu_instance> HeadlessInstances;
+    span<gpu_instance> HeadlessTransient;
 };
 renderer_state *renderer;
 
-} // namespace
+auto InstanceCount() -> uint32_t
+{
+    return renderer->GroupBegin[kNumGroups];
+}
 
-namespace Renderer
+auto GroupOf(mesh_handle mesh, uint32_t lod) -> uint32_t
 {
+    return mesh.index * MeshManager::kMaxLods + lod;
+}
 
-void API Bootstrap(region_alloc &)
+void MarkDirty(uint32_t dense)
 {
-    renderer = &RegionAlloc::Alloc<renderer_state>(RegionAlloc::g_BootstrapAlloc);
+    renderer->Dirty[dense / 64] |= uint64_t{1} << (dense % 64);
+}
+
+void MoveInstance(uint32_t dst, uint32_t src)
+{
+    renderer->Pos[dst] = renderer->Pos[src];
+    renderer->Scale[dst] = renderer->Scale[src];
+    renderer->Rotation[dst] = renderer->Rotation[src];
+    renderer->Meshes[dst] = renderer->Meshes[src];
+    renderer->Textures[dst] = renderer->Textures[src];
+    renderer->Lods[dst] = renderer->Lods[src];
+
+    const uint32_t slot = renderer->DenseToSlot[src];
+    renderer->DenseToSlot[dst] = slot;
+    renderer->Slots[slot].dense = dst;
+
+    MarkDirty(dst);
+}
+
+// Opens a hole at the end of the group by shifting every following group up by one element.
+auto InsertDense(uint32_t group) -> uint32_t
+{
+    ASSERT(InstanceCount() < kMaxInstances);
+    ++renderer->GroupBegin[kNumGroups];
+
+    for (uint32_t g = kNumGroups - 1; g > group; --g)
+    {
+        const uint32_t begin = renderer->GroupBegin[g];
+        const uint32_t end = renderer->GroupBegin[g + 1] - 1;
+        if (begin != end)
+            MoveInstance(end, begin);
+        renderer->GroupBegin[g] = begin + 1;
+    }
+
+    return renderer->GroupBegin[group + 1] - 1;
+}
+
+void RemoveDense(uint32_t dense, uint32_t group)
+{
+    uint32_t hole = renderer->GroupBegin[group + 1] - 1;
+    if (dense != hole)
+        MoveInstance(dense, hole);
+
+    for (uint32_t g = group + 1; g < kNumGroups; ++g)
+    {
+        const uint32_t begin = renderer->GroupBegin[g];
+        const uint32_t end = renderer->GroupBegin[g + 1];
+        renderer->GroupBegin[g] = begin - 1;
+
+        if (begin != end)
+        {
+            MoveInstance(hole, end - 1);
+            hole = end - 1;
+        }
+    }
+
+    --renderer->GroupBegin[kNumGroups];
+}
+
+void SwapInstances(uint32_t a, uint32_t b)
+{
+    if (a == b)
+        return;
+
+    const float3 pos = renderer->Pos[a];
+    const float3 scale = renderer->Scale[a];
+    const float rotation = renderer->Rotation[a];
+    const mesh_handle mesh = renderer->Meshes[a];
+    const texture_handle texture = renderer->Textures[a];
+    const uint8_t lod = renderer->Lods[a];
+    const uint32_t slot = renderer->DenseToSlot[a];
+
+    MoveInstance(a, b);
+
+    renderer->Pos[b] = pos;
+    renderer->Scale[b] = scale;
+    renderer->Rotation[b] = rotation;
+    renderer->Meshes[b] = mesh;
+    renderer->Textures[b] = texture;
+    renderer->Lods[b] = lod;
+    renderer->DenseToSlot[b] = slot;
+    renderer->Slots[slot].dense = b;
+    MarkDirty(b);
+}
+
+// Walks the instance across the boundaries between two groups, swapping it with the edge element of every group
+// it leaves. Lods of one mesh are adjacent groups, so a lod change costs one swap per level.
+auto MoveToGroup(uint32_t dense, uint32_t from, uint32_t to) -> uint32_t
+{
+    for (; from < to; ++from)
+    {
+        const uint32_t last = --renderer->GroupBegin[from + 1];
+        SwapInstances(dense, last);
+        dense = last;
+    }
+    for (; from > to; --from)
+    {
+        const uint32_t first = renderer->GroupBegin[from]++;
+        SwapInstances(dense, first);
+        dense = first;
+    }
+    return dense;
+}
 
-    array<rhi_vertex_attribute_desc, 3> vertexAttributes{
+auto MakeLodView() -> lod_view
+{
+    const float4x4 vp = renderer->Proj * renderer->View;
+    const float projY = renderer->Proj[1][1] < 0 ? -renderer->Proj[1][1] : renderer->Proj[1][1];
+    const float threshold = kLodPixelError * Pow(2.f, renderer->LodBias);
+
+    return lod_view{
+        .wRow = {vp[0][3], vp[1][3], vp[2][3], vp[3][3]},
+        .errorScale = projY * renderer->ViewportHeight * .5f / threshold,
+    };
+}
+
+// Coarsest level whose error, scaled by the largest axis of the instance, stays under the pixel threshold.
+auto SelectLod(const lod_view &view, mesh_handle mesh, float3 pos, float3 scale) -> uint32_t
+{
+    const uint32_t lodCount = MeshManager::GetLodCount(mesh);
+    if (lodCount == 1 || view.errorScale == 0)
+        return 0;
+
+    const float w = view.wRow[0] * pos[0] + view.wRow[1] * pos[1] + view.wRow[2] * pos[2] + view.wRow[3];
+    float maxScale = 0;
+    for (uint32_t i = 0; i < 3; ++i)
+        maxScale = Max(maxScale, scale[i] < 0 ? -scale[i] : scale[i]);
+
+    const float pixelsPerError = maxScale * view.errorScale / Max(w, kLodMinW);
+
+    uint32_t lod = 0;
+    while (lod + 1 < lodCount && MeshManager::GetLodError(mesh, lod + 1) * pixelsPerError <= 1.f)
+        ++lod;
+    return lod;
+}
+
+// Moves only swap instances within their own groups, except the one at dense, so every pass places one more
+// instance in its group and the loop ends.
+void RefreshLod(const lod_view &view, uint32_t dense)
+{
+    const uint32_t firstGroup = renderer->Meshes[dense].index * MeshManager::kMaxLods;
+    for (;;)
+    {
+        const uint32_t lod = SelectLod(view, renderer->Meshes[dense], renderer->Pos[dense], renderer->Scale[dense]);
+        const uint32_t current = renderer->Lods[dense];
+        if (lod == current)
+            break;
+
+        const uint32_t moved = MoveToGroup(dense, firstGroup + current, firstGroup + lod);
+        renderer->Lods[moved] = uint8_t(lod);
+    }
+}
+
+// Dirty instances are placed right away, the rest are rechecked a slice per frame.
+void UpdateLods()
+{
+    const uint32_t count = InstanceCount();
+    if (!count)
+        return;
+
+    const lod_view view = MakeLodView();
+
+    // A move can carry an unchecked dirty instance past the scan, so they are queued by slot first.
+    uint32_t queued = 0;
+    const uint32_t numWords = (count + 63) / 64;
+    for (uint32_t word = 0; word < numWords; ++word)
+    {
+        uint64_t bits = renderer->Dirty[word];
+        while (bits)
+        {
+            const uint32_t dense = word * 64 + uint32_t(BitScanForward64(bits));
+            bits &= bits - 1;
+            if (dense >= count)
+                break;
+            renderer->LodQueue[queued++] = renderer->DenseToSlot[dense];
+        }
+    }
+    for (uint32_t i = 0; i < queued; ++i)
+        RefreshLod(view, renderer->Slots[renderer->LodQueue[i]].dense);
+
+    const uint32_t sweep = count < kLodSweepPerFrame ? count : kLodSweepPerFrame;
+    uint32_t dense = renderer->LodCursor < count ? renderer->LodCursor : 0;
+    for (uint32_t n = 0; n < sweep; ++n)
+    {
+        RefreshLod(view, dense);
+        if (++dense == count)
+            dense = 0;
+    }
+    renderer->LodCursor = dense;
+}
+
+// Keeps the lod, which has to match the group the instance sits in.
+void WriteInstance(uint32_t dense, const render_instance_desc &desc)
+{
+    renderer->Pos[dense] = desc.pos;
+    renderer->Scale[dense] = desc.scale;
+    renderer->Rotation[dense] = desc.rotation;
+    renderer->Meshes[dense] = desc.mesh;
+    renderer->Textures[dense] = desc.texture;
+    MarkDirty(dense);
+}
+
+auto ResolveSlot(render_instance instance) -> instance_slot &
+{
+    ASSERT(instance.gen && instance.index < kMaxInstances);
+    instance_slot &slot = renderer->Slots[instance.index];
+    ASSERT(slot.used && slot.gen == instance.gen);
+    return slot;
+}
+
+// Falls back to the mesh texture; false while the texture is not uploaded yet. Headless nothing is uploaded, every
+// instance gets the first view.
+auto ResolveSrv(mesh_handle mesh, texture_handle texture, rhi_srv &out) -> bool
+{
+    if (renderer->Headless)
+    {
+        out = {};
+        return true;
+    }
+
+    if (!texture)
+    {
+        texture = MeshManager::GetTexture(mesh);
+        if (!texture)
+            return false;
+    }
+
+    out = TextureManager::GetSRV(texture);
+    return bool(out);
+}
+
+// Meshes come grouped, so this only rebinds when the vertex format changes between groups.
+void CmdBindPipelineForMesh(rhi_cmdlist cmd, mesh_handle mesh, uint32_t &boundFormat)
+{
+    const uint32_t format = uint32_t(MeshManager::GetVertexFormat(mesh));
+    if (format == boundFormat)
+        return;
+
+    Rhi::CmdBindGraphicsPipeline(cmd, PipelineCache::Resolve(renderer->Pipelines[format]));
+    boundFormat = format;
+}
+
+// One pipeline per cooked vertex format, only the attribute formats differ and the shaders are shared.
+auto AcquirePipeline(mesh_blob_vertex_format vertexFormat) -> pipeline_cache_handle
+{
+    const bool quantized = vertexFormat == mesh_blob_vertex_format::Quantized;
+
+    array<rhi_vertex_attribute_desc, 8> vertexAttributes{
         rhi_vertex_attribute_desc{
             .binding = 0,
             .semantic = "POSITION0"_s,
-            .format = rhi_vertex_format::R32G32B32Float,
+            .format = quantized ? rhi_vertex_format::R16G16B16A16Float : rhi_vertex_format::R32G32B32Float,
             .offset = 0,
         },
         rhi_vertex_attribute_desc{
             .binding = 0,
             .semantic = "NORMAL0"_s,
-            .format = rhi_vertex_format::R32G32B32Float,
-            .offset = 12,
+            .format = quantized ? rhi_vertex_format::R16G16Snorm : rhi_vertex_format::R32G32Float,
+            .offset = quantized ? 8u : 12u,
         },
         rhi_vertex_attribute_desc{
             .binding = 0,
             .semantic = "TEXCOORD0"_s,
-            .format = rhi_vertex_format::R32G32Float,
-            .offset = 24,
+            .format = quantized ? rhi_vertex_format::R16G16Float : rhi_vertex_format::R32G32Float,
+            .offset = quantized ? 12u : 20u,
+        },
+        rhi_vertex_attribute_desc{
+            .binding = 1,
+            .semantic = "MODEL0"_s,
+            .format = rhi_vertex_format::R32G32B32A32Float,
+            .offset = 0,
+        },
+        rhi_vertex_attribute_desc{
+            .binding = 1,
+            .semantic = "MODEL1"_s,
+            .format = rhi_vertex_format::R32G32B32A32Float,
+            .offset = 16,
+        },
+        rhi_vertex_attribute_desc{
+            .binding = 1,
+            .semantic = "MODEL2"_s,
+            .format = rhi_vertex_format::R32G32B32A32Float,
+            .offset = 32,
+        },
+        rhi_vertex_attribute_desc{
+            .binding = 1,
+            .semantic = "MODEL3"_s,
+            .format = rhi_vertex_format::R32G32B32A32Float,
+            .offset = 48,
+        },
+        rhi_vertex_attribute_desc{
+            .binding = 1,
+            .semantic = "MATERIAL0"_s,
+            .format = rhi_vertex_format::R32G32B32A32Uint,
+            .offset = 64,
         },
     };
 
-    rhi_vertex_binding_desc vertexBinding{
-        .binding = 0,
-        .stride = 32,
-        .inputRate = rhi_input_rate::PerVertex,
+    array<rhi_vertex_binding_desc, 2> vertexBindings{
+        rhi_vertex_binding_desc{
+            .binding = 0,
+            .stride = quantized ? kMeshBlobQuantizedVertexStride : kMeshBlobFloat32VertexStride,
+            .inputRate = rhi_input_rate::PerVertex,
+        },
+        rhi_vertex_binding_desc{
+            .binding = 1,
+            .stride = sizeof(gpu_instance),
+            .inputRate = rhi_input_rate::PerInstance,
+        },
     };
 
     rhi_texture_format colorFormat = rhi_texture_format::B8G8R8A8_sRGB;
 
     const rhi_graphics_pipeline_desc pipelineDesc{
         .debugName = "Renderer"_s,
-        .vertexBindings = {&vertexBinding, 1},
+        .vertexBindings = vertexBindings,
         .vertexAttributes = vertexAttributes,
         .colorTargetFormats = {&colorFormat, 1},
         .depthFormat = rhi_texture_format::D32_Float_S8_UINT,
@@ -101,7 +459,72 @@ void API Bootstrap(region_alloc &)
         .frontFace = rhi_front_face::CCW,
     };
 
-    renderer->Pipeline = PipelineCache::Acquire(0xA1B649BF9958EC11, 0xFE6E3D0D77673448, pipelineDesc);
+    return PipelineCache::Acquire(0xA1B649BF9958EC11, 0xFE6E3D0D77673448, pipelineDesc);
+}
+
+void AllocInstances()
+{
+    renderer = &RegionAlloc::Alloc<renderer_state>(RegionAlloc::g_BootstrapAlloc);
+
+    region_alloc &bootstrapAlloc = RegionAlloc::g_BootstrapAlloc;
+    renderer->Pos = RegionAlloc::AllocArray<float3>(bootstrapAlloc, kMaxInstances);
+    renderer->Scale = RegionAlloc::AllocArray<float3>(bootstrapAlloc, kMaxInstances);
+    renderer->Rotation = RegionAlloc::AllocArray<float>(bootstrapAlloc, kMaxInstances);
+    renderer->Meshes = RegionAlloc::AllocArray<mesh_handle>(bootstrapAlloc, kMaxInstances);
+    renderer->Textures = RegionAlloc::AllocArray<texture_handle>(bootstrapAlloc, kMaxInstances);
+    renderer->Lods = RegionAlloc::AllocArray<uint8_t>(bootstrapAlloc, kMaxInstances);
+    renderer->DenseToSlot = RegionAlloc::AllocArray<uint32_t>(bootstrapAlloc, kMaxInstances);
+    renderer->Dirty = RegionAlloc::AllocArray<uint64_t>(bootstrapAlloc, kMaxInstances / 64);
+    renderer->LodQueue = RegionAlloc::AllocArray<uint32_t>(bootstrapAlloc, kMaxInstances);
+    renderer->Slots = RegionAlloc::AllocArray<instance_slot>(bootstrapAlloc, kMaxInstances);
+
+    for (uint32_t i = 0; i < kMaxInstances; ++i)
+        renderer->Slots[i].dense = i + 1;
+    renderer->FreeSlot = 0;
+}
+
+} // namespace
+
+namespace Renderer
+{
+
+void API Bootstrap(region_alloc &)
+{
+    AllocInstances();
+
+    renderer->InstanceBuffer = Rhi::CreateBuffer(rhi_buffer_desc{
+        .size = uint64_t{kMaxInstances} * sizeof(gpu_instance),
+        .bufferUsage = rhi_buffer_usage::Vertex | rhi_buffer_usage::CopyDst,
+        .memoryUsage = rhi_memory_usage::GpuOnly,
+    });
+    Rhi::NameBuffer(renderer->InstanceBuffer, "RendererInstances"_s);
+
+    renderer->TransientBuffer = Rhi::CreateBuffer(rhi_buffer_desc{
+        .size = uint64_t{kMaxTransientInstances} * sizeof(gpu_instance) * Rhi::GetNumFramesInFlight(),
+        .bufferUsage = rhi_buffer_usage::Vertex,
+        .memoryUsage = rhi_memory_usage::CpuToGpu,
+    });
+    Rhi::NameBuffer(renderer->TransientBuffer, "RendererTransientInstances"_s);
+
+    renderer->Pipelines[uint32_t(mesh_blob_vertex_format::Float32)] =
+        AcquirePipeline(mesh_blob_vertex_format::Float32);
+    renderer->Pipelines[uint32_t(mesh_blob_vertex_format::Quantized)] =
+        AcquirePipeline(mesh_blob_vertex_format::Quantized);
+}
+
+void API BootstrapHeadless()
+{
+    AllocInstances();
+
+    renderer->Headless = true;
+    renderer->HeadlessInstances = RegionAlloc::AllocArray<gpu_instance>(RegionAlloc::g_BootstrapAlloc, kMaxInstances);
+    renderer->HeadlessTransient =
+        RegionAlloc::AllocArray<gpu_instance>(RegionAlloc::g_BootstrapAlloc, kMaxTransientInstances);
+}
+
+void API RegisterTunables()
+{
+    Tunables::RegisterFloat("renderer.lodBias"_s, &renderer->LodBias, .25f, -4.f, 4.f);
 }
 
 void API SetView(float4x4 m)
@@ -131,6 +554,7 @@ void API SetOrthoProjection(uint32_t width, uint32_t height, float metersOnScree
     worldW = base * aspect;
 
     renderer->Proj = Mat::Ortho(-worldW * .5f, worldW * .5f, worldH * .5f, -worldH * .5f, 0.f, 1.f);
+    renderer->ViewportHeight = (float)height;
 }
 
 void API SetPerspectiveProjection(uint32_t width, uint32_t height, float fovDegrees, float nearPlane, float farPlane)
@@ -139,36 +563,180 @@ void API SetPerspectiveProjection(uint32_t width, uint32_t height, float fovDegr
     const float fovRadians = fovDegrees * (math::pi / 180.0f);
 
     renderer->Proj = Mat::Perspective(fovRadians, aspect, nearPlane, farPlane);
+    renderer->ViewportHeight = (float)height;
 }
 
-void API Mesh(float3 pos, float3 scale, mesh_handle Mesh, texture_handle Texture)
+auto API CreateInstance(const render_instance_desc &desc) -> render_instance
+{
+    ASSERT(desc.mesh.index < MeshManager::kMaxMeshes);
+    ASSERT(renderer->FreeSlot < kMaxInstances);
+
+    const uint32_t slotIndex = renderer->FreeSlot;
+    instance_slot &slot = renderer->Slots[slotIndex];
+    renderer->FreeSlot = slot.dense;
+
+    const uint32_t dense = InsertDense(GroupOf(desc.mesh, 0));
+    ++slot.gen;
+    slot.used = true;
+    slot.dense = dense;
+    renderer->DenseToSlot[dense] = slotIndex;
+    renderer->Lods[dense] = 0;
+    WriteInstance(dense, desc);
+
+    render_instance ret;
+    ret.gen = slot.gen;
+    ret.index = slotIndex;
+    return ret;
+}
+
+void API UpdateInstance(render_instance instance, const render_instance_desc &desc)
+{
+    ASSERT(desc.mesh.index < MeshManager::kMaxMeshes);
+    instance_slot &slot = ResolveSlot(instance);
+
+    const mesh_handle oldMesh = renderer->Meshes[slot.dense];
+    if (oldMesh.index != desc.mesh.index)
+    {
+        RemoveDense(slot.dense, GroupOf(oldMesh, renderer->Lods[slot.dense]));
+        slot.dense = InsertDense(GroupOf(desc.mesh, 0));
+        renderer->DenseToSlot[slot.dense] = instance.index;
+        renderer->Lods[slot.dense] = 0;
+    }
+
+    WriteInstance(slot.dense, desc);
+}
+
+void API DestroyInstance(render_instance instance)
+{
+    instance_slot &slot = ResolveSlot(instance);
+    RemoveDense(slot.dense, GroupOf(renderer->Meshes[slot.dense], renderer->Lods[slot.dense]));
+
+    slot.used = false;
+    slot.dense = renderer->FreeSlot;
+    renderer->FreeSlot = instance.index;
+}
+
+void API Update(rhi_cmdlist cmd)
 {
-    if (!Texture)
+    UpdateLods();
+
+    const uint32_t count = InstanceCount();
+    const uint32_t numWords = (count + 63) / 64;
+    uint32_t budget = uint32_t(kInstanceUploadBudget / sizeof(gpu_instance));
+    bool transitioned = false;
+
+    for (uint32_t n = 0; n < numWords && budget; ++n)
     {
-        Texture = MeshManager::GetTexture(Mesh);
-        if (!Texture)
-            return;
+        const uint32_t word = (renderer->DirtyCursor + n) % numWords;
+        uint64_t bits = renderer->Dirty[word];
+        if (!bits)
+            continue;
+        renderer->Dirty[word] = 0;
+
+        while (bits)
+        {
+            // Each run of consecutive dirty instances is one copy.
+            const uint32_t first = uint32_t(BitScanForward64(bits));
+            const uint64_t run = ~(bits >> first);
+            uint32_t len = run ? uint32_t(BitScanForward64(run)) : 64 - first;
+            if (len > budget)
+                len = budget;
+            bits &= len == 64 ? 0 : ~(((uint64_t{1} << len) - 1) << first);
+
+            const uint32_t begin = word * 64 + first;
+            if (begin >= count)
+                break;
+            const uint32_t end = begin + len < count ? begin + len : count;
+
+            budget -= end - begin;
+            if (!budget)
+            {
+                renderer->Dirty[word] |= bits;
+                renderer->DirtyCursor = word;
+                bits = 0;
+            }
+
+            gpu_instance *dst;
+            if (renderer->Headless)
+            {
+                dst = renderer->HeadlessInstances.data + begin;
+            }
+            else
+            {
+                if (!transitioned)
+                {
+                    Rhi::CmdTransitionBuffer(cmd, renderer->InstanceBuffer, rhi_buffer_state::CopyDst);
+                    transitioned = true;
+                }
+
+                dst = (gpu_instance *)GpuUpload::CmdCopyBuffer(cmd, renderer->InstanceBuffer,
+                                                               uint64_t{begin} * sizeof(gpu_instance),
+                                                               uint64_t{end - begin} * sizeof(gpu_instance));
+            }
+
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                gpu_instance &out = dst[i - begin];
+
+                rhi_srv srv;
+                if (ResolveSrv(renderer->Meshes[i], renderer->Textures[i], srv))
+                {
+                    out.model = Mat::TranslateRotateScale(renderer->Pos[i], renderer->Rotation[i], renderer->Scale[i]);
+                    out.srvTextureIndex = srv.index;
+                }
+                else
+                {
+                    // Degenerate until the texture is uploaded, retried next frame.
+                    MemZero(&out.model);
+                    out.srvTextureIndex = 0;
+                    MarkDirty(i);
+                }
+                out.samplerIndex = uint32_t(sampler_type::NearestClamp);
+            }
+        }
     }
 
-    rhi_srv srv = TextureManager::GetSRV(Texture);
-    if (!srv)
+    if (transitioned)
+        Rhi::CmdTransitionBuffer(cmd, renderer->InstanceBuffer, rhi_buffer_state::Vertex);
+}
+
+void API Mesh(float3 pos, float3 scale, mesh_handle Mesh, texture_handle Texture)
+{
+    rhi_srv srv;
+    if (!ResolveSrv(Mesh, Texture, srv))
         return;
 
-    draw_call &drawCall = InlineVec::Append(renderer->DrawQueue, draw_call{.Mesh = Mesh});
-    entity &entity = drawCall.Entity;
+    const uint64_t index = renderer->DrawQueue.size;
+    InlineVec::Append(renderer->DrawQueue, draw_call{.Mesh = Mesh, .Pos = pos, .Scale = scale});
 
-    Mat::Identity(entity.model);
-    entity.model = entity.model * Mat::Translate(float4{pos[0], pos[1], pos[2], 1.f});
-    entity.model = entity.model * Mat::Scale(float4{scale[0], scale[1], scale[2], 1.f});
+    const gpu_instance instance{
+        .model = Mat::TranslateScale(pos, scale),
+        .srvTextureIndex = srv.index,
+        .samplerIndex = uint32_t(sampler_type::NearestClamp),
+    };
 
-    entity.srvTextureIndex = srv.index;
+    if (renderer->Headless)
+    {
+        renderer->HeadlessTransient[index] = instance;
+        return;
+    }
 
-    entity.samplerIndex = uint32_t(sampler_type::NearestClamp);
+    const uint64_t offset = (uint64_t{Rhi::GetFrameIndex()} * kMaxTransientInstances + index) * sizeof(gpu_instance);
+    *(gpu_instance *)(Rhi::MapBuffer(renderer->TransientBuffer) + offset) = instance;
+    Rhi::BufferMarkWritten(renderer->TransientBuffer, offset, sizeof(gpu_instance));
 }
 
 void API CmdFlush(rhi_cmdlist cmd)
 {
-    Rhi::CmdBindGraphicsPipeline(cmd, PipelineCache::Resolve(renderer->Pipeline));
+    // Nothing to record, the immediate draws still pick their lod.
+    if (renderer->Headless)
+    {
+        const lod_view view = MakeLodView();
+        for (const draw_call &draw : renderer->DrawQueue)
+            SelectLod(view, draw.Mesh, draw.Pos, draw.Scale);
+        InlineVec::Clear(renderer->DrawQueue);
+        return;
+    }
 
     float4x4 vp = renderer->Proj * renderer->View;
     float4x4 invVp = Mat::Inverse(vp);
@@ -179,15 +747,41 @@ void API CmdFlush(rhi_cmdlist cmd)
 
     Rhi::SetPassConstant(cmd, Span::ByteViewPtr(&scene));
 
-    const uint32_t frameIndex = Rhi::GetFrameIndex();
+    uint32_t boundFormat = kNoVertexFormat;
 
-    for (const auto &drawCall : renderer->DrawQueue)
+    if (InstanceCount())
     {
-        const auto &entity = drawCall.Entity;
-        Rhi::SetDrawConstant(cmd, Span::ByteViewPtr(&entity));
+        const uint64_t offset = 0;
+        Rhi::CmdBindVertexBuffers(cmd, 1, {&renderer->InstanceBuffer, 1}, {&offset, 1});
+
+        for (uint32_t g = 0; g < kNumGroups; ++g)
+        {
+            const uint32_t begin = renderer->GroupBegin[g];
+            const uint32_t end = renderer->GroupBegin[g + 1];
+            if (begin == end)
+                continue;
+
+            const mesh_handle mesh = renderer->Meshes[begin];
+            CmdBindPipelineForMesh(cmd, mesh, boundFormat);
+            MeshManager::CmdBindMesh(cmd, mesh);
+            MeshManager::CmdDrawMesh(cmd, mesh, g % MeshManager::kMaxLods, end - begin, begin);
+        }
+    }
 
-        MeshManager::CmdBindMesh(cmd, drawCall.Mesh);
-        MeshManager::CmdDrawMesh(cmd, drawCall.Mesh);
+    const uint32_t frameIndex = Rhi::GetFrameIndex();
+    if (renderer->DrawQueue.size)
+    {
+        const uint64_t offset = uint64_t{frameIndex} * kMaxTransientInstances * sizeof(gpu_instance);
+        Rhi::CmdBindVertexBuffers(cmd, 1, {&renderer->TransientBuffer, 1}, {&offset, 1});
+
+        const lod_view view = MakeLodView();
+        for (uint32_t i = 0; i < renderer->DrawQueue.size; ++i)
+        {
+            const draw_call &draw = renderer->DrawQueue[i];
+            CmdBindPipelineForMesh(cmd, draw.Mesh, boundFormat);
+            MeshManager::CmdBindMesh(cmd, draw.Mesh);
+            MeshManager::CmdDrawMesh(cmd, draw.Mesh, SelectLod(view, draw.Mesh, draw.Pos, draw.Scale), 1, i);
+        }
     }
     InlineVec::Clear(renderer->DrawQueue);
 }
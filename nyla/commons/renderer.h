@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "nyla/commons/handle.h"
 #include "nyla/commons/mat.h"
 #include "nyla/commons/mesh_manager.h"
 #include "nyla/commons/rhi.h"
@@ -11,11 +12,42 @@
 namespace nyla
 {
 
+struct render_instance : handle
+{
+};
+
+struct render_instance_desc
+{
+    float3 pos;
+    float3 scale;
+    float rotation;
+    mesh_handle mesh;
+    texture_handle texture;
+};
+
 namespace Renderer
 {
 
 void API Bootstrap(region_alloc &alloc);
+// No GPU buffers or pipelines: Update and Mesh write instances to CPU memory, CmdFlush only empties the immediate
+// queue and every cmd argument is ignored. Textures are not resolved. For tools and benchmarks.
+void API BootstrapHeadless();
+
+// Registers renderer.lodBias, must run after Tunables::Bootstrap. Each step of +1 doubles the pixel error
+// accepted before switching to a coarser lod.
+void API RegisterTunables();
+
+// Retained instances are drawn by every CmdFlush until destroyed. Only created or updated instances are
+// re-transformed and uploaded, static ones cost nothing per frame.
+auto API CreateInstance(const render_instance_desc &desc) -> render_instance;
+void API UpdateInstance(render_instance instance, const render_instance_desc &desc);
+void API DestroyInstance(render_instance instance);
+
+// Picks a lod for every instance from the current view and projection, then uploads changed instances. Must be
+// recorded outside of a pass.
+void API Update(rhi_cmdlist cmd);
 
+// Immediate mode, drawn by the next CmdFlush only. The lod is picked at CmdFlush.
 void API Mesh(float3 pos, float3 scale, mesh_handle Mesh, texture_handle Texture);
 void API CmdFlush(rhi_cmdlist cmd);
 
@@ -59,6 +59,15 @@ enum class rhi_vertex_format
     R32G32B32Float,
     R32G32Float,
     R32G32B32A32Uint,
+    R16G16B16A16Float,
+    R16G16Float,
+    R16G16Snorm,
+};
+
+enum class rhi_index_format
+{
+    UInt16,
+    UInt32,
 };
 
 enum class rhi_input_rate
@@ -360,7 +369,7 @@ void API DestroyGraphicsPipeline(rhi_graphics_pipeline);
 void API CmdBindGraphicsPipeline(rhi_cmdlist, rhi_graphics_pipeline);
 void API CmdBindVertexBuffers(rhi_cmdlist cmd, uint32_t firstBinding, span<const rhi_buffer> buffers,
                               span<const uint64_t> offsets);
-void API CmdBindIndexBuffer(rhi_cmdlist cmd, rhi_buffer buffer, uint64_t offset);
+void API CmdBindIndexBuffer(rhi_cmdlist cmd, rhi_buffer buffer, uint64_t offset, rhi_index_format format);
 void API CmdPushGraphicsConstants(rhi_cmdlist cmd, uint32_t offset, rhi_shader_stage stage, byteview data);
 void API CmdDraw(rhi_cmdlist cmd, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex,
                  uint32_t firstInstance);
@@ -190,6 +190,12 @@ auto ConvertVertexFormatIntoVkFormat(rhi_vertex_format format) -> VkFormat
         return VK_FORMAT_R32G32_SFLOAT;
     case rhi_vertex_format::R32G32B32A32Uint:
         return VK_FORMAT_R32G32B32A32_UINT;
+    case rhi_vertex_format::R16G16B16A16Float:
+        return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case rhi_vertex_format::R16G16Float:
+        return VK_FORMAT_R16G16_SFLOAT;
+    case rhi_vertex_format::R16G16Snorm:
+        return VK_FORMAT_R16G16_SNORM;
     }
     ASSERT(false);
     return static_cast<VkFormat>(0);
@@ -450,6 +456,11 @@ auto GetVertexFormatSize(rhi_vertex_format format) -> uint32_t
         return 16;
     case rhi_vertex_format::R32G32B32A32Uint:
         return 16;
+    case rhi_vertex_format::R16G16B16A16Float:
+        return 8;
+    case rhi_vertex_format::R16G16Float:
+    case rhi_vertex_format::R16G16Snorm:
+        return 4;
     }
     ASSERT(false);
     return 0;
@@ -2196,12 +2207,14 @@ void Rhi::CmdBindVertexBuffers(rhi_cmdlist cmd, uint32_t firstBinding, span<cons
     vkCmdBindVertexBuffers(cmdData.cmdbuf, firstBinding, buffers.size, vkBufs.data, vkOffsets.data);
 }
 
-void Rhi::CmdBindIndexBuffer(rhi_cmdlist cmd, rhi_buffer buffer, uint64_t offset)
+void Rhi::CmdBindIndexBuffer(rhi_cmdlist cmd, rhi_buffer buffer, uint64_t offset, rhi_index_format format)
 {
     const VulkanBufferData &bufferData = HandlePool::ResolveData(rhi->buffers, buffer);
 
     const VulkanCmdListData &cmdData = HandlePool::ResolveData(rhi->cmdlists, cmd);
-    vkCmdBindIndexBuffer(cmdData.cmdbuf, bufferData.buffer, offset, VkIndexType::VK_INDEX_TYPE_UINT16);
+    const VkIndexType indexType =
+        format == rhi_index_format::UInt32 ? VkIndexType::VK_INDEX_TYPE_UINT32 : VkIndexType::VK_INDEX_TYPE_UINT16;
+    vkCmdBindIndexBuffer(cmdData.cmdbuf, bufferData.buffer, offset, indexType);
 }
 
 void Rhi::CmdDraw(rhi_cmdlist cmd, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex,
@@ -0,0 +1,464 @@
+#include "nyla/commons/scrollback.h"
+
+#include <cstdint>
+
+#include <immintrin.h>
+
+#include "nyla/commons/cell_renderer.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/region_alloc_def.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+constexpr inline uint64_t kBlockSize = 4 * kPageSize;
+constexpr inline uint32_t kMaxLineCells = 1024;
+
+// Record: u16 cells, u16 runs, u8 glyph width, glyphs, then runs of { u16 len, u16 flags, u32 fg, u32 bg }.
+constexpr inline uint64_t kRecordHeaderSize = 5;
+constexpr inline uint64_t kRunSize = 12;
+
+// Slotted block: records grow up from the header, u16 record offsets grow down from the block end.
+struct scrollback_block
+{
+    uint64_t firstLine;
+    uint32_t lineCount;
+    uint32_t dataEnd;
+};
+static_assert(kBlockSize <= 64_KiB);
+static_assert(kRecordHeaderSize + kMaxLineCells * (2 + kRunSize) + 2 + sizeof(scrollback_block) <= kBlockSize);
+
+} // namespace
+
+struct scrollback
+{
+    scrollback_desc desc;
+
+    span<cell_attr> hotCells;
+    span<uint16_t> hotLens;
+    uint32_t hotCount;
+    uint64_t endLine;
+
+    region_alloc coldAlloc;
+    span<scrollback_block *> blocks;
+    uint64_t blockHead;
+    uint64_t blockCount;
+
+    uint32_t viewCols;
+    uint64_t viewLine;
+    uint64_t viewRowsBelow;
+
+    span<cell_attr> lineCells;
+    span<uint8_t> lineText;
+};
+
+namespace
+{
+
+INLINE auto RowsFor(uint32_t len, uint32_t cols) -> uint64_t
+{
+    if (len == 0)
+        return 1;
+    return (len + cols - 1) / cols;
+}
+
+INLINE auto HotLine(scrollback &self, uint64_t line) -> cell_attr *
+{
+    return self.hotCells.data + (line % self.desc.hotLines) * self.desc.maxLineCells;
+}
+
+INLINE auto BlockAt(scrollback &self, uint64_t i) -> scrollback_block *
+{
+    return self.blocks[(self.blockHead + i) % self.blocks.size];
+}
+
+INLINE auto RecordOffsets(scrollback_block *block) -> uint16_t *
+{
+    return (uint16_t *)((uint8_t *)block + kBlockSize);
+}
+
+INLINE auto Record(scrollback_block *block, uint64_t line) -> uint8_t *
+{
+    const uint64_t k = line - block->firstLine;
+    DASSERT(k < block->lineCount);
+    return (uint8_t *)block + RecordOffsets(block)[-1 - (int64_t)k];
+}
+
+auto HotStart(const scrollback &self) -> uint64_t
+{
+    return self.endLine - self.hotCount;
+}
+
+auto FindBlock(scrollback &self, uint64_t line) -> scrollback_block *
+{
+    uint64_t lo = 0, hi = self.blockCount;
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (BlockAt(self, mid)->firstLine <= line)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    DASSERT(lo > 0);
+    return BlockAt(self, lo - 1);
+}
+
+auto LineLength(scrollback &self, uint64_t line) -> uint32_t
+{
+    if (line >= HotStart(self))
+        return self.hotLens[line % self.desc.hotLines];
+
+    return LoadU<uint16_t>(Record(FindBlock(self, line), line));
+}
+
+auto NewBlock(scrollback &self, uint64_t firstLine) -> scrollback_block *
+{
+    scrollback_block *block;
+    if (self.blockCount == self.blocks.size)
+    {
+        block = self.blocks[self.blockHead];
+        self.blockHead = (self.blockHead + 1) % self.blocks.size;
+        --self.blockCount;
+    }
+    else
+    {
+        block = (scrollback_block *)RegionAlloc::Alloc(self.coldAlloc, kBlockSize, kPageSize);
+    }
+
+    block->firstLine = firstLine;
+    block->lineCount = 0;
+    block->dataEnd = sizeof(scrollback_block);
+
+    self.blocks[(self.blockHead + self.blockCount) % self.blocks.size] = block;
+    ++self.blockCount;
+    return block;
+}
+
+void CompressLine(scrollback &self, uint64_t line)
+{
+    const cell_attr *cells = HotLine(self, line);
+    const uint32_t len = self.hotLens[line % self.desc.hotLines];
+
+    uint32_t wide = 1;
+    uint32_t runCount = 0;
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        if (cells[i].glyphIndex > 0xFF)
+            wide = 2;
+
+        if (i == 0 || cells[i].flags != cells[i - 1].flags || cells[i].fgRgba != cells[i - 1].fgRgba ||
+            cells[i].bgRgba != cells[i - 1].bgRgba)
+            ++runCount;
+    }
+
+    const uint64_t size = kRecordHeaderSize + uint64_t{len} * wide + runCount * kRunSize;
+
+    scrollback_block *block = self.blockCount ? BlockAt(self, self.blockCount - 1) : nullptr;
+    if (!block || block->dataEnd + size + (block->lineCount + 1) * sizeof(uint16_t) > kBlockSize)
+        block = NewBlock(self, line);
+
+    uint8_t *p = (uint8_t *)block + block->dataEnd;
+    RecordOffsets(block)[-1 - (int64_t)block->lineCount] = (uint16_t)block->dataEnd;
+    ++block->lineCount;
+    block->dataEnd += (uint32_t)size;
+
+    WriteU<uint16_t>(p, (uint16_t)len);
+    WriteU<uint16_t>(p + 2, (uint16_t)runCount);
+    p[4] = (uint8_t)wide;
+    p += kRecordHeaderSize;
+
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        if (wide == 1)
+            *p++ = (uint8_t)cells[i].glyphIndex;
+        else
+        {
+            WriteU<uint16_t>(p, cells[i].glyphIndex);
+            p += 2;
+        }
+    }
+
+    for (uint32_t i = 0; i < len;)
+    {
+        uint32_t j = i + 1;
+        while (j < len && cells[j].flags == cells[i].flags && cells[j].fgRgba == cells[i].fgRgba &&
+               cells[j].bgRgba == cells[i].bgRgba)
+            ++j;
+
+        WriteU<uint16_t>(p, (uint16_t)(j - i));
+        WriteU<uint16_t>(p + 2, cells[i].flags);
+        WriteU<uint32_t>(p + 4, cells[i].fgRgba);
+        WriteU<uint32_t>(p + 8, cells[i].bgRgba);
+        p += kRunSize;
+
+        i = j;
+    }
+}
+
+void PushLineImpl(scrollback &self, span<const cell_attr> cells)
+{
+    if (self.hotCount == self.desc.hotLines)
+    {
+        CompressLine(self, HotStart(self));
+        --self.hotCount;
+    }
+
+    const uint64_t line = self.endLine;
+    MemCpy(HotLine(self, line), cells.data, Span::SizeBytes(cells));
+    self.hotLens[line % self.desc.hotLines] = (uint16_t)cells.size;
+    ++self.hotCount;
+    ++self.endLine;
+
+    if (self.viewCols)
+        self.viewRowsBelow += RowsFor((uint32_t)cells.size, self.viewCols);
+}
+
+auto DecodeLine(scrollback &self, uint64_t line, span<cell_attr> out) -> uint32_t
+{
+    if (line >= HotStart(self))
+    {
+        const uint32_t n = Min<uint32_t>(self.hotLens[line % self.desc.hotLines], (uint32_t)out.size);
+        MemCpy(out.data, HotLine(self, line), n * sizeof(cell_attr));
+        return n;
+    }
+
+    const uint8_t *p = Record(FindBlock(self, line), line);
+    const uint32_t len = LoadU<uint16_t>(p);
+    const uint32_t runCount = LoadU<uint16_t>(p + 2);
+    const uint32_t wide = p[4];
+    const uint8_t *glyphs = p + kRecordHeaderSize;
+    const uint8_t *runs = glyphs + uint64_t{len} * wide;
+
+    const uint32_t n = Min<uint32_t>(len, (uint32_t)out.size);
+    uint32_t col = 0;
+    for (uint32_t r = 0; r < runCount && col < n; ++r, runs += kRunSize)
+    {
+        const uint32_t runLen = LoadU<uint16_t>(runs);
+        const uint16_t flags = LoadU<uint16_t>(runs + 2);
+        const uint32_t fg = LoadU<uint32_t>(runs + 4);
+        const uint32_t bg = LoadU<uint32_t>(runs + 8);
+
+        for (uint32_t end = Min(col + runLen, n); col < end; ++col)
+        {
+            cell_attr &cell = out.data[col];
+            if (wide == 1)
+                cell.glyphIndex = glyphs[col];
+            else
+                cell.glyphIndex = LoadU<uint16_t>(glyphs + uint64_t{col} * 2);
+            cell.flags = flags;
+            cell.fgRgba = fg;
+            cell.bgRgba = bg;
+        }
+    }
+    return n;
+}
+
+// Glyph indices for the first 256 codepoints are the codepoints themselves, so text is the low glyph byte.
+auto LineText(scrollback &self, scrollback_block *block, uint64_t line) -> byteview
+{
+    if (block)
+    {
+        const uint8_t *p = Record(block, line);
+        if (p[4] == 1)
+            return byteview{p + kRecordHeaderSize, LoadU<uint16_t>(p)};
+    }
+
+    const uint32_t n = DecodeLine(self, line, self.lineCells);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        const uint16_t glyph = self.lineCells.data[i].glyphIndex;
+        self.lineText.data[i] = glyph > 0xFF ? 0 : (uint8_t)glyph;
+    }
+    return byteview{self.lineText.data, n};
+}
+
+auto MemFind(byteview haystack, byteview needle) -> int64_t
+{
+    const uint64_t n = haystack.size;
+    const uint64_t m = needle.size;
+    if (m == 0)
+        return 0;
+    if (m > n)
+        return -1;
+
+    const uint8_t *h = haystack.data;
+    const __m256i first = _mm256_set1_epi8((char)needle.data[0]);
+    const __m256i last = _mm256_set1_epi8((char)needle.data[m - 1]);
+
+    uint64_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32)
+    {
+        const __m256i a = _mm256_loadu_si256((const __m256i *)(h + i));
+        const __m256i b = _mm256_loadu_si256((const __m256i *)(h + i + m - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+
+        while (mask)
+        {
+            const uint32_t bit = BitScanForward32(mask);
+            if (m <= 2 || MemEq(h + i + bit + 1, needle.data + 1, m - 2))
+                return (int64_t)(i + bit);
+            mask &= mask - 1;
+        }
+    }
+
+    for (; i + m <= n; ++i)
+    {
+        if (h[i] == needle.data[0] && MemEq(h + i, needle.data, m))
+            return (int64_t)i;
+    }
+    return -1;
+}
+
+} // namespace
+
+namespace Scrollback
+{
+
+auto API Create(region_alloc &alloc, const scrollback_desc &desc) -> scrollback *
+{
+    ASSERT(desc.maxLineCells > 0 && desc.maxLineCells <= kMaxLineCells);
+    ASSERT(desc.hotLines > 0);
+
+    auto &self = RegionAlloc::Alloc<scrollback>(alloc);
+    self.desc = desc;
+    self.hotCells = RegionAlloc::AllocArray<cell_attr>(alloc, uint64_t{desc.hotLines} * desc.maxLineCells);
+    self.hotLens = RegionAlloc::AllocArray<uint16_t>(alloc, desc.hotLines);
+    self.lineCells = RegionAlloc::AllocArray<cell_attr>(alloc, desc.maxLineCells);
+    self.lineText = RegionAlloc::AllocArray<uint8_t>(alloc, desc.maxLineCells);
+
+    const uint64_t maxBlocks = desc.maxColdBytes / kBlockSize;
+    ASSERT(maxBlocks >= 2);
+    self.coldAlloc = RegionAlloc::Create(maxBlocks * kBlockSize, 0);
+    self.blocks = RegionAlloc::AllocArray<scrollback_block *>(alloc, maxBlocks);
+
+    return &self;
+}
+
+void API Destroy(scrollback &self)
+{
+    RegionAlloc::Destroy(self.coldAlloc);
+}
+
+void API PushLine(scrollback &self, span<const cell_attr> cells)
+{
+    while (cells.size > self.desc.maxLineCells)
+    {
+        PushLineImpl(self, Span::SubSpan(cells, 0, self.desc.maxLineCells));
+        cells = Span::SubSpan(cells, self.desc.maxLineCells);
+    }
+    PushLineImpl(self, cells);
+}
+
+auto API FirstLine(const scrollback &self) -> uint64_t
+{
+    if (self.blockCount)
+        return self.blocks[self.blockHead]->firstLine;
+    return HotStart(self);
+}
+
+auto API EndLine(const scrollback &self) -> uint64_t
+{
+    return self.endLine;
+}
+
+auto API ReadLine(scrollback &self, uint64_t line, span<cell_attr> out) -> uint32_t
+{
+    if (line < FirstLine(self) || line >= self.endLine)
+        return 0;
+    return DecodeLine(self, line, out);
+}
+
+auto API ReadViewRow(scrollback &self, uint32_t cols, uint64_t rowFromBottom, span<cell_attr> out) -> uint32_t
+{
+    ASSERT(cols > 0);
+
+    const uint64_t firstLine = FirstLine(self);
+    if (firstLine == self.endLine)
+        return 0;
+
+    if (cols != self.viewCols || self.viewLine < firstLine || self.viewLine >= self.endLine)
+    {
+        self.viewCols = cols;
+        self.viewLine = self.endLine - 1;
+        self.viewRowsBelow = 0;
+    }
+
+    while (rowFromBottom < self.viewRowsBelow)
+    {
+        ++self.viewLine;
+        self.viewRowsBelow -= RowsFor(LineLength(self, self.viewLine), cols);
+    }
+
+    uint64_t rows = RowsFor(LineLength(self, self.viewLine), cols);
+    while (rowFromBottom >= self.viewRowsBelow + rows)
+    {
+        if (self.viewLine == firstLine)
+            return 0;
+
+        self.viewRowsBelow += rows;
+        --self.viewLine;
+        rows = RowsFor(LineLength(self, self.viewLine), cols);
+    }
+
+    const uint64_t subRow = rows - 1 - (rowFromBottom - self.viewRowsBelow);
+    const uint32_t len = DecodeLine(self, self.viewLine, self.lineCells);
+    const uint32_t begin = (uint32_t)(subRow * cols);
+    if (begin >= len)
+        return 0;
+
+    const uint32_t n = Min<uint32_t>(Min(len - begin, cols), (uint32_t)out.size);
+    MemCpy(out.data, self.lineCells.data + begin, n * sizeof(cell_attr));
+    return n;
+}
+
+auto API FindPrev(scrollback &self, byteview needle, uint64_t beforeLine, scrollback_match &out) -> bool
+{
+    auto test = [&](scrollback_block *block, uint64_t line) -> bool {
+        const int64_t col = MemFind(LineText(self, block, line), needle);
+        if (col < 0)
+            return false;
+
+        out = scrollback_match{.line = line, .col = (uint32_t)col};
+        return true;
+    };
+
+    uint64_t line = Min(beforeLine, self.endLine);
+
+    for (const uint64_t hotStart = HotStart(self); line > hotStart;)
+    {
+        if (test(nullptr, --line))
+            return true;
+    }
+
+    for (uint64_t i = self.blockCount; i-- > 0;)
+    {
+        scrollback_block *block = BlockAt(self, i);
+        for (line = Min(line, block->firstLine + block->lineCount); line > block->firstLine;)
+        {
+            if (test(block, --line))
+                return true;
+        }
+    }
+    return false;
+}
+
+auto API MemoryUsage(const scrollback &self) -> uint64_t
+{
+    return Span::SizeBytes(self.hotCells) + Span::SizeBytes(self.hotLens) + self.blockCount * kBlockSize;
+}
+
+} // namespace Scrollback
+
+} // namespace nyla
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/byteliterals.h"
+#include "nyla/commons/cell_renderer.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/region_alloc_def.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+struct scrollback_desc
+{
+    uint32_t maxLineCells = 512;
+    uint32_t hotLines = 1024;
+    uint64_t maxColdBytes = 128_MiB;
+};
+
+struct scrollback_match
+{
+    uint64_t line;
+    uint32_t col;
+};
+
+struct scrollback;
+
+namespace Scrollback
+{
+
+auto API Create(region_alloc &alloc, const scrollback_desc &desc) -> scrollback *;
+void API Destroy(scrollback &self);
+
+// Appends one logical (unwrapped) line. Lines longer than maxLineCells are hard-split.
+void API PushLine(scrollback &self, span<const cell_attr> cells);
+
+// Lines are numbered monotonically; [FirstLine, EndLine) is what is still retained.
+auto API FirstLine(const scrollback &self) -> uint64_t;
+auto API EndLine(const scrollback &self) -> uint64_t;
+
+auto API ReadLine(scrollback &self, uint64_t line, span<cell_attr> out) -> uint32_t;
+
+// Wrapped view at the given width, counted upwards from the newest row. Reflow happens lazily on read.
+auto API ReadViewRow(scrollback &self, uint32_t cols, uint64_t rowFromBottom, span<cell_attr> out) -> uint32_t;
+
+// Searches backwards starting at line beforeLine - 1.
+auto API FindPrev(scrollback &self, byteview needle, uint64_t beforeLine, scrollback_match &out) -> bool;
+
+auto API MemoryUsage(const scrollback &self) -> uint64_t;
+
+} // namespace Scrollback
+
+} // namespace nyla
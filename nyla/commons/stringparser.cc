@@ -1,6 +1,11 @@
 #include "nyla/commons/stringparser.h"
 
-#include <cstdlib>
+#include <cstdint>
+
+#include "nyla/commons/byteparser.h"
+#include "nyla/commons/float_conv.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
 
 namespace nyla
 {
@@ -8,16 +13,56 @@ namespace nyla
 namespace StringParser
 {
 
-auto ParseDoubleFromBytes(const uint8_t *data, uint64_t size) -> double
+auto API ParseDecimal(byte_parser &self, double &outDouble, int64_t &outLong) -> ParseNumberResult
 {
-    char buf[1024];
-    ASSERT(size < sizeof(buf));
+    const uint8_t *start = self.at;
+
+    bool negative = false;
+    if (ByteParser::HasNext(self) && ByteParser::Peek(self) == '-')
+    {
+        negative = true;
+        ByteParser::Advance(self);
+    }
+
+    uint64_t mantissa = 0;
+    int32_t digitCount = 0;
+    bool overflow = false;
+
+    while (ByteParser::HasNext(self) && IsNumber(ByteParser::Peek(self)))
+    {
+        uint8_t digit = ByteParser::Read(self) - '0';
+        if (digitCount < 19)
+        {
+            mantissa = mantissa * 10 + digit;
+            ++digitCount;
+        }
+        else
+        {
+            overflow = true;
+        }
+    }
+
+    uint64_t int64AbsLimit;
+    if (negative)
+        int64AbsLimit = (uint64_t)INT64_MAX + 1;
+    else
+        int64AbsLimit = (uint64_t)INT64_MAX;
 
-    for (uint64_t i = 0; i < size; ++i)
-        buf[i] = (char)data[i];
-    buf[size] = '\0';
+    const uint8_t next = ByteParser::HasNext(self) ? ByteParser::Peek(self) : '\0';
+    if (next != '.' && next != 'e' && next != 'E' && !overflow && mantissa <= int64AbsLimit)
+    {
+        if (negative)
+            outLong = (int64_t)(0u - mantissa);
+        else
+            outLong = (int64_t)mantissa;
+        return ParseNumberResult::Long;
+    }
 
-    return ::strtod(buf, nullptr);
+    // Scanned again from the start, the integer digits are a small part of a float literal.
+    const uint64_t consumed = FloatConv::ParseDouble(byteview{start, (uint64_t)(self.end - start)}, outDouble);
+    if (consumed)
+        self.at = start + consumed;
+    return ParseNumberResult::Double;
 }
 
 } // namespace StringParser
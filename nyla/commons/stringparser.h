@@ -47,78 +47,9 @@ enum ParseNumberResult
     Long,
 };
 
-// Defined in stringparser.cc. Linker drops it (and the libc strtod reference)
-// when no caller pulls ParseDecimal/ParseLong into the program.
-auto ParseDoubleFromBytes(const uint8_t *data, uint64_t size) -> double;
-
-inline auto ParseDecimal(byte_parser &self, double &outDouble, int64_t &outLong) -> ParseNumberResult
-{
-    const uint8_t *start = self.at;
-
-    bool negative = false;
-    if (ByteParser::HasNext(self) && ByteParser::Peek(self) == '-')
-    {
-        negative = true;
-        ByteParser::Advance(self);
-    }
-
-    uint64_t mantissa = 0;
-    int32_t digitCount = 0;
-    bool overflow = false;
-
-    while (ByteParser::HasNext(self) && IsNumber(ByteParser::Peek(self)))
-    {
-        uint8_t digit = ByteParser::Read(self) - '0';
-        if (digitCount < 19)
-        {
-            mantissa = mantissa * 10 + digit;
-            ++digitCount;
-        }
-        else
-        {
-            overflow = true;
-        }
-    }
-
-    bool hasDot = false;
-    if (ByteParser::HasNext(self) && ByteParser::Peek(self) == '.')
-    {
-        hasDot = true;
-        ByteParser::Advance(self);
-        while (ByteParser::HasNext(self) && IsNumber(ByteParser::Peek(self)))
-            ByteParser::Advance(self);
-    }
-
-    bool hasExp = false;
-    if (ByteParser::HasNext(self) && (ByteParser::Peek(self) == 'e' || ByteParser::Peek(self) == 'E'))
-    {
-        hasExp = true;
-        ByteParser::Advance(self);
-        if (ByteParser::HasNext(self) && (ByteParser::Peek(self) == '+' || ByteParser::Peek(self) == '-'))
-            ByteParser::Advance(self);
-        while (ByteParser::HasNext(self) && IsNumber(ByteParser::Peek(self)))
-            ByteParser::Advance(self);
-    }
-
-    uint64_t int64AbsLimit;
-    if (negative)
-        int64AbsLimit = (uint64_t)INT64_MAX + 1;
-    else
-        int64AbsLimit = (uint64_t)INT64_MAX;
-    if (hasDot || hasExp || overflow || mantissa > int64AbsLimit)
-    {
-        outDouble = ParseDoubleFromBytes(start, (uint64_t)(self.at - start));
-        return ParseNumberResult::Double;
-    }
-    else
-    {
-        if (negative)
-            outLong = (int64_t)(0u - mantissa);
-        else
-            outLong = (int64_t)mantissa;
-        return ParseNumberResult::Long;
-    }
-}
+// Integer literals that fit int64 come back as Long, everything else ([-]digits[.digits][e[+-]digits]) as a correctly
+// rounded Double.
+auto API ParseDecimal(byte_parser &self, double &outDouble, int64_t &outLong) -> ParseNumberResult;
 
 INLINE auto ParseLong(byte_parser &self) -> int64_t
 {
@@ -5,6 +5,7 @@
 #include "nyla/commons/byteparser.h"
 #include "nyla/commons/cell_renderer.h"
 #include "nyla/commons/file.h"
+#include "nyla/commons/float_conv.h"
 #include "nyla/commons/fmt.h"
 #include "nyla/commons/inline_string.h"
 #include "nyla/commons/macros.h"
@@ -374,9 +375,11 @@ void API Save()
         const auto &e = g_tunables->entries[i];
         if (e.type == tunable_type::Float)
         {
-            const float v = *static_cast<const float *>(e.ptr);
-            FileWriteFmt(f, span<uint8_t>{lineBuf, sizeof(lineBuf)}, "%.*s = %f\n"_s, e.name.size, e.name.data.data,
-                         (double)v);
+            // Shortest float text, so a save/load cycle gives back the exact value.
+            uint8_t valueBuf[FloatConv::kMaxShortestChars];
+            const uint32_t valueLen = FloatConv::FormatShortest(*static_cast<const float *>(e.ptr), valueBuf);
+            FileWriteFmt(f, span<uint8_t>{lineBuf, sizeof(lineBuf)}, "%.*s = %.*s\n"_s, e.name.size, e.name.data.data,
+                         (uint64_t)valueLen, valueBuf);
         }
         else
         {
@@ -412,9 +415,10 @@ void API CmdFlush(rhi_cmdlist cmd, int32_t originPxX, int32_t originPxY)
         uint64_t n;
         if (e.type == tunable_type::Float)
         {
-            const float v = *static_cast<const float *>(e.ptr);
-            n = StringWriteFmt(span<uint8_t>{lineBuf, sizeof(lineBuf)}, "%.*s = %f"_s, e.name.size, e.name.data.data,
-                               (double)v);
+            uint8_t valueBuf[FloatConv::kMaxShortestChars];
+            const uint32_t valueLen = FloatConv::FormatShortest(*static_cast<const float *>(e.ptr), valueBuf);
+            n = StringWriteFmt(span<uint8_t>{lineBuf, sizeof(lineBuf)}, "%.*s = %.*s"_s, e.name.size,
+                               e.name.data.data, (uint64_t)valueLen, valueBuf);
         }
         else
         {
@@ -16,7 +16,7 @@ struct VS_INPUT
     uint vert_id : SV_VertexID;
     uint inst_id : SV_InstanceID;
     // packed cell:
-    //   x = (cellY << 16) | cellX
+    //   x = (cellY << 16) | cellX, pixel offsets instead when flags & 0x8000
     //   y = (flags << 16) | glyphIndex
     //   z = fgRgba (0xAABBGGRR)
     //   w = bgRgba
@@ -41,11 +41,15 @@ VS_OUTPUT main(VS_INPUT input)
     uint cellX = input.cell_data.x & 0xFFFFu;
     uint cellY = (input.cell_data.x >> 16) & 0xFFFFu;
     uint glyphIndex = input.cell_data.y & 0xFFFFu;
+    bool pixelPositioned = (input.cell_data.y & 0x80000000u) != 0;
 
     float2 corner = corners[input.vert_id];
 
-    float2 pixelPos =
-        float2(pc.origin_px) + float2(cellX, cellY) * float2(pc.cell_size_px) + corner * float2(pc.cell_size_px);
+    float2 cellOffsetPx = float2(cellX, cellY);
+    if (!pixelPositioned)
+        cellOffsetPx *= float2(pc.cell_size_px);
+
+    float2 pixelPos = float2(pc.origin_px) + cellOffsetPx + corner * float2(pc.cell_size_px);
 
     float2 ndc = (pixelPos / float2(pc.screen_size_px)) * 2.0f - 1.0f;
     ndc.y = -ndc.y;
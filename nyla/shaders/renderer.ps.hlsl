@@ -3,16 +3,9 @@ struct VSOutput
     float4 position : SV_Position;
     float3 normal : NORMAL0;
     float2 uv : TEXCOORD0;
+    nointerpolation uint2 material : MATERIAL0;
 };
 
-struct Entity
-{
-    float4x4 model;
-    uint32_t textureIndex;
-    uint32_t samplerIndex;
-};
-
-ConstantBuffer<Entity> entity : register(b2, space0);
 Texture2D textures[] : register(s0, space1);
 SamplerState samplers[] : register(t0, space2);
 
@@ -25,8 +18,8 @@ PSOutput main(VSOutput input)
 {
     PSOutput o;
 
-    Texture2D texture = textures[entity.textureIndex];
-    SamplerState samplerState = samplers[entity.samplerIndex];
+    Texture2D texture = textures[input.material.x];
+    SamplerState samplerState = samplers[input.material.y];
 
     o.color = texture.Sample(samplerState, input.uv);
 
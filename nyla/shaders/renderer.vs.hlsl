@@ -4,21 +4,20 @@ struct Scene
     float4x4 invVp;
 };
 
-struct Entity
-{
-    float4x4 model;
-    uint32_t textureIndex;
-    uint32_t samplerIndex;
-};
-
 ConstantBuffer<Scene> scene : register(b1, space0);
-ConstantBuffer<Entity> entity : register(b2, space0);
 
 struct VSInput
 {
     float3 position : POSITION0;
-    float3 normal : NORMAL0;
+    float2 normal : NORMAL0; // octahedral
     float2 uv : TEXCOORD0;
+
+    // per instance, model matrix columns and (textureIndex, samplerIndex)
+    float4 model0 : MODEL0;
+    float4 model1 : MODEL1;
+    float4 model2 : MODEL2;
+    float4 model3 : MODEL3;
+    uint4 material : MATERIAL0;
 };
 
 struct VSOutput
@@ -26,20 +25,32 @@ struct VSOutput
     float4 position : SV_Position;
     float3 normal : NORMAL0;
     float2 uv : TEXCOORD0;
+    nointerpolation uint2 material : MATERIAL0;
 };
 
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 VSOutput main(VSInput input)
 {
     VSOutput o;
 
-    float4 worldPos = mul(entity.model, float4(input.position, 1));
+    float4 worldPos = input.model0 * input.position.x + input.model1 * input.position.y +
+                      input.model2 * input.position.z + input.model3;
 
     o.position = mul(scene.vp, worldPos);
 
     // o.position.y = -o.position.y;
 
-    o.normal = input.normal;
+    o.normal = DecodeOctahedral(input.normal);
     o.uv = input.uv;
+    o.material = input.material.xy;
 
     return o;
 }
\ No newline at end of file
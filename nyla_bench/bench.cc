@@ -0,0 +1,316 @@
+#include "nyla_bench/bench.h"
+
+#include <cinttypes>
+#include <cstdint>
+
+#include "nyla/commons/file.h"
+#include "nyla/commons/file_utils.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/json_parser.h"
+#include "nyla/commons/json_value.h"
+#include "nyla/commons/macros.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/mempage_pool.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/time.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+constexpr uint32_t kMaxResults = 256;
+constexpr uint32_t kMaxBatches = 31;
+constexpr uint64_t kNameColumn = 36;
+
+struct bench_result
+{
+    byteview name;
+    uint64_t iterations; // per batch
+    uint32_t batches;
+    double medianNs; // per iteration
+    double madNs;
+    double minNs;
+    uint64_t bytesPerIteration;
+};
+
+struct bench_state
+{
+    byteview filter;
+    double tscTicksPerNs;
+    uint64_t batchNs;
+    uint64_t warmupNs;
+    uint32_t batches;
+
+    bench_result results[kMaxResults];
+    uint32_t resultCount;
+};
+bench_state *g_bench;
+
+auto TimeBatch(bench_fn fn, void *user, uint64_t iterations) -> uint64_t
+{
+    const uint64_t start = ReadTimestampCounter();
+    fn(user, iterations);
+    return ReadTimestampCounter() - start;
+}
+
+void SortAscending(double *values, uint32_t count)
+{
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        const double v = values[i];
+        uint32_t j = i;
+        for (; j > 0 && values[j - 1] > v; --j)
+            values[j] = values[j - 1];
+        values[j] = v;
+    }
+}
+
+auto Median(double *values, uint32_t count) -> double
+{
+    SortAscending(values, count);
+    if (count & 1)
+        return values[count / 2];
+    return (values[count / 2 - 1] + values[count / 2]) * 0.5;
+}
+
+auto Contains(byteview haystack, byteview needle) -> bool
+{
+    for (uint64_t i = 0; i + needle.size <= haystack.size; ++i)
+    {
+        if (MemEq(haystack.data + i, needle.data, needle.size))
+            return true;
+    }
+    return false;
+}
+
+auto Abs(double v) -> double
+{
+    return v < 0 ? -v : v;
+}
+
+// Name padded to the first column, then whatever the caller formats after it.
+void LogRow(byteview name, byteview rest)
+{
+    uint8_t line[256];
+    uint64_t n = Min<uint64_t>(name.size, kNameColumn - 1);
+    MemCpy(line, name.data, n);
+    for (; n < kNameColumn; ++n)
+        line[n] = ' ';
+    const uint64_t restSize = Min<uint64_t>(rest.size, sizeof(line) - n);
+    MemCpy(line + n, rest.data, restSize);
+    LOG(SV_FMT, SV_ARG((byteview{line, n + restSize})));
+}
+
+auto FindResult(json_value &results, byteview name, json_value *&out) -> bool
+{
+    for (json_value &result : results)
+    {
+        byteview resultName;
+        if (JsonValue::TryString(result, "name"_s, resultName) && Span::Eq(resultName, name))
+        {
+            out = &result;
+            return true;
+        }
+    }
+    return false;
+}
+
+auto ReadResults(region_alloc &alloc, byteview path) -> json_value *
+{
+    file_handle file = FileOpen(path, FileOpenMode::Read);
+    span<uint8_t> bytes;
+    const bool read = TryFileReadFully(alloc, file, bytes);
+    if (FileValid(file))
+        FileClose(file);
+    if (!read)
+    {
+        LOG("bench: could not read " SV_FMT, SV_ARG(path));
+        return nullptr;
+    }
+
+    const json_result json = JsonParser::Parse(bytes, alloc);
+    json_value *results;
+    if (json.error != json_error::None || !JsonValue::TryArray(*json.root, "results"_s, results))
+    {
+        LOG("bench: " SV_FMT " is not a result file", SV_ARG(path));
+        return nullptr;
+    }
+    return results;
+}
+
+} // namespace
+
+namespace Bench
+{
+
+void Bootstrap(byteview filter, bool quick)
+{
+    g_bench = &RegionAlloc::Alloc<bench_state>(RegionAlloc::g_BootstrapAlloc);
+    g_bench->filter = filter;
+    g_bench->batchNs = quick ? 100'000 : 1'000'000;
+    g_bench->warmupNs = quick ? 2'000'000 : 50'000'000;
+    g_bench->batches = quick ? 5 : kMaxBatches;
+
+    // Spin rather than sleep, a sleeping core may clock down and the TSC is invariant anyway.
+    const uint64_t calibrateNs = quick ? 5'000'000 : 50'000'000;
+    const uint64_t startNs = GetMonotonicTimeNanos();
+    const uint64_t startTicks = ReadTimestampCounter();
+    uint64_t nowNs;
+    while ((nowNs = GetMonotonicTimeNanos()) - startNs < calibrateNs)
+        CpuRelax();
+    g_bench->tscTicksPerNs = (double)(ReadTimestampCounter() - startTicks) / (double)(nowNs - startNs);
+
+    LOG("bench: tsc %.3f GHz, %u batches of ~%" PRIu64 " us", g_bench->tscTicksPerNs, g_bench->batches,
+        g_bench->batchNs / 1000);
+}
+
+auto Selected(byteview name) -> bool
+{
+    return Contains(name, g_bench->filter);
+}
+
+auto Run(byteview name, bench_fn fn, void *user, uint64_t bytesPerIteration) -> double
+{
+    if (!Selected(name))
+        return 0;
+    ASSERT(g_bench->resultCount < kMaxResults);
+
+    const double batchTicks = (double)g_bench->batchNs * g_bench->tscTicksPerNs;
+    const double warmupTicks = (double)g_bench->warmupNs * g_bench->tscTicksPerNs;
+
+    // Doubling doubles as the warmup: caches, branch predictors and page faults settle before anything is kept.
+    uint64_t iterations = 1;
+    double spent = 0;
+    for (;;)
+    {
+        const uint64_t ticks = TimeBatch(fn, user, iterations);
+        spent += (double)ticks;
+        if ((double)ticks >= batchTicks)
+        {
+            if (spent >= warmupTicks)
+                break;
+            continue;
+        }
+        iterations = ticks ? Max<uint64_t>(iterations * 2, (uint64_t)((double)iterations * batchTicks / (double)ticks))
+                           : iterations * 2;
+    }
+
+    double perIteration[kMaxBatches];
+    for (uint32_t i = 0; i < g_bench->batches; ++i)
+        perIteration[i] = (double)TimeBatch(fn, user, iterations) / g_bench->tscTicksPerNs / (double)iterations;
+
+    const double median = Median(perIteration, g_bench->batches); // sorts
+
+    bench_result &result = g_bench->results[g_bench->resultCount++];
+    result = bench_result{
+        .name = name,
+        .iterations = iterations,
+        .batches = g_bench->batches,
+        .medianNs = median,
+        .minNs = perIteration[0],
+        .bytesPerIteration = bytesPerIteration,
+    };
+
+    double deviation[kMaxBatches];
+    for (uint32_t i = 0; i < g_bench->batches; ++i)
+        deviation[i] = Abs(perIteration[i] - result.medianNs);
+    result.madNs = Median(deviation, g_bench->batches);
+
+    uint8_t rest[128];
+    uint64_t n = StringWriteFmt(span<uint8_t>{rest, sizeof(rest)}, "%12.2f ns  +-%8.2f"_s, result.medianNs,
+                                result.madNs);
+    if (bytesPerIteration)
+        n += StringWriteFmt(span<uint8_t>{rest + n, sizeof(rest) - n}, "  %9.1f MiB/s"_s,
+                            (double)bytesPerIteration / result.medianNs * 1e9 / (1 << 20));
+    LogRow(name, byteview{rest, n});
+    return result.medianNs;
+}
+
+auto WriteJson(byteview path) -> bool
+{
+    file_handle file = FileOpen(path, FileOpenMode::Write);
+    if (!FileValid(file))
+    {
+        LOG("bench: could not write " SV_FMT, SV_ARG(path));
+        return false;
+    }
+
+    uint8_t buf[512];
+    FileWriteFmt(file, span<uint8_t>{buf, sizeof(buf)}, "{\n  \"tscTicksPerNs\": %.4f,\n  \"results\": ["_s,
+                 g_bench->tscTicksPerNs);
+    for (uint32_t i = 0; i < g_bench->resultCount; ++i)
+    {
+        const bench_result &r = g_bench->results[i];
+        FileWriteFmt(file, span<uint8_t>{buf, sizeof(buf)},
+                     "%s\n    {\"name\": \"" SV_FMT "\", \"iterations\": %" PRIu64 ", \"batches\": %u, "
+                     "\"medianNs\": %.3f, \"madNs\": %.3f, \"minNs\": %.3f, \"bytesPerIteration\": %" PRIu64 "}"_s,
+                     i ? "," : "", SV_ARG(r.name), r.iterations, r.batches, r.medianNs, r.madNs, r.minNs,
+                     r.bytesPerIteration);
+    }
+    FileWriteFmt(file, span<uint8_t>{buf, sizeof(buf)}, "\n  ]\n}\n"_s);
+    FileClose(file);
+
+    LOG("bench: wrote " SV_FMT, SV_ARG(path));
+    return true;
+}
+
+auto Compare(byteview basePath, byteview newPath) -> bool
+{
+    region_alloc alloc = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+
+    json_value *base = ReadResults(alloc, basePath);
+    json_value *next = base ? ReadResults(alloc, newPath) : nullptr;
+    if (!next)
+    {
+        RegionAlloc::Destroy(alloc);
+        return false;
+    }
+
+    LogRow("case"_s, "     base ns       new ns    change"_s);
+    uint32_t faster = 0;
+    uint32_t slower = 0;
+    for (json_value &result : *next)
+    {
+        const byteview name = JsonValue::String(result, "name"_s);
+        const double newMedian = JsonValue::Double(result, "medianNs"_s);
+
+        uint8_t rest[128];
+        uint64_t n;
+        json_value *old;
+        if (!FindResult(*base, name, old))
+        {
+            n = StringWriteFmt(span<uint8_t>{rest, sizeof(rest)}, "           - %12.2f       new"_s, newMedian);
+            LogRow(name, byteview{rest, n});
+            continue;
+        }
+
+        const double oldMedian = JsonValue::Double(*old, "medianNs"_s);
+        const double noise = 3 * (JsonValue::Double(*old, "madNs"_s) + JsonValue::Double(result, "madNs"_s));
+        const double delta = newMedian - oldMedian;
+        const double percent = oldMedian > 0 ? delta / oldMedian * 100 : 0;
+
+        const char *mark = "";
+        if (Abs(percent) > 2 && Abs(delta) > noise)
+        {
+            mark = delta < 0 ? "  faster" : "  SLOWER";
+            ++(delta < 0 ? faster : slower);
+        }
+
+        n = StringWriteFmt(span<uint8_t>{rest, sizeof(rest)}, "%12.2f %12.2f %8.1f%%%s"_s, oldMedian, newMedian,
+                           percent, mark);
+        LogRow(name, byteview{rest, n});
+    }
+    LOG("bench: %u faster, %u slower", faster, slower);
+
+    RegionAlloc::Destroy(alloc);
+    return true;
+}
+
+} // namespace Bench
+
+} // namespace nyla
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nyla/commons/macros.h"
+#include "nyla/commons/span_def.h"
+
+namespace nyla
+{
+
+// Runs the code under test iterations times in a row, the harness times the whole call.
+using bench_fn = void (*)(void *user, uint64_t iterations);
+
+namespace Bench
+{
+
+// Calibrates the TSC against the monotonic clock. Only cases whose name contains filter run, an empty filter runs
+// everything. Quick takes fewer and shorter batches, for checking that the suites still work rather than for numbers.
+void Bootstrap(byteview filter, bool quick);
+
+// Warms up while doubling the iteration count until a batch takes about a millisecond, then times a fixed number of
+// batches and records the median and the median absolute deviation of the time per iteration. name must outlive the
+// run, bytesPerIteration adds a throughput column when non zero. Returns the median, zero when filtered out.
+auto Run(byteview name, bench_fn fn, void *user, uint64_t bytesPerIteration = 0) -> double;
+
+// Whether the filter lets name through, for measurements that are not timings.
+auto Selected(byteview name) -> bool;
+
+// { "tscTicksPerNs": ..., "results": [ { "name": ..., "medianNs": ..., "madNs": ..., ... } ] }
+auto WriteJson(byteview path) -> bool;
+
+// Matches cases by name and prints the change of the median. A change is only flagged when it is larger than 2% and
+// than three times the combined MAD of both runs. Returns false when a file can not be read.
+auto Compare(byteview basePath, byteview newPath) -> bool;
+
+// Keeps a value the benchmark computes from being optimized away, without storing it anywhere.
+template <typename T> INLINE void Keep(const T &value)
+{
+#if defined(__clang__) || defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    *(volatile const T *)&value;
+    _ReadWriteBarrier();
+#endif
+}
+
+} // namespace Bench
+
+} // namespace nyla
@@ -0,0 +1,48 @@
+#include <cstdint>
+
+#include "nyla/commons/engine.h"
+#include "nyla/commons/game_module.h"
+
+namespace nyla
+{
+
+namespace
+{
+
+// The smallest game there is, for timing GameModule itself.
+struct bench_game_state
+{
+    uint32_t loads;
+    uint64_t updates;
+};
+
+void Init(void *state, bool)
+{
+    ++static_cast<bench_game_state *>(state)->loads;
+}
+
+void Update(void *state, const engine_frame &)
+{
+    ++static_cast<bench_game_state *>(state)->updates;
+}
+
+void Render(void *, const engine_frame &, uint32_t, uint32_t)
+{
+}
+
+constexpr game_api kGameApi{
+    .version = kGameApiVersion,
+    .stateSize = sizeof(bench_game_state),
+    .init = &Init,
+    .update = &Update,
+    .render = &Render,
+};
+
+} // namespace
+
+NYLA_GAME_EXPORT auto NylaGetGameApi() -> const game_api *
+{
+    return &kGameApi;
+}
+
+} // namespace nyla
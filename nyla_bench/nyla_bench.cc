@@ -0,0 +1,2812 @@
+#include <cinttypes>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "nyla/commons/array.h" // IWYU pragma: keep
+#include "nyla/commons/asset_file_format.h"
+#include "nyla/commons/asset_import.h"
+#include "nyla/commons/asset_manager.h"
+#include "nyla/commons/audio.h"
+#include "nyla/commons/bdf.h"
+#include "nyla/commons/byteliterals.h"
+#include "nyla/commons/byteparser.h"
+#include "nyla/commons/cell_renderer.h"
+#include "nyla/commons/debug_text_renderer.h"
+#include "nyla/commons/dev_shaders.h"
+#include "nyla/commons/dir_watcher.h"
+#include "nyla/commons/entrypoint_headless.h"
+#include "nyla/commons/file.h"
+#include "nyla/commons/file_utils.h"
+#include "nyla/commons/float_conv.h"
+#include "nyla/commons/fmt.h"
+#include "nyla/commons/game_module.h"
+#include "nyla/commons/gamepad.h"
+#include "nyla/commons/gltf.h"
+#include "nyla/commons/handle.h"
+#include "nyla/commons/handle_pool.h"
+#include "nyla/commons/input_manager.h"
+#include "nyla/commons/intrin.h"
+#include "nyla/commons/job_system.h"
+#include "nyla/commons/json_parser.h"
+#include "nyla/commons/log.h"
+#include "nyla/commons/macros.h" // IWYU pragma: keep
+#include "nyla/commons/mat.h"
+#include "nyla/commons/mem.h"
+#include "nyla/commons/mempage_pool.h"
+#include "nyla/commons/mesh_manager.h"
+#include "nyla/commons/minmax.h"
+#include "nyla/commons/platform.h"
+#include "nyla/commons/platform_audio.h"
+#include "nyla/commons/platform_condvar.h"
+#include "nyla/commons/platform_mutex.h"
+#include "nyla/commons/platform_thread.h"
+#include "nyla/commons/qoa.h"
+#include "nyla/commons/random.h"
+#include "nyla/commons/region_alloc.h"
+#include "nyla/commons/renderer.h"
+#include "nyla/commons/scrollback.h"
+#include "nyla/commons/span.h"
+#include "nyla/commons/texture_manager.h"
+#include "nyla/commons/time.h"
+#include "nyla/commons/wave.h"
+#include "nyla_bench/bench.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nyla
+{
+
+namespace
+{
+
+// Inputs are generated, so the numbers do not depend on what happens to be in assets/. The seed is fixed so that two
+// runs see the same data.
+void Seed(uint64_t (&s)[4])
+{
+    s[0] = 0x9E3779B97F4A7C15;
+    s[1] = 0xBF58476D1CE4E5B9;
+    s[2] = 0x94D049BB133111EB;
+    s[3] = 0x2545F4914F6CDD1D;
+}
+
+struct text_builder
+{
+    span<uint8_t> buf;
+    uint64_t size;
+};
+
+void Add(text_builder &self, byteview fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    self.size += StringWriteFmt_(span<uint8_t>{self.buf.data + self.size, self.buf.size - self.size}, fmt, args);
+    va_end(args);
+}
+
+auto Text(const text_builder &self) -> byteview
+{
+    return byteview{self.buf.data, self.size};
+}
+
+//
+
+struct region_alloc_bench
+{
+    region_alloc alloc;
+    uint64_t size;
+};
+
+void RegionAllocAlloc(void *user, uint64_t iterations)
+{
+    auto &b = *(region_alloc_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        if ((i & 1023) == 0)
+            RegionAlloc::Reset(b.alloc);
+        Bench::Keep(RegionAlloc::Alloc(b.alloc, b.size, 16));
+    }
+}
+
+void RegionAllocAllocUninit(void *user, uint64_t iterations)
+{
+    auto &b = *(region_alloc_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        if ((i & 1023) == 0)
+            RegionAlloc::Reset(b.alloc);
+        Bench::Keep(RegionAlloc::AllocUninit(b.alloc, b.size, 16));
+    }
+}
+
+void BenchRegionAlloc()
+{
+    static region_alloc_bench small{.alloc = RegionAlloc::Create(1 << 20, 1 << 20), .size = 64};
+    static region_alloc_bench large{.alloc = RegionAlloc::Create(4 << 20, 4 << 20), .size = 4096};
+
+    Bench::Run("region_alloc/alloc_64"_s, &RegionAllocAlloc, &small);
+    Bench::Run("region_alloc/alloc_4k"_s, &RegionAllocAlloc, &large, large.size);
+    Bench::Run("region_alloc/alloc_uninit_64"_s, &RegionAllocAllocUninit, &small);
+}
+
+//
+
+struct bench_handle : handle
+{
+};
+
+constexpr uint32_t kPoolLive = 192;
+constexpr uint32_t kResolveCount = 1024;
+
+struct handle_pool_bench
+{
+    handle_pool<bench_handle, uint64_t, 256> pool;
+    bench_handle handles[kResolveCount];
+};
+
+// The pool scans for a free slot from the front, so acquiring behind 192 live slots is the realistic case.
+void HandlePoolAcquireRelease(void *user, uint64_t iterations)
+{
+    auto &b = *(handle_pool_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const bench_handle h = HandlePool::Acquire(b.pool, i);
+        Bench::Keep(HandlePool::ReleaseData(b.pool, h));
+    }
+}
+
+void HandlePoolResolve(void *user, uint64_t iterations)
+{
+    auto &b = *(handle_pool_bench *)user;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+        sum += HandlePool::ResolveData(b.pool, b.handles[i & (kResolveCount - 1)]);
+    Bench::Keep(sum);
+}
+
+void BenchHandlePool(region_alloc &alloc)
+{
+    auto &b = RegionAlloc::Alloc<handle_pool_bench>(alloc);
+
+    bench_handle live[kPoolLive];
+    for (uint32_t i = 0; i < kPoolLive; ++i)
+        live[i] = HandlePool::Acquire(b.pool, (uint64_t)i);
+
+    uint64_t rng[4];
+    Seed(rng);
+    for (uint32_t i = 0; i < kResolveCount; ++i)
+        b.handles[i] = live[Xoshiro256ss(rng) % kPoolLive];
+
+    Bench::Run("handle_pool/acquire_release"_s, &HandlePoolAcquireRelease, &b);
+    Bench::Run("handle_pool/resolve"_s, &HandlePoolResolve, &b);
+}
+
+//
+
+constexpr uint32_t kAssetCount = 4096;
+constexpr uint32_t kAssetSize = 64;
+constexpr uint32_t kOverrideCount = 64;
+constexpr uint32_t kLookupCount = 1024;
+
+struct asset_manager_bench
+{
+    uint64_t packed[kLookupCount];
+    uint64_t overrides[kLookupCount];
+};
+
+void AssetManagerGet(void *user, uint64_t iterations)
+{
+    const uint64_t *guids = (const uint64_t *)user;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+        sum += AssetManager::Get(guids[i & (kLookupCount - 1)]).size;
+    Bench::Keep(sum);
+}
+
+// AssetManager only boots from a file, so the database is written next to the results first.
+void BenchAssetManager(region_alloc &alloc)
+{
+    constexpr uint64_t kGuidBase = 0x1000;
+    constexpr uint64_t kGuidStride = 7919;
+
+    const uint64_t dataOffset = sizeof(assetdb_header) + kAssetCount * sizeof(assetdb_index_entry);
+    span<uint8_t> db = RegionAlloc::AllocArray<uint8_t>(alloc, dataOffset + kAssetCount * kAssetSize);
+
+    auto *header = (assetdb_header *)db.data;
+    header->magic = kAssetDbMagic;
+    header->entryCount = kAssetCount;
+    auto *index = (assetdb_index_entry *)(db.data + sizeof(assetdb_header));
+    for (uint32_t i = 0; i < kAssetCount; ++i)
+    {
+        index[i] = assetdb_index_entry{
+            .guid = kGuidBase + i * kGuidStride,
+            .dataOffset = dataOffset + i * kAssetSize,
+            .dataSize = kAssetSize,
+        };
+    }
+
+    const byteview path = "nyla-bench-assets.bin"_s;
+    file_handle file = FileOpen(path, FileOpenMode::Write);
+    ASSERT(FileValid(file));
+    ASSERT(FileWrite(file, (uint32_t)db.size, db.data) == db.size);
+    FileClose(file);
+
+    file = FileOpen(path, FileOpenMode::Read);
+    ASSERT(FileValid(file));
+    AssetManager::Bootstrap(file);
+    FileClose(file);
+
+    auto &b = RegionAlloc::Alloc<asset_manager_bench>(alloc);
+    const uint64_t overrideBase = kGuidBase + kAssetCount * kGuidStride;
+    for (uint32_t i = 0; i < kOverrideCount; ++i)
+        AssetManager::Set(overrideBase + i, byteview{db.data, kAssetSize});
+
+    uint64_t rng[4];
+    Seed(rng);
+    for (uint32_t i = 0; i < kLookupCount; ++i)
+    {
+        b.packed[i] = kGuidBase + (Xoshiro256ss(rng) % kAssetCount) * kGuidStride;
+        b.overrides[i] = overrideBase + Xoshiro256ss(rng) % kOverrideCount;
+    }
+
+    Bench::Run("asset_manager/get_packed"_s, &AssetManagerGet, b.packed);
+    Bench::Run("asset_manager/get_override"_s, &AssetManagerGet, b.overrides);
+}
+
+//
+
+struct parse_bench
+{
+    region_alloc alloc;
+    byteview text;
+};
+
+void JsonParse(void *user, uint64_t iterations)
+{
+    auto &b = *(parse_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        RegionAlloc::Reset(b.alloc);
+        const json_result json = JsonParser::Parse(b.text, b.alloc);
+        ASSERT(json.error == json_error::None);
+        Bench::Keep(json.root);
+    }
+}
+
+// The JSON chunk of a glTF as exporters write it: meshes of one indexed primitive, four accessors each with
+// seven digit bounds.
+auto MakeGltfJson(region_alloc &alloc, uint32_t meshes) -> byteview
+{
+    constexpr uint32_t kTextures = 8;
+
+    text_builder tb{.buf = RegionAlloc::AllocArrayUninit<uint8_t>(alloc, uint64_t{meshes} * 2048 + 4096)};
+    uint64_t rng[4];
+    Seed(rng);
+
+    Add(tb, "{\"asset\": {\"version\": \"2.0\"},\n\"buffers\": [{\"byteLength\": %u, \"uri\": \"level.bin\"}],\n"_s,
+        meshes * 4096);
+
+    Add(tb, "\"images\": ["_s);
+    for (uint32_t i = 0; i < kTextures; ++i)
+        Add(tb, "%s{\"uri\": \"tex_%u.png\", \"mimeType\": \"image/png\"}"_s, i ? ", " : "", i);
+    Add(tb, "],\n\"textures\": ["_s);
+    for (uint32_t i = 0; i < kTextures; ++i)
+        Add(tb, "%s{\"source\": %u, \"sampler\": 0}"_s, i ? ", " : "", i);
+    Add(tb, "],\n\"materials\": ["_s);
+    for (uint32_t i = 0; i < kTextures; ++i)
+        Add(tb, "%s{\"name\": \"mat_%u\", \"pbrMetallicRoughness\": {\"baseColorTexture\": {\"index\": %u}, "
+                "\"metallicFactor\": 0.0}}"_s,
+            i ? ", " : "", i, i);
+
+    Add(tb, "],\n\"bufferViews\": ["_s);
+    for (uint32_t i = 0; i < meshes * 4; ++i)
+        Add(tb, "%s\n  {\"buffer\": 0, \"byteOffset\": %u, \"byteLength\": 1024, \"byteStride\": 12}"_s,
+            i ? "," : "", i * 1024);
+
+    const char *types[4] = {"VEC3", "VEC3", "VEC2", "SCALAR"};
+    const uint32_t components[4] = {5126, 5126, 5126, 5123};
+    Add(tb, "],\n\"accessors\": ["_s);
+    for (uint32_t i = 0; i < meshes * 4; ++i)
+    {
+        double bounds[6];
+        for (double &bound : bounds)
+            bound = (double)(Xoshiro256ss(rng) % 10'000'000) * 1e-7;
+        Add(tb,
+            "%s\n  {\"bufferView\": %u, \"componentType\": %u, \"count\": 85, \"type\": \"%s\", "
+            "\"min\": [-%.7f, -%.7f, -%.7f], \"max\": [%.7f, %.7f, %.7f]}"_s,
+            i ? "," : "", i, components[i & 3], types[i & 3], bounds[0], bounds[1], bounds[2], bounds[3], bounds[4],
+            bounds[5]);
+    }
+
+    Add(tb, "],\n\"meshes\": ["_s);
+    for (uint32_t i = 0; i < meshes; ++i)
+        Add(tb,
+            "%s\n  {\"name\": \"mesh_%u\", \"primitives\": [{\"attributes\": {\"POSITION\": %u, \"NORMAL\": %u, "
+            "\"TEXCOORD_0\": %u}, \"indices\": %u, \"material\": %u}]}"_s,
+            i ? "," : "", i, i * 4, i * 4 + 1, i * 4 + 2, i * 4 + 3, i % kTextures);
+    Add(tb, "\n]}\n"_s);
+    ASSERT(tb.size < tb.buf.size);
+    return Text(tb);
+}
+
+// A 4096 mesh glTF, about 4.5 MB where floats dominate, and scene-like records: integers, short strings, nested
+// objects.
+void BenchJson(region_alloc &alloc)
+{
+    static parse_bench b{.alloc = RegionAlloc::Create(256 << 20, 0)};
+
+    b.text = MakeGltfJson(alloc, 4096);
+    Bench::Run("json_parser/parse"_s, &JsonParse, &b, b.text.size);
+
+    text_builder tb{.buf = RegionAlloc::AllocArrayUninit<uint8_t>(alloc, 1 << 20)};
+    uint64_t rng[4];
+    Seed(rng);
+
+    Add(tb, "{\"entities\": ["_s);
+    for (uint32_t i = 0; i < 2000; ++i)
+    {
+        const double x = (double)(Xoshiro256ss(rng) % 100000) / 100;
+        const double y = (double)(Xoshiro256ss(rng) % 100000) / 100;
+        Add(tb,
+            "%s\n  {\"id\": %u, \"name\": \"entity_%u\", \"pos\": [%.2f, %.2f, 0.0], \"scale\": 1.5e-3, "
+            "\"active\": %s, \"tags\": [\"dynamic\", \"lit\"], \"parent\": null, \"mesh\": {\"guid\": %u}}"_s,
+            i ? "," : "", i, i, x, y, (i & 1) ? "true" : "false", i * 31);
+    }
+    Add(tb, "\n]}\n"_s);
+    b.text = Text(tb);
+
+    Bench::Run("json_parser/parse_records"_s, &JsonParse, &b, b.text.size);
+}
+
+//
+
+void GltfParse(void *user, uint64_t iterations)
+{
+    auto &b = *(parse_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        RegionAlloc::Reset(b.alloc);
+        gltf_parser gltf{.jsonChunk = b.text};
+        ASSERT(GltfParser::Parse(gltf, b.alloc));
+        Bench::Keep(gltf.meshes.data);
+    }
+}
+
+// The JSON chunk of a level sized glTF, 64 meshes.
+void BenchGltf(region_alloc &alloc)
+{
+    static parse_bench b{.alloc = RegionAlloc::Create(64 << 20, 0)};
+    b.text = MakeGltfJson(alloc, 64);
+    Bench::Run("gltf_parser/parse"_s, &GltfParse, &b, b.text.size);
+}
+
+//
+
+void WriteFmt(void *user, uint64_t iterations)
+{
+    uint8_t buf[256];
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const uint64_t n = StringWriteFmt(span<uint8_t>{buf, sizeof(buf)},
+                                          "%s: frame %u at %.3f ms, guid 0x%016" PRIx64 ", %d items " SV_FMT "\n"_s,
+                                          "renderer", (uint32_t)i, (double)i * 0.016, i * 0x9E3779B97F4A7C15,
+                                          -(int32_t)(i & 255), SV_ARG("ok"_s));
+        Bench::Keep(n);
+    }
+}
+
+void BenchFmt()
+{
+    Bench::Run("fmt/string_write"_s, &WriteFmt, nullptr);
+}
+
+//
+
+constexpr uint32_t kFloatConvChecks = 2'000'000;
+constexpr uint32_t kFloatConvValues = 1024;
+
+struct float_conv_bench
+{
+    double values[kFloatConvValues];
+    char text[kFloatConvValues][FloatConv::kMaxShortestChars + 1];
+    uint32_t textSize[kFloatConvValues];
+};
+
+// Any finite bit pattern, so every exponent and subnormals come up as often as ordinary values.
+auto RandomDouble(uint64_t (&rng)[4]) -> double
+{
+    for (;;)
+    {
+        const uint64_t bits = Xoshiro256ss(rng);
+        if ((bits >> 52 & 0x7FF) == 0x7FF)
+            continue;
+        double ret;
+        MemCpy(&ret, &bits, sizeof(ret));
+        return ret;
+    }
+}
+
+auto RandomFloatBits(uint64_t (&rng)[4]) -> float
+{
+    for (;;)
+    {
+        const uint32_t bits = (uint32_t)(Xoshiro256ss(rng) >> 32);
+        if ((bits >> 23 & 0xFF) == 0xFF)
+            continue;
+        float ret;
+        MemCpy(&ret, &bits, sizeof(ret));
+        return ret;
+    }
+}
+
+// Parses text, which has to be nul terminated, with both ParseDouble and the C library and compares the bits.
+void CheckParse(const char *text, uint64_t size)
+{
+    double got;
+    ASSERT(FloatConv::ParseDouble(byteview{(const uint8_t *)text, size}, got) == size,
+           "float_conv: ParseDouble stopped early in %s", text);
+    const double expected = strtod(text, nullptr);
+    ASSERT(MemEq(&got, &expected, sizeof(double)), "float_conv: ParseDouble(%s) is %g, strtod says %g", text,
+           got, expected);
+}
+
+// Halfway cases, the subnormal and overflow edges and literals longer than the 19 digits the fast path keeps.
+constexpr const char *kFloatConvHardCases[] = {
+    "0",
+    "-0.0",
+    "0.1",
+    "1e23",
+    "8.589973e9",
+    "7.038531e-26",
+    "9007199254740993",
+    "9007199254740993.0000000000000000001",
+    "9007199254740992.9999999999999999999",
+    "1.00000000000000011102230246251565404236316680908203125",
+    "1.00000000000000011102230246251565404236316680908203124",
+    "1.00000000000000011102230246251565404236316680908203126",
+    "2.2250738585072011e-308",
+    "2.2250738585072012e-308",
+    "2.2250738585072013e-308",
+    "4.9406564584124654e-324",
+    "2.4703282292062327e-324",
+    "2.4703282292062328e-324",
+    "1e-400",
+    "1.7976931348623157e308",
+    "1.7976931348623158e308",
+    "179769313486231580793728971405301e276",
+    "123456789012345678901234567890",
+    "0.000000000000000000000000000000000000000000001",
+    "3.14159265358979323846264338327950288419716939937510",
+    "4503599627370496.5",
+    "4503599627370497.5",
+    "1448997445238699",
+    "5e-324",
+    "1e308",
+};
+
+// Round trips go through FormatShortest and back through ParseDouble, and the text is also read by strtod so the
+// formatter is not only checked against its own parser. Floats are parsed as doubles and narrowed.
+void CheckFloatConv()
+{
+    uint64_t rng[4];
+    Seed(rng);
+
+    char text[FloatConv::kMaxShortestChars + 1];
+    for (uint32_t i = 0; i < kFloatConvChecks; ++i)
+    {
+        const double value = RandomDouble(rng);
+        const uint32_t size = FloatConv::FormatShortest(value, (uint8_t *)text);
+        text[size] = 0;
+
+        double parsed;
+        ASSERT(FloatConv::ParseDouble(byteview{(const uint8_t *)text, size}, parsed) == size);
+        ASSERT(MemEq(&parsed, &value, sizeof(double)), "float_conv: %g became %s, which parses to %g", value,
+               text, parsed);
+        const double libc = strtod(text, nullptr);
+        ASSERT(MemEq(&libc, &value, sizeof(double)), "float_conv: %g became %s, which strtod reads as %g",
+               value, text, libc);
+    }
+
+    for (uint32_t i = 0; i < kFloatConvChecks; ++i)
+    {
+        const float value = RandomFloatBits(rng);
+        const uint32_t size = FloatConv::FormatShortest(value, (uint8_t *)text);
+        text[size] = 0;
+
+        double parsed;
+        ASSERT(FloatConv::ParseDouble(byteview{(const uint8_t *)text, size}, parsed) == size);
+        const float narrowed = (float)parsed;
+        ASSERT(MemEq(&narrowed, &value, sizeof(float)), "float_conv: %g became %s, which parses to %g",
+               (double)value, text, (double)narrowed);
+        const float libc = strtof(text, nullptr);
+        ASSERT(MemEq(&libc, &value, sizeof(float)), "float_conv: %g became %s, which strtof reads as %g",
+               (double)value, text, (double)libc);
+    }
+
+    for (const char *hard : kFloatConvHardCases)
+        CheckParse(hard, CStrLen(hard, 128));
+
+    LOG("float_conv: %u doubles and %u floats round trip through FormatShortest and ParseDouble and agree with "
+        "strtod, %u hard literals parse like strtod",
+        kFloatConvChecks, kFloatConvChecks, (uint32_t)(sizeof(kFloatConvHardCases) / sizeof(kFloatConvHardCases[0])));
+}
+
+void FloatConvFormatShortest(void *user, uint64_t iterations)
+{
+    auto &b = *(float_conv_bench *)user;
+    uint8_t out[FloatConv::kMaxShortestChars];
+    for (uint64_t i = 0; i < iterations; ++i)
+        Bench::Keep(FloatConv::FormatShortest(b.values[i % kFloatConvValues], out));
+}
+
+// %.17g is what round trips without a shortest formatter.
+void FloatConvSnprintf(void *user, uint64_t iterations)
+{
+    auto &b = *(float_conv_bench *)user;
+    char out[32];
+    for (uint64_t i = 0; i < iterations; ++i)
+        Bench::Keep(snprintf(out, sizeof(out), "%.17g", b.values[i % kFloatConvValues]));
+}
+
+void FloatConvParseDouble(void *user, uint64_t iterations)
+{
+    auto &b = *(float_conv_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const uint64_t k = i % kFloatConvValues;
+        double value;
+        Bench::Keep(FloatConv::ParseDouble(byteview{(const uint8_t *)b.text[k], b.textSize[k]}, value));
+        Bench::Keep(value);
+    }
+}
+
+void FloatConvStrtod(void *user, uint64_t iterations)
+{
+    auto &b = *(float_conv_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+        Bench::Keep(strtod(b.text[i % kFloatConvValues], nullptr));
+}
+
+void BenchFloatConv(region_alloc &alloc)
+{
+    if (Bench::Selected("float_conv/round_trip"_s))
+        CheckFloatConv();
+
+    auto &b = RegionAlloc::Alloc<float_conv_bench>(alloc);
+    uint64_t rng[4];
+    Seed(rng);
+    for (uint32_t i = 0; i < kFloatConvValues; ++i)
+    {
+        b.values[i] = RandomDouble(rng);
+        b.textSize[i] = FloatConv::FormatShortest(b.values[i], (uint8_t *)b.text[i]);
+    }
+
+    Bench::Run("float_conv/format_shortest"_s, &FloatConvFormatShortest, &b);
+    Bench::Run("float_conv/snprintf_17g"_s, &FloatConvSnprintf, &b);
+    Bench::Run("float_conv/parse_double"_s, &FloatConvParseDouble, &b);
+    Bench::Run("float_conv/strtod"_s, &FloatConvStrtod, &b);
+}
+
+//
+
+struct bdf_bench
+{
+    region_alloc alloc;
+    byteview text;
+    bdf_parser parser;
+};
+
+void BdfNextGlyph(void *user, uint64_t iterations)
+{
+    auto &b = *(bdf_bench *)user;
+    bdf_glyph glyph;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        RegionAlloc::Reset(b.alloc);
+        if (!BdfParser::NextGlyph(b.parser, b.alloc, glyph))
+        {
+            ByteParser::Init(b.parser, b.text.data, b.text.size);
+            ASSERT(BdfParser::NextGlyph(b.parser, b.alloc, glyph));
+        }
+        Bench::Keep(glyph.bitmap.data);
+    }
+}
+
+// A 16x32 cell font like the one the cell renderer loads, 256 glyphs.
+auto MakeBdf(region_alloc &alloc) -> byteview
+{
+    text_builder tb{.buf = RegionAlloc::AllocArrayUninit<uint8_t>(alloc, 1 << 20)};
+    uint64_t rng[4];
+    Seed(rng);
+
+    Add(tb, "STARTFONT 2.1\nFONT -bench-fixed-medium-r-normal--32-240-75-75-C-160-ISO10646-1\nSIZE 24 75 75\n"
+            "FONTBOUNDINGBOX 16 32 0 -8\nCHARS 256\n"_s);
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        Add(tb, "STARTCHAR U+%04X\nENCODING %u\nSWIDTH 480 0\nDWIDTH 16 0\nBBX 16 32 0 -8\nBITMAP\n"_s, i, i);
+        for (uint32_t row = 0; row < 32; ++row)
+            Add(tb, "%04X\n"_s, (uint32_t)(Xoshiro256ss(rng) & 0xFFFF));
+        Add(tb, "ENDCHAR\n"_s);
+    }
+    Add(tb, "ENDFONT\n"_s);
+    return Text(tb);
+}
+
+void BenchBdf(region_alloc &alloc)
+{
+    static bdf_bench b{.alloc = RegionAlloc::Create(1 << 20, 0)};
+
+    b.text = MakeBdf(alloc);
+    ByteParser::Init(b.parser, b.text.data, b.text.size);
+
+    Bench::Run("bdf_parser/next_glyph"_s, &BdfNextGlyph, &b, b.text.size / 256);
+}
+
+//
+
+constexpr uint32_t kDebugTextStrings = 1000;
+constexpr uint64_t kDebugTextBdfGuid = 0x4000;
+constexpr uint64_t kDebugTextCellBytes = 16; // one packed CellRenderer instance per glyph
+
+struct debug_text_bench
+{
+    byteview strings[kDebugTextStrings];
+    uint64_t glyphs;
+};
+
+// Ten columns of a hundred strings, like a stats overlay.
+INLINE auto DebugTextX(uint32_t i) -> int32_t
+{
+    return (int32_t)(i % 10) * 480;
+}
+
+INLINE auto DebugTextY(uint32_t i) -> int32_t
+{
+    return (int32_t)(i / 10) * 32;
+}
+
+void DebugTextText(void *user, uint64_t iterations)
+{
+    auto &b = *(debug_text_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (uint32_t s = 0; s < kDebugTextStrings; ++s)
+            DebugTextRenderer::Text(DebugTextX(s), DebugTextY(s), b.strings[s]);
+        DebugTextRenderer::CmdFlush({});
+    }
+}
+
+void DebugTextFmt(void *, uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (uint32_t s = 0; s < kDebugTextStrings; ++s)
+            DebugTextRenderer::Fmt(DebugTextX(s), DebugTextY(s), "entity %u: pos %.2f %.2f"_s, s, s * .37, s * -1.3);
+        DebugTextRenderer::CmdFlush({});
+    }
+}
+
+// 1k strings per frame packed into the cell instances, preformatted and through Fmt. CellRenderer is headless, so
+// this is the CPU side up to the instance buffer.
+void BenchDebugText(region_alloc &alloc)
+{
+    if (!Bench::Selected("debug_text/text_1k"_s) && !Bench::Selected("debug_text/fmt_1k"_s))
+        return;
+
+    AssetManager::Set(kDebugTextBdfGuid, MakeBdf(alloc));
+    CellRenderer::BootstrapHeadless(cell_renderer_init_desc{.bdfGuid = kDebugTextBdfGuid, .maxCells = 32 * 1024});
+    DebugTextRenderer::Bootstrap(alloc);
+
+    auto &b = RegionAlloc::Alloc<debug_text_bench>(alloc);
+    for (uint32_t s = 0; s < kDebugTextStrings; ++s)
+    {
+        span<uint8_t> buf = RegionAlloc::AllocArray<uint8_t>(alloc, 64);
+        b.strings[s] = byteview{buf.data, StringWriteFmt(buf, "entity %u: pos %.2f %.2f"_s, s, s * .37, s * -1.3)};
+        b.glyphs += b.strings[s].size;
+    }
+    ASSERT(b.glyphs <= 32 * 1024);
+
+    Bench::Run("debug_text/text_1k"_s, &DebugTextText, &b, b.glyphs * kDebugTextCellBytes);
+    Bench::Run("debug_text/fmt_1k"_s, &DebugTextFmt, &b, b.glyphs * kDebugTextCellBytes);
+}
+
+//
+
+constexpr uint32_t kScrollbackLines = 1'000'000;
+constexpr uint32_t kScrollbackCols = 60;
+constexpr uint32_t kScrollbackSamples = 1024;
+constexpr uint64_t kScrollbackNeedleLine = kScrollbackLines / 2;
+
+struct scrollback_bench
+{
+    cell_attr lines[kScrollbackSamples][kScrollbackCols];
+    scrollback *pushed;
+    scrollback *full;
+    uint32_t next;
+};
+
+// Lowercase words and spaces in two colors, so a needle with a digit only matches where it is planted.
+void MakeScrollbackLine(uint64_t (&rng)[4], cell_attr (&cells)[kScrollbackCols])
+{
+    const uint32_t split = 8 + (uint32_t)(Xoshiro256ss(rng) % 16);
+    for (uint32_t col = 0; col < kScrollbackCols; ++col)
+    {
+        const uint64_t r = Xoshiro256ss(rng);
+        cells[col] = cell_attr{
+            .glyphIndex = (uint16_t)(r % 7 == 0 ? ' ' : 'a' + r % 26),
+            .fgRgba = col < split ? 0x55FF55FFu : 0xC0C0C0FFu,
+            .bgRgba = 0x000000FF,
+        };
+    }
+}
+
+void ScrollbackPushLine(void *user, uint64_t iterations)
+{
+    auto &b = *(scrollback_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        Scrollback::PushLine(*b.pushed, span<const cell_attr>{b.lines[b.next], kScrollbackCols});
+        b.next = (b.next + 1) % kScrollbackSamples;
+    }
+}
+
+void ScrollbackFindMiss(void *user, uint64_t iterations)
+{
+    auto &b = *(scrollback_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        scrollback_match match;
+        ASSERT(!Scrollback::FindPrev(*b.full, "zz9zz"_s, Scrollback::EndLine(*b.full), match));
+    }
+}
+
+void ScrollbackFindHit(void *user, uint64_t iterations)
+{
+    auto &b = *(scrollback_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        scrollback_match match;
+        ASSERT(Scrollback::FindPrev(*b.full, "needle42"_s, Scrollback::EndLine(*b.full), match));
+        ASSERT(match.line == kScrollbackNeedleLine);
+    }
+}
+
+// 1M lines of 60 cells with two attribute runs each, what a long build log leaves behind. find_miss scans every
+// line, find_hit stops halfway.
+void BenchScrollback(region_alloc &alloc)
+{
+    if (!Bench::Selected("scrollback/push_line"_s) && !Bench::Selected("scrollback/memory"_s) &&
+        !Bench::Selected("scrollback/find_miss"_s) && !Bench::Selected("scrollback/find_hit"_s))
+        return;
+
+    auto &b = RegionAlloc::Alloc<scrollback_bench>(alloc);
+    uint64_t rng[4];
+    Seed(rng);
+    for (uint32_t i = 0; i < kScrollbackSamples; ++i)
+        MakeScrollbackLine(rng, b.lines[i]);
+
+    b.pushed = Scrollback::Create(alloc, scrollback_desc{});
+    Bench::Run("scrollback/push_line"_s, &ScrollbackPushLine, &b, kScrollbackCols * sizeof(cell_attr));
+    Scrollback::Destroy(*b.pushed);
+
+    b.full = Scrollback::Create(alloc, scrollback_desc{.maxColdBytes = 256_MiB});
+    cell_attr needleLine[kScrollbackCols];
+    for (uint32_t i = 0; i < kScrollbackLines; ++i)
+    {
+        const cell_attr *cells = b.lines[i % kScrollbackSamples];
+        if (i == kScrollbackNeedleLine)
+        {
+            MemCpy(needleLine, cells, sizeof(needleLine));
+            const byteview needle = "needle42"_s;
+            for (uint32_t j = 0; j < needle.size; ++j)
+                needleLine[20 + j].glyphIndex = needle.data[j];
+            cells = needleLine;
+        }
+        Scrollback::PushLine(*b.full, span<const cell_attr>{cells, kScrollbackCols});
+    }
+    ASSERT(Scrollback::FirstLine(*b.full) == 0, "scrollback: dropped lines, raise maxColdBytes");
+
+    if (Bench::Selected("scrollback/memory"_s))
+    {
+        const uint64_t bytes = Scrollback::MemoryUsage(*b.full);
+        LOG("scrollback: %u lines of %u cells in %" PRIu64 " KiB, %.1f bytes per line, %u raw", kScrollbackLines,
+            kScrollbackCols, bytes >> 10, (double)bytes / kScrollbackLines,
+            (uint32_t)(kScrollbackCols * sizeof(cell_attr)));
+    }
+
+    Bench::Run("scrollback/find_miss"_s, &ScrollbackFindMiss, &b, uint64_t{kScrollbackLines} * kScrollbackCols);
+    Bench::Run("scrollback/find_hit"_s, &ScrollbackFindHit, &b,
+               (kScrollbackLines - kScrollbackNeedleLine) * kScrollbackCols);
+    Scrollback::Destroy(*b.full);
+}
+
+//
+
+constexpr uint32_t kMatBenchBatch = 1024;
+
+struct mat_bench
+{
+    mat<4, 4, float> m[64];
+    float3 p[64];
+
+    float soa[6][kMatBenchBatch];
+    translate_scale_soa batchIn;
+    mat<4, 4, float> batchOut[kMatBenchBatch];
+};
+
+void MatInverse(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const mat<4, 4, float> inv = Mat::Inverse(b.m[i & 63]);
+        Bench::Keep(inv);
+    }
+}
+
+void MatInverseScalar(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const mat<4, 4, float> inv = Mat::InverseScalar(b.m[i & 63]);
+        Bench::Keep(inv);
+    }
+}
+
+constexpr uint32_t kMatChecks = 4096;
+constexpr uint32_t kMatBatch = 67; // not a multiple of four, so the scalar tail runs too
+constexpr float kMatEpsilon = 1e-4f;
+
+auto RandomFloat(uint64_t (&rng)[4], float lo, float hi) -> float
+{
+    return lo + (hi - lo) * (float)(Xoshiro256ss(rng) >> 40) * (1.f / (float)(1 << 24));
+}
+
+// Relative to the larger of one and the expected value, the SIMD paths sum in another order than the references.
+auto MatNear(float got, float expected) -> bool
+{
+    const float diff = got > expected ? got - expected : expected - got;
+    const float mag = expected > 0.f ? expected : -expected;
+    return diff <= kMatEpsilon * (mag > 1.f ? mag : 1.f);
+}
+
+auto MatNear(const float4x4 &got, const float4x4 &expected) -> bool
+{
+    for (uint32_t col = 0; col < 4; ++col)
+    {
+        for (uint32_t row = 0; row < 4; ++row)
+        {
+            if (!MatNear(got[col][row], expected[col][row]))
+                return false;
+        }
+    }
+    return true;
+}
+
+auto MulScalar(const float4x4 &a, const float4x4 &b) -> float4x4
+{
+    float4x4 ret{};
+    for (uint32_t col = 0; col < 4; ++col)
+    {
+        for (uint32_t row = 0; row < 4; ++row)
+        {
+            for (uint32_t k = 0; k < 4; ++k)
+                ret[col][row] += a[k][row] * b[col][k];
+        }
+    }
+    return ret;
+}
+
+auto TransformPointScalar(const float4x4 &a, const float3 &p) -> float3
+{
+    float3 ret;
+    for (uint32_t k = 0; k < 3; ++k)
+        ret[k] = a[0][k] * p[0] + a[1][k] * p[1] + a[2][k] * p[2] + a[3][k];
+    return ret;
+}
+
+// Well conditioned but otherwise arbitrary: random entries on top of a dominant diagonal.
+auto RandomInvertible(uint64_t (&rng)[4]) -> float4x4
+{
+    float4x4 m;
+    for (uint32_t col = 0; col < 4; ++col)
+    {
+        for (uint32_t row = 0; row < 4; ++row)
+            m[col][row] = RandomFloat(rng, -1.f, 1.f) + (col == row ? 4.f : 0.f);
+    }
+    return m;
+}
+
+// The SIMD paths against the scalar ones, like input/replay this runs whatever the filter says.
+void CheckMat()
+{
+    uint64_t rng[4];
+    Seed(rng);
+
+    float4x4 identity;
+    Mat::Identity(identity);
+
+    for (uint32_t i = 0; i < kMatChecks; ++i)
+    {
+        const float4x4 a = i & 1 ? RandomInvertible(rng)
+                                 : Mat::TranslateRotateScale(
+                                       {RandomFloat(rng, -100.f, 100.f), RandomFloat(rng, -100.f, 100.f),
+                                        RandomFloat(rng, -100.f, 100.f)},
+                                       RandomFloat(rng, 0.f, 6.2831853f),
+                                       {RandomFloat(rng, 0.1f, 10.f), RandomFloat(rng, 0.1f, 10.f),
+                                        RandomFloat(rng, 0.1f, 10.f)});
+        const float4x4 b = RandomInvertible(rng);
+
+        ASSERT(MatNear(a * b, MulScalar(a, b)), "mat: operator* differs from the scalar product");
+
+        const float4x4 inv = Mat::Inverse(a);
+        ASSERT(MatNear(inv, Mat::InverseScalar(a)), "mat: Inverse differs from InverseScalar");
+        ASSERT(MatNear(MulScalar(a, inv), identity), "mat: Inverse times the matrix is not the identity");
+
+        const float3 p{RandomFloat(rng, -50.f, 50.f), RandomFloat(rng, -50.f, 50.f), RandomFloat(rng, -50.f, 50.f)};
+        const float3 got = Mat::TransformPoint(a, p);
+        const float3 expected = TransformPointScalar(a, p);
+        for (uint32_t k = 0; k < 3; ++k)
+            ASSERT(MatNear(got[k], expected[k]), "mat: TransformPoint differs from the scalar transform");
+    }
+
+    float soa[6][kMatBatch];
+    for (uint32_t k = 0; k < 6; ++k)
+    {
+        for (uint32_t i = 0; i < kMatBatch; ++i)
+            soa[k][i] = k < 3 ? RandomFloat(rng, -100.f, 100.f) : RandomFloat(rng, 0.1f, 10.f);
+    }
+    const translate_scale_soa in{
+        .posX = {soa[0], kMatBatch},
+        .posY = {soa[1], kMatBatch},
+        .posZ = {soa[2], kMatBatch},
+        .scaleX = {soa[3], kMatBatch},
+        .scaleY = {soa[4], kMatBatch},
+        .scaleZ = {soa[5], kMatBatch},
+    };
+    float4x4 batch[kMatBatch];
+    Mat::TranslateScaleBatch(in, span<float4x4>{batch, kMatBatch});
+    for (uint32_t i = 0; i < kMatBatch; ++i)
+    {
+        const float4x4 expected =
+            Mat::TranslateScale({soa[0][i], soa[1][i], soa[2][i]}, {soa[3][i], soa[4][i], soa[5][i]});
+        ASSERT(MemEq(&batch[i], &expected, sizeof(float4x4)), "mat: TranslateScaleBatch differs at %u", i);
+    }
+
+    LOG("mat: operator*, Inverse and TransformPoint match the scalar paths on %u matrices, TranslateScaleBatch "
+        "matches TranslateScale exactly",
+        kMatChecks);
+}
+
+void MatMul(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const mat<4, 4, float> m = b.m[i & 63] * b.m[(i + 1) & 63];
+        Bench::Keep(m);
+    }
+}
+
+void MatMulScalar(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const mat<4, 4, float> m = MulScalar(b.m[i & 63], b.m[(i + 1) & 63]);
+        Bench::Keep(m);
+    }
+}
+
+void MatTransformPoint(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const float3 p = Mat::TransformPoint(b.m[i & 63], b.p[(i >> 6) & 63]);
+        Bench::Keep(p);
+    }
+}
+
+void MatTransformPointScalar(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const float3 p = TransformPointScalar(b.m[i & 63], b.p[(i >> 6) & 63]);
+        Bench::Keep(p);
+    }
+}
+
+// One iteration is a batch of kMatBenchBatch instances.
+void MatTranslateScaleBatch(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        Mat::TranslateScaleBatch(b.batchIn, span<mat<4, 4, float>>{b.batchOut, kMatBenchBatch});
+        Bench::Keep(b.batchOut[i % kMatBenchBatch]);
+    }
+}
+
+void MatTranslateScaleBatchScalar(void *user, uint64_t iterations)
+{
+    auto &b = *(mat_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (uint32_t k = 0; k < kMatBenchBatch; ++k)
+            b.batchOut[k] = Mat::TranslateScale({b.soa[0][k], b.soa[1][k], b.soa[2][k]},
+                                                {b.soa[3][k], b.soa[4][k], b.soa[5][k]});
+        Bench::Keep(b.batchOut[i % kMatBenchBatch]);
+    }
+}
+
+void BenchMat(region_alloc &alloc)
+{
+    CheckMat();
+
+    auto &b = RegionAlloc::Alloc<mat_bench>(alloc);
+    uint64_t rng[4];
+    Seed(rng);
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        const float r = (float)(Xoshiro256ss(rng) % 6283) * 1e-3f;
+        b.m[i] = Mat::TranslateRotateScale({(float)i, 2.f, -3.f}, r, {1.f + (float)(i & 3), 2.f, 1.f});
+        b.p[i] = {RandomFloat(rng, -50.f, 50.f), RandomFloat(rng, -50.f, 50.f), RandomFloat(rng, -50.f, 50.f)};
+    }
+    for (uint32_t k = 0; k < 6; ++k)
+    {
+        for (uint32_t i = 0; i < kMatBenchBatch; ++i)
+            b.soa[k][i] = k < 3 ? RandomFloat(rng, -100.f, 100.f) : RandomFloat(rng, 0.1f, 10.f);
+    }
+    b.batchIn = {
+        .posX = {b.soa[0], kMatBenchBatch},
+        .posY = {b.soa[1], kMatBenchBatch},
+        .posZ = {b.soa[2], kMatBenchBatch},
+        .scaleX = {b.soa[3], kMatBenchBatch},
+        .scaleY = {b.soa[4], kMatBenchBatch},
+        .scaleZ = {b.soa[5], kMatBenchBatch},
+    };
+
+    Bench::Run("mat/inverse"_s, &MatInverse, &b);
+    Bench::Run("mat/inverse_scalar"_s, &MatInverseScalar, &b);
+    Bench::Run("mat/mul"_s, &MatMul, &b);
+    Bench::Run("mat/mul_scalar"_s, &MatMulScalar, &b);
+    Bench::Run("mat/transform_point"_s, &MatTransformPoint, &b);
+    Bench::Run("mat/transform_point_scalar"_s, &MatTransformPointScalar, &b);
+    Bench::Run("mat/translate_scale_batch"_s, &MatTranslateScaleBatch, &b, kMatBenchBatch * sizeof(float4x4));
+    Bench::Run("mat/translate_scale_batch_scalar"_s, &MatTranslateScaleBatchScalar, &b,
+               kMatBenchBatch * sizeof(float4x4));
+}
+
+//
+
+constexpr uint32_t kMeshGrid = 64;
+constexpr uint32_t kMeshVertices = (kMeshGrid + 1) * (kMeshGrid + 1);
+constexpr uint32_t kMeshIndices = kMeshGrid * kMeshGrid * 6;
+constexpr uint64_t kMeshGuid = 0x3000;
+constexpr uint64_t kMeshTextureGuid = 0x3001;
+
+struct mesh_bench
+{
+    region_alloc alloc; // what the parse path allocates per load
+    byteview json;
+    byteview bin;
+    byteview blob;
+    span<uint8_t> vertices;
+    span<uint8_t> indices;
+};
+
+// A rolling 64x64 quad terrain patch as one indexed primitive, the only shape the parse path loaded.
+void MakeMeshGltf(region_alloc &alloc, mesh_bench &b)
+{
+    constexpr uint32_t kPosOffset = 0;
+    constexpr uint32_t kNormOffset = kPosOffset + kMeshVertices * 12;
+    constexpr uint32_t kUvOffset = kNormOffset + kMeshVertices * 12;
+    constexpr uint32_t kIndexOffset = kUvOffset + kMeshVertices * 8;
+    constexpr uint32_t kBinSize = kIndexOffset + kMeshIndices * 2;
+
+    span<uint8_t> bin = RegionAlloc::AllocArray<uint8_t>(alloc, kBinSize);
+    auto *pos = (float *)(bin.data + kPosOffset);
+    auto *norm = (float *)(bin.data + kNormOffset);
+    auto *uv = (float *)(bin.data + kUvOffset);
+    for (uint32_t z = 0; z <= kMeshGrid; ++z)
+    {
+        for (uint32_t x = 0; x <= kMeshGrid; ++x)
+        {
+            const uint32_t v = z * (kMeshGrid + 1) + x;
+            const float fx = (float)x - kMeshGrid * .5f;
+            const float fz = (float)z - kMeshGrid * .5f;
+            const float y = 2.f * std::sin(fx * .2f) * std::cos(fz * .15f);
+
+            pos[v * 3 + 0] = fx;
+            pos[v * 3 + 1] = y;
+            pos[v * 3 + 2] = fz;
+            norm[v * 3 + 0] = 0.f;
+            norm[v * 3 + 1] = 1.f;
+            norm[v * 3 + 2] = 0.f;
+            uv[v * 2 + 0] = (float)x / kMeshGrid;
+            uv[v * 2 + 1] = (float)z / kMeshGrid;
+        }
+    }
+
+    auto *index = (uint16_t *)(bin.data + kIndexOffset);
+    for (uint32_t z = 0; z < kMeshGrid; ++z)
+    {
+        for (uint32_t x = 0; x < kMeshGrid; ++x)
+        {
+            const auto v = (uint16_t)(z * (kMeshGrid + 1) + x);
+            const auto below = (uint16_t)(v + kMeshGrid + 1);
+            const uint16_t quad[6] = {v, below, (uint16_t)(v + 1), (uint16_t)(v + 1), below, (uint16_t)(below + 1)};
+            MemCpy(index, quad, sizeof(quad));
+            index += 6;
+        }
+    }
+    b.bin = bin;
+
+    text_builder tb{.buf = RegionAlloc::AllocArrayUninit<uint8_t>(alloc, 4096)};
+    Add(tb,
+        "{\"asset\": {\"version\": \"2.0\"}, \"buffers\": [{\"byteLength\": %u}],\n"
+        "\"images\": [{\"uri\": \"patch.png\"}], \"textures\": [{\"source\": 0}],\n"
+        "\"materials\": [{\"pbrMetallicRoughness\": {\"baseColorTexture\": {\"index\": 0}}}],\n"_s,
+        kBinSize);
+    Add(tb,
+        "\"bufferViews\": [{\"buffer\": 0, \"byteOffset\": %u, \"byteLength\": %u}, "
+        "{\"buffer\": 0, \"byteOffset\": %u, \"byteLength\": %u}, {\"buffer\": 0, \"byteOffset\": %u, "
+        "\"byteLength\": %u}, {\"buffer\": 0, \"byteOffset\": %u, \"byteLength\": %u}],\n"_s,
+        kPosOffset, kNormOffset - kPosOffset, kNormOffset, kUvOffset - kNormOffset, kUvOffset,
+        kIndexOffset - kUvOffset, kIndexOffset, kBinSize - kIndexOffset);
+    Add(tb,
+        "\"accessors\": [{\"bufferView\": 0, \"componentType\": 5126, \"count\": %u, \"type\": \"VEC3\"}, "
+        "{\"bufferView\": 1, \"componentType\": 5126, \"count\": %u, \"type\": \"VEC3\"}, "
+        "{\"bufferView\": 2, \"componentType\": 5126, \"count\": %u, \"type\": \"VEC2\"}, "
+        "{\"bufferView\": 3, \"componentType\": 5123, \"count\": %u, \"type\": \"SCALAR\"}],\n"_s,
+        kMeshVertices, kMeshVertices, kMeshVertices, kMeshIndices);
+    Add(tb, "\"meshes\": [{\"name\": \"patch\", \"primitives\": [{\"attributes\": {\"POSITION\": 0, "
+            "\"NORMAL\": 1, \"TEXCOORD_0\": 2}, \"indices\": 3, \"material\": 0}]}]}\n"_s);
+    b.json = Text(tb);
+}
+
+// What MeshManager::Update did per mesh before meshes were cooked: parse the glTF, copy the indices and interleave
+// the three attributes one MemCpy each.
+void LoadMeshGltf(mesh_bench &b)
+{
+    RegionAlloc::Reset(b.alloc);
+    gltf_parser gltf{.jsonChunk = b.json, .binChunk = b.bin};
+    ASSERT(GltfParser::Parse(gltf, b.alloc));
+
+    const gltf_mesh_primitive &primitive = Span::Front(Span::Front(gltf.meshes).primitives);
+    const gltf_accessor &indices = gltf.accessors[primitive.indices];
+    ASSERT(indices.componentType == gltf_accessor_component_type::UNSIGNED_SHORT);
+    const byteview indexData = GltfParser::GetAccessorData(gltf, indices);
+    MemCpy(b.indices.data, indexData.data, indexData.size);
+
+    gltf_accessor attributes[3];
+    const byteview names[3] = {"POSITION"_s, "NORMAL"_s, "TEXCOORD_0"_s};
+    uint32_t offsets[3];
+    uint32_t stride = 0;
+    for (uint32_t a = 0; a < 3; ++a)
+    {
+        ASSERT(GltfParser::FindAttributeAccessor(gltf, primitive.attributes, names[a], attributes[a]));
+        offsets[a] = stride;
+        stride += GetGltfAccessorSize(attributes[a]);
+    }
+
+    const byteview data[3] = {GltfParser::GetAccessorData(gltf, attributes[0]),
+                              GltfParser::GetAccessorData(gltf, attributes[1]),
+                              GltfParser::GetAccessorData(gltf, attributes[2])};
+    for (uint32_t i = 0; i < attributes[0].count; ++i)
+    {
+        for (uint32_t a = 0; a < 3; ++a)
+        {
+            const uint32_t size = GetGltfAccessorSize(attributes[a]);
+            MemCpy(b.vertices.data + uint64_t{i} * stride + offsets[a], data[a].data + uint64_t{i} * size, size);
+        }
+    }
+}
+
+// Cooked the way asset_packer does, quantized with every lod.
+auto CookMesh(region_alloc &alloc, const mesh_bench &b) -> byteview
+{
+    gltf_parser gltf{.jsonChunk = b.json, .binChunk = b.bin};
+    ASSERT(GltfParser::Parse(gltf, alloc));
+    const uint64_t imageGuid = kMeshTextureGuid;
+    const byteview blob = ImportMeshFromGltf(gltf, span<const uint64_t>{&imageGuid, 1}, mesh_import_options{}, alloc);
+    ASSERT(blob.size);
+    return blob;
+}
+
+void MeshLoadCooked(void *user, uint64_t iterations)
+{
+    auto &b = *(mesh_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        AssetManager::Set(kMeshGuid, b.blob);
+        MeshManager::Update({});
+    }
+}
+
+void MeshLoadGltf(void *user, uint64_t iterations)
+{
+    auto &b = *(mesh_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        LoadMeshGltf(b);
+        Bench::Keep(b.vertices.data);
+    }
+}
+
+// One 8k triangle mesh loaded through the cooked blob, which is what MeshManager runs now, and through the glTF parse
+// it replaced. Both copy their streams to CPU memory, the GPU upload itself is not timed.
+void BenchMesh(region_alloc &alloc)
+{
+    if (!Bench::Selected("mesh/load_cooked"_s) && !Bench::Selected("mesh/load_gltf"_s))
+        return;
+
+    auto &b = RegionAlloc::Alloc<mesh_bench>(alloc);
+    b.alloc = RegionAlloc::Create(16 << 20, 0);
+    b.vertices =
+        RegionAlloc::AllocArray<uint8_t>(alloc, uint64_t{kMeshVertices} * (sizeof(float3) * 2 + sizeof(float2)));
+    b.indices = RegionAlloc::AllocArray<uint8_t>(alloc, uint64_t{kMeshIndices} * sizeof(uint16_t));
+    MakeMeshGltf(alloc, b);
+    b.blob = CookMesh(alloc, b);
+
+    const mesh_handle mesh = MeshManager::DeclareMesh(kMeshGuid);
+    AssetManager::Set(kMeshGuid, b.blob);
+    MeshManager::Update({});
+    ASSERT(MeshManager::GetLodCount(mesh) > 1);
+
+    Bench::Run("mesh/load_cooked"_s, &MeshLoadCooked, &b, b.blob.size);
+    Bench::Run("mesh/load_gltf"_s, &MeshLoadGltf, &b, b.json.size + b.bin.size);
+}
+
+//
+
+constexpr uint32_t kRendererInstances = 100'000;
+constexpr uint32_t kRendererMeshes = 16;
+// One in a hundred instances moves per frame, the rest of the scene is static.
+constexpr uint32_t kRendererMovedPerFrame = kRendererInstances / 100;
+// Renderer queues this many immediate draws between two CmdFlush.
+constexpr uint32_t kRendererImmediateBatch = 256;
+
+struct renderer_bench
+{
+    span<render_instance> instances;
+    span<render_instance_desc> descs;
+    uint32_t nextMoved;
+    uint32_t frame;
+};
+
+void RendererRetainedStatic(void *, uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+        Renderer::Update({});
+}
+
+void RendererRetainedMoving(void *user, uint64_t iterations)
+{
+    auto &b = *(renderer_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (uint32_t n = 0; n < kRendererMovedPerFrame; ++n)
+        {
+            render_instance_desc &desc = b.descs[b.nextMoved];
+            desc.pos[1] = desc.pos[1] > 0 ? -desc.pos[1] : 0.5f - desc.pos[1];
+            Renderer::UpdateInstance(b.instances[b.nextMoved], desc);
+            b.nextMoved = (b.nextMoved + 7919) % kRendererInstances;
+        }
+        Renderer::Update({});
+    }
+}
+
+// The camera dollies back and forth, so lods change without any instance being touched.
+void RendererRetainedCameraMoving(void *user, uint64_t iterations)
+{
+    auto &b = *(renderer_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const float z = -200.f + 150.f * std::sin((float)b.frame++ * .05f);
+        Renderer::SetLookAtView({0.f, 50.f, z}, {0.f, 0.f, z + 200.f}, {0.f, 1.f, 0.f});
+        Renderer::Update({});
+    }
+}
+
+void RendererImmediate(void *user, uint64_t iterations)
+{
+    auto &b = *(renderer_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (uint32_t n = 0; n < kRendererInstances; ++n)
+        {
+            const render_instance_desc &desc = b.descs[n];
+            Renderer::Mesh(desc.pos, desc.scale, desc.mesh, desc.texture);
+            if ((n + 1) % kRendererImmediateBatch == 0)
+                Renderer::CmdFlush({});
+        }
+        Renderer::CmdFlush({});
+    }
+}
+
+// One frame of a 100k instance scene on the CPU: retained with nothing, 1% or only the camera changed, against
+// drawing every instance through Mesh. Every mesh is the cooked terrain patch with 4 lods, most instances are far
+// enough for a coarse one. Headless, so the numbers are the dirty tracking, lod selection and transforms without the
+// GPU copies.
+void BenchRenderer(region_alloc &alloc)
+{
+    if (!Bench::Selected("renderer/retained_static"_s) && !Bench::Selected("renderer/retained_moving"_s) &&
+        !Bench::Selected("renderer/retained_camera_moving"_s) && !Bench::Selected("renderer/immediate"_s))
+        return;
+
+    Renderer::SetLookAtView({0.f, 50.f, -200.f}, {0.f, 0.f, 0.f}, {0.f, 1.f, 0.f});
+    Renderer::SetPerspectiveProjection(1920, 1080, 60.f, .1f, 1000.f);
+
+    auto &patch = RegionAlloc::Alloc<mesh_bench>(alloc);
+    MakeMeshGltf(alloc, patch);
+    const byteview blob = CookMesh(alloc, patch);
+
+    mesh_handle meshes[kRendererMeshes];
+    for (uint32_t i = 0; i < kRendererMeshes; ++i)
+    {
+        meshes[i] = MeshManager::DeclareMesh(0x2000 + i);
+        AssetManager::Set(0x2000 + i, blob);
+    }
+    MeshManager::Update({});
+
+    auto &b = RegionAlloc::Alloc<renderer_bench>(alloc);
+    b.instances = RegionAlloc::AllocArray<render_instance>(alloc, kRendererInstances);
+    b.descs = RegionAlloc::AllocArray<render_instance_desc>(alloc, kRendererInstances);
+
+    uint64_t rng[4];
+    Seed(rng);
+    for (uint32_t i = 0; i < kRendererInstances; ++i)
+    {
+        const float scale = RandomFloat(rng, .5f, 2.f);
+        b.descs[i] = render_instance_desc{
+            .pos = {RandomFloat(rng, -500.f, 500.f), 0.f, RandomFloat(rng, -500.f, 500.f)},
+            .scale = {scale, scale, scale},
+            .rotation = RandomFloat(rng, 0.f, 6.283f),
+            .mesh = meshes[Xoshiro256ss(rng) % kRendererMeshes],
+        };
+        b.instances[i] = Renderer::CreateInstance(b.descs[i]);
+    }
+
+    // Creation leaves everything dirty and at lod 0, the upload budget and the lod sweep settle it over a few
+    // frames.
+    for (uint32_t i = 0; i < 32; ++i)
+        Renderer::Update({});
+
+    Bench::Run("renderer/retained_static"_s, &RendererRetainedStatic, &b);
+    Bench::Run("renderer/retained_moving"_s, &RendererRetainedMoving, &b);
+    Bench::Run("renderer/retained_camera_moving"_s, &RendererRetainedCameraMoving, &b);
+    Bench::Run("renderer/immediate"_s, &RendererImmediate, &b);
+}
+
+//
+
+constexpr uint32_t kInputKeys = 4;
+constexpr uint32_t kInputEvents = 1000;
+constexpr uint64_t kInputStepNs = 1'000'000'000 / 120;
+constexpr uint64_t kInputFrameNs = 1'000'000'000 / 60;
+
+struct input_bench
+{
+    input_event recording[kInputEvents]; // times from zero
+    input_event recorded[kInputEvents];
+    uint64_t durationNs;
+    uint64_t clockNs; // where the next replay starts, InputManager never goes back in time
+};
+
+// Four keys tapped independently with holds of 0.5 to 40 ms and gaps of 1 to 60 ms, so plenty of taps begin and end
+// inside one 120 Hz step. Every key is up again at the end, so replays start from the same state.
+void RecordInput(input_bench &b)
+{
+    uint64_t rng[4];
+    Seed(rng);
+
+    uint64_t next[kInputKeys];
+    bool down[kInputKeys]{};
+    uint32_t downCount = 0;
+    for (uint32_t k = 0; k < kInputKeys; ++k)
+        next[k] = Xoshiro256ss(rng) % 60'000'000;
+
+    for (uint32_t i = 0; i < kInputEvents; ++i)
+    {
+        const bool onlyReleases = kInputEvents - i <= downCount;
+        uint32_t k = kInputKeys;
+        for (uint32_t j = 0; j < kInputKeys; ++j)
+        {
+            if (onlyReleases && !down[j])
+                continue;
+            if (k == kInputKeys || next[j] < next[k])
+                k = j;
+        }
+
+        b.recording[i] = {
+            .timeNs = next[k],
+            .code = k + 1,
+            .type = input_interface_type::Keyboard,
+            .pressed = !down[k],
+        };
+        down[k] = !down[k];
+        downCount = down[k] ? downCount + 1 : downCount - 1;
+        next[k] += down[k] ? 500'000 + Xoshiro256ss(rng) % 39'500'000 : 1'000'000 + Xoshiro256ss(rng) % 59'000'000;
+    }
+    b.durationNs = b.recording[kInputEvents - 1].timeNs + kInputStepNs;
+}
+
+// Plays events back through 120 Hz steps, handing them over either all up front or a 60 Hz frame at a time just
+// ahead of the steps that consume them. Returns a digest of what every step reported.
+auto ReplayInput(input_bench &b, const input_event *events, bool perFrame) -> uint64_t
+{
+    const uint64_t base = b.clockNs;
+    InputManager::Step(base);
+
+    uint64_t digest = 0xCBF29CE484222325;
+    uint32_t fed = 0;
+    uint64_t t = base;
+    while (t < base + b.durationNs)
+    {
+        t += kInputStepNs;
+        const uint64_t feedUntil = perFrame ? base + ((t - base) / kInputFrameNs + 1) * kInputFrameNs : UINT64_MAX;
+        for (; fed < kInputEvents && base + events[fed].timeNs < feedUntil; ++fed)
+        {
+            input_event event = events[fed];
+            event.timeNs += base;
+            InputManager::HandleEvent(event);
+        }
+
+        InputManager::Step(t);
+        for (uint32_t k = 0; k < kInputKeys; ++k)
+        {
+            const input_id input = (input_id)(k + 1);
+            const float held = InputManager::GetHeldFraction(input);
+            uint32_t heldBits;
+            MemCpy(&heldBits, &held, sizeof(heldBits));
+
+            const uint32_t flags = InputManager::GetPressCount(input) | InputManager::WasReleased(input) << 8 |
+                                   InputManager::IsPressed(input) << 9;
+            digest = (digest ^ flags) * 0x100000001B3;
+            digest = (digest ^ heldBits) * 0x100000001B3;
+        }
+    }
+
+    b.clockNs = t;
+    return digest;
+}
+
+void InputReplay(void *user, uint64_t iterations)
+{
+    auto &b = *(input_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+        Bench::Keep(ReplayInput(b, b.recording, true));
+}
+
+// The same recording played back twice, once fed all at once and once frame by frame as the ring hands it back,
+// has to step the same way.
+void BenchInput(region_alloc &alloc)
+{
+    auto &b = RegionAlloc::Alloc<input_bench>(alloc);
+    RecordInput(b);
+    b.clockNs = 1'000'000'000;
+
+    InputManager::Bootstrap();
+    for (uint32_t k = 0; k < kInputKeys; ++k)
+        InputManager::Map((input_id)(k + 1), input_interface_type::Keyboard, k + 1);
+
+    const uint64_t firstBase = b.clockNs;
+    const uint64_t upFront = ReplayInput(b, b.recording, false);
+    ASSERT(InputManager::CopyRecentEvents({b.recorded, kInputEvents}) == kInputEvents);
+    for (input_event &event : b.recorded)
+        event.timeNs -= firstBase;
+    const uint64_t perFrame = ReplayInput(b, b.recorded, true);
+    ASSERT(perFrame == upFront, "input replay is not deterministic");
+
+    const uint64_t steps = b.durationNs / kInputStepNs + 1;
+    const double medianNs = Bench::Run("input/replay"_s, &InputReplay, &b);
+    if (medianNs > 0)
+        LOG("input: %u events over %" PRIu64 " steps replay identically, %.1f ns per step", kInputEvents, steps,
+            medianNs / (double)steps);
+}
+
+//
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kMixFrames = 512;
+constexpr uint32_t kMixVoices = 16;
+constexpr uint32_t kMixMonoVoices = 64;
+constexpr uint32_t kCrowdVoices = 1000;
+
+// One second of 16-bit noise as a complete RIFF file.
+auto MakeWav(region_alloc &alloc, uint16_t channels) -> byteview
+{
+    const uint32_t dataSize = kSampleRate * channels * sizeof(int16_t);
+    constexpr uint32_t kFmtSize = 16;
+    span<uint8_t> wav = RegionAlloc::AllocArray<uint8_t>(alloc, 12 + 8 + kFmtSize + 8 + dataSize);
+
+    uint8_t *p = wav.data;
+    auto put32 = [&p](uint32_t v) {
+        MemCpy(p, &v, 4);
+        p += 4;
+    };
+    auto put16 = [&p](uint16_t v) {
+        MemCpy(p, &v, 2);
+        p += 2;
+    };
+
+    MemCpy(p, "RIFF", 4);
+    p += 4;
+    put32((uint32_t)wav.size - 8);
+    MemCpy(p, "WAVEfmt ", 8);
+    p += 8;
+    put32(kFmtSize);
+    put16(1); // PCM
+    put16(channels);
+    put32(kSampleRate);
+    put32(kSampleRate * channels * sizeof(int16_t));
+    put16(channels * sizeof(int16_t));
+    put16(16);
+    MemCpy(p, "data", 4);
+    p += 4;
+    put32(dataSize);
+
+    uint64_t rng[4];
+    Seed(rng);
+    for (uint32_t i = 0; i < dataSize / 2; ++i)
+        put16((uint16_t)(Xoshiro256ss(rng) >> 52)); // quiet, so a few voices do not clip all the time
+    return wav;
+}
+
+void WavParse(void *user, uint64_t iterations)
+{
+    const byteview wav = *(const byteview *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const ParseWavFileResult parsed = ParseWavFile(wav);
+        Bench::Keep(parsed.data.data);
+    }
+}
+
+void AudioMix(void *, uint64_t iterations)
+{
+    int16_t out[kMixFrames * 2];
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        Audio::Mix(out, kMixFrames);
+        Bench::Keep(out[0]);
+    }
+}
+
+// Besides the raw rate, how many such voices one core keeps up with in real time.
+void LogVoicesPerMs(double medianNs, uint32_t voices)
+{
+    if (medianNs <= 0)
+        return;
+
+    const double blockNs = (double)kMixFrames * 1e9 / kSampleRate;
+    LOG("audio: %.0f voices of %u frames mixed per ms, %.0f per core in real time", (double)voices * 1e6 / medianNs,
+        kMixFrames, (double)voices * blockNs / medianNs);
+}
+
+void PlayVoices(voice *voices, uint32_t count, audio_clip clip, audio_resample_quality quality)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        voices[i] = Audio::Play(clip, {.volume = 0.1f + 0.01f * (float)i, .loop = true, .quality = quality});
+}
+
+void StopVoices(voice *voices, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        Audio::Stop(voices[i]);
+}
+
+// Phase of an exponential sweep from f0 to f1 over duration seconds.
+auto SweepPhase(double t, double f0, double f1, double duration) -> double
+{
+    const double k = std::log(f1 / f0);
+    return 2 * 3.14159265358979 * f0 * duration / k * (std::exp(t / duration * k) - 1);
+}
+
+auto ToDb(double ratio) -> double
+{
+    return 10 * std::log10(ratio);
+}
+
+// Plays a mono clip alone for one second of device time and returns the left channel.
+auto Render(region_alloc &alloc, const audio_clip &clip, audio_resample_quality quality) -> const int16_t *
+{
+    int16_t *out = RegionAlloc::AllocArrayUninit<int16_t>(alloc, kSampleRate * 2).data;
+    const voice v = Audio::Play(clip, {.quality = quality});
+    Audio::Mix(out, kSampleRate);
+    Audio::Stop(v);
+    return out;
+}
+
+// Upsamples a 20 Hz - 15 kHz sweep from 44.1 kHz and compares it with the sweep evaluated at the exact source
+// positions the mixer steps through, then downsamples a 30 kHz tone from 96 kHz, which has to vanish rather than
+// alias down to 18 kHz. Both against a half scale input, and asserted against the floor of the quality tier.
+void ResampleQuality(region_alloc &alloc, audio_resample_quality quality, byteview name, double minSnrDb,
+                     double maxAliasDb)
+{
+    constexpr double kAmplitude = 16384;
+    constexpr uint32_t kEdge = 64;
+
+    constexpr uint32_t kSweepRate = 44100;
+    int16_t *sweep = RegionAlloc::AllocArrayUninit<int16_t>(alloc, kSweepRate).data;
+    for (uint32_t i = 0; i < kSweepRate; ++i)
+        sweep[i] = (int16_t)std::lround(kAmplitude * std::sin(SweepPhase((double)i / kSweepRate, 20, 15000, 1)));
+
+    const int16_t *out = Render(alloc, {sweep, kSweepRate, kSweepRate, 1}, quality);
+    const uint64_t step = ((uint64_t)kSweepRate << 32) / kSampleRate;
+    double signal = 0;
+    double noise = 0;
+    for (uint32_t f = kEdge; f < kSampleRate - kEdge; ++f)
+    {
+        const double t = (double)(f * step) / 4294967296.0 / kSweepRate;
+        const double ref = kAmplitude * std::sin(SweepPhase(t, 20, 15000, 1));
+        const double err = (double)out[f * 2] - ref;
+        signal += ref * ref;
+        noise += err * err;
+    }
+
+    constexpr uint32_t kToneRate = 96000;
+    int16_t *tone = RegionAlloc::AllocArrayUninit<int16_t>(alloc, kToneRate).data;
+    for (uint32_t i = 0; i < kToneRate; ++i)
+        tone[i] = (int16_t)std::lround(kAmplitude * std::sin(2 * 3.14159265358979 * 30000 * i / kToneRate));
+
+    out = Render(alloc, {tone, kToneRate, kToneRate, 1}, quality);
+    double alias = 0;
+    for (uint32_t f = kEdge; f < kSampleRate - kEdge; ++f)
+        alias += (double)out[f * 2] * out[f * 2];
+    const double input = kAmplitude * kAmplitude / 2 * (kSampleRate - 2 * kEdge);
+
+    const double snrDb = ToDb(signal / noise);
+    const double aliasDb = ToDb(Max(alias, 1e-3) / input);
+    LOG("audio: " SV_FMT " sweep SNR %.1f dB, 30 kHz alias %.1f dB", SV_ARG(name), snrDb, aliasDb);
+    ASSERT(snrDb >= minSnrDb, "audio: " SV_FMT " sweep SNR %.1f dB is below %.1f dB", SV_ARG(name), snrDb, minSnrDb);
+    ASSERT(aliasDb <= maxAliasDb, "audio: " SV_FMT " 30 kHz alias %.1f dB is above %.1f dB", SV_ARG(name), aliasDb,
+           maxAliasDb);
+}
+
+//
+
+struct qoa_bench
+{
+    const int16_t *pcm;
+    qoa_desc desc;
+    span<uint8_t> out;
+    byteview blob;
+    int16_t *decoded;
+};
+
+auto MakeQoaBench(region_alloc &alloc, byteview wav) -> qoa_bench
+{
+    const ParseWavFileResult parsed = ParseWavFile(wav);
+    qoa_bench b{
+        .pcm = (const int16_t *)parsed.data.data,
+        .desc =
+            {
+                .numFrames = (uint32_t)(parsed.data.size / (parsed.fmt->numChannels * sizeof(int16_t))),
+                .sampleRate = parsed.fmt->numSamplesPerSec,
+                .channels = parsed.fmt->numChannels,
+            },
+    };
+    b.out = RegionAlloc::AllocArrayUninit<uint8_t>(alloc, Qoa::EncodeBound(b.desc.numFrames, b.desc.channels));
+    b.blob = byteview{b.out.data, Qoa::Encode(b.pcm, b.desc, b.out)};
+    b.decoded = RegionAlloc::AllocArrayUninit<int16_t>(alloc, (uint64_t)b.desc.numFrames * b.desc.channels).data;
+    return b;
+}
+
+void QoaEncode(void *user, uint64_t iterations)
+{
+    qoa_bench &b = *(qoa_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+        Bench::Keep(Qoa::Encode(b.pcm, b.desc, b.out));
+}
+
+void QoaDecode(void *user, uint64_t iterations)
+{
+    qoa_bench &b = *(qoa_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        uint64_t offset = kQoaFileHeaderSize;
+        for (uint32_t frame = 0; frame < b.desc.numFrames;)
+        {
+            uint32_t numFrames;
+            offset = Qoa::DecodeFrame(b.blob, b.desc, offset, b.decoded + (uint64_t)frame * b.desc.channels, numFrames);
+            frame += numFrames;
+        }
+        Bench::Keep(b.decoded[0]);
+    }
+}
+
+// Noise is the worst case for the predictor, a sweep is closer to music. The size does not depend on the input, QOA
+// spends 64 bits on every 20 samples of a channel.
+void QoaReport(region_alloc &alloc, const qoa_bench &noise)
+{
+    constexpr double kAmplitude = 16384;
+    int16_t *sweep = RegionAlloc::AllocArrayUninit<int16_t>(alloc, kSampleRate * 2).data;
+    for (uint32_t i = 0; i < kSampleRate; ++i)
+    {
+        const double phase = SweepPhase((double)i / kSampleRate, 20, 15000, 1);
+        sweep[i * 2] = (int16_t)std::lround(kAmplitude * std::sin(phase));
+        sweep[i * 2 + 1] = (int16_t)std::lround(kAmplitude * std::cos(phase));
+    }
+
+    qoa_bench b = noise;
+    b.pcm = sweep;
+    b.blob = byteview{b.out.data, Qoa::Encode(b.pcm, b.desc, b.out)};
+    QoaDecode(&b, 1);
+
+    double signal = 0;
+    double error = 0;
+    for (uint32_t i = 0; i < kSampleRate * 2; ++i)
+    {
+        const double d = (double)sweep[i] - b.decoded[i];
+        signal += (double)sweep[i] * sweep[i];
+        error += d * d;
+    }
+
+    const uint64_t pcmBytes = (uint64_t)kSampleRate * 2 * sizeof(int16_t);
+    LOG("qoa: one second of stereo, %" PRIu64 " bytes of PCM, %" PRIu64 " of QOA (%.2fx), sweep SNR %.1f dB",
+        pcmBytes, b.blob.size, (double)pcmBytes / b.blob.size, ToDb(signal / error));
+
+    // What a playing five minute stereo track keeps in memory, the decode ring on top of the compressed clip.
+    const uint64_t trackPcm = pcmBytes * 300;
+    const uint64_t trackQoa = b.blob.size * 300;
+    const uint64_t ring = (uint64_t)kAudioStreamRingFrames * 2 * sizeof(int16_t);
+    LOG("qoa: 5 min stereo track resident %.1f MiB as PCM, %.1f MiB streamed (%.1f MiB clip + %" PRIu64
+        " KiB ring per voice)",
+        (double)trackPcm / (1 << 20), (double)(trackQoa + ring) / (1 << 20), (double)trackQoa / (1 << 20),
+        ring >> 10);
+}
+
+void BenchQoa(region_alloc &alloc)
+{
+    const byteview wav = MakeWav(alloc, 2);
+    static qoa_bench b = MakeQoaBench(alloc, wav);
+    const uint64_t pcmBytes = (uint64_t)b.desc.numFrames * b.desc.channels * sizeof(int16_t);
+    Bench::Run("qoa/encode"_s, &QoaEncode, &b, pcmBytes);
+    Bench::Run("qoa/decode"_s, &QoaDecode, &b, pcmBytes);
+
+    if (Bench::Selected("qoa/report"_s))
+        QoaReport(alloc, b);
+}
+
+// The decoder thread's work runs in the same loop, so the difference to mix_16_voices is decoding plus staging.
+void AudioMixStreams(void *, uint64_t iterations)
+{
+    int16_t out[kMixFrames * 2];
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        Audio::PumpStreams();
+        Audio::Mix(out, kMixFrames);
+        Bench::Keep(out[0]);
+    }
+}
+
+// A crowd of one shots and ambience: eight priority levels and gains from -60 dB to 0 dB, most of them too
+// unimportant to be heard over the voice budget.
+void PlayCrowd(voice *voices, audio_clip clip)
+{
+    for (uint32_t i = 0; i < kCrowdVoices; ++i)
+    {
+        const float volume = Pow(10.f, -3.f * (float)(i * 7919 % kCrowdVoices) / kCrowdVoices);
+        voices[i] = Audio::Play(clip, {.volume = volume, .loop = true, .priority = (uint8_t)(i % 8 * 32)});
+    }
+}
+
+// Hands queued commands to the mixer, which nothing else does when the filter skips the runs in between.
+void DrainAudioCommands()
+{
+    int16_t out[kMixFrames * 2];
+    Audio::Mix(out, kMixFrames);
+}
+
+void CrowdReport(byteview name, double medianNs)
+{
+    if (medianNs <= 0)
+        return;
+
+    const audio_voice_stats stats = Audio::GetVoiceStats();
+    LOG("audio: " SV_FMT " %u voices playing, %u mixed, %" PRIu64 " stolen, %" PRIu64 " dropped", SV_ARG(name),
+        stats.playing, stats.real, stats.stolen, stats.dropped);
+    LogVoicesPerMs(medianNs, stats.playing);
+}
+
+void BenchAudio(region_alloc &alloc)
+{
+    static byteview wav = MakeWav(alloc, 2);
+    const byteview monoWav = MakeWav(alloc, 1);
+    Bench::Run("wave/parse"_s, &WavParse, &wav);
+
+    Audio::BootstrapHeadless(kSampleRate, 2);
+
+    voice voices[kMixMonoVoices];
+    const audio_clip clip = Audio::LoadWav(wav);
+    PlayVoices(voices, kMixVoices, clip, audio_resample_quality::Sinc);
+    LogVoicesPerMs(Bench::Run("audio/mix_16_voices"_s, &AudioMix, nullptr, kMixFrames * 2 * sizeof(int16_t)),
+                   kMixVoices);
+    StopVoices(voices, kMixVoices);
+
+    const audio_clip monoClip = Audio::LoadWav(monoWav);
+    PlayVoices(voices, kMixMonoVoices, monoClip, audio_resample_quality::Sinc);
+    LogVoicesPerMs(
+        Bench::Run("audio/mix_64_mono_voices"_s, &AudioMix, nullptr, kMixFrames * 2 * sizeof(int16_t)),
+        kMixMonoVoices);
+    StopVoices(voices, kMixMonoVoices);
+
+    // The same stereo noise, played as if it had been authored at 44.1 kHz.
+    audio_clip resampledClip = clip;
+    resampledClip.sampleRate = 44100;
+    PlayVoices(voices, kMixVoices, resampledClip, audio_resample_quality::Sinc);
+    LogVoicesPerMs(
+        Bench::Run("audio/mix_16_resampled_sinc"_s, &AudioMix, nullptr, kMixFrames * 2 * sizeof(int16_t)),
+        kMixVoices);
+    StopVoices(voices, kMixVoices);
+
+    PlayVoices(voices, kMixVoices, resampledClip, audio_resample_quality::Cubic);
+    LogVoicesPerMs(
+        Bench::Run("audio/mix_16_resampled_cubic"_s, &AudioMix, nullptr, kMixFrames * 2 * sizeof(int16_t)),
+        kMixVoices);
+    StopVoices(voices, kMixVoices);
+
+    const qoa_bench streamed = MakeQoaBench(alloc, wav);
+    PlayVoices(voices, kMixVoices, Audio::LoadQoa(streamed.blob), audio_resample_quality::Sinc);
+    LogVoicesPerMs(Bench::Run("audio/mix_16_streams"_s, &AudioMixStreams, nullptr, kMixFrames * 2 * sizeof(int16_t)),
+                   kMixVoices);
+    StopVoices(voices, kMixVoices);
+    Audio::PumpStreams();
+
+    // The same 1000 voices with the default budget and with every one of them mixed.
+    voice *crowd = RegionAlloc::AllocArray<voice>(alloc, kCrowdVoices).data;
+    DrainAudioCommands();
+    PlayCrowd(crowd, clip);
+    CrowdReport("audio/mix_1000_voices"_s,
+                Bench::Run("audio/mix_1000_voices"_s, &AudioMix, nullptr, kMixFrames * 2 * sizeof(int16_t)));
+    Audio::SetVoiceBudget(kAudioMaxVoices);
+    CrowdReport("audio/mix_1000_voices_all_real"_s,
+                Bench::Run("audio/mix_1000_voices_all_real"_s, &AudioMix, nullptr, kMixFrames * 2 * sizeof(int16_t)));
+    Audio::SetVoiceBudget(kAudioDefaultVoiceBudget);
+    DrainAudioCommands();
+    StopVoices(crowd, kCrowdVoices);
+
+    if (Bench::Selected("audio/resample_quality"_s))
+    {
+        ResampleQuality(alloc, audio_resample_quality::Sinc, "sinc"_s, 80, -70);
+        // Cubic does not filter, the tone folds back at full level and the bound only catches a gain error.
+        ResampleQuality(alloc, audio_resample_quality::Cubic, "cubic"_s, 25, 0.5);
+    }
+
+    Audio::Shutdown();
+}
+
+//
+
+constexpr uint64_t kJobBatch = 256;
+constexpr uint64_t kParallelItems = 1 << 16;
+constexpr uint64_t kParallelGrain = 512;
+constexpr uint32_t kParallelRounds = 64;
+constexpr uint32_t kMaxParallelWidths = 16;
+
+void NoopJob(void *)
+{
+}
+
+// Per job: the push, the pop or steal, the call and the counter. Waits every kJobBatch jobs.
+void JobRunWait(void *, uint64_t iterations)
+{
+    job_counter counter{};
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        JobSystem::Run(&NoopJob, nullptr, &counter);
+        if (i % kJobBatch == kJobBatch - 1)
+            JobSystem::Wait(counter);
+    }
+    JobSystem::Wait(counter);
+}
+
+struct parallel_bench
+{
+    span<float> items;
+    uint32_t width;
+};
+
+// Arithmetic only, so that what scales is the scheduler and not the memory bandwidth.
+void ParallelItems(void *user, uint64_t begin, uint64_t end)
+{
+    auto &b = *(parallel_bench *)user;
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        float x = b.items[i];
+        for (uint32_t r = 0; r < kParallelRounds; ++r)
+            x = x * 0.999f + Sqrt(x + 1.f) * 0.001f;
+        b.items[i] = x;
+    }
+}
+
+void JobParallelFor(void *user, uint64_t iterations)
+{
+    auto &b = *(parallel_bench *)user;
+    for (uint64_t i = 0; i < iterations; ++i)
+        JobSystem::ParallelFor(b.items.size, kParallelGrain, &ParallelItems, &b, b.width);
+    Bench::Keep(b.items[0]);
+}
+
+// ParallelFor over one worker, then doubling up to one per processor.
+void BenchJobSystem(region_alloc &alloc)
+{
+    const uint32_t processors = GetProcessorCount();
+    array<uint32_t, kMaxParallelWidths> widths;
+    array<byteview, kMaxParallelWidths> names;
+    uint32_t widthCount = 0;
+    bool selected = Bench::Selected("job_system/run_wait"_s);
+    for (uint32_t width = 1; widthCount < kMaxParallelWidths; width *= 2)
+    {
+        widths[widthCount] = Min(width, processors);
+        span<uint8_t> name = RegionAlloc::AllocArray<uint8_t>(alloc, 48);
+        const uint64_t nameSize = StringWriteFmt(name, "job_system/parallel_for_w%u"_s, widths[widthCount]);
+        names[widthCount] = byteview{name.data, nameSize};
+        selected |= Bench::Selected(names[widthCount]);
+        ++widthCount;
+        if (width >= processors)
+            break;
+    }
+    if (!selected)
+        return;
+
+    JobSystem::Bootstrap();
+    Bench::Run("job_system/run_wait"_s, &JobRunWait, nullptr);
+
+    parallel_bench b{.items = RegionAlloc::AllocArray<float>(alloc, kParallelItems)};
+    double oneNs = 0;
+    for (uint32_t i = 0; i < widthCount; ++i)
+    {
+        b.width = widths[i];
+        const double medianNs = Bench::Run(names[i], &JobParallelFor, &b);
+        if (medianNs <= 0)
+            continue;
+        if (widths[i] == 1)
+            oneNs = medianNs;
+        LOG("job_system: %" PRIu64 " items on %u workers in %.1f us, %.2fx of one worker", kParallelItems, widths[i],
+            medianNs / 1000.0, oneNs > 0 ? oneNs / medianNs : 0.0);
+    }
+
+    const job_system_stats stats = JobSystem::GetStats();
+    LOG("job_system: %u workers, %" PRIu64 " jobs stolen, %" PRIu64 " sleeps", JobSystem::GetWorkerCount(),
+        stats.stolen, stats.sleeps);
+}
+
+#if defined(__linux__)
+
+//
+
+constexpr uint32_t kLogThreads = 8;
+
+// Stderr points at /dev/null while a case runs, the flusher still does every write. The background threads log lines
+// lines each round, or until stop when lines is zero.
+struct log_bench
+{
+    int nullFd;
+    int savedStderr;
+
+    platform_mutex *mutex;
+    platform_condvar *start;
+    platform_thread *threads[kLogThreads - 1];
+    uint32_t generation;
+    uint32_t quit;
+    uint64_t lines;
+    uint32_t stop;
+    uint64_t done;
+};
+
+// Shaped like a per-frame renderer line, about 70 bytes.
+void LogLine(uint64_t i)
+{
+    LOG("renderer: frame %" PRIu64 " took %.3f ms, %u draws, %u instances uploaded", i, (double)(i & 1023) * 0.016,
+        (uint32_t)(i & 255), (uint32_t)(i * 7 & 4095));
+}
+
+void LogWorker(void *user)
+{
+    auto &b = *(log_bench *)user;
+    uint32_t seen = 0;
+    for (;;)
+    {
+        PlatformMutex::Lock(*b.mutex);
+        while (b.generation == seen && !b.quit)
+            PlatformCondvar::Wait(*b.start, *b.mutex);
+        seen = b.generation;
+        const bool quit = b.quit;
+        const uint64_t lines = b.lines;
+        PlatformMutex::Unlock(*b.mutex);
+        if (quit)
+            return;
+
+        if (lines)
+        {
+            for (uint64_t i = 0; i < lines; ++i)
+                LogLine(i);
+        }
+        else
+        {
+            for (uint64_t i = 0; !AtomicLoad32(&b.stop); ++i)
+                LogLine(i);
+        }
+        AtomicFetchAdd64(&b.done, 1);
+    }
+}
+
+void LogStartRound(log_bench &b, uint64_t lines)
+{
+    PlatformMutex::Lock(*b.mutex);
+    b.lines = lines;
+    AtomicStore32(&b.stop, 0);
+    AtomicStore64(&b.done, 0);
+    ++b.generation;
+    PlatformCondvar::Broadcast(*b.start);
+    PlatformMutex::Unlock(*b.mutex);
+}
+
+// Waits for the background threads, then for the flusher to write out everything, before stderr comes back.
+void LogFinishRound(log_bench &b)
+{
+    AtomicStore32(&b.stop, 1);
+    while (AtomicLoad64(&b.done) < kLogThreads - 1)
+        Sleep(0);
+}
+
+// Flushes first, the result line of the previous case may still be queued.
+void LogMute(log_bench &b)
+{
+    Log::Flush();
+    dup2(b.nullFd, STDERR_FILENO);
+}
+
+void LogUnmute(log_bench &b)
+{
+    Log::Flush();
+    dup2(b.savedStderr, STDERR_FILENO);
+}
+
+void LogWrite(void *user, uint64_t iterations)
+{
+    auto &b = *(log_bench *)user;
+    LogMute(b);
+    for (uint64_t i = 0; i < iterations; ++i)
+        LogLine(i);
+    LogUnmute(b);
+}
+
+// One iteration is a line from each of the eight threads, written out.
+void LogWriteThreads(void *user, uint64_t iterations)
+{
+    auto &b = *(log_bench *)user;
+    LogMute(b);
+    LogStartRound(b, iterations);
+    for (uint64_t i = 0; i < iterations; ++i)
+        LogLine(i);
+    LogFinishRound(b);
+    LogUnmute(b);
+}
+
+// What a LOG costs the caller while seven other threads keep the ring busy.
+void LogWriteContended(void *user, uint64_t iterations)
+{
+    auto &b = *(log_bench *)user;
+    LogMute(b);
+    LogStartRound(b, 0);
+    for (uint64_t i = 0; i < iterations; ++i)
+        LogLine(i);
+    LogFinishRound(b);
+    LogUnmute(b);
+}
+
+void BenchLog(region_alloc &alloc)
+{
+    if (!Bench::Selected("log/write"_s))
+        return;
+
+    auto &b = RegionAlloc::Alloc<log_bench>(alloc);
+    b.nullFd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    b.savedStderr = dup(STDERR_FILENO);
+    ASSERT(b.nullFd >= 0 && b.savedStderr >= 0);
+    b.mutex = PlatformMutex::Create(alloc);
+    b.start = PlatformCondvar::Create(alloc);
+    for (platform_thread *&thread : b.threads)
+        thread = PlatformThread::Create(alloc, &LogWorker, &b);
+
+    const double oneNs = Bench::Run("log/write"_s, &LogWrite, &b);
+    const double threadsNs = Bench::Run("log/write_8_threads"_s, &LogWriteThreads, &b);
+    const double callerNs = Bench::Run("log/write_contended_caller"_s, &LogWriteContended, &b);
+    if (oneNs > 0 && threadsNs > 0 && callerNs > 0)
+        LOG("log: %.2f M lines/s from one thread, %.2f M lines/s from %u threads, %.0f ns per LOG on the caller "
+            "while %u others log",
+            1e3 / oneNs, kLogThreads * 1e3 / threadsNs, kLogThreads, callerNs, kLogThreads - 1);
+
+    PlatformMutex::Lock(*b.mutex);
+    b.quit = 1;
+    PlatformCondvar::Broadcast(*b.start);
+    PlatformMutex::Unlock(*b.mutex);
+    for (platform_thread *thread : b.threads)
+        PlatformThread::Join(*thread);
+    close(b.nullFd);
+    close(b.savedStderr);
+}
+
+//
+
+void FillRamp(void *, int16_t *out, uint32_t numFrames)
+{
+    for (uint32_t i = 0; i < numFrames * 2; ++i)
+        out[i] = (int16_t)i;
+}
+
+// ALSA's null device takes frames as fast as they come, so the feeder runs flat out and its CPU time per frame is
+// the cost of the path itself. On a real device Audio::Shutdown logs the same statistics.
+void FeederReport(byteview name, bool copy)
+{
+    PlatformAudio::Init({
+        .sampleRate = kSampleRate,
+        .channels = 2,
+        .latencyUs = 10'000,
+        .callback = &FillRamp,
+        .user = nullptr,
+        .device = "null",
+        .copy = copy,
+        .normalPriority = true,
+    });
+    Sleep(1000);
+    PlatformAudio::Destroy();
+
+    const platform_audio_stats stats = PlatformAudio::GetStats();
+    LOG("platform_audio: " SV_FMT " %s, %u frame buffer, %" PRIu64 " frames at %.2f ns of feeder CPU each, %" PRIu64
+        " underruns",
+        SV_ARG(name), stats.zeroCopy ? "zero copy" : "copying", stats.bufferFrames, stats.frames,
+        stats.frames ? (double)stats.feederCpuNs / (double)stats.frames : 0.0, stats.underruns);
+}
+
+void BenchPlatformAudio()
+{
+    if (Bench::Selected("platform_audio/null_copy"_s))
+        FeederReport("platform_audio/null_copy"_s, true);
+    if (Bench::Selected("platform_audio/null_mmap"_s))
+        FeederReport("platform_audio/null_mmap"_s, false);
+}
+
+//
+
+constexpr uint32_t kGamepadMoves = 1000;
+
+void EmitUinput(int fd, uint16_t type, uint16_t code, int32_t value)
+{
+    ::input_event event{};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    ASSERT(write(fd, &event, sizeof(event)) == sizeof(event));
+}
+
+// Drives a virtual pad through uinput, so the whole path is timed: the kernel stamps the report, the gamepad thread
+// wakes in epoll_wait and publishes it, and UpdateGamepad here sees it. Needs write access to /dev/uinput.
+void GamepadLatency()
+{
+    const int fd = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        LOG("gamepad/uinput_latency: no access to /dev/uinput, skipped");
+        return;
+    }
+
+    bool connectedBefore[kMaxGamepads];
+    for (uint32_t i = 0; i < kMaxGamepads; ++i)
+        connectedBefore[i] = UpdateGamepad(i);
+
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    ioctl(fd, UI_SET_KEYBIT, BTN_SOUTH);
+    ioctl(fd, UI_SET_KEYBIT, BTN_EAST);
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    constexpr uint16_t kAxes[] = {ABS_X, ABS_Y, ABS_RX, ABS_RY};
+    for (uint16_t code : kAxes)
+    {
+        uinput_abs_setup abs{};
+        abs.code = code;
+        abs.absinfo.minimum = -32768;
+        abs.absinfo.maximum = 32767;
+        ioctl(fd, UI_ABS_SETUP, &abs);
+    }
+
+    uinput_setup setup{};
+    setup.id.bustype = BUS_VIRTUAL;
+    MemCpy(setup.name, "nyla_bench gamepad", sizeof("nyla_bench gamepad"));
+    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0)
+    {
+        LOG("gamepad/uinput_latency: could not create the device, skipped");
+        close(fd);
+        return;
+    }
+
+    // Hot plug: the node shows up through inotify, possibly before udev lets us open it.
+    uint32_t index = kMaxGamepads;
+    for (uint64_t deadline = GetMonotonicTimeMillis() + 3000; index == kMaxGamepads;)
+    {
+        for (uint32_t i = 0; i < kMaxGamepads; ++i)
+        {
+            if (!connectedBefore[i] && UpdateGamepad(i))
+                index = i;
+        }
+        if (GetMonotonicTimeMillis() > deadline)
+            break;
+        Sleep(1);
+    }
+
+    if (index == kMaxGamepads)
+    {
+        LOG("gamepad/uinput_latency: the virtual pad never showed up, skipped");
+        ioctl(fd, UI_DEV_DESTROY);
+        close(fd);
+        return;
+    }
+
+    const gamepad_stats before = GetGamepadStats(index);
+    uint64_t visibleNsSum = 0;
+    uint64_t visibleNsMax = 0;
+    uint32_t missed = 0;
+    for (uint32_t i = 0; i < kGamepadMoves; ++i)
+    {
+        const bool right = i & 1;
+        const uint64_t start = GetMonotonicTimeNanos();
+        EmitUinput(fd, EV_ABS, ABS_X, right ? 32767 : -32768);
+        EmitUinput(fd, EV_SYN, SYN_REPORT, 0);
+
+        for (;;)
+        {
+            UpdateGamepad(index);
+            const float x = GetGamepadLeftStick(index)[0];
+            if (right ? x > 0.5f : x < -0.5f)
+                break;
+            if (GetMonotonicTimeNanos() - start > 100'000'000)
+            {
+                ++missed;
+                break;
+            }
+        }
+
+        const uint64_t visibleNs = GetMonotonicTimeNanos() - start;
+        visibleNsSum += visibleNs;
+        visibleNsMax = Max(visibleNsMax, visibleNs);
+    }
+    const gamepad_stats after = GetGamepadStats(index);
+
+    ioctl(fd, UI_DEV_DESTROY);
+    close(fd);
+
+    const uint64_t reports = after.reports - before.reports;
+    LOG("gamepad/uinput_latency: write to visible %.1f us mean, %.1f us max over %u moves, %u missed",
+        (double)visibleNsSum / kGamepadMoves / 1000.0, (double)visibleNsMax / 1000.0, kGamepadMoves, missed);
+    LOG("gamepad/uinput_latency: kernel stamp to visible %.1f us mean, %.1f us max over %" PRIu64 " reports",
+        reports ? (double)(after.latencyNsSum - before.latencyNsSum) / (double)reports / 1000.0 : 0.0,
+        (double)after.latencyNsMax / 1000.0, reports);
+}
+
+void BenchGamepad()
+{
+    if (Bench::Selected("gamepad/uinput_latency"_s))
+        GamepadLatency();
+}
+
+//
+
+constexpr uint32_t kWatchTopDirs = 10;
+constexpr uint32_t kWatchSubDirs = 99; // 10 + 10 * 99 = 1000 directories below the root
+constexpr uint32_t kStormFiles = 500;
+constexpr uint32_t kStormWrites = 4; // an editor's save: truncate, then the contents in a few writes
+constexpr uint32_t kStormPasses = 2; // every file saved twice, the kernel merges back to back events on one file
+
+struct watch_bench
+{
+    array<char, 64> root;
+    uint32_t events;
+};
+
+// Directory 0..9 is a top level one, the rest are spread below them. file may be null for the directory itself.
+auto WatchBenchPath(array<uint8_t, 256> &out, const watch_bench &b, uint32_t dir, const char *file) -> const char *
+{
+    uint64_t size = StringWriteFmt(out, "%s/d%u"_s, b.root.data, dir % kWatchTopDirs);
+    if (dir >= kWatchTopDirs)
+        size += StringWriteFmt(Span::SubSpan(span<uint8_t>{out.data, sizeof(out.data)}, size), "/s%u"_s,
+                               dir / kWatchTopDirs - 1);
+    if (file)
+        size += StringWriteFmt(Span::SubSpan(span<uint8_t>{out.data, sizeof(out.data)}, size), "/%s"_s, file);
+    out[size] = 0;
+    return (const char *)out.data;
+}
+
+auto StormFileName(array<uint8_t, 32> &out, uint32_t i) -> const char *
+{
+    out[StringWriteFmt(out, "f%u.png"_s, i)] = 0;
+    return (const char *)out.data;
+}
+
+void OnWatchBenchEvent(const dir_watcher_event &, void *user)
+{
+    ++static_cast<watch_bench *>(user)->events;
+}
+
+void WatcherIdleTick(void *, uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+        DirWatcher::Tick();
+}
+
+// Only the changes the watcher was told about are counted, the files are written before the clock starts so that
+// what is timed is the watcher: Ticks that drain the storm and hand out the coalesced events.
+void WatcherStorm(watch_bench &b)
+{
+    array<uint8_t, 256> path;
+    array<uint8_t, 32> name;
+    array<uint8_t, 4096> contents{};
+
+    const dir_watcher_stats before = DirWatcher::GetStats();
+    b.events = 0;
+
+    for (uint32_t pass = 0; pass < kStormPasses; ++pass)
+    {
+        for (uint32_t i = 0; i < kStormFiles; ++i)
+        {
+            const int fd =
+                open(WatchBenchPath(path, b, (i * 7) % (kWatchTopDirs * (kWatchSubDirs + 1)), StormFileName(name, i)),
+                     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            ASSERT(fd != -1);
+            for (uint32_t w = 0; w < kStormWrites; ++w)
+                ASSERT(write(fd, contents.data, sizeof(contents.data) / kStormWrites) > 0);
+            close(fd);
+        }
+    }
+    const uint64_t writtenNs = GetMonotonicTimeNanos();
+
+    uint64_t tickNs = 0;
+    uint64_t busyTicks = 0;
+    while (b.events < kStormFiles && GetMonotonicTimeNanos() - writtenNs < 5'000'000'000)
+    {
+        const uint32_t eventsBefore = b.events;
+        const uint64_t start = GetMonotonicTimeNanos();
+        DirWatcher::Tick();
+        tickNs += GetMonotonicTimeNanos() - start;
+        if (b.events != eventsBefore)
+            ++busyTicks;
+        Sleep(1);
+    }
+    const uint64_t doneNs = GetMonotonicTimeNanos();
+
+    const dir_watcher_stats after = DirWatcher::GetStats();
+    LOG("dir_watcher/save_storm: %u files, %" PRIu64 " raw events, %" PRIu64 " delivered in %" PRIu64
+        " ticks, %.1f us of Tick in total, last event %.1f ms after the last write",
+        kStormFiles, after.raw - before.raw, after.delivered - before.delivered, busyTicks, (double)tickNs / 1000.0,
+        (double)(doneNs - writtenNs) / 1e6);
+}
+
+void BenchDirWatcher()
+{
+    const bool idle = Bench::Selected("dir_watcher/idle_tick_1000_dirs"_s);
+    const bool storm = Bench::Selected("dir_watcher/save_storm"_s);
+    if (!idle && !storm)
+        return;
+
+    watch_bench b{};
+    MemCpy(b.root.data, "/tmp/nyla-bench-watch-XXXXXX", sizeof("/tmp/nyla-bench-watch-XXXXXX"));
+    ASSERT(mkdtemp(b.root.data));
+
+    array<uint8_t, 256> path;
+    array<uint8_t, 32> name;
+    const uint32_t dirs = kWatchTopDirs * (kWatchSubDirs + 1);
+    for (uint32_t d = 0; d < dirs; ++d)
+        ASSERT(mkdir(WatchBenchPath(path, b, d, nullptr), 0755) == 0);
+
+    DirWatcher::Subscribe(".png"_s, &OnWatchBenchEvent, &b);
+    DirWatcher::WatchDir(Span::FromCStr(b.root.data, sizeof(b.root.data)));
+
+    if (idle)
+        Bench::Run("dir_watcher/idle_tick_1000_dirs"_s, &WatcherIdleTick, nullptr);
+    if (storm)
+        WatcherStorm(b);
+
+    for (uint32_t i = 0; i < kStormFiles; ++i)
+        unlink(WatchBenchPath(path, b, (i * 7) % dirs, StormFileName(name, i)));
+    for (uint32_t d = dirs; d-- > 0;)
+        rmdir(WatchBenchPath(path, b, d, nullptr));
+    rmdir(b.root.data);
+}
+
+//
+
+constexpr uint32_t kShaderBenchShaders = 48; // half vertex, half pixel, all of them include common.hlsli
+constexpr uint32_t kStandInDxcMs = 80;
+constexpr uint64_t kShaderBenchTimeoutNs = 120'000'000'000;
+
+// Without a dxc on PATH: about as slow as dxc on a small shader, and the output follows the source.
+constexpr const char kStandInDxc[] = "#!/bin/sh\n"
+                                     "out=\n"
+                                     "src=\n"
+                                     "while [ $# -gt 0 ]; do\n"
+                                     "    case \"$1\" in\n"
+                                     "    -Fo) out=$2; shift ;;\n"
+                                     "    *) src=$1 ;;\n"
+                                     "    esac\n"
+                                     "    shift\n"
+                                     "done\n"
+                                     "[ -z \"$out\" ] && { echo stand-in dxc; exit 0; }\n"
+                                     "sleep 0.08\n"
+                                     "cat \"$src\" > \"$out\"\n";
+
+struct shader_bench
+{
+    array<char, 64> root;
+};
+
+// name is a format taking i, the directory itself without one.
+auto ShaderBenchPath(array<uint8_t, 256> &out, const shader_bench &b, byteview dir, byteview name = ""_s,
+                     uint32_t i = 0) -> byteview
+{
+    uint64_t size = StringWriteFmt(out, "%s/" SV_FMT ""_s, b.root.data, SV_ARG(dir));
+    if (name.size)
+    {
+        out[size++] = '/';
+        size += StringWriteFmt(Span::SubSpan(span<uint8_t>{out.data, sizeof(out.data)}, size), name, i);
+    }
+    out[size] = 0;
+    return byteview{out.data, size};
+}
+
+auto ShaderBenchName(uint32_t i) -> byteview
+{
+    return i % 2 ? "s%u.ps.hlsl"_s : "s%u.vs.hlsl"_s;
+}
+
+auto ShaderBenchOutput(uint32_t i) -> byteview
+{
+    return i % 2 ? "s%u.ps.hlsl.spv"_s : "s%u.vs.hlsl.spv"_s;
+}
+
+void WriteBenchFile(byteview path, byteview contents, uint32_t mode)
+{
+    const int fd = open(Span::CStr(path), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    ASSERT(fd != -1);
+    ASSERT(write(fd, contents.data, contents.size) == (ssize_t)contents.size);
+    close(fd);
+}
+
+void WriteShaderHeader(const shader_bench &b, uint32_t version)
+{
+    array<uint8_t, 256> path;
+    array<uint8_t, 256> text;
+    const uint64_t n =
+        StringWriteFmt(text, "float4 Tint(float4 c)\n{\n    return c * %u.0 / 8.0;\n}\n"_s, version + 1);
+    WriteBenchFile(ShaderBenchPath(path, b, "src"_s, "common.hlsli"_s), byteview{text.data, n}, 0644);
+}
+
+auto ShaderJobsDone(const dev_shaders_stats &stats) -> uint64_t
+{
+    return stats.compiled + stats.cached + stats.failed;
+}
+
+// Wall clock from saving the header to the last shader written, the watcher's debounce included.
+void ShaderHeaderRebuild(const shader_bench &b, uint32_t version, const char *name)
+{
+    const dev_shaders_stats before = DevShaders::GetStats();
+    const uint64_t start = GetMonotonicTimeNanos();
+    WriteShaderHeader(b, version);
+
+    dev_shaders_stats after = before;
+    while (ShaderJobsDone(after) - ShaderJobsDone(before) < kShaderBenchShaders &&
+           GetMonotonicTimeNanos() - start < kShaderBenchTimeoutNs)
+    {
+        DirWatcher::Tick();
+        Sleep(1);
+        after = DevShaders::GetStats();
+    }
+    const uint64_t doneNs = GetMonotonicTimeNanos();
+
+    LOG("dev_shaders/%s: %u shaders in %.1f ms, %" PRIu64 " compiled, %" PRIu64 " from the cache, %" PRIu64
+        " failed, %.1f ms in dxc summed over the workers",
+        name, kShaderBenchShaders, (double)(doneNs - start) / 1e6, after.compiled - before.compiled,
+        after.cached - before.cached, after.failed - before.failed, (double)(after.dxcNs - before.dxcNs) / 1e6);
+}
+
+// Cold: the header gets contents never compiled before. Warm: the edit is reverted, every output is in the cache.
+void BenchDevShaders(region_alloc &alloc)
+{
+    if (!Bench::Selected("dev_shaders/header_rebuild"_s))
+        return;
+
+    shader_bench b{};
+    MemCpy(b.root.data, "/tmp/nyla-bench-shaders-XXXXXX", sizeof("/tmp/nyla-bench-shaders-XXXXXX"));
+    ASSERT(mkdtemp(b.root.data));
+
+    array<uint8_t, 256> path;
+    array<uint8_t, 1024> text;
+    ASSERT(mkdir(Span::CStr(ShaderBenchPath(path, b, "src"_s)), 0755) == 0);
+    ASSERT(mkdir(Span::CStr(ShaderBenchPath(path, b, "out"_s)), 0755) == 0);
+    ASSERT(mkdir(Span::CStr(ShaderBenchPath(path, b, "bin"_s)), 0755) == 0);
+
+    const char *versionArgv[] = {"dxc", "--version", nullptr};
+    byteview log{};
+    if (RunSync(span<const char *const>{versionArgv, 3}, alloc, log) != 0)
+    {
+        WriteBenchFile(ShaderBenchPath(path, b, "bin"_s, "dxc"_s),
+                       byteview{(const uint8_t *)kStandInDxc, sizeof(kStandInDxc) - 1}, 0755);
+        const char *oldPath = getenv("PATH");
+        const uint64_t n = StringWriteFmt(text, "%s/bin:%s"_s, b.root.data, oldPath ? oldPath : "/usr/bin:/bin");
+        text[n] = 0;
+        setenv("PATH", (const char *)text.data, 1);
+        LOG("dev_shaders: no dxc on PATH, timing a stand-in that takes %u ms per shader", kStandInDxcMs);
+    }
+
+    WriteShaderHeader(b, 0);
+    for (uint32_t i = 0; i < kShaderBenchShaders; ++i)
+    {
+        const uint64_t n =
+            i % 2 ? StringWriteFmt(text,
+                                   "#include \"common.hlsli\"\n\nfloat4 main(float4 position : SV_Position) : "
+                                   "SV_Target\n{\n    return Tint(float4(%u.0, 0.0, 0.0, 1.0));\n}\n"_s,
+                                   i)
+                  : StringWriteFmt(text,
+                                   "#include \"common.hlsli\"\n\nfloat4 main(float3 position : POSITION) : "
+                                   "SV_Position\n{\n    return Tint(float4(position, %u.0));\n}\n"_s,
+                                   i);
+        WriteBenchFile(ShaderBenchPath(path, b, "src"_s, ShaderBenchName(i), i), byteview{text.data, n}, 0644);
+    }
+
+    array<uint8_t, 256> srcDir;
+    array<uint8_t, 256> outDir;
+    const dev_shader_root root{
+        .srcDir = ShaderBenchPath(srcDir, b, "src"_s),
+        .outDir = ShaderBenchPath(outDir, b, "out"_s),
+    };
+
+    const uint64_t start = GetMonotonicTimeNanos();
+    DevShaders::Bootstrap(span<const dev_shader_root>{&root, 1});
+    DevShaders::WaitIdle();
+    const dev_shaders_stats boot = DevShaders::GetStats();
+    LOG("dev_shaders/bootstrap: %u missing outputs in %.1f ms, %.1f ms in dxc summed over the workers",
+        kShaderBenchShaders, (double)(GetMonotonicTimeNanos() - start) / 1e6, (double)boot.dxcNs / 1e6);
+
+    ShaderHeaderRebuild(b, 1, "header_rebuild_cold");
+    ShaderHeaderRebuild(b, 0, "header_rebuild_warm");
+
+    for (uint32_t i = 0; i < kShaderBenchShaders; ++i)
+    {
+        unlink(Span::CStr(ShaderBenchPath(path, b, "src"_s, ShaderBenchName(i), i)));
+        unlink(Span::CStr(ShaderBenchPath(path, b, "out"_s, ShaderBenchOutput(i), i)));
+    }
+    unlink(Span::CStr(ShaderBenchPath(path, b, "src"_s, "common.hlsli"_s)));
+    unlink(Span::CStr(ShaderBenchPath(path, b, "bin"_s, "dxc"_s)));
+
+    if (dir_iter *it = DirIter::Create(alloc, ShaderBenchPath(path, b, "out/.spvcache"_s)))
+    {
+        file_metadata meta;
+        while (DirIter::Next(alloc, *it, meta))
+        {
+            const uint64_t n = StringWriteFmt(text, "%s/out/.spvcache/" SV_FMT ""_s, b.root.data,
+                                              SV_ARG(meta.fileName));
+            text[n] = 0;
+            unlink((const char *)text.data);
+        }
+        DirIter::Destroy(*it);
+    }
+
+    rmdir(Span::CStr(ShaderBenchPath(path, b, "out/.spvcache"_s)));
+    rmdir(Span::CStr(ShaderBenchPath(path, b, "out"_s)));
+    rmdir(Span::CStr(ShaderBenchPath(path, b, "src"_s)));
+    rmdir(Span::CStr(ShaderBenchPath(path, b, "bin"_s)));
+    rmdir(b.root.data);
+}
+
+//
+
+#if defined(NYLA_BENCH_GAME_MODULE)
+
+constexpr uint32_t kGameReloads = 20;
+constexpr uint32_t kGameRestarts = 10;
+constexpr uint64_t kGameReloadTimeoutNs = 5'000'000'000;
+
+// What nyla_bench --game-restart runs in the child: a process that comes up, loads the module, runs its first update
+// and exits.
+void GameRestartChild()
+{
+    DirWatcher::Bootstrap();
+    game_module &game = *GameModule::Load(NYLA_BENCH_GAME_MODULE ""_s);
+    GameModule::Update(game, engine_frame{});
+    GameModule::Unload(game);
+}
+
+auto CountLiveCopies(region_alloc &alloc, byteview dir) -> uint32_t
+{
+    uint32_t count = 0;
+    if (dir_iter *it = DirIter::Create(alloc, dir))
+    {
+        file_metadata meta;
+        while (DirIter::Next(alloc, *it, meta))
+        {
+            if (Span::StartsWith(meta.fileName, NYLA_BENCH_GAME_MODULE ".live"_s))
+                ++count;
+        }
+        DirIter::Destroy(*it);
+    }
+    return count;
+}
+
+// Rewrites the module the way the linker does and times until the host runs the new copy: the watcher's debounce, the
+// copy, dlopen and init. Against it, a restart of nyla_bench that loads the module and runs one update, which is the
+// floor of restarting a game: breakout would pay for the window, the GPU and the assets on top.
+void BenchGameModule(region_alloc &alloc)
+{
+    if (!Bench::Selected("game_module/reload"_s))
+        return;
+
+    uint64_t start = GetMonotonicTimeNanos();
+    game_module &game = *GameModule::Load(NYLA_BENCH_GAME_MODULE ""_s);
+    const uint64_t loadNs = GetMonotonicTimeNanos() - start;
+
+    const byteview exe = GetExecutablePath(alloc);
+    uint64_t dirSize = exe.size;
+    while (dirSize && exe[dirSize - 1] != '/')
+        --dirSize;
+
+    array<uint8_t, 512> path;
+    const uint64_t n = StringWriteFmt(path, SV_FMT NYLA_BENCH_GAME_MODULE ""_s, SV_ARG(Span::SubSpan(exe, 0, dirSize)));
+    path[n] = 0;
+    const byteview modulePath{path.data, n};
+
+    file_handle file = FileOpen(modulePath, FileOpenMode::Read);
+    span<uint8_t> bytes;
+    ASSERT(TryFileReadFully(alloc, file, bytes));
+    FileClose(file);
+
+    const engine_frame frame{};
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t reloadNs = 0;
+    uint32_t reloads = 0;
+    for (uint32_t i = 0; i < kGameReloads; ++i)
+    {
+        const uint32_t before = GameModule::GetStats(game).reloads;
+        start = GetMonotonicTimeNanos();
+        WriteBenchFile(modulePath, byteview{bytes.data, bytes.size}, 0755);
+
+        while (GameModule::GetStats(game).reloads == before && GetMonotonicTimeNanos() - start < kGameReloadTimeoutNs)
+        {
+            DirWatcher::Tick();
+            GameModule::Update(game, frame);
+            Sleep(1);
+        }
+
+        const game_module_stats stats = GameModule::GetStats(game);
+        if (stats.reloads == before)
+            continue;
+
+        const uint64_t ns = GetMonotonicTimeNanos() - start;
+        totalNs += ns;
+        maxNs = Max(maxNs, ns);
+        reloadNs += stats.lastReloadNs;
+        ++reloads;
+    }
+    GameModule::Unload(game);
+
+    array<uint8_t, 512> dir;
+    const uint64_t dirLen = StringWriteFmt(dir, SV_FMT ""_s, SV_ARG(Span::SubSpan(exe, 0, dirSize - 1)));
+    dir[dirLen] = 0;
+    const uint32_t leftCopies = CountLiveCopies(alloc, byteview{dir.data, dirLen});
+
+    const char *const cmd[] = {Span::CStr(exe), "--game-restart", nullptr};
+    uint64_t restartNs = 0;
+    uint32_t restarts = 0;
+    for (uint32_t i = 0; i < kGameRestarts; ++i)
+    {
+        byteview childLog;
+        start = GetMonotonicTimeNanos();
+        const int32_t status = RunSync(span<const char *const>{cmd, 3}, alloc, childLog);
+        if (status != 0)
+        {
+            LOG("game_module/restart: child exited with %d: " SV_FMT, status, SV_ARG(childLog));
+            continue;
+        }
+        restartNs += GetMonotonicTimeNanos() - start;
+        ++restarts;
+    }
+
+    LOG("game_module/reload: first load %.2f ms, %u of %u rewrites running after %.1f ms on average (%.1f ms at "
+        "most, %" PRIu64 " ms of it the watcher's debounce), %.2f ms of that copying, loading and init",
+        (double)loadNs / 1e6, reloads, kGameReloads, reloads ? (double)totalNs / reloads / 1e6 : 0.0,
+        (double)maxNs / 1e6, kDirWatcherDebounceMs, reloads ? (double)reloadNs / reloads / 1e6 : 0.0);
+    LOG("game_module/restart: %u of %u restarts ran the first update after %.1f ms on average, %u .live copies left "
+        "after unload",
+        restarts, kGameRestarts, restarts ? (double)restartNs / restarts / 1e6 : 0.0, leftCopies);
+}
+
+#endif
+
+#endif
+
+} // namespace
+
+// nyla_bench [filter] [--quick] [--out result.json]
+// nyla_bench --compare base.json new.json
+void UserMain()
+{
+    byteview args[16]{};
+    ParseStdArgs(args, 16);
+
+    byteview filter{};
+    byteview out = "nyla-bench.json"_s;
+    bool quick = false;
+    for (uint32_t i = 1; i < 16 && args[i].size; ++i)
+    {
+        if (Span::Eq(args[i], "--compare"_s))
+        {
+            ASSERT(i + 2 < 16 && args[i + 1].size && args[i + 2].size, "--compare needs two result files");
+            Bench::Compare(args[i + 1], args[i + 2]);
+            return;
+        }
+#if defined(__linux__) && defined(NYLA_BENCH_GAME_MODULE)
+        if (Span::Eq(args[i], "--game-restart"_s))
+        {
+            GameRestartChild();
+            return;
+        }
+#endif
+        if (Span::Eq(args[i], "--quick"_s))
+            quick = true;
+        else if (Span::Eq(args[i], "--out"_s) && i + 1 < 16 && args[i + 1].size)
+            out = args[++i];
+        else
+            filter = args[i];
+    }
+
+    Bench::Bootstrap(filter, quick);
+
+    region_alloc alloc = RegionAlloc::Create(MemPagePool::kChunkSize, 0);
+    BenchRegionAlloc();
+    BenchHandlePool(alloc);
+    BenchAssetManager(alloc);
+    BenchJson(alloc);
+    BenchGltf(alloc);
+    BenchFmt();
+    BenchFloatConv(alloc);
+    BenchBdf(alloc);
+    BenchScrollback(alloc);
+    BenchMat(alloc);
+    TextureManager::Bootstrap();
+    MeshManager::BootstrapHeadless();
+    Renderer::BootstrapHeadless();
+    BenchMesh(alloc);
+    BenchRenderer(alloc);
+    BenchDebugText(alloc);
+    BenchInput(alloc);
+    BenchQoa(alloc);
+    BenchAudio(alloc);
+    BenchJobSystem(alloc);
+#if defined(__linux__)
+    BenchLog(alloc);
+    BenchPlatformAudio();
+    BenchGamepad();
+    DirWatcher::Bootstrap();
+    BenchDirWatcher();
+    BenchDevShaders(alloc);
+#if defined(NYLA_BENCH_GAME_MODULE)
+    BenchGameModule(alloc);
+#endif
+#endif
+
+    Bench::WriteJson(out);
+}
+
+} // namespace nyla
@@ -0,0 +1,96 @@
+"""Generates nyla/commons/float_conv_tables.h.
+
+kPow10Split: for FormatShortest (Schubfach). 10^-k = beta 2^r with 2^125 <= beta < 2^126, g = floor(beta) + 1,
+split into the high and low 63 bits, for k in [kPow10SplitMinK, kPow10SplitMaxK].
+
+kPow5Floor: for DecimalToDouble (Eisel-Lemire). floor(5^q 2^s) normalized to [2^127, 2^128), split into the high
+and low 64 bits, for q in [kPow5MinQ, kPow5MaxQ]. Rounded down for every q, so the product is a lower bound.
+"""
+
+from pathlib import Path
+
+POW10_MIN_K = -324
+POW10_MAX_K = 292
+POW5_MIN_Q = -342
+POW5_MAX_Q = 308
+
+
+def flog2pow10(e: int) -> int:
+    return (e * 913_124_641_741) >> 38
+
+
+def pow10_split(k: int) -> tuple[int, int]:
+    # 10^-k 2^-r with r = flog2pow10(-k) - 125, rounded down, plus one.
+    r = flog2pow10(-k) - 125
+    if -k >= 0:
+        num, den = 10 ** -k, 1
+    else:
+        num, den = 1, 10 ** k
+    if r >= 0:
+        den <<= r
+    else:
+        num <<= -r
+    g = num // den + 1
+    assert 1 << 125 <= g < 1 << 126, k
+    return g >> 63, g & ((1 << 63) - 1)
+
+
+def pow5_floor(q: int) -> int:
+    if q >= 0:
+        p = 5 ** q
+        b = p.bit_length() - 1
+        t = p << (127 - b) if b <= 127 else p >> (b - 127)
+    else:
+        d = 5 ** -q
+        t = (1 << (127 + d.bit_length())) // d
+    assert 1 << 127 <= t < 1 << 128, q
+    return t
+
+
+def main() -> None:
+    for q in range(POW5_MIN_Q, POW5_MAX_Q + 1):
+        # Used by the parser to get floor(log2(5^q)).
+        fl = (5 ** q).bit_length() - 1 if q >= 0 else -(5 ** -q).bit_length()
+        assert (q * 1_217_359) >> 19 == fl, q
+
+    out = []
+    out.append("#pragma once")
+    out.append("")
+    out.append("// Generated by scripts/gen_float_conv_tables.py, do not edit.")
+    out.append("")
+    out.append("#include <cstdint>")
+    out.append("")
+    out.append("namespace nyla")
+    out.append("{")
+    out.append("")
+    out.append("namespace FloatConvTables")
+    out.append("{")
+    out.append("")
+    out.append(f"constexpr inline int32_t kPow10SplitMinK = {POW10_MIN_K};")
+    out.append(f"constexpr inline int32_t kPow10SplitMaxK = {POW10_MAX_K};")
+    out.append(f"constexpr inline int32_t kPow5MinQ = {POW5_MIN_Q};")
+    out.append(f"constexpr inline int32_t kPow5MaxQ = {POW5_MAX_Q};")
+    out.append("")
+    out.append(f"constexpr inline uint64_t kPow10Split[{POW10_MAX_K - POW10_MIN_K + 1}][2] = {{")
+    for k in range(POW10_MIN_K, POW10_MAX_K + 1):
+        g1, g0 = pow10_split(k)
+        out.append(f"    {{0x{g1:016X}, 0x{g0:016X}}}, // {k}")
+    out.append("};")
+    out.append("")
+    out.append(f"constexpr inline uint64_t kPow5Floor[{POW5_MAX_Q - POW5_MIN_Q + 1}][2] = {{")
+    for q in range(POW5_MIN_Q, POW5_MAX_Q + 1):
+        t = pow5_floor(q)
+        out.append(f"    {{0x{t >> 64:016X}, 0x{t & ((1 << 64) - 1):016X}}}, // {q}")
+    out.append("};")
+    out.append("")
+    out.append("} // namespace FloatConvTables")
+    out.append("")
+    out.append("} // namespace nyla")
+    out.append("")
+
+    path = Path(__file__).resolve().parent.parent / "nyla" / "commons" / "float_conv_tables.h"
+    path.write_text("\n".join(out), newline="\n")
+
+
+if __name__ == "__main__":
+    main()
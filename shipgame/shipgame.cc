@@ -8,6 +8,7 @@
 #include "nyla/commons/asset_manager.h"
 #include "nyla/commons/byteliterals.h"
 #include "nyla/commons/cell_renderer.h"
+#include "nyla/commons/cpu_sampler.h"
 #include "nyla/commons/debug_text_renderer.h"
 #include "nyla/commons/dev_assets.h"
 #include "nyla/commons/dev_log.h"
@@ -243,11 +244,11 @@ void UserMain()
 #endif
     Shader::Bootstrap();
     PipelineCache::Bootstrap();
-    DebugTextRenderer::Bootstrap(alloc);
-#if !defined(NDEBUG)
     CellRenderer::Bootstrap(alloc, cell_renderer_init_desc{
                                        .bdfGuid = ID_bdf_terminus_u32,
                                    });
+    DebugTextRenderer::Bootstrap(alloc);
+#if !defined(NDEBUG)
     Tunables::Bootstrap("shipgame.tunables"_s);
     Tunables::RegisterFloat("camera.zoom"_s, &game->cameraZoom, 0.05f, 0.1f, 2.5f);
     Tunables::RegisterFloat("camera.metersOnScreen"_s, &game->metersOnScreen, 4.f, 8.f, 256.f);
@@ -377,7 +378,6 @@ void UserMain()
         DebugTextRenderer::Fmt(500, 10, "fps=%d"_s, uint32_t(frame.fps));
 
         GpuUpload::Update();
-        InputManager::Update();
         TweenManager::Update(frame.dt);
         TextureManager::Update(frame.cmd);
 
@@ -390,24 +390,6 @@ void UserMain()
             RenderTargets::GetTargets(renderTargets, backbufferInfo.width, backbufferInfo.height, &rtv, &dsv);
 
             {
-                // game input
-                const int dx =
-                    InputManager::IsPressed(input_id::MoveRight) - InputManager::IsPressed(input_id::MoveLeft);
-                const int dy =
-                    InputManager::IsPressed(input_id::MoveBackward) - InputManager::IsPressed(input_id::MoveForward);
-                const bool brake = InputManager::IsPressed(input_id::Brake);
-                const bool boost = InputManager::IsPressed(input_id::Sprint) && !brake;
-
-                if (boost && !game->boostActive)
-                {
-                    game->boostStartUs = frame.frameStartUs;
-                    game->boostActive = true;
-                }
-                else if (!boost)
-                {
-                    game->boostActive = false;
-                }
-
                 // game simulation
                 static uint64_t dtUsAccumulator = 0;
                 dtUsAccumulator += frame.dtUs;
@@ -416,6 +398,27 @@ void UserMain()
                 constexpr float kStep = 1.f / 120.f;
                 for (; dtUsAccumulator >= kStepUs; dtUsAccumulator -= kStepUs)
                 {
+                    // game input, the events that arrived during this step
+                    const uint64_t stepEndUs = frame.frameStartUs - (dtUsAccumulator - kStepUs);
+                    InputManager::Step(stepEndUs * 1000);
+
+                    const int dx =
+                        InputManager::IsPressed(input_id::MoveRight) - InputManager::IsPressed(input_id::MoveLeft);
+                    const int dy = InputManager::IsPressed(input_id::MoveBackward) -
+                                   InputManager::IsPressed(input_id::MoveForward);
+                    const bool brake = InputManager::IsPressed(input_id::Brake);
+                    const bool boost = InputManager::IsPressed(input_id::Sprint) && !brake;
+
+                    if (boost && !game->boostActive)
+                    {
+                        game->boostStartUs = stepEndUs;
+                        game->boostActive = true;
+                    }
+                    else if (!boost)
+                    {
+                        game->boostActive = false;
+                    }
+
                     if (dx || dy)
                     {
                         float angle = std::atan2(-static_cast<float>(dy), static_cast<float>(dx));
@@ -434,7 +437,7 @@ void UserMain()
                         const float2 direction = Vec::Normalized(
                             float2{std::cos(game->ship.angleRadians), std::sin(game->ship.angleRadians)});
 
-                        const uint64_t duration = frame.frameStartUs - game->boostStartUs;
+                        const uint64_t duration = stepEndUs - game->boostStartUs;
                         const float maxSpeed =
                             duration < 100'000 ? 100.f : 100.f + static_cast<float>(duration - 100'000) / 10000.f;
 
@@ -557,7 +560,8 @@ void UserMain()
                             CellRenderer::CmdFlush(frame.cmd);
                         }
                         Profiler::CmdFlush(frame.cmd, 8, 8 + 32 * 9, frame.fps);
-                        Tunables::CmdFlush(frame.cmd, 8, 8 + 32 * 18);
+                        CpuSampler::CmdFlush(frame.cmd, 8 + 16 * 66, 8 + 32 * 9);
+                        Tunables::CmdFlush(frame.cmd, 8, 8 + 32 * 24);
                     }
 #endif
                 }
@@ -28,6 +28,7 @@
 #include "nyla/commons/renderer.h"
 #include "nyla/commons/rhi.h"
 #include "nyla/commons/sampler_manager.h"
+#include "nyla/commons/scrollback.h"
 #include "nyla/commons/shader.h"
 #include "nyla/commons/span_def.h"
 #include "nyla/commons/texture_manager.h"
@@ -238,6 +239,33 @@ void UserMain()
         }
     }
 
+    constexpr uint32_t kCols = 80;
+    constexpr uint32_t kRows = 24;
+
+    scrollback *history = Scrollback::Create(alloc, scrollback_desc{});
+    {
+        auto pushText = [history](byteview text, uint32_t fgRgba, uint32_t bgRgba) -> void {
+            cell_attr cells[kCols];
+            uint32_t n = 0;
+            for (uint64_t i = 0; i < text.size && n < kCols; ++i)
+            {
+                cells[n++] = cell_attr{
+                    .glyphIndex = CellRenderer::GlyphForCodepoint(text.data[i]),
+                    .flags = 0,
+                    .fgRgba = fgRgba,
+                    .bgRgba = bgRgba,
+                };
+            }
+            Scrollback::PushLine(*history, span<const cell_attr>{cells, n});
+        };
+
+        pushText("nyla cell renderer"_s, 0xFFEEEEEEu, 0xFF1C1C1Cu);
+        pushText(""_s, 0xFFEEEEEEu, 0xFF1C1C1Cu);
+        pushText("abcdefghijklmnopqrstuvwxyz"_s, 0xFF87AF87u, 0xFF1C1C1Cu);
+        pushText("ABCDEFGHIJKLMNOPQRSTUVWXYZ"_s, 0xFFD7D7AFu, 0xFF1C1C1Cu);
+        pushText("0123456789 !@#$%^&*()_+-=[]{}"_s, 0xFFD7D7AFu, 0xFF1C1C1Cu);
+    }
+
     render_targets renderTargets{
         .ColorFormat = rhi_texture_format::B8G8R8A8_sRGB,
         .DepthStencilFormat = rhi_texture_format::D32_Float_S8_UINT,
@@ -252,7 +280,7 @@ void UserMain()
         GpuUpload::Update();
         InputManager::Update();
         TweenManager::Update(frame.dt);
-        MeshManager::Update(alloc, frame.cmd);
+        MeshManager::Update(frame.cmd);
         TextureManager::Update(frame.cmd);
 
         {
@@ -271,11 +299,20 @@ void UserMain()
                     .rtv = rtv,
                 });
                 {
-                    CellRenderer::Begin(16, 16, 80, 24);
-                    CellRenderer::Text(0, 0, "nyla cell renderer"_s, 0xFFEEEEEEu, 0xFF1C1C1Cu);
-                    CellRenderer::Text(0, 2, "abcdefghijklmnopqrstuvwxyz"_s, 0xFF87AF87u, 0xFF1C1C1Cu);
-                    CellRenderer::Text(0, 3, "ABCDEFGHIJKLMNOPQRSTUVWXYZ"_s, 0xFFD7D7AFu, 0xFF1C1C1Cu);
-                    CellRenderer::Text(0, 4, "0123456789 !@#$%^&*()_+-=[]{}"_s, 0xFFD7D7AFu, 0xFF1C1C1Cu);
+                    CellRenderer::Begin(16, 16, kCols, kRows);
+                    {
+                        const uint64_t numLines = Scrollback::EndLine(*history) - Scrollback::FirstLine(*history);
+                        const uint32_t numRows = static_cast<uint32_t>(Min<uint64_t>(numLines, kRows));
+
+                        cell_attr cells[kCols];
+                        for (uint32_t row = 0; row < numRows; ++row)
+                        {
+                            const uint32_t n = Scrollback::ReadViewRow(*history, kCols, numRows - 1 - row,
+                                                                       span<cell_attr>{cells, kCols});
+                            for (uint32_t col = 0; col < n; ++col)
+                                CellRenderer::PutCell(col, row, cells[col]);
+                        }
+                    }
                     CellRenderer::CmdFlush(frame.cmd);
 
                     DebugTextRenderer::CmdFlush(frame.cmd);
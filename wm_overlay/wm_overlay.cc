@@ -4,17 +4,22 @@
 #include <xcb/xcb.h>
 #include <xcb/xproto.h>
 
+#include "assets.h"
 #include "nyla/commons/asset_manager.h"
+#include "nyla/commons/cell_renderer.h"
 #include "nyla/commons/debug_text_renderer.h"
 #include "nyla/commons/dev_assets.h"
 #include "nyla/commons/dev_shaders.h"
 #include "nyla/commons/entrypoint.h"
 #include "nyla/commons/file.h"
+#include "nyla/commons/gpu_upload.h"
 #include "nyla/commons/pipeline_cache.h"
 #include "nyla/commons/platform_linux.h"
 #include "nyla/commons/region_alloc.h"
 #include "nyla/commons/rhi.h"
+#include "nyla/commons/sampler_manager.h"
 #include "nyla/commons/shader.h"
+#include "nyla/commons/texture_manager.h"
 #include "nyla/commons/time.h"
 
 namespace nyla
@@ -35,21 +40,24 @@ void UserMain()
                               .flags = rhi_flags::VSync,
                               .limits =
                                   {
-                                      .numTextures = 0,
-                                      .numTextureViews = 0,
-                                      .numBuffers = 0,
-                                      .numSamplers = 0,
+                                      .numTextures = 4,
+                                      .numTextureViews = 4,
+                                      .numBuffers = 4,
+                                      .numSamplers = 4,
                                       .numFramesInFlight = 1,
                                       .maxDrawCount = 1,
                                       .maxPassCount = 1,
                                       .frameConstantSize = 0,
                                       .passConstantSize = 0,
                                       .drawConstantSize = 0,
-                                      .largeDrawConstantSize = 320,
+                                      .largeDrawConstantSize = 64,
                                   },
                           });
 
     AssetManager::Bootstrap(FileOpen(R"(assets.bin)"_s, FileOpenMode::Read));
+    GpuUpload::Bootstrap();
+    SamplerManager::Bootstrap();
+    TextureManager::Bootstrap();
 #if !defined(NDEBUG)
     {
         const byteview devRoots[] = {"assets"_s, "asset_public"_s};
@@ -63,6 +71,10 @@ void UserMain()
 #endif
     Shader::Bootstrap();
     PipelineCache::Bootstrap();
+    CellRenderer::Bootstrap(alloc, cell_renderer_init_desc{
+                                       .bdfGuid = ID_bdf_terminus_u32,
+                                       .maxCells = 256,
+                                   });
     DebugTextRenderer::Bootstrap(alloc);
 
     for (;;)
@@ -72,6 +84,7 @@ void UserMain()
         rhi_cmdlist cmd = Rhi::FrameBegin(alloc);
 
         bool shouldRedraw = false;
+        bool shouldQuit = false;
 
         auto processEvents = [&] -> void {
             for (;;)
@@ -83,13 +96,13 @@ void UserMain()
                 if (event.type == PlatformEventType::Repaint)
                     shouldRedraw = true;
                 if (event.type == PlatformEventType::Quit)
-                    exit(0);
+                    shouldQuit = true;
             }
         };
         processEvents();
 
         static uint64_t prevUs = GetMonotonicTimeMicros();
-        if (!shouldRedraw)
+        if (!shouldRedraw && !shouldQuit)
         {
             for (;;)
             {
@@ -110,18 +123,25 @@ void UserMain()
                 if (pollRes > 0)
                 {
                     processEvents();
-                    if (shouldRedraw)
+                    if (shouldRedraw || shouldQuit)
                         break;
                 }
                 continue;
             }
         }
 
+        // Returning lets LibMain shut the log down, which writes out the lines still queued.
+        if (shouldQuit)
+            return;
+
         time_t t = time(nullptr);
         struct tm *tm = localtime(&t);
         DebugTextRenderer::Fmt(1, 1, "%02d:%02d:%02d %02d.%02d.%04d"_s, tm->tm_hour, tm->tm_min, tm->tm_sec,
                                tm->tm_mday, tm->tm_mon + 1, tm->tm_year + 1900);
 
+        GpuUpload::Update();
+        TextureManager::Update(cmd);
+
         rhi_texture backbuffer = Rhi::GetTexture(Rhi::GetBackbufferView());
 
         Rhi::CmdTransitionTexture(cmd, backbuffer, rhi_texture_state::ColorTarget);